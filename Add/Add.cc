@@ -4,38 +4,60 @@
 #include "acl/acl.h"
 #include "acl/acl_op_compiler.h"
 #include "common/logging.h"
+#include "common/benchmark.h"
+#include "common/cmdline.h"
+#include "common/compare.h"
+#include "common/dtype.h"
+#include "common/random.h"
+#include "common/ref_broadcast.h"
+#include "common/summary.h"
 
 #define ACL_CALL(msg) CHECK_EQ(reinterpret_cast<aclError>(msg), ACL_SUCCESS)
 
-int main() {
-  // Init
-  ACL_CALL(aclInit(nullptr));
-  ACL_CALL(aclrtSetDevice(0));
-
+// usage: ./Add [dtype] [iters] [key=value ...], any value can be a sweep (common/cmdline.h)
+//   dtype    fp32 (default), fp16 or bf16
+//   iters    warm runs timed after the first, compiling one (default 0)
+//   shape    x and out, default 4x6x4x4
+//   y_shape  broadcast to shape, default 1x6x1x1
+//   format   default NCHW
+template <typename T>
+bool Run(aclDataType dtype, const CaseParams& p) {
+  const int iters = p.Int("iters", 0);
   // op type
   const std::string op_type = "Add";
 
   // common
-  const aclFormat origin_format = ACL_FORMAT_NCHW;
-  const aclFormat storage_format = ACL_FORMAT_NCHW;
+  const aclFormat origin_format = p.Format("format", ACL_FORMAT_NCHW);
+  const aclFormat storage_format = origin_format;
 
   // input - x
-  const std::vector<int64_t> x_origin_dims{4, 6, 4, 4};
-  const std::vector<int64_t> x_storage_dims{4, 6, 4, 4};
-  const std::vector<float> x_data(64*6, 1);
+  const std::vector<int64_t> x_origin_dims = p.Ints("shape", {4, 6, 4, 4});
+  const std::vector<int64_t> x_storage_dims = x_origin_dims;
+  int64_t x_numel = 1;
+  for (auto d : x_origin_dims) x_numel *= d;
+  std::vector<T> x_data(x_numel);
+  RandomUniform(x_data.data(), x_data.size(), -1.0, 1.0, 0);
 
   // input - y
-  const std::vector<int64_t> y_origin_dims{1, 6, 1, 1};
-  const std::vector<int64_t> y_storage_dims{1, 6, 1, 1};
-  const std::vector<float> y_data(6, 1);
+  const std::vector<int64_t> y_origin_dims = p.Ints("y_shape", {1, 6, 1, 1});
+  const std::vector<int64_t> y_storage_dims = y_origin_dims;
+  int64_t y_numel = 1;
+  for (auto d : y_origin_dims) y_numel *= d;
+  std::vector<T> y_data(y_numel);
+  RandomUniform(y_data.data(), y_data.size(), -1.0, 1.0, 1);
+  StrideView<T> y_view;
+  if (!BroadcastToView(y_data.data(), y_origin_dims, x_origin_dims, &y_view)) {
+    LOG(WARNING) << "y_shape does not broadcast to shape, skipped";
+    return true;
+  }
 
   // output - out
   // const std::vector<int64_t> origin_dims{4, 6, 4, 4};
   // const std::vector<int64_t> storage_dims{4, 1, 4, 4, 16};
-  std::vector<float> out_data(64*6, 0); // output = 2
+  std::vector<T> out_data(x_numel); // output = x + y broadcast
 
   // input - x
-  auto x_desc = aclCreateTensorDesc(ACL_FLOAT, x_origin_dims.size(), x_origin_dims.data(), origin_format);
+  auto x_desc = aclCreateTensorDesc(dtype, x_origin_dims.size(), x_origin_dims.data(), origin_format);
   ACL_CALL(aclSetTensorFormat(x_desc, storage_format));
   ACL_CALL(aclSetTensorShape(x_desc, x_storage_dims.size(), x_storage_dims.data()));
   auto x_size = aclGetTensorDescSize(x_desc);
@@ -46,7 +68,7 @@ int main() {
   auto x_buffer = aclCreateDataBuffer(x_device_ptr, x_size);
 
   // input - x
-  auto y_desc = aclCreateTensorDesc(ACL_FLOAT, y_origin_dims.size(), y_origin_dims.data(), origin_format);
+  auto y_desc = aclCreateTensorDesc(dtype, y_origin_dims.size(), y_origin_dims.data(), origin_format);
   ACL_CALL(aclSetTensorFormat(y_desc, storage_format));
   ACL_CALL(aclSetTensorShape(y_desc, y_storage_dims.size(), y_storage_dims.data()));
   auto y_size = aclGetTensorDescSize(y_desc);
@@ -66,7 +88,7 @@ int main() {
 
 
   // output - out
-  auto out_desc = aclCreateTensorDesc(ACL_FLOAT, x_origin_dims.size(), x_origin_dims.data(), origin_format);
+  auto out_desc = aclCreateTensorDesc(dtype, x_origin_dims.size(), x_origin_dims.data(), origin_format);
   ACL_CALL(aclSetTensorFormat(out_desc, storage_format));
   ACL_CALL(aclSetTensorShape(out_desc, x_storage_dims.size(), x_storage_dims.data()));
   auto out_size = aclGetTensorDescSize(out_desc);
@@ -89,23 +111,39 @@ int main() {
   ACL_CALL(aclrtCreateStream(&stream));
 
   // run operator
-  std::cout << "aclopCompileAndExecute : " << op_type << std::endl;
-  ACL_CALL(aclopCompileAndExecute(op_type.c_str(), 
-            input_descs.size(), input_descs.data(), input_buffers.data(), 
-            output_descs.size(), output_descs.data(), output_buffers.data(), 
-            attr, ACL_ENGINE_SYS, ACL_COMPILE_SYS, NULL, stream));
-
-  // sync and destroy stream
-  ACL_CALL(aclrtSynchronizeStream(stream));
+  auto run = [&]() {
+    ACL_CALL(aclopCompileAndExecute(op_type.c_str(), 
+              input_descs.size(), input_descs.data(), input_buffers.data(), 
+              output_descs.size(), output_descs.data(), output_buffers.data(), 
+              attr, ACL_ENGINE_SYS, ACL_COMPILE_SYS, NULL, stream));
+    ACL_CALL(aclrtSynchronizeStream(stream));
+  };
+  std::cout << "aclopCompileAndExecute : " << op_type << " " << DataTypeName(dtype) << std::endl;
+  run();
+  if (iters > 0) {
+    Timer timer;
+    for (int i = 0; i < iters; ++i) {
+      run();
+    }
+    std::cout << op_type << " " << DataTypeName(dtype) << ": " << timer.ElapsedMs() / iters << " ms" << std::endl;
+  }
+
+  // destroy stream
   ACL_CALL(aclrtDestroyStream(stream));
 
   ACL_CALL(aclrtMemcpy(out_data.data(), out_size, out_device_ptr, out_size, ACL_MEMCPY_DEVICE_TO_HOST));
 
-  std::cout << "y = [";
-  for (int i = 0; i < out_data.size(); ++i) {
-    std::cout << out_data[i] << ", ";
+  PrintTensor("y", out_data.data(), out_data.size());
+
+  // verify - y broadcast to the shape of x
+  std::vector<T> y_broadcast(x_numel);
+  Materialize(y_view, y_broadcast.data());
+  std::vector<float> out_ref(out_data.size());
+  for (size_t i = 0; i < out_ref.size(); ++i) {
+    out_ref[i] = static_cast<float>(x_data[i]) + static_cast<float>(y_broadcast[i]);
   }
-  std::cout << "]" << std::endl;
+  const CompareReport report = Compare(out_data.data(), out_ref.data(), x_origin_dims, Tolerance::For(dtype));
+  report.Print("y");
 
   ACL_CALL(aclDestroyDataBuffer(x_buffer));
   ACL_CALL(aclDestroyDataBuffer(y_buffer));
@@ -118,10 +156,29 @@ int main() {
   aclDestroyTensorDesc(y_desc);
   aclDestroyTensorDesc(out_desc);
   aclopDestroyAttr(attr);
+  return report.ok();
+}
+
+int main(int argc, char* argv[]) {
+  const std::vector<CaseParams> configs = ParseSweep(argc, argv, {"dtype", "iters"});
+
+  // Init
+  ACL_CALL(aclInit(nullptr));
+  ACL_CALL(aclrtSetDevice(0));
+
+  bool ok = true;
+  ForEachConfig(configs, [&ok](const CaseParams& p) {
+    const aclDataType dtype = ParseFloatType(p.Get("dtype"));
+    switch (dtype) {
+      case ACL_FLOAT16: ok = Run<float16>(dtype, p) && ok; break;
+      case ACL_BF16: ok = Run<bfloat16>(dtype, p) && ok; break;
+      default: ok = Run<float>(dtype, p) && ok; break;
+    }
+  });
 
   // release
   ACL_CALL(aclrtResetDevice(0));
   ACL_CALL(aclFinalize());
 
-  return 0;
+  return ok ? 0 : 1;
 }
\ No newline at end of file
@@ -2,6 +2,8 @@
 #include <vector>
 
 #include "common/nputensor.h"
+#include "common/ref_argreduce.h"
+#include "common/compare.h"
 
 int main() {
   // Init
@@ -71,6 +73,13 @@ int main() {
   input_x->Print("x");
   output_y->Print("y");
 
+  // verify against the CPU reference
+  std::vector<int64_t> y_ref(y_dims[0] * y_dims[1]);
+  RefArgMax(x_data.data(), x_dims, axis_data[0], y_ref.data());
+  output_y->CopyToHost();
+  const CompareReport report = Compare(output_y->data(), y_ref.data(), y_dims);
+  report.Print("y");
+
   // destroy
   input_x->Destroy();
   input_axis->Destroy();
@@ -82,5 +91,5 @@ int main() {
   ACL_CALL(aclrtResetDevice(0));
   ACL_CALL(aclFinalize());
 
-  return 0;
+  return report.ok() ? 0 : 1;
 }
\ No newline at end of file
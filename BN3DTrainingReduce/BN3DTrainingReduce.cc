@@ -1,35 +1,43 @@
+#include <cmath>
 #include <iostream>
 #include <vector>
 
 #include "common/nputensor.h"
-
-int main() {
-  // Init
-  ACL_CALL(aclInit(nullptr));
-  ACL_CALL(aclrtSetDevice(0));
-
-  // Get Run Mode - ACL_HOST
-  aclrtRunMode runMode;
-  ACL_CALL(aclrtGetRunMode(&runMode));
-  std::string run_mode_str = (runMode == ACL_DEVICE) ? "ACL_DEVICE" : "ACL_HOST";
-  std::cout << "aclrtRunMode is : " << run_mode_str << std::endl;
-
+#include "common/benchmark.h"
+#include "common/ref_bn.h"
+#include "common/cmdline.h"
+#include "common/compare.h"
+#include "common/dtype.h"
+#include "common/random.h"
+
+// usage: ./BN3DTrainingReduce [dtype] [iters] [key=value ...], any value can be a sweep (common/cmdline.h)
+//   dtype  of x, fp32 (default), fp16 or bf16, sum / square_sum stay fp32
+//   iters  warm runs timed after the first, compiling one (default 0)
+//   shape  x in NCDHW, default 2x4x6x6x6, 8x32x16x28x28 when iters > 0
+template <typename T>
+bool Run(aclDataType dtype, const CaseParams& p) {
+  const int iters = p.Int("iters", 0);
   // op type
   const std::string op_type = "BN3DTrainingReduce";
 
-  // input - x
-  const std::vector<int64_t> x_dims{2, 4, 6, 6, 6}; // NCDHW
-  std::vector<float> x_data(2*4*6*6*6, 1.0);
-  // std::iota(x_data.begin(), x_data.end(), 1.0);
+  // input - x, uniform in [0, 1), positive so that sum does not cancel
+  const std::vector<int64_t> x_dims =
+      p.Ints("shape", iters > 0 ? std::vector<int64_t>{8, 32, 16, 28, 28} : std::vector<int64_t>{2, 4, 6, 6, 6});
+  if (x_dims.size() != 5) {
+    LOG(WARNING) << "shape must be NCDHW, skipped";
+    return true;
+  }
+  int64_t numel = 1;
+  for (auto d : x_dims) numel *= d;
+  std::vector<T> x_data(numel);
+  RandomUniform(x_data.data(), x_data.size(), 0.0, 1.0, 0);
   // output - sum & square_sum
-  const std::vector<int64_t> sum_dims{4}; // ND
-  std::vector<float> sum_data(4, 0.0);
-  std::vector<float> square_sum_data(4, 0.0);
+  const std::vector<int64_t> sum_dims{x_dims[1]}; // ND
   // attr - epsilon
   const float epsilon = 1e-5;
 
   // input - x
-  auto input_x = new npuTensor<float>(ACL_FLOAT, x_dims.size(), x_dims.data(), ACL_FORMAT_NCDHW, x_data.data());
+  auto input_x = new npuTensor<T>(dtype, x_dims.size(), x_dims.data(), ACL_FORMAT_NCDHW, x_data.data());
   // set inputs desc and buffer
   std::vector<aclTensorDesc *> input_descs;
   std::vector<aclDataBuffer *> input_buffers;
@@ -57,31 +65,76 @@ int main() {
   aclrtStream stream = nullptr;
   ACL_CALL(aclrtCreateStream(&stream));
 
-  std::cout << "aclopCompileAndExecute : " << op_type << std::endl;
-  ACL_CALL(aclopCompileAndExecute(op_type.c_str(), 
-            input_descs.size(), input_descs.data(), input_buffers.data(), 
-            output_descs.size(), output_descs.data(), output_buffers.data(), 
-            attr, ACL_ENGINE_SYS, ACL_COMPILE_SYS, NULL, stream));
-
-  // sync and destroy stream
-  ACL_CALL(aclrtSynchronizeStream(stream));
+  auto run = [&]() {
+    ACL_CALL(aclopCompileAndExecute(op_type.c_str(), 
+              input_descs.size(), input_descs.data(), input_buffers.data(), 
+              output_descs.size(), output_descs.data(), output_buffers.data(), 
+              attr, ACL_ENGINE_SYS, ACL_COMPILE_SYS, NULL, stream));
+    ACL_CALL(aclrtSynchronizeStream(stream));
+  };
+  std::cout << "aclopCompileAndExecute : " << op_type << " " << DataTypeName(dtype) << std::endl;
+  run();
+  if (iters > 0) {
+    Timer timer;
+    for (int i = 0; i < iters; ++i) {
+      run();
+    }
+    std::cout << op_type << " " << DataTypeName(dtype) << ": " << timer.ElapsedMs() / iters << " ms" << std::endl;
+  }
+
+  // destroy stream
   ACL_CALL(aclrtDestroyStream(stream));
 
   // print output
   output_sum->Print("output_sum");
   output_square_sum->Print("output_square_sum");
 
+  // verify against the CPU reference
+  std::vector<float> sum_ref(sum_dims[0]);
+  std::vector<float> square_sum_ref(sum_dims[0]);
+  RefBNTrainingReduce(x_data.data(), x_dims, ACL_FORMAT_NCDHW, sum_ref.data(), square_sum_ref.data());
+  output_sum->CopyToHost();
+  output_square_sum->CopyToHost();
+  const Tolerance tol = dtype == ACL_FLOAT ? Tolerance::Rel(1e-4) : Tolerance::For(dtype);
+  const CompareReport sum_report = Compare(output_sum->data(), sum_ref.data(), sum_dims, tol);
+  const CompareReport square_sum_report = Compare(output_square_sum->data(), square_sum_ref.data(), sum_dims, tol);
+  sum_report.Print("sum");
+  square_sum_report.Print("square_sum");
 
-  // destroy
   // destroy
   input_x->Destroy();
   output_sum->Destroy();
   output_square_sum->Destroy();
   aclopDestroyAttr(attr);
+  return sum_report.ok() && square_sum_report.ok();
+}
+
+int main(int argc, char* argv[]) {
+  const std::vector<CaseParams> configs = ParseSweep(argc, argv, {"dtype", "iters"});
+
+  // Init
+  ACL_CALL(aclInit(nullptr));
+  ACL_CALL(aclrtSetDevice(0));
+
+  // Get Run Mode - ACL_HOST
+  aclrtRunMode runMode;
+  ACL_CALL(aclrtGetRunMode(&runMode));
+  std::string run_mode_str = (runMode == ACL_DEVICE) ? "ACL_DEVICE" : "ACL_HOST";
+  std::cout << "aclrtRunMode is : " << run_mode_str << std::endl;
+
+  bool ok = true;
+  ForEachConfig(configs, [&ok](const CaseParams& p) {
+    const aclDataType dtype = ParseFloatType(p.Get("dtype"));
+    switch (dtype) {
+      case ACL_FLOAT16: ok = Run<float16>(dtype, p) && ok; break;
+      case ACL_BF16: ok = Run<bfloat16>(dtype, p) && ok; break;
+      default: ok = Run<float>(dtype, p) && ok; break;
+    }
+  });
 
   // release
   ACL_CALL(aclrtResetDevice(0));
   ACL_CALL(aclFinalize());
 
-  return 0;
+  return ok ? 0 : 1;
 }
\ No newline at end of file
@@ -1,46 +1,56 @@
+#include <cmath>
 #include <iostream>
 #include <vector>
 
 #include "common/nputensor.h"
-
-int main() {
-  // Init
-  ACL_CALL(aclInit(nullptr));
-  ACL_CALL(aclrtSetDevice(0));
-
-  // Get Run Mode - ACL_HOST
-  aclrtRunMode runMode;
-  ACL_CALL(aclrtGetRunMode(&runMode));
-  std::string run_mode_str = (runMode == ACL_DEVICE) ? "ACL_DEVICE" : "ACL_HOST";
-  std::cout << "aclrtRunMode is : " << run_mode_str << std::endl;
-
+#include "common/benchmark.h"
+#include "common/ref_bn.h"
+#include "common/cmdline.h"
+#include "common/compare.h"
+#include "common/dtype.h"
+#include "common/random.h"
+
+// usage: ./BNTrainingUpdate [dtype] [iters] [key=value ...], any value can be a sweep (common/cmdline.h)
+//   dtype  of x / y, fp32 (default), fp16 or bf16, the channel tensors stay fp32
+//   iters  warm runs timed after the first, compiling one (default 0)
+//   shape  x / y in NCHW, default 2x4x6x6, 32x64x56x56 when iters > 0
+template <typename T>
+bool Run(aclDataType dtype, const CaseParams& p) {
+  const int iters = p.Int("iters", 0);
   // op type
   const std::string op_type = "BNTrainingUpdate";
 
-  // input - x
-  const std::vector<int64_t> x_dims{1, 2, 4};
-  std::vector<float> x_data(8);
-  std::iota(x_data.begin(), x_data.end(), 0);
-  // input - sum
-  const std::vector<int64_t> c_dims{2};
-  const std::vector<float> sum_data{6.0, 22.0};
-  // input - square_sum
-  const std::vector<float> square_sum_data{14.0, 126.0};
+  // input - x, uniform in [0, 1)
+  const std::vector<int64_t> x_dims =
+      p.Ints("shape", iters > 0 ? std::vector<int64_t>{32, 64, 56, 56} : std::vector<int64_t>{2, 4, 6, 6});
+  if (x_dims.size() != 4) {
+    LOG(WARNING) << "shape must be NCHW, skipped";
+    return true;
+  }
+  int64_t numel = 1;
+  for (auto d : x_dims) numel *= d;
+  std::vector<T> x_data(numel);
+  RandomUniform(x_data.data(), x_data.size(), 0.0, 1.0, 0);
+  // input - sum, square_sum of x, as BNTrainingReduce gives them
+  const std::vector<int64_t> c_dims{x_dims[1]};
+  std::vector<float> sum_data(c_dims[0]);
+  std::vector<float> square_sum_data(c_dims[0]);
+  RefBNTrainingReduce(x_data.data(), x_dims, ACL_FORMAT_NCHW, sum_data.data(), square_sum_data.data());
   // input - scale
-  const std::vector<float> scale_data{1.0, 1.0};
+  const std::vector<float> scale_data(c_dims[0], 1.0);
   // input - offset
-  const std::vector<float> offset_data{0.0, 0.0};
+  const std::vector<float> offset_data(c_dims[0], 0.0);
   // input - mean
-  const std::vector<float> mean_data{0.0, 0.0};
+  const std::vector<float> mean_data(c_dims[0], 0.0);
   // input - var
-  const std::vector<float> var_data{1.0, 1.0};
+  const std::vector<float> var_data(c_dims[0], 1.0);
   // attr - epsilon
   const float epsilon = 1e-5;
   // attr - factor
   const float factor = 0.9;
 
   // input - x
-  auto x = new npuTensor<float>(ACL_FLOAT, x_dims.size(), x_dims.data(), ACL_FORMAT_NCHW, x_data.data());
+  auto x = new npuTensor<T>(dtype, x_dims.size(), x_dims.data(), ACL_FORMAT_NCHW, x_data.data());
   auto sum = new npuTensor<float>(ACL_FLOAT, c_dims.size(), c_dims.data(), ACL_FORMAT_ND, sum_data.data());
   auto square_sum = new npuTensor<float>(ACL_FLOAT, c_dims.size(), c_dims.data(), ACL_FORMAT_ND, square_sum_data.data());
   auto scale = new npuTensor<float>(ACL_FLOAT, c_dims.size(), c_dims.data(), ACL_FORMAT_ND, scale_data.data());
@@ -67,7 +77,7 @@ int main() {
   input_buffers.emplace_back(var->buffer);
 
   // output - y
-  auto y = new npuTensor<float>(ACL_FLOAT, x_dims.size(), x_dims.data(), ACL_FORMAT_NCHW, nullptr);
+  auto y = new npuTensor<T>(dtype, x_dims.size(), x_dims.data(), ACL_FORMAT_NCHW, nullptr);
   auto mean_out = new npuTensor<float>(ACL_FLOAT, c_dims.size(), c_dims.data(), ACL_FORMAT_ND, nullptr);
   auto var_out = new npuTensor<float>(ACL_FLOAT, c_dims.size(), c_dims.data(), ACL_FORMAT_ND, nullptr);
   auto saved_mean = new npuTensor<float>(ACL_FLOAT, c_dims.size(), c_dims.data(), ACL_FORMAT_ND, nullptr);
@@ -96,14 +106,24 @@ int main() {
   aclrtStream stream = nullptr;
   ACL_CALL(aclrtCreateStream(&stream));
 
-  std::cout << "aclopCompileAndExecute : " << op_type << std::endl;
-  ACL_CALL(aclopCompileAndExecute(op_type.c_str(), 
-            input_descs.size(), input_descs.data(), input_buffers.data(), 
-            output_descs.size(), output_descs.data(), output_buffers.data(), 
-            attr, ACL_ENGINE_SYS, ACL_COMPILE_SYS, NULL, stream));
-
-  // sync and destroy stream
-  ACL_CALL(aclrtSynchronizeStream(stream));
+  auto run = [&]() {
+    ACL_CALL(aclopCompileAndExecute(op_type.c_str(), 
+              input_descs.size(), input_descs.data(), input_buffers.data(), 
+              output_descs.size(), output_descs.data(), output_buffers.data(), 
+              attr, ACL_ENGINE_SYS, ACL_COMPILE_SYS, NULL, stream));
+    ACL_CALL(aclrtSynchronizeStream(stream));
+  };
+  std::cout << "aclopCompileAndExecute : " << op_type << " " << DataTypeName(dtype) << std::endl;
+  run();
+  if (iters > 0) {
+    Timer timer;
+    for (int i = 0; i < iters; ++i) {
+      run();
+    }
+    std::cout << op_type << " " << DataTypeName(dtype) << ": " << timer.ElapsedMs() / iters << " ms" << std::endl;
+  }
+
+  // destroy stream
   ACL_CALL(aclrtDestroyStream(stream));
 
   // print output
@@ -113,6 +133,28 @@ int main() {
   saved_mean->Print("saved_mean");
   saved_var->Print("saved_var");
 
+  // verify against the CPU reference
+  const size_t C = c_dims[0];
+  std::vector<float> y_ref(x_data.size());
+  std::vector<float> mean_out_ref(C), var_out_ref(C), saved_mean_ref(C), saved_var_ref(C);
+  RefBNTrainingUpdate(x_data.data(), x_dims, ACL_FORMAT_NCHW, sum_data.data(), square_sum_data.data(),
+                      scale_data.data(), offset_data.data(), mean_data.data(), var_data.data(), factor, epsilon,
+                      y_ref.data(), mean_out_ref.data(), var_out_ref.data(), saved_mean_ref.data(), saved_var_ref.data());
+  bool ok = true;
+  const Tolerance tol = dtype == ACL_FLOAT ? Tolerance::Rel(1e-4) : Tolerance::For(dtype);
+  auto check = [&ok, &tol](const std::string& name, auto* out, const std::vector<float>& ref,
+                           const std::vector<int64_t>& dims) {
+    out->CopyToHost();
+    const CompareReport report = Compare(out->data(), ref.data(), dims, tol);
+    report.Print(name);
+    ok = ok && report.ok();
+  };
+  check("y", y, y_ref, x_dims);
+  check("mean", mean_out, mean_out_ref, c_dims);
+  check("variance", var_out, var_out_ref, c_dims);
+  check("batch_mean", saved_mean, saved_mean_ref, c_dims);
+  check("batch_variance", saved_var, saved_var_ref, c_dims);
+
   // destroy - inputs
   x->Destroy();
   sum->Destroy();
@@ -129,10 +171,35 @@ int main() {
   saved_var->Destroy();
 
   aclopDestroyAttr(attr);
+  return ok;
+}
+
+int main(int argc, char* argv[]) {
+  const std::vector<CaseParams> configs = ParseSweep(argc, argv, {"dtype", "iters"});
+
+  // Init
+  ACL_CALL(aclInit(nullptr));
+  ACL_CALL(aclrtSetDevice(0));
+
+  // Get Run Mode - ACL_HOST
+  aclrtRunMode runMode;
+  ACL_CALL(aclrtGetRunMode(&runMode));
+  std::string run_mode_str = (runMode == ACL_DEVICE) ? "ACL_DEVICE" : "ACL_HOST";
+  std::cout << "aclrtRunMode is : " << run_mode_str << std::endl;
+
+  bool ok = true;
+  ForEachConfig(configs, [&ok](const CaseParams& p) {
+    const aclDataType dtype = ParseFloatType(p.Get("dtype"));
+    switch (dtype) {
+      case ACL_FLOAT16: ok = Run<float16>(dtype, p) && ok; break;
+      case ACL_BF16: ok = Run<bfloat16>(dtype, p) && ok; break;
+      default: ok = Run<float>(dtype, p) && ok; break;
+    }
+  });
 
   // release
   ACL_CALL(aclrtResetDevice(0));
   ACL_CALL(aclFinalize());
 
-  return 0;
+  return ok ? 0 : 1;
 }
\ No newline at end of file
@@ -1,95 +1,152 @@
+#include <cmath>
 #include <iostream>
 #include <vector>
 
 #include "common/nputensor.h"
-
-int main() {
-  // Init
-  ACL_CALL(aclInit(nullptr));
-  ACL_CALL(aclrtSetDevice(0));
-
-  // Get Run Mode - ACL_HOST
-  aclrtRunMode runMode;
-  ACL_CALL(aclrtGetRunMode(&runMode));
-  std::string run_mode_str = (runMode == ACL_DEVICE) ? "ACL_DEVICE" : "ACL_HOST";
-  std::cout << "aclrtRunMode is : " << run_mode_str << std::endl;
-
+#include "common/benchmark.h"
+#include "common/ref_batch_matmul.h"
+#include "common/compare.h"
+#include "common/cmdline.h"
+#include "common/dtype.h"
+#include "common/opsignature.h"
+#include "common/random.h"
+
+// usage: ./BatchMatMul [M] [K] [N] [dtype] [iters] [key=value ...], any value can be a sweep
+// (common/cmdline.h), e.g. M=128:4096:*2 K={M} N={M} dtype=fp32,fp16 iters=10
+//   M, K, N          default 3, 4, 5
+//   dtype            fp32 (default), fp16 or bf16, fp32 accumulation in the reference
+//   iters            warm runs timed after the first, compiling one (default 0)
+//   batch1, batch2   batch dims of x1 / x2, broadcast against each other, default 3x1 and 1x2
+//   adj_x1, adj_x2   transposed x1 / x2, default 0
+//   format           default NCHW for 4-d inputs, ND otherwise
+template <typename T>
+bool Run(aclDataType dtype, const CaseParams& p) {
+  const int64_t M = p.Int("M", 3);
+  const int64_t K = p.Int("K", 4);
+  const int64_t N = p.Int("N", 5);
+  const int iters = p.Int("iters", 0);
   // op type
   const std::string op_type = "BatchMatMul";
-  // shape
-  const int64_t M = 3;
-  const int64_t K = 4;
-  const int64_t N = 5;
+  // attr
+  const bool trans_x1 = p.Bool("adj_x1", false);
+  const bool trans_x2 = p.Bool("adj_x2", false);
   // input - x1
-  const std::vector<int64_t> x1_dims{3, 1, M, K};
-  std::vector<float> x1_data(3 * M * K);
-  std::iota(x1_data.begin(), x1_data.end(), 0);
+  std::vector<int64_t> x1_dims = p.Ints("batch1", {3, 1});
+  int64_t x1_numel = M * K;
+  for (auto d : x1_dims) x1_numel *= d;
+  x1_dims.push_back(trans_x1 ? K : M);
+  x1_dims.push_back(trans_x1 ? M : K);
+  std::vector<float> x1_float(x1_numel);
   // input - x2
-  const std::vector<int64_t> x2_dims{1, 2, K, N};
-  std::vector<float> x2_data(2 * K * N);
-  std::iota(x2_data.begin(), x2_data.end(), 0);
-  // attr
-  const bool trans_x1 = false;
-  const bool trans_x2 = false;
+  std::vector<int64_t> x2_dims = p.Ints("batch2", {1, 2});
+  int64_t x2_numel = K * N;
+  for (auto d : x2_dims) x2_numel *= d;
+  x2_dims.push_back(trans_x2 ? N : K);
+  x2_dims.push_back(trans_x2 ? K : N);
+  std::vector<float> x2_float(x2_numel);
+  // iota only for the default 3x4x5 fp32 case, readable in the printout; iota
+  // products leave the fp16 range, and the fp16 cube precision fp32 runs
+  // under by default, beyond tiny shapes
+  const bool tiny = !p.Has("M") && !p.Has("K") && !p.Has("N") && !p.Has("batch1") && !p.Has("batch2");
+  if (dtype == ACL_FLOAT && tiny) {
+    std::iota(x1_float.begin(), x1_float.end(), 0);
+    std::iota(x2_float.begin(), x2_float.end(), 0);
+  } else {
+    RandomUniform(x1_float.data(), x1_float.size(), -1.0, 1.0, 0);
+    RandomUniform(x2_float.data(), x2_float.size(), -1.0, 1.0, 1);
+  }
+  // rounded to T, the reference reads the same values
+  std::vector<T> x1_data = FromFloat<T>(x1_float);
+  std::vector<T> x2_data = FromFloat<T>(x2_float);
   // output - y
-  const std::vector<int64_t> y_dims{3, 2, M, N};
+  const std::vector<int64_t> y_dims = BatchMatMulDims(x1_dims, x2_dims, trans_x1, trans_x2);
+  int64_t batch = 1;
+  for (size_t d = 0; d + 2 < y_dims.size(); ++d) batch *= y_dims[d];
+  const aclFormat format = p.Format("format", x1_dims.size() == 4 ? ACL_FORMAT_NCHW : ACL_FORMAT_ND);
 
   // input - x
-  auto x1 = new npuTensor<float>(ACL_FLOAT, x1_dims.size(), x1_dims.data(), ACL_FORMAT_NCHW, x1_data.data());
-  auto x2 = new npuTensor<float>(ACL_FLOAT, x2_dims.size(), x2_dims.data(), ACL_FORMAT_NCHW, x2_data.data());
-
-  // set inputs desc and buffer
-  std::vector<aclTensorDesc *> input_descs;
-  std::vector<aclDataBuffer *> input_buffers;
-  input_descs.emplace_back(x1->desc);
-  input_descs.emplace_back(x2->desc);
-  input_buffers.emplace_back(x1->buffer);
-  input_buffers.emplace_back(x2->buffer);
+  auto x1 = new npuTensor<T>(dtype, x1_dims.size(), x1_dims.data(), format, x1_data.data());
+  auto x2 = new npuTensor<T>(dtype, x2_dims.size(), x2_dims.data(), format, x2_data.data());
 
   // output - y
-  auto y = new npuTensor<float>(ACL_FLOAT, y_dims.size(), y_dims.data(), ACL_FORMAT_NCHW, nullptr);
+  auto y = new npuTensor<T>(dtype, y_dims.size(), y_dims.data(), format, nullptr);
 
-  // set output desc and buffer
-  std::vector<aclTensorDesc *> output_descs;
-  std::vector<aclDataBuffer *> output_buffers;
-  output_descs.emplace_back(y->desc);
-  output_buffers.emplace_back(y->buffer);
+  // x1, x2 -> y, attrs adj_x1, adj_x2
+  static constexpr auto kAttrs = sig::Names("adj_x1", "adj_x2");
+  OpSignature<In<T, T>, Out<T>, AttrTypes<bool, bool>> batch_matmul(op_type.c_str(), kAttrs);
 
-  // attr
-  auto attr = aclopCreateAttr();
-  ACL_CALL(aclopSetAttrBool(attr, "adj_x1", trans_x1));
-  ACL_CALL(aclopSetAttrBool(attr, "adj_x2", trans_x2));
-  
   // create stream
   aclrtStream stream = nullptr;
   ACL_CALL(aclrtCreateStream(&stream));
 
-  std::cout << "aclopCompileAndExecute : " << op_type << std::endl;
-  ACL_CALL(aclopCompileAndExecute(op_type.c_str(), 
-            input_descs.size(), input_descs.data(), input_buffers.data(), 
-            output_descs.size(), output_descs.data(), output_buffers.data(), 
-            attr, ACL_ENGINE_SYS, ACL_COMPILE_SYS, NULL, stream));
-
-  // sync and destroy stream
-  ACL_CALL(aclrtSynchronizeStream(stream));
+  auto run = [&]() {
+    ACL_CALL(batch_matmul.Execute(stream, x1, x2, y, trans_x1, trans_x2));
+    ACL_CALL(aclrtSynchronizeStream(stream));
+  };
+  std::cout << "aclopCompileAndExecute : " << op_type << " " << DataTypeName(dtype) << std::endl;
+  run();
+  if (iters > 0) {
+    Timer timer;
+    for (int i = 0; i < iters; ++i) {
+      run();
+    }
+    const double ms = timer.ElapsedMs() / iters;
+    std::cout << op_type << " " << DataTypeName(dtype) << ": " << ms << " ms, "
+              << 2.0 * batch * M * N * K / (ms * 1e9) << " TFLOPS" << std::endl;
+  }
+
+  // destroy stream
   ACL_CALL(aclrtDestroyStream(stream));
 
   // print output
-  x1->Print("x1");
-  x2->Print("x2");
-  y->Print("y");
+  if (y->size / sizeof(T) <= 1024) {
+    x1->Print("x1");
+    x2->Print("x2");
+    y->Print("y");
+  }
+
+  // verify against the CPU reference
+  std::vector<float> y_ref(y->size / sizeof(T));
+  RefBatchMatMul(x1_data.data(), x1_dims, x2_data.data(), x2_dims, trans_x1, trans_x2, y_ref.data());
+  y->CopyToHost();
+  const Tolerance tol = dtype == ACL_FLOAT ? Tolerance::Rel(1e-3) : Tolerance::For(dtype);
+  const CompareReport report = Compare(y->data(), y_ref.data(), y_dims, tol);
+  report.Print("y");
 
   // destroy - inputs
   x1->Destroy();
   x2->Destroy();
   // destroy - outputs
   y->Destroy();
+  return report.ok();
+}
+
+int main(int argc, char* argv[]) {
+  const std::vector<CaseParams> configs = ParseSweep(argc, argv, {"M", "K", "N", "dtype", "iters"});
+
+  // Init
+  ACL_CALL(aclInit(nullptr));
+  ACL_CALL(aclrtSetDevice(0));
+
+  // Get Run Mode - ACL_HOST
+  aclrtRunMode runMode;
+  ACL_CALL(aclrtGetRunMode(&runMode));
+  std::string run_mode_str = (runMode == ACL_DEVICE) ? "ACL_DEVICE" : "ACL_HOST";
+  std::cout << "aclrtRunMode is : " << run_mode_str << std::endl;
 
-  aclopDestroyAttr(attr);
+  bool ok = true;
+  ForEachConfig(configs, [&ok](const CaseParams& p) {
+    const aclDataType dtype = ParseFloatType(p.Get("dtype"));
+    switch (dtype) {
+      case ACL_FLOAT16: ok = Run<float16>(dtype, p) && ok; break;
+      case ACL_BF16: ok = Run<bfloat16>(dtype, p) && ok; break;
+      default: ok = Run<float>(dtype, p) && ok; break;
+    }
+  });
 
   // release
   ACL_CALL(aclrtResetDevice(0));
   ACL_CALL(aclFinalize());
 
-  return 0;
+  return ok ? 0 : 1;
 }
\ No newline at end of file
@@ -0,0 +1,154 @@
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <vector>
+
+#include "common/nputensor.h"
+#include "common/memplan.h"
+#include "common/benchmark.h"
+#include "common/compare.h"
+#include "common/ref_argreduce.h"
+
+// ArgMaxV2 / ArgMin on x = {outer, len, inner} along axis 1: device time
+// against the CPU reference (common/ref_argreduce.h) over reduction length
+// and outer size. Values are drawn from a small range so ties are common.
+// Each case prints the first differing output index. A final probe with
+// NaNs reports which argNanMode the device follows.
+//
+// usage: ./Bench_ArgReduce [max_len] [max_elems] [inner] [iters]
+
+struct ArgResult {
+  aclError ret = ACL_SUCCESS;
+  double ms = 0;
+  std::vector<int64_t> y;
+};
+
+static ArgResult RunDevice(const std::string& op_type, const std::vector<float>& x,
+                           const std::vector<int64_t>& x_dims, int iters, aclrtStream stream) {
+  const std::vector<int64_t> axis_dims{1};
+  const std::vector<int64_t> axis_data{1};
+  const std::vector<int64_t> y_dims{x_dims[0], x_dims[2]};
+  auto input_x = new npuTensor<float>(ACL_FLOAT, x_dims.size(), x_dims.data(), ACL_FORMAT_ND, x.data());
+  auto input_axis = PlanInput<int64_t>(op_type, 1, ACL_INT64, axis_dims.size(), axis_dims.data(), ACL_FORMAT_ND, axis_data.data());
+  auto output_y = new npuTensor<int64_t>(ACL_INT64, y_dims.size(), y_dims.data(), ACL_FORMAT_ND, nullptr);
+  std::vector<aclTensorDesc *> input_descs{input_x->desc, input_axis->desc};
+  std::vector<aclDataBuffer *> input_buffers{input_x->buffer, input_axis->buffer};
+  std::vector<aclTensorDesc *> output_descs{output_y->desc};
+  std::vector<aclDataBuffer *> output_buffers{output_y->buffer};
+  auto attr = aclopCreateAttr();
+  ACL_CALL(aclopSetAttrDataType(attr, "dtype", ACL_INT64));
+
+  ArgResult result;
+  auto run = [&] {
+    aclError ret = aclopCompileAndExecute(op_type.c_str(),
+              input_descs.size(), input_descs.data(), input_buffers.data(),
+              output_descs.size(), output_descs.data(), output_buffers.data(),
+              attr, ACL_ENGINE_SYS, ACL_COMPILE_SYS, NULL, stream);
+    return ret != ACL_SUCCESS ? ret : aclrtSynchronizeStream(stream);
+  };
+  // first call compiles
+  result.ret = run();
+  if (result.ret == ACL_SUCCESS) {
+    Timer timer;
+    for (int i = 0; i < iters && result.ret == ACL_SUCCESS; ++i) {
+      result.ret = run();
+    }
+    result.ms = timer.ElapsedMs() / iters;
+    output_y->CopyToHost();
+    result.y.assign(output_y->data(), output_y->data() + y_dims[0] * y_dims[1]);
+  }
+
+  input_x->Destroy();
+  input_axis->Destroy();
+  output_y->Destroy();
+  aclopDestroyAttr(attr);
+  return result;
+}
+
+static void RunRef(const std::string& op_type, const std::vector<float>& x, const std::vector<int64_t>& x_dims,
+                   argNanMode nan_mode, std::vector<int64_t>* y) {
+  y->resize(x_dims[0] * x_dims[2]);
+  if (op_type == "ArgMin") {
+    RefArgMin(x.data(), x_dims, 1, y->data(), nan_mode);
+  } else {
+    RefArgMax(x.data(), x_dims, 1, y->data(), nan_mode);
+  }
+}
+
+int main(int argc, char* argv[]) {
+  const int64_t max_len = argc > 1 ? atoll(argv[1]) : (1 << 20);
+  const int64_t max_elems = argc > 2 ? atoll(argv[2]) : (1 << 24);
+  const int64_t inner = argc > 3 ? atoll(argv[3]) : 1;
+  const int iters = argc > 4 ? atoi(argv[4]) : 3;
+
+  // Init
+  ACL_CALL(aclInit(nullptr));
+  ACL_CALL(aclrtSetDevice(0));
+
+  aclrtStream stream = nullptr;
+  ACL_CALL(aclrtCreateStream(&stream));
+
+  std::mt19937 gen(0);
+  std::cout << "inner " << inner << ", host threads " << NumHostThreads() << std::endl;
+  std::cout << std::setw(10) << "op" << std::setw(9) << "len" << std::setw(8) << "outer" << std::setw(12) << "npu_ms"
+            << std::setw(12) << "npu_GB/s" << std::setw(12) << "ref_ms" << std::setw(12) << "ref_GB/s"
+            << "  first_diff" << std::endl;
+  for (int64_t len = 16; len <= max_len; len *= 16) {
+    for (int64_t outer = 1; outer * len * inner <= max_elems && outer <= 4096; outer *= 64) {
+      const std::vector<int64_t> x_dims{outer, len, inner};
+      std::vector<float> x(outer * len * inner);
+      for (auto& v : x) v = static_cast<float>(gen() % 64);
+      const double gb = x.size() * sizeof(float) / 1e6;
+      for (const std::string op_type : {"ArgMaxV2", "ArgMin"}) {
+        ArgResult npu = RunDevice(op_type, x, x_dims, iters, stream);
+        std::vector<int64_t> y_ref;
+        Timer timer;
+        RunRef(op_type, x, x_dims, NAN_PROPAGATE, &y_ref);
+        const double ref_ms = timer.ElapsedMs();
+        std::cout << std::setw(10) << op_type << std::setw(9) << len << std::setw(8) << outer;
+        if (npu.ret != ACL_SUCCESS) {
+          std::cout << std::setw(12) << "error " << npu.ret << std::setw(12) << ref_ms << std::setw(12)
+                    << gb / ref_ms << std::endl;
+          continue;
+        }
+        std::cout << std::setw(12) << npu.ms << std::setw(12) << gb / npu.ms << std::setw(12) << ref_ms
+                  << std::setw(12) << gb / ref_ms;
+        const int64_t diff = Compare(npu.y.data(), y_ref.data(), {outer, inner}, Tolerance(), true).first_failure;
+        if (diff < 0) {
+          std::cout << "  none" << std::endl;
+        } else {
+          std::cout << "  y[" << diff / inner << ", " << diff % inner << "] npu " << npu.y[diff] << " ref "
+                    << y_ref[diff] << std::endl;
+        }
+      }
+    }
+  }
+
+  // NaN probe
+  const std::vector<int64_t> probe_dims{4, 8, 1};
+  std::vector<float> probe(32);
+  for (auto& v : probe) v = static_cast<float>(gen() % 8);
+  probe[3] = probe[12] = probe[13] = probe[31] = NAN;
+  for (int64_t k = 16; k < 24; ++k) probe[k] = NAN;
+  for (const std::string op_type : {"ArgMaxV2", "ArgMin"}) {
+    ArgResult npu = RunDevice(op_type, probe, probe_dims, 1, stream);
+    std::vector<int64_t> propagate;
+    std::vector<int64_t> ignore;
+    RunRef(op_type, probe, probe_dims, NAN_PROPAGATE, &propagate);
+    RunRef(op_type, probe, probe_dims, NAN_IGNORE, &ignore);
+    std::cout << op_type << " NaN handling: "
+              << (npu.ret != ACL_SUCCESS ? "error"
+                  : npu.y == propagate   ? "NAN_PROPAGATE"
+                  : npu.y == ignore      ? "NAN_IGNORE"
+                                         : "matches neither")
+              << std::endl;
+  }
+
+  ACL_CALL(aclrtDestroyStream(stream));
+
+  // release
+  ACL_CALL(aclrtResetDevice(0));
+  ACL_CALL(aclFinalize());
+
+  return 0;
+}
@@ -0,0 +1,188 @@
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <vector>
+
+#include "common/nputensor.h"
+#include "common/benchmark.h"
+#include "common/bandwidth.h"
+
+// Host <-> device transfer characterization.
+//
+// Sweeps 4 KB .. max_mb (default 4 GB) over H2D/D2H with pageable and pinned
+// host memory, sync and async copies on one or several streams, and D2D via
+// aclrtMemcpy vs the Identity op. Writes one CSV row per measurement and a
+// fitted latency + bandwidth model per path to BandwidthModelFile().
+//
+// usage: ./Bench_Bandwidth [max_mb] [csv_file] [num_streams]
+
+enum Path {
+  H2D_PAGEABLE,
+  H2D_PINNED,
+  D2H_PAGEABLE,
+  D2H_PINNED,
+  H2D_PINNED_ASYNC,
+  D2H_PINNED_ASYNC,
+  H2D_PINNED_MULTI_STREAM,
+  D2H_PINNED_MULTI_STREAM,
+  D2D_MEMCPY,
+  D2D_IDENTITY,
+  NUM_PATHS,
+};
+
+static const char* kPathNames[NUM_PATHS] = {
+  "h2d_pageable", "h2d_pinned", "d2h_pageable", "d2h_pinned",
+  "h2d_pinned_async", "d2h_pinned_async", "h2d_pinned_multi_stream", "d2h_pinned_multi_stream",
+  "d2d_memcpy", "d2d_identity",
+};
+
+struct Buffers {
+  char* pageable;
+  void* pinned;
+  void* device_src;
+  void* device_dst;
+  std::vector<aclrtStream> streams;
+  aclopAttr* attr;
+};
+
+static void Transfer(Path path, size_t bytes, Buffers& b) {
+  const int num_streams = b.streams.size();
+  switch (path) {
+    case H2D_PAGEABLE:
+      ACL_CALL(aclrtMemcpy(b.device_dst, bytes, b.pageable, bytes, ACL_MEMCPY_HOST_TO_DEVICE));
+      break;
+    case H2D_PINNED:
+      ACL_CALL(aclrtMemcpy(b.device_dst, bytes, b.pinned, bytes, ACL_MEMCPY_HOST_TO_DEVICE));
+      break;
+    case D2H_PAGEABLE:
+      ACL_CALL(aclrtMemcpy(b.pageable, bytes, b.device_src, bytes, ACL_MEMCPY_DEVICE_TO_HOST));
+      break;
+    case D2H_PINNED:
+      ACL_CALL(aclrtMemcpy(b.pinned, bytes, b.device_src, bytes, ACL_MEMCPY_DEVICE_TO_HOST));
+      break;
+    case H2D_PINNED_ASYNC:
+      ACL_CALL(aclrtMemcpyAsync(b.device_dst, bytes, b.pinned, bytes, ACL_MEMCPY_HOST_TO_DEVICE, b.streams[0]));
+      ACL_CALL(aclrtSynchronizeStream(b.streams[0]));
+      break;
+    case D2H_PINNED_ASYNC:
+      ACL_CALL(aclrtMemcpyAsync(b.pinned, bytes, b.device_src, bytes, ACL_MEMCPY_DEVICE_TO_HOST, b.streams[0]));
+      ACL_CALL(aclrtSynchronizeStream(b.streams[0]));
+      break;
+    case H2D_PINNED_MULTI_STREAM:
+    case D2H_PINNED_MULTI_STREAM: {
+      // split the transfer into one piece per stream
+      const size_t piece = (bytes / num_streams + 63) / 64 * 64;
+      for (int s = 0; s < num_streams && s * piece < bytes; ++s) {
+        const size_t offset = s * piece;
+        const size_t count = std::min(piece, bytes - offset);
+        if (path == H2D_PINNED_MULTI_STREAM) {
+          ACL_CALL(aclrtMemcpyAsync(static_cast<char *>(b.device_dst) + offset, count,
+                                    static_cast<char *>(b.pinned) + offset, count,
+                                    ACL_MEMCPY_HOST_TO_DEVICE, b.streams[s]));
+        } else {
+          ACL_CALL(aclrtMemcpyAsync(static_cast<char *>(b.pinned) + offset, count,
+                                    static_cast<char *>(b.device_src) + offset, count,
+                                    ACL_MEMCPY_DEVICE_TO_HOST, b.streams[s]));
+        }
+      }
+      for (auto stream : b.streams) {
+        ACL_CALL(aclrtSynchronizeStream(stream));
+      }
+      break;
+    }
+    case D2D_MEMCPY:
+      ACL_CALL(aclrtMemcpy(b.device_dst, bytes, b.device_src, bytes, ACL_MEMCPY_DEVICE_TO_DEVICE));
+      break;
+    case D2D_IDENTITY: {
+      const int64_t numel = bytes / sizeof(float);
+      auto desc = aclCreateTensorDesc(ACL_FLOAT, 1, &numel, ACL_FORMAT_ND);
+      auto x = aclCreateDataBuffer(b.device_src, bytes);
+      auto y = aclCreateDataBuffer(b.device_dst, bytes);
+      ACL_CALL(aclopCompileAndExecute("Identity", 1, &desc, &x, 1, &desc, &y,
+                b.attr, ACL_ENGINE_SYS, ACL_COMPILE_SYS, NULL, b.streams[0]));
+      ACL_CALL(aclrtSynchronizeStream(b.streams[0]));
+      ACL_CALL(aclDestroyDataBuffer(x));
+      ACL_CALL(aclDestroyDataBuffer(y));
+      aclDestroyTensorDesc(desc);
+      break;
+    }
+    default:
+      LOG(FATAL) << "unknown path " << path;
+  }
+}
+
+int main(int argc, char* argv[]) {
+  // non-numeric arguments read as 0, checked before max_mb becomes a size_t
+  const int64_t max_mb = argc > 1 ? atoll(argv[1]) : 4096;
+  const std::string csv_file = argc > 2 ? argv[2] : "bandwidth.csv";
+  const int num_streams = argc > 3 ? atoi(argv[3]) : 4;
+  if (max_mb < 1 || num_streams < 1) {
+    LOG(WARNING) << "usage: ./Bench_Bandwidth [max_mb >= 1] [csv_file] [num_streams >= 1]";
+    return 1;
+  }
+  const size_t max_bytes = static_cast<size_t>(max_mb) << 20;
+
+  // Init
+  ACL_CALL(aclInit(nullptr));
+  ACL_CALL(aclrtSetDevice(0));
+
+  Buffers b;
+  b.pageable = new char[max_bytes];
+  std::fill(b.pageable, b.pageable + max_bytes, 1);
+  ACL_CALL(aclrtMallocHost(&b.pinned, max_bytes));
+  std::fill(static_cast<char *>(b.pinned), static_cast<char *>(b.pinned) + max_bytes, 1);
+  ACL_CALL(aclrtMalloc(&b.device_src, max_bytes, ACL_MEM_MALLOC_HUGE_FIRST));
+  ACL_CALL(aclrtMalloc(&b.device_dst, max_bytes, ACL_MEM_MALLOC_HUGE_FIRST));
+  ACL_CALL(aclrtMemset(b.device_src, max_bytes, 0, max_bytes));
+  b.streams.resize(num_streams);
+  for (auto& stream : b.streams) {
+    ACL_CALL(aclrtCreateStream(&stream));
+  }
+  b.attr = aclopCreateAttr();
+
+  std::ofstream csv(csv_file);
+  csv << "path,bytes,iters,avg_ms,gbps\n";
+  std::map<std::string, std::vector<std::pair<size_t, double>>> samples;
+  for (int p = 0; p < NUM_PATHS; ++p) {
+    const Path path = static_cast<Path>(p);
+    for (size_t bytes = 4096; bytes <= max_bytes; bytes *= 4) {
+      // ~256 MB moved per point, at least 3 and at most 100 repeats
+      const int iters = std::max<int>(3, std::min<size_t>(100, (256 << 20) / bytes));
+      Transfer(path, bytes, b); // warm up, compiles Identity once per shape
+      Timer timer;
+      for (int i = 0; i < iters; ++i) {
+        Transfer(path, bytes, b);
+      }
+      const double avg_ms = timer.ElapsedMs() / iters;
+      const double gbps = bytes / (avg_ms * 1e6);
+      csv << kPathNames[p] << "," << bytes << "," << iters << "," << avg_ms << "," << gbps << "\n";
+      samples[kPathNames[p]].emplace_back(bytes, avg_ms);
+    }
+  }
+  std::cout << "measurements written to " << csv_file << std::endl;
+
+  std::map<std::string, BandwidthModel> models;
+  for (const auto& it : samples) {
+    models[it.first] = FitBandwidthModel(it.second);
+    std::cout << std::setw(24) << it.first << " : latency = " << models[it.first].latency_us
+              << " us, bandwidth = " << models[it.first].gbps << " GB/s" << std::endl;
+  }
+  SaveBandwidthModels(models);
+  std::cout << "model written to " << BandwidthModelFile() << std::endl;
+
+  aclopDestroyAttr(b.attr);
+  for (auto stream : b.streams) {
+    ACL_CALL(aclrtDestroyStream(stream));
+  }
+  ACL_CALL(aclrtFree(b.device_src));
+  ACL_CALL(aclrtFree(b.device_dst));
+  ACL_CALL(aclrtFreeHost(b.pinned));
+  delete[] b.pageable;
+
+  // release
+  ACL_CALL(aclrtResetDevice(0));
+  ACL_CALL(aclFinalize());
+
+  return 0;
+}
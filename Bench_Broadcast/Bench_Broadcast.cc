@@ -0,0 +1,149 @@
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include "common/nputensor.h"
+#include "common/memplan.h"
+#include "common/benchmark.h"
+#include "common/compare.h"
+#include "common/ref_broadcast.h"
+
+// BroadcastTo, Expand, Tile and TileWithAxis on the same expansions of a
+// float x to y = {rows, cols}: a column x = {rows, 1} and a row x = {1, cols}.
+// All four write the same y, so their GB/s (x read + y written) compare
+// directly. The CPU reference materializes the stride view of each case
+// (common/ref_broadcast.h) and every device output is checked against it.
+//
+// usage: ./Bench_Broadcast [max_elems] [iters]
+
+struct Expansion {
+  std::string name;
+  std::vector<int64_t> x_dims;
+  std::vector<int64_t> y_dims;
+  int64_t axis;  // the axis that is repeated
+};
+
+struct BroadcastResult {
+  aclError ret = ACL_SUCCESS;
+  double ms = 0;
+  int64_t mismatch = -1;
+};
+
+static BroadcastResult RunDevice(const std::string& op_type, const Expansion& e, const std::vector<float>& x,
+                                 const std::vector<float>& y_ref, int iters, aclrtStream stream) {
+  // shape for BroadcastTo / Expand, multiples for Tile
+  std::vector<int64_t> shape_data = e.y_dims;
+  if (op_type == "Tile") {
+    shape_data = {1, 1};
+    shape_data[e.axis] = e.y_dims[e.axis];
+  }
+  const std::vector<int64_t> shape_dims{2};
+  auto input_x = new npuTensor<float>(ACL_FLOAT, e.x_dims.size(), e.x_dims.data(), ACL_FORMAT_ND, x.data());
+  auto output_y = new npuTensor<float>(ACL_FLOAT, e.y_dims.size(), e.y_dims.data(), ACL_FORMAT_ND, nullptr);
+  std::vector<aclTensorDesc *> input_descs{input_x->desc};
+  std::vector<aclDataBuffer *> input_buffers{input_x->buffer};
+  npuTensor<int64_t>* input_shape = nullptr;
+  auto attr = aclopCreateAttr();
+  if (op_type == "TileWithAxis") {
+    ACL_CALL(aclopSetAttrInt(attr, "axis", e.axis));
+    ACL_CALL(aclopSetAttrInt(attr, "tiles", e.y_dims[e.axis]));
+  } else {
+    input_shape = PlanInput<int64_t>(op_type, 1, ACL_INT64, shape_dims.size(), shape_dims.data(), ACL_FORMAT_ND,
+                                     shape_data.data());
+    input_descs.emplace_back(input_shape->desc);
+    input_buffers.emplace_back(input_shape->buffer);
+  }
+  std::vector<aclTensorDesc *> output_descs{output_y->desc};
+  std::vector<aclDataBuffer *> output_buffers{output_y->buffer};
+
+  BroadcastResult result;
+  auto run = [&] {
+    aclError ret = aclopCompileAndExecute(op_type.c_str(),
+              input_descs.size(), input_descs.data(), input_buffers.data(),
+              output_descs.size(), output_descs.data(), output_buffers.data(),
+              attr, ACL_ENGINE_SYS, ACL_COMPILE_SYS, NULL, stream);
+    return ret != ACL_SUCCESS ? ret : aclrtSynchronizeStream(stream);
+  };
+  // first call compiles
+  result.ret = run();
+  if (result.ret == ACL_SUCCESS) {
+    Timer timer;
+    for (int i = 0; i < iters && result.ret == ACL_SUCCESS; ++i) {
+      result.ret = run();
+    }
+    result.ms = timer.ElapsedMs() / iters;
+    output_y->CopyToHost();
+    result.mismatch = Compare(output_y->data(), y_ref.data(), e.y_dims, Tolerance(), true).first_failure;
+  }
+
+  input_x->Destroy();
+  if (input_shape != nullptr) {
+    input_shape->Destroy();
+  }
+  output_y->Destroy();
+  aclopDestroyAttr(attr);
+  return result;
+}
+
+int main(int argc, char* argv[]) {
+  const int64_t max_elems = argc > 1 ? atoll(argv[1]) : (1 << 26);
+  const int iters = argc > 2 ? atoi(argv[2]) : 5;
+
+  // Init
+  ACL_CALL(aclInit(nullptr));
+  ACL_CALL(aclrtSetDevice(0));
+
+  aclrtStream stream = nullptr;
+  ACL_CALL(aclrtCreateStream(&stream));
+
+  std::cout << "host threads " << NumHostThreads() << std::endl;
+  std::cout << std::setw(8) << "case" << std::setw(16) << "y" << std::setw(14) << "op" << std::setw(12) << "npu_ms"
+            << std::setw(12) << "npu_GB/s" << std::setw(12) << "ref_ms" << std::setw(12) << "ref_GB/s"
+            << "  first_diff" << std::endl;
+  for (int64_t elems = 1 << 12; elems <= max_elems; elems *= 16) {
+    for (int64_t rows = 1 << 2; rows < elems; rows *= 64) {
+      const int64_t cols = elems / rows;
+      const std::vector<Expansion> expansions{{"column", {rows, 1}, {rows, cols}, 1},
+                                              {"row", {1, cols}, {rows, cols}, 0}};
+      for (const auto& e : expansions) {
+        std::vector<float> x(e.x_dims[0] * e.x_dims[1]);
+        std::iota(x.begin(), x.end(), 0);
+        StrideView<float> view;
+        CHECK(BroadcastToView(x.data(), e.x_dims, e.y_dims, &view));
+        std::vector<float> y_ref(view.numel());
+        Timer timer;
+        Materialize(view, y_ref.data());
+        const double ref_ms = timer.ElapsedMs();
+        const double gb = (x.size() + y_ref.size()) * sizeof(float) / 1e6;
+
+        std::stringstream shape;
+        shape << rows << "x" << cols;
+        for (const std::string op_type : {"BroadcastTo", "Expand", "Tile", "TileWithAxis"}) {
+          BroadcastResult npu = RunDevice(op_type, e, x, y_ref, iters, stream);
+          std::cout << std::setw(8) << e.name << std::setw(16) << shape.str() << std::setw(14) << op_type;
+          if (npu.ret != ACL_SUCCESS) {
+            std::cout << std::setw(12) << "error " << npu.ret << std::setw(12) << ref_ms << std::setw(12)
+                      << gb / ref_ms << std::endl;
+            continue;
+          }
+          std::cout << std::setw(12) << npu.ms << std::setw(12) << gb / npu.ms << std::setw(12) << ref_ms
+                    << std::setw(12) << gb / ref_ms;
+          if (npu.mismatch < 0) {
+            std::cout << "  none" << std::endl;
+          } else {
+            std::cout << "  y[" << npu.mismatch / cols << ", " << npu.mismatch % cols << "] ref "
+                      << y_ref[npu.mismatch] << std::endl;
+          }
+        }
+      }
+    }
+  }
+
+  ACL_CALL(aclrtDestroyStream(stream));
+
+  // release
+  ACL_CALL(aclrtResetDevice(0));
+  ACL_CALL(aclFinalize());
+
+  return 0;
+}
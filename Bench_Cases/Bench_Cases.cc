@@ -0,0 +1,151 @@
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "common/nputensor.h"
+#include "common/cmdline.h"
+#include "common/compile_cache.h"
+#include "common/golden_store.h"
+#include "common/opcase.h"
+#include "common/typed_matrix.h"
+
+// Data-driven op cases: each JSON spec (common/opcase.h) names the op, its
+// attributes, the input / output descriptors and tolerances, and refers to
+// .npy or raw files for input data and golden outputs, e.g. tensors captured
+// from a model. Files are memory-mapped and uploaded / compared straight from
+// the mapping, several GB large inputs are never copied into a std::vector.
+// Directories are searched for *.json recursively, all cases run in one
+// process, so cases sharing a kernel compile it once. Specs that fail to
+// parse or whose files do not match are reported and skipped. With `dump`
+// the outputs of each case are saved as <dump>/<spec name>.y<i>.npy.
+//
+// With `store` every case is also checked against a golden regression store
+// (common/golden_store.h) in that directory: the first run records a digest
+// of each output (with `full=1` the whole output too), later runs, e.g.
+// after a CANN upgrade, report each case as same / close / changed by
+// digest, reading a stored full output only when its hash differs.
+// `update=1` re-records changed cases.
+//
+// usage: ./Bench_Cases <spec.json | dir> ... [iters=1] [dump=<dir>] [store=<dir> [full=0] [update=0]]
+
+static bool EndsWith(const std::string& s, const std::string& suffix) {
+  return s.size() > suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+static bool IsDir(const std::string& path) {
+  struct stat st;
+  return stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+// *.json below `dir`, sorted
+static void ListSpecs(const std::string& dir, std::vector<std::string>* specs) {
+  DIR* d = opendir(dir.c_str());
+  if (d == nullptr) {
+    LOG(WARNING) << "cannot open " << dir;
+    return;
+  }
+  std::vector<std::string> names;
+  while (dirent* e = readdir(d)) {
+    const std::string name = e->d_name;
+    if (name != "." && name != "..") {
+      names.push_back(name);
+    }
+  }
+  closedir(d);
+  std::sort(names.begin(), names.end());
+  for (const auto& name : names) {
+    const std::string path = dir + (dir.back() == '/' ? "" : "/") + name;
+    if (IsDir(path)) {
+      ListSpecs(path, specs);
+    } else if (EndsWith(name, ".json")) {
+      specs->push_back(path);
+    }
+  }
+}
+
+int main(int argc, char* argv[]) {
+  CaseParams params;
+  std::vector<std::string> specs;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    const size_t eq = arg.find('=');
+    if (eq != std::string::npos) {
+      params.Set(arg.substr(0, eq), arg.substr(eq + 1));
+    } else if (IsDir(arg)) {
+      ListSpecs(arg, &specs);
+    } else {
+      specs.push_back(arg);
+    }
+  }
+  const int iters = params.Int("iters", 1);
+  const std::string dump = params.Get("dump", "");
+  const std::string store_dir = params.Get("store", "");
+  GoldenStore* store = nullptr;
+  if (!store_dir.empty()) {
+    store = new GoldenStore(store_dir, params.Bool("full", false), params.Bool("update", false));
+  }
+  for (const auto& key : params.Unused()) {
+    LOG(WARNING) << "unused parameter " << key;
+  }
+
+  // Init
+  ACL_CALL(aclInit(nullptr));
+  ACL_CALL(aclrtSetDevice(0));
+
+  aclrtStream stream = nullptr;
+  ACL_CALL(aclrtCreateStream(&stream));
+
+  MatrixTable table;
+  CompileCounter kernels;
+  int skipped = 0;
+  for (const auto& spec : specs) {
+    OpCase c;
+    std::string error;
+    if (!OpCase::FromJson(spec, &c, &error) || !c.CheckFiles(&error)) {
+      std::cout << "skipped " << error << std::endl;
+      ++skipped;
+      continue;
+    }
+    OpCaseRun run(c);
+    kernels.Add(run.Key());
+    MatrixCell cell = run.Time(iters, stream);
+    cell.config = spec;
+    if (store != nullptr && cell.supported()) {
+      cell.golden = GoldenStatusName(run.CheckGolden(store, spec));
+    }
+    table.Add(cell);
+    if (!dump.empty()) {
+      std::string name = spec.substr(spec.rfind('/') + 1);
+      if (EndsWith(name, ".json")) {
+        name.resize(name.size() - 5);
+      }
+      run.SaveOutputs(dump + "/" + name);
+    }
+  }
+
+  std::cout << std::endl;
+  table.Print();
+  int failed = 0;
+  for (const auto& cell : table.cells()) {
+    failed += (cell.reference && !cell.verified) || !cell.supported() || cell.golden == "changed";
+  }
+  std::cout << specs.size() << " cases, " << kernels.count() << " distinct kernels, " << failed << " failed, "
+            << skipped << " skipped" << std::endl;
+  if (store != nullptr) {
+    store->Save();
+    std::cout << "golden store " << store->dir() << ": " << store->size() << " outputs" << std::endl;
+    delete store;
+  }
+
+  ACL_CALL(aclrtDestroyStream(stream));
+
+  // release
+  ACL_CALL(aclrtResetDevice(0));
+  ACL_CALL(aclFinalize());
+
+  return failed + skipped > 0 ? 1 : 0;
+}
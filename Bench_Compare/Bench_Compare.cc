@@ -0,0 +1,95 @@
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "common/benchmark.h"
+#include "common/compare.h"
+#include "common/float16.h"
+#include "common/parallel.h"
+#include "common/random.h"
+
+// Host Compare() (common/compare.h): first the NaN / Inf / integer rules on
+// single pairs, each case with the failure count it must report, then the
+// time to verify n float outputs (default 100M) against a reference that
+// differs by a few ulp. Host only, exits non-zero when a rule case fails.
+//
+// usage: ./Bench_Compare [n] [iters]
+
+namespace {
+
+const float kInf = std::numeric_limits<float>::infinity();
+const float kNaN = std::numeric_limits<float>::quiet_NaN();
+
+template <typename T>
+bool Case(const std::string& name, T actual, T expected, const Tolerance& tol, int64_t want) {
+  const CompareReport report = Compare(&actual, &expected, {1}, tol);
+  const bool ok = report.failures == want;
+  std::cout << std::setw(36) << std::left << name << std::right << std::setw(10) << report.failures
+            << std::setw(10) << want << std::setw(6) << (ok ? "ok" : "FAIL") << std::endl;
+  return ok;
+}
+
+bool Rules() {
+  const Tolerance rel = Tolerance::For(ACL_FLOAT);
+  Tolerance nan_unequal = rel;
+  nan_unequal.nan_equal = false;
+  std::cout << std::setw(36) << std::left << "case" << std::right << std::setw(10) << "failures" << std::setw(10)
+            << "expected" << std::endl;
+  bool ok = true;
+  ok &= Case("fp32 1 vs +inf", 1.0f, kInf, rel, 1);
+  ok &= Case("fp32 -inf vs +inf", -kInf, kInf, rel, 1);
+  ok &= Case("fp32 nan vs +inf", kNaN, kInf, rel, 1);
+  ok &= Case("fp32 +inf vs 1", kInf, 1.0f, rel, 1);
+  ok &= Case("fp32 +inf vs +inf", kInf, kInf, rel, 0);
+  ok &= Case("fp32 -inf vs -inf", -kInf, -kInf, rel, 0);
+  ok &= Case("fp32 nan vs nan", kNaN, kNaN, rel, 0);
+  ok &= Case("fp32 nan vs nan, nan_equal off", kNaN, kNaN, nan_unequal, 1);
+  ok &= Case("fp32 nan vs 1", kNaN, 1.0f, rel, 1);
+  ok &= Case("fp32 1 + 1e-6 vs 1", 1.000001f, 1.0f, rel, 0);
+  ok &= Case("fp32 1.001 vs 1", 1.001f, 1.0f, rel, 1);
+  ok &= Case("fp16 1 vs +inf", float16(1.0f), float16(kInf), Tolerance::For(ACL_FLOAT16), 1);
+  ok &= Case("fp16 +inf vs +inf", float16(kInf), float16(kInf), Tolerance::For(ACL_FLOAT16), 0);
+  ok &= Case("int64 2^53 + 1 vs 2^53", (int64_t(1) << 53) + 1, int64_t(1) << 53, Tolerance::Exact(), 1);
+  ok &= Case("int64 max vs min", std::numeric_limits<int64_t>::max(), std::numeric_limits<int64_t>::min(),
+             Tolerance::Exact(), 1);
+  ok &= Case("bool true vs false", true, false, Tolerance::Exact(), 1);
+  return ok;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  const int64_t n = argc > 1 ? atoll(argv[1]) : 100000000;
+  const int iters = argc > 2 ? atoi(argv[2]) : 5;
+  if (n < 1 || iters < 1) {
+    LOG(WARNING) << "usage: ./Bench_Compare [n >= 1] [iters >= 1]";
+    return 1;
+  }
+
+  const bool rules_ok = Rules();
+
+  // reference uniform in [-1, 1), actual a few ulp away and one element off
+  std::vector<float> expected(n);
+  std::vector<float> actual(n);
+  RandomUniform(expected.data(), n, -1.0, 1.0, 0);
+  for (int64_t i = 0; i < n; ++i) {
+    actual[i] = std::nextafter(std::nextafter(expected[i], 2.0f), 2.0f);
+  }
+  actual[n / 2] += 1.0f;
+  const std::vector<int64_t> dims{n};
+  const Tolerance tol = Tolerance::For(ACL_FLOAT);
+
+  CompareReport report = Compare(actual.data(), expected.data(), dims, tol);
+  Timer timer;
+  for (int i = 0; i < iters; ++i) {
+    report = Compare(actual.data(), expected.data(), dims, tol);
+  }
+  const double ms = timer.ElapsedMs() / iters;
+  std::cout << "threads " << NumHostThreads() << ", " << n << " fp32 elements: " << ms << " ms, "
+            << 2 * n * sizeof(float) / (ms * 1e6) << " GB/s, " << report.failures << " failures (expected 1)"
+            << std::endl;
+  return rules_ok && report.failures == 1 ? 0 : 1;
+}
@@ -0,0 +1,152 @@
+#include <functional>
+#include <iostream>
+#include <vector>
+
+#include "common/nputensor.h"
+#include "common/memplan.h"
+#include "common/compile_bench.h"
+#include "common/compile_cache.h"
+#include "common/benchmark.h"
+
+// Compile count and latency of shape/axis-like inputs placed on device vs on
+// host as const (PlanInput), for Resize, ReduceSum, Range and
+// StridedSliceAssign over a sweep of input values. "compiles" is measured
+// from the first-call vs cached latency (common/compile_bench.h), "predicted"
+// is the number of distinct CompileKeys.
+//
+// usage: ./Bench_ConstInputs [repeats]
+
+struct SweepStats : CompileStats {
+  void Add(OpCall& call, bool const_inputs, CompileCounter& counter, aclrtStream stream) {
+    const bool new_key = counter.Add(CompileKey(call.op_type, call.input_descs, call.input_buffers,
+                                                call.output_descs, "", const_inputs));
+    CompileStats::Add([&] { return call.Execute(stream); }, new_key);
+  }
+};
+
+typedef std::function<void(bool, CompileCounter&, SweepStats&, aclrtStream)> Sweep;
+
+static void SweepReduceSum(bool const_inputs, CompileCounter& counter, SweepStats& stats, aclrtStream stream) {
+  const std::string op_type = "ReduceSum";
+  const std::vector<int64_t> x_dims{8, 8, 8, 8};
+  const std::vector<float> x_data(8 * 8 * 8 * 8, 1);
+  const std::vector<int64_t> a_dims{1};
+  for (int64_t axis = 0; axis < 4; ++axis) {
+    const std::vector<int64_t> axes{axis};
+    std::vector<int64_t> y_dims = x_dims;
+    y_dims[axis] = 1;
+    OpCall call(op_type);
+    call.Input(PlanInput<float>(op_type, 0, ACL_FLOAT, x_dims.size(), x_dims.data(), ACL_FORMAT_ND, x_data.data(), const_inputs));
+    call.Input(PlanInput<int64_t>(op_type, 1, ACL_INT64, a_dims.size(), a_dims.data(), ACL_FORMAT_ND, axes.data(), const_inputs));
+    call.Output(new npuTensor<float>(ACL_FLOAT, y_dims.size(), y_dims.data(), ACL_FORMAT_ND, nullptr));
+    ACL_CALL(aclopSetAttrBool(call.attr, "keep_dims", true));
+    stats.Add(call, const_inputs, counter, stream);
+  }
+}
+
+static void SweepRange(bool const_inputs, CompileCounter& counter, SweepStats& stats, aclrtStream stream) {
+  const std::string op_type = "Range";
+  const std::vector<int64_t> dims{1};
+  const std::vector<float> start{0};
+  const std::vector<float> delta{1};
+  for (float limit : {8.0f, 16.0f, 32.0f}) {
+    const std::vector<float> limit_data{limit};
+    const std::vector<int64_t> y_dims{static_cast<int64_t>(limit)};
+    OpCall call(op_type);
+    call.Input(PlanInput<float>(op_type, 0, ACL_FLOAT, dims.size(), dims.data(), ACL_FORMAT_ND, start.data(), const_inputs));
+    call.Input(PlanInput<float>(op_type, 1, ACL_FLOAT, dims.size(), dims.data(), ACL_FORMAT_ND, limit_data.data(), const_inputs));
+    call.Input(PlanInput<float>(op_type, 2, ACL_FLOAT, dims.size(), dims.data(), ACL_FORMAT_ND, delta.data(), const_inputs));
+    call.Output(new npuTensor<float>(ACL_FLOAT, y_dims.size(), y_dims.data(), ACL_FORMAT_ND, nullptr));
+    stats.Add(call, const_inputs, counter, stream);
+  }
+}
+
+static void SweepStridedSliceAssign(bool const_inputs, CompileCounter& counter, SweepStats& stats, aclrtStream stream) {
+  const std::string op_type = "StridedSliceAssign";
+  const std::vector<int64_t> var_dims{16, 16};
+  const std::vector<float> var_data(16 * 16, 1);
+  const std::vector<int64_t> value_dims{4, 4};
+  const std::vector<float> value_data(4 * 4, 2);
+  const std::vector<int64_t> index_dims{2};
+  const std::vector<int64_t> stride_data{1, 1};
+  // same shapes, only the slice position changes
+  for (int64_t offset = 0; offset < 16; offset += 4) {
+    const std::vector<int64_t> begin_data{offset, offset};
+    const std::vector<int64_t> end_data{offset + 4, offset + 4};
+    OpCall call(op_type);
+    call.Input(PlanInput<float>(op_type, 0, ACL_FLOAT, var_dims.size(), var_dims.data(), ACL_FORMAT_ND, var_data.data(), const_inputs));
+    call.Input(PlanInput<float>(op_type, 1, ACL_FLOAT, value_dims.size(), value_dims.data(), ACL_FORMAT_ND, value_data.data(), const_inputs));
+    call.Input(PlanInput<int64_t>(op_type, 2, ACL_INT64, index_dims.size(), index_dims.data(), ACL_FORMAT_ND, begin_data.data(), const_inputs));
+    call.Input(PlanInput<int64_t>(op_type, 3, ACL_INT64, index_dims.size(), index_dims.data(), ACL_FORMAT_ND, end_data.data(), const_inputs));
+    call.Input(PlanInput<int64_t>(op_type, 4, ACL_INT64, index_dims.size(), index_dims.data(), ACL_FORMAT_ND, stride_data.data(), const_inputs));
+    call.Output(new npuTensor<float>(ACL_FLOAT, var_dims.size(), var_dims.data(), ACL_FORMAT_ND, nullptr));
+    stats.Add(call, const_inputs, counter, stream);
+  }
+}
+
+static void SweepResize(bool const_inputs, CompileCounter& counter, SweepStats& stats, aclrtStream stream) {
+  const std::string op_type = "Resize";
+  const std::vector<int64_t> x_dims{1, 1, 4, 4};
+  std::vector<float> x_data(16);
+  std::iota(x_data.begin(), x_data.end(), 0);
+  const std::vector<int64_t> roi_dims{2};
+  const std::vector<float> roi_data{0, 1};
+  const std::vector<int64_t> pair_dims{2};
+  for (int64_t size : {6, 8, 12}) {
+    const std::vector<float> scales_data{size / 4.0f, size / 4.0f};
+    const std::vector<int64_t> sizes_data{size, size};
+    const std::vector<int64_t> y_dims{1, 1, size, size};
+    OpCall call(op_type);
+    call.Input(PlanInput<float>(op_type, 0, ACL_FLOAT, x_dims.size(), x_dims.data(), ACL_FORMAT_NCHW, x_data.data(), const_inputs));
+    call.Input(PlanInput<float>(op_type, 1, ACL_FLOAT, roi_dims.size(), roi_dims.data(), ACL_FORMAT_ND, roi_data.data(), const_inputs));
+    call.Input(PlanInput<float>(op_type, 2, ACL_FLOAT, pair_dims.size(), pair_dims.data(), ACL_FORMAT_ND, scales_data.data(), const_inputs));
+    call.Input(PlanInput<int64_t>(op_type, 3, ACL_INT64, pair_dims.size(), pair_dims.data(), ACL_FORMAT_ND, sizes_data.data(), const_inputs));
+    call.Output(new npuTensor<float>(ACL_FLOAT, y_dims.size(), y_dims.data(), ACL_FORMAT_NCHW, nullptr));
+    ACL_CALL(aclopSetAttrString(call.attr, "coordinate_transformation_mode", "pytorch_half_pixel"));
+    ACL_CALL(aclopSetAttrString(call.attr, "mode", "nearest"));
+    ACL_CALL(aclopSetAttrString(call.attr, "nearest_mode", "floor"));
+    stats.Add(call, const_inputs, counter, stream);
+  }
+}
+
+int main(int argc, char* argv[]) {
+  const int repeats = argc > 1 ? atoi(argv[1]) : 3;
+
+  // Init
+  ACL_CALL(aclInit(nullptr));
+  ACL_CALL(aclrtSetDevice(0));
+
+  aclrtStream stream = nullptr;
+  ACL_CALL(aclrtCreateStream(&stream));
+
+  const std::vector<std::pair<std::string, Sweep>> sweeps{
+    {"Resize", SweepResize},
+    {"ReduceSum", SweepReduceSum},
+    {"Range", SweepRange},
+    {"StridedSliceAssign", SweepStridedSliceAssign},
+  };
+  std::cout << std::setw(20) << "op" << std::setw(8) << "inputs" << std::setw(8) << "calls" << std::setw(8) << "errors"
+            << std::setw(10) << "compiles" << std::setw(11) << "predicted" << std::setw(14) << "compile_ms"
+            << std::setw(14) << "cached_ms" << std::endl;
+  for (const auto& sweep : sweeps) {
+    for (bool const_inputs : {false, true}) {
+      CompileCounter counter;
+      SweepStats stats;
+      for (int r = 0; r < repeats; ++r) {
+        sweep.second(const_inputs, counter, stats, stream);
+      }
+      std::cout << std::setw(20) << sweep.first << std::setw(8) << (const_inputs ? "const" : "device")
+                << std::setw(8) << stats.calls << std::setw(8) << stats.errors << std::setw(10) << stats.compiles
+                << std::setw(11) << stats.predicted << std::setw(14) << stats.avg_compile_ms()
+                << std::setw(14) << stats.avg_cached_ms() << std::endl;
+    }
+  }
+
+  ACL_CALL(aclrtDestroyStream(stream));
+
+  // release
+  ACL_CALL(aclrtResetDevice(0));
+  ACL_CALL(aclFinalize());
+
+  return 0;
+}
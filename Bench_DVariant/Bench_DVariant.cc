@@ -0,0 +1,187 @@
+#include <functional>
+#include <iostream>
+#include <numeric>
+#include <vector>
+
+#include "common/nputensor.h"
+#include "common/memplan.h"
+#include "common/compile_bench.h"
+#include "common/compile_cache.h"
+#include "common/dispatch.h"
+#include "common/benchmark.h"
+
+// Compile count and latency of the tensor form of an op with its shape-like
+// inputs on device, the tensor form with them on host as const, and
+// DispatchCall, which switches to the static-attribute "D" variant when it
+// can. BroadcastTo is swept with DT_FLOAT and DT_INT64, the latter has no D
+// variant and must stay on the tensor form. "compiles" is measured from the
+// first-call vs cached latency (common/compile_bench.h), "predicted" is the
+// number of distinct compile keys.
+//
+// usage: ./Bench_DVariant [repeats]
+
+typedef enum {
+  MODE_DEVICE = 0,
+  MODE_CONST = 1,
+  MODE_DISPATCH = 2,
+} dispatchMode;
+
+static const char* ModeName(dispatchMode mode) {
+  return mode == MODE_DEVICE ? "device" : mode == MODE_CONST ? "const" : "dispatch";
+}
+
+// DispatchCall plus the tensors it uses, destroyed with the call
+class BenchCall : public TensorOwner {
+ public:
+  BenchCall(const std::string& op_type, dispatchMode mode, DispatchCall::AttrSetter set_attrs = nullptr)
+      : op_type(op_type), mode(mode), call(op_type, set_attrs, mode == MODE_DISPATCH) {}
+
+  template <typename T>
+  void Input(int index, aclDataType dataType, const std::vector<int64_t>& dims, aclFormat format, const T* ptr) {
+    call.Input(Own(PlanInput<T>(op_type, index, dataType, dims.size(), dims.data(), format, ptr, mode != MODE_DEVICE)));
+  }
+
+  template <typename T>
+  void Output(aclDataType dataType, const std::vector<int64_t>& dims, aclFormat format) {
+    call.Output(Own(new npuTensor<T>(dataType, dims.size(), dims.data(), format, nullptr)));
+  }
+
+  std::string op_type;
+  dispatchMode mode;
+  DispatchCall call;
+};
+
+struct SweepStats : CompileStats {
+  int d_calls = 0;
+
+  void Add(BenchCall& bench, CompileCounter& counter, aclrtStream stream) {
+    if (bench.call.Selected() != bench.op_type) {
+      ++d_calls;
+    }
+    CompileStats::Add([&] {
+      const aclError ret = bench.call.Execute(stream);
+      return ret != ACL_SUCCESS ? ret : aclrtSynchronizeStream(stream);
+    }, counter.Add(bench.call.Key()));
+  }
+};
+
+typedef std::function<void(dispatchMode, CompileCounter&, SweepStats&, aclrtStream)> Sweep;
+
+static void SweepReduceSum(dispatchMode mode, CompileCounter& counter, SweepStats& stats, aclrtStream stream) {
+  const std::vector<int64_t> x_dims{8, 8, 8, 8};
+  const std::vector<float> x_data(8 * 8 * 8 * 8, 1);
+  for (int64_t axis = 0; axis < 4; ++axis) {
+    const std::vector<int64_t> axes{axis};
+    std::vector<int64_t> y_dims = x_dims;
+    y_dims[axis] = 1;
+    BenchCall bench("ReduceSum", mode, [](aclopAttr* attr) { ACL_CALL(aclopSetAttrBool(attr, "keep_dims", true)); });
+    bench.Input<float>(0, ACL_FLOAT, x_dims, ACL_FORMAT_ND, x_data.data());
+    bench.Input<int64_t>(1, ACL_INT64, {1}, ACL_FORMAT_ND, axes.data());
+    bench.Output<float>(ACL_FLOAT, y_dims, ACL_FORMAT_ND);
+    stats.Add(bench, counter, stream);
+  }
+}
+
+template <typename T>
+static void SweepBroadcastTo(aclDataType dataType, dispatchMode mode, CompileCounter& counter, SweepStats& stats,
+                             aclrtStream stream) {
+  const std::vector<int64_t> x_dims{1, 8};
+  const std::vector<T> x_data(8, 1);
+  for (int64_t rows : {2, 4, 8}) {
+    const std::vector<int64_t> shape{rows, 8};
+    BenchCall bench("BroadcastTo", mode);
+    bench.Input<T>(0, dataType, x_dims, ACL_FORMAT_ND, x_data.data());
+    bench.Input<int64_t>(1, ACL_INT64, {2}, ACL_FORMAT_ND, shape.data());
+    bench.Output<T>(dataType, shape, ACL_FORMAT_ND);
+    stats.Add(bench, counter, stream);
+  }
+}
+
+static void SweepStridedSliceAssign(dispatchMode mode, CompileCounter& counter, SweepStats& stats, aclrtStream stream) {
+  const std::vector<int64_t> var_dims{16, 16};
+  const std::vector<float> var_data(16 * 16, 1);
+  const std::vector<int64_t> value_dims{4, 4};
+  const std::vector<float> value_data(4 * 4, 2);
+  const std::vector<int64_t> stride_data{1, 1};
+  for (int64_t offset = 0; offset < 16; offset += 4) {
+    const std::vector<int64_t> begin_data{offset, offset};
+    const std::vector<int64_t> end_data{offset + 4, offset + 4};
+    BenchCall bench("StridedSliceAssign", mode);
+    bench.Input<float>(0, ACL_FLOAT, var_dims, ACL_FORMAT_ND, var_data.data());
+    bench.Input<float>(1, ACL_FLOAT, value_dims, ACL_FORMAT_ND, value_data.data());
+    bench.Input<int64_t>(2, ACL_INT64, {2}, ACL_FORMAT_ND, begin_data.data());
+    bench.Input<int64_t>(3, ACL_INT64, {2}, ACL_FORMAT_ND, end_data.data());
+    bench.Input<int64_t>(4, ACL_INT64, {2}, ACL_FORMAT_ND, stride_data.data());
+    bench.Output<float>(ACL_FLOAT, var_dims, ACL_FORMAT_ND);
+    stats.Add(bench, counter, stream);
+  }
+}
+
+static void SweepResize(dispatchMode mode, CompileCounter& counter, SweepStats& stats, aclrtStream stream) {
+  const std::vector<int64_t> x_dims{1, 1, 4, 4};
+  std::vector<float> x_data(16);
+  std::iota(x_data.begin(), x_data.end(), 0);
+  const std::vector<float> roi_data{0, 1};
+  for (int64_t size : {6, 8, 12}) {
+    const std::vector<float> scales_data{size / 4.0f, size / 4.0f};
+    const std::vector<int64_t> sizes_data{size, size};
+    BenchCall bench("Resize", mode, [](aclopAttr* attr) {
+      ACL_CALL(aclopSetAttrString(attr, "coordinate_transformation_mode", "pytorch_half_pixel"));
+      ACL_CALL(aclopSetAttrString(attr, "mode", "nearest"));
+      ACL_CALL(aclopSetAttrString(attr, "nearest_mode", "floor"));
+    });
+    bench.Input<float>(0, ACL_FLOAT, x_dims, ACL_FORMAT_NCHW, x_data.data());
+    bench.Input<float>(1, ACL_FLOAT, {2}, ACL_FORMAT_ND, roi_data.data());
+    bench.Input<float>(2, ACL_FLOAT, {2}, ACL_FORMAT_ND, scales_data.data());
+    bench.Input<int64_t>(3, ACL_INT64, {2}, ACL_FORMAT_ND, sizes_data.data());
+    bench.Output<float>(ACL_FLOAT, {1, 1, size, size}, ACL_FORMAT_NCHW);
+    stats.Add(bench, counter, stream);
+  }
+}
+
+int main(int argc, char* argv[]) {
+  const int repeats = argc > 1 ? atoi(argv[1]) : 3;
+
+  // Init
+  ACL_CALL(aclInit(nullptr));
+  ACL_CALL(aclrtSetDevice(0));
+
+  aclrtStream stream = nullptr;
+  ACL_CALL(aclrtCreateStream(&stream));
+
+  const std::vector<std::pair<std::string, Sweep>> sweeps{
+    {"ReduceSum", SweepReduceSum},
+    {"BroadcastTo(f32)", [](dispatchMode mode, CompileCounter& counter, SweepStats& stats, aclrtStream stream) {
+       SweepBroadcastTo<float>(ACL_FLOAT, mode, counter, stats, stream);
+     }},
+    {"BroadcastTo(i64)", [](dispatchMode mode, CompileCounter& counter, SweepStats& stats, aclrtStream stream) {
+       SweepBroadcastTo<int64_t>(ACL_INT64, mode, counter, stats, stream);
+     }},
+    {"StridedSliceAssign", SweepStridedSliceAssign},
+    {"Resize", SweepResize},
+  };
+  std::cout << std::setw(20) << "op" << std::setw(10) << "mode" << std::setw(8) << "calls" << std::setw(8) << "d_calls"
+            << std::setw(8) << "errors" << std::setw(10) << "compiles" << std::setw(11) << "predicted"
+            << std::setw(14) << "compile_ms" << std::setw(14) << "cached_ms" << std::endl;
+  for (const auto& sweep : sweeps) {
+    for (dispatchMode mode : {MODE_DEVICE, MODE_CONST, MODE_DISPATCH}) {
+      CompileCounter counter;
+      SweepStats stats;
+      for (int r = 0; r < repeats; ++r) {
+        sweep.second(mode, counter, stats, stream);
+      }
+      std::cout << std::setw(20) << sweep.first << std::setw(10) << ModeName(mode)
+                << std::setw(8) << stats.calls << std::setw(8) << stats.d_calls << std::setw(8) << stats.errors
+                << std::setw(10) << stats.compiles << std::setw(11) << stats.predicted
+                << std::setw(14) << stats.avg_compile_ms() << std::setw(14) << stats.avg_cached_ms() << std::endl;
+    }
+  }
+
+  ACL_CALL(aclrtDestroyStream(stream));
+
+  // release
+  ACL_CALL(aclrtResetDevice(0));
+  ACL_CALL(aclFinalize());
+
+  return 0;
+}
@@ -0,0 +1,150 @@
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "common/nputensor.h"
+#include "common/benchmark.h"
+#include "common/compare.h"
+#include "common/ref_deformable_offsets.h"
+
+// DeformableOffsets on x = {N, C, H, W} over kernel size, deformable_groups
+// and the magnitude of random offsets (uniform in [-mag, mag], masks in
+// [0, 1]): device latency and max abs error against the CPU reference
+// (common/ref_deformable_offsets.h). Pads keep Ho = H / stride. Large
+// offsets push samples off the input, which exercises the border handling.
+//
+// usage: ./Bench_DeformableOffsets [N] [C] [H] [W] [stride] [dilation] [iters]
+
+struct DeviceResult {
+  aclError ret = ACL_SUCCESS;
+  double ms = 0;
+  std::vector<float> y;
+};
+
+static DeviceResult RunDevice(const std::vector<float>& x, const std::vector<int64_t>& x_dims,
+                              const std::vector<float>& offsets, const DeformableOffsetsParams& params, int iters,
+                              aclrtStream stream) {
+  const std::string op_type = "DeformableOffsets";
+  const std::vector<int64_t> offset_dims = DeformableOffsetsOffsetDims(x_dims, params);
+  const std::vector<int64_t> y_dims = DeformableOffsetsOutputDims(x_dims, params);
+  auto input_x = new npuTensor<float>(ACL_FLOAT, x_dims.size(), x_dims.data(), ACL_FORMAT_NCHW, x.data());
+  auto input_offset = new npuTensor<float>(ACL_FLOAT, offset_dims.size(), offset_dims.data(), ACL_FORMAT_NCHW, offsets.data());
+  auto output_y = new npuTensor<float>(ACL_FLOAT, y_dims.size(), y_dims.data(), ACL_FORMAT_NCHW, nullptr);
+  std::vector<aclTensorDesc *> input_descs{input_x->desc, input_offset->desc};
+  std::vector<aclDataBuffer *> input_buffers{input_x->buffer, input_offset->buffer};
+  std::vector<aclTensorDesc *> output_descs{output_y->desc};
+  std::vector<aclDataBuffer *> output_buffers{output_y->buffer};
+  auto attr = aclopCreateAttr();
+  ACL_CALL(aclopSetAttrListInt(attr, "ksize", params.ksize.size(), params.ksize.data()));
+  ACL_CALL(aclopSetAttrListInt(attr, "strides", params.strides.size(), params.strides.data()));
+  ACL_CALL(aclopSetAttrListInt(attr, "pads", params.pads.size(), params.pads.data()));
+  ACL_CALL(aclopSetAttrListInt(attr, "dilations", params.dilations.size(), params.dilations.data()));
+  ACL_CALL(aclopSetAttrInt(attr, "deformable_groups", params.deformable_groups));
+  ACL_CALL(aclopSetAttrString(attr, "data_format", "NCHW"));
+  ACL_CALL(aclopSetAttrBool(attr, "modulated", params.modulated));
+
+  DeviceResult result;
+  auto run = [&] {
+    aclError ret = aclopCompileAndExecute(op_type.c_str(),
+              input_descs.size(), input_descs.data(), input_buffers.data(),
+              output_descs.size(), output_descs.data(), output_buffers.data(),
+              attr, ACL_ENGINE_SYS, ACL_COMPILE_SYS, NULL, stream);
+    return ret != ACL_SUCCESS ? ret : aclrtSynchronizeStream(stream);
+  };
+  // first call compiles
+  result.ret = run();
+  if (result.ret == ACL_SUCCESS) {
+    Timer timer;
+    for (int i = 0; i < iters && result.ret == ACL_SUCCESS; ++i) {
+      result.ret = run();
+    }
+    result.ms = timer.ElapsedMs() / iters;
+    output_y->CopyToHost();
+    result.y.assign(output_y->data(), output_y->data() + output_y->size / sizeof(float));
+  }
+
+  input_x->Destroy();
+  input_offset->Destroy();
+  output_y->Destroy();
+  aclopDestroyAttr(attr);
+  return result;
+}
+
+int main(int argc, char* argv[]) {
+  const int64_t N = argc > 1 ? atoll(argv[1]) : 2;
+  const int64_t C = argc > 2 ? atoll(argv[2]) : 64;
+  const int64_t H = argc > 3 ? atoll(argv[3]) : 64;
+  const int64_t W = argc > 4 ? atoll(argv[4]) : 64;
+  const int64_t stride = argc > 5 ? atoll(argv[5]) : 1;
+  const int64_t dilation = argc > 6 ? atoll(argv[6]) : 1;
+  const int iters = argc > 7 ? atoi(argv[7]) : 5;
+
+  // Init
+  ACL_CALL(aclInit(nullptr));
+  ACL_CALL(aclrtSetDevice(0));
+
+  aclrtStream stream = nullptr;
+  ACL_CALL(aclrtCreateStream(&stream));
+
+  std::mt19937 gen(0);
+  const std::vector<int64_t> x_dims{N, C, H, W};
+  std::vector<float> x(N * C * H * W);
+  std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+  for (auto& v : x) v = unit(gen);
+
+  std::cout << "x " << N << "x" << C << "x" << H << "x" << W << ", stride " << stride << ", dilation " << dilation
+            << ", host threads " << NumHostThreads() << std::endl;
+  std::cout << std::setw(6) << "ksize" << std::setw(8) << "groups" << std::setw(8) << "offset" << std::setw(12)
+            << "npu_ms" << std::setw(12) << "ref_ms" << std::setw(12) << "max_err" << std::endl;
+  for (const int64_t k : {1, 3, 5, 7}) {
+    for (const int64_t groups : {1, 2, 4, 8}) {
+      if (C % groups != 0) {
+        continue;
+      }
+      for (const float mag : {0.0f, 0.5f, 4.0f, 32.0f}) {
+        DeformableOffsetsParams params;
+        params.ksize = {k, k};
+        params.strides = {1, 1, stride, stride};
+        const int64_t pad = dilation * (k - 1) / 2;
+        params.pads = {pad, pad, pad, pad};
+        params.dilations = {1, 1, dilation, dilation};
+        params.deformable_groups = groups;
+        params.modulated = true;
+        const std::vector<int64_t> offset_dims = DeformableOffsetsOffsetDims(x_dims, params);
+        const int64_t block = groups * k * k * offset_dims[2] * offset_dims[3];
+        std::vector<float> offsets(N * 3 * block);
+        std::uniform_real_distribution<float> offset(-mag, mag);
+        std::uniform_real_distribution<float> mask(0.0f, 1.0f);
+        for (int64_t n = 0; n < N; ++n) {
+          float* off = offsets.data() + n * 3 * block;
+          for (int64_t i = 0; i < 2 * block; ++i) off[i] = offset(gen);
+          for (int64_t i = 2 * block; i < 3 * block; ++i) off[i] = mask(gen);
+        }
+
+        const std::vector<int64_t> y_dims = DeformableOffsetsOutputDims(x_dims, params);
+        std::vector<float> y_ref(y_dims[0] * y_dims[1] * y_dims[2] * y_dims[3]);
+        Timer timer;
+        RefDeformableOffsets(x.data(), x_dims, offsets.data(), params, y_ref.data());
+        const double ref_ms = timer.ElapsedMs();
+
+        DeviceResult npu = RunDevice(x, x_dims, offsets, params, iters, stream);
+        std::cout << std::setw(6) << k << std::setw(8) << groups << std::setw(8) << mag;
+        if (npu.ret != ACL_SUCCESS) {
+          std::cout << std::setw(12) << "error " << npu.ret << std::setw(12) << ref_ms << std::endl;
+          continue;
+        }
+        const CompareReport report = Compare(npu.y.data(), y_ref.data(), y_dims);
+        std::cout << std::setw(12) << npu.ms << std::setw(12) << ref_ms << std::setw(12) << report.max_abs_err
+                  << std::endl;
+      }
+    }
+  }
+
+  ACL_CALL(aclrtDestroyStream(stream));
+
+  // release
+  ACL_CALL(aclrtResetDevice(0));
+  ACL_CALL(aclFinalize());
+
+  return 0;
+}
@@ -0,0 +1,116 @@
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "common/nputensor.h"
+#include "common/benchmark.h"
+#include "common/compare.h"
+#include "common/device_compare.h"
+
+// Result verification cost over float outputs of 1 MB .. max_mb (default
+// 4 GB): downloading the output and comparing on host (CopyToHost +
+// Compare, the golden tensor already on host) vs DeviceCompare against a
+// golden tensor on device, which only copies back a few scalars per chunk
+// (a DeviceComparer, its scratch allocated before the timed calls).
+// Both sides are filled with zeros and one element of the output is set to
+// 1, so both paths must report 1 failure and max abs err 1. Sizes that do
+// not fit in free device memory are skipped, the host path needs 2x the size
+// in host memory.
+//
+// usage: ./Bench_DeviceCompare [max_mb] [iters]
+
+struct Timing {
+  double download_ms = 0;
+  double host_cmp_ms = 0;
+  double device_ms = 0;
+  CompareReport host;
+  DeviceCompareReport device;
+};
+
+static Timing Run(int64_t n, int iters, aclrtStream stream) {
+  const std::vector<int64_t> dims{n};
+  const Tolerance tol = Tolerance::For(ACL_FLOAT);
+  auto actual = new npuTensor<float>(ACL_FLOAT, dims.size(), dims.data(), ACL_FORMAT_ND, nullptr);
+  auto expected = new npuTensor<float>(ACL_FLOAT, dims.size(), dims.data(), ACL_FORMAT_ND, nullptr);
+  ACL_CALL(aclrtMemset(actual->device_ptr, actual->size, 0, actual->size));
+  ACL_CALL(aclrtMemset(expected->device_ptr, expected->size, 0, expected->size));
+  const float one = 1.0f;
+  ACL_CALL(aclrtMemcpy(static_cast<float *>(actual->device_ptr) + n / 2, sizeof(float), &one, sizeof(float),
+                       ACL_MEMCPY_HOST_TO_DEVICE));
+  // host golden, downloaded once up front
+  expected->CopyToHost();
+
+  Timing t;
+  for (int i = 0; i < iters; ++i) {
+    Timer timer;
+    actual->CopyToHost();
+    t.download_ms += timer.ElapsedMs();
+    timer.Start();
+    t.host = Compare(actual->data(), expected->data(), dims, tol);
+    t.host_cmp_ms += timer.ElapsedMs();
+  }
+  t.download_ms /= iters;
+  t.host_cmp_ms /= iters;
+
+  // first call compiles and allocates the scratch, the timed ones only queue the
+  // ops and download the per-chunk scalars
+  DeviceComparer comparer;
+  t.device = comparer.Compare(actual, expected, tol, stream);
+  if (t.device.ret == ACL_SUCCESS) {
+    Timer timer;
+    for (int i = 0; i < iters && t.device.ret == ACL_SUCCESS; ++i) {
+      t.device = comparer.Compare(actual, expected, tol, stream);
+    }
+    t.device_ms = timer.ElapsedMs() / iters;
+  }
+
+  actual->Destroy();
+  expected->Destroy();
+  return t;
+}
+
+int main(int argc, char* argv[]) {
+  const int64_t max_mb = argc > 1 ? atoll(argv[1]) : 4096;
+  const int iters = argc > 2 ? atoi(argv[2]) : 3;
+
+  // Init
+  ACL_CALL(aclInit(nullptr));
+  ACL_CALL(aclrtSetDevice(0));
+
+  aclrtStream stream = nullptr;
+  ACL_CALL(aclrtCreateStream(&stream));
+
+  std::cout << "copy strategy " << (CopyStrategy() == copyStrategy::ZERO_COPY ? "zero-copy" : "staged")
+            << ", host threads " << NumHostThreads() << std::endl;
+  std::cout << std::setw(10) << "size_MB" << std::setw(14) << "download_ms" << std::setw(14) << "host_cmp_ms"
+            << std::setw(14) << "host_ms" << std::setw(14) << "device_ms" << std::setw(10) << "speedup"
+            << std::setw(10) << "failures" << std::setw(10) << "agree" << std::endl;
+  for (int64_t mb = 1; mb <= max_mb; mb *= 4) {
+    const int64_t n = mb * 1024 * 1024 / sizeof(float);
+    // actual + expected + DeviceComparer scratch
+    const size_t need = 2 * mb * 1024 * 1024 + DeviceComparer().ScratchBytes(n);
+    if (need > DeviceFreeBytes()) {
+      std::cout << std::setw(10) << mb << "  skipped, needs " << ToMB(need) << " MB of device memory" << std::endl;
+      continue;
+    }
+    const Timing t = Run(n, iters, stream);
+    const double host_ms = t.download_ms + t.host_cmp_ms;
+    std::cout << std::setw(10) << mb << std::setw(14) << t.download_ms << std::setw(14) << t.host_cmp_ms
+              << std::setw(14) << host_ms;
+    if (t.device.ret != ACL_SUCCESS) {
+      std::cout << std::setw(14) << "error " << t.device.ret << std::endl;
+      continue;
+    }
+    const bool agree = t.host.failures == t.device.failures && t.host.max_abs_err == t.device.max_abs_err;
+    std::cout << std::setw(14) << t.device_ms << std::setw(10) << host_ms / t.device_ms << std::setw(10)
+              << t.device.failures << std::setw(10) << (agree ? "yes" : "NO") << std::endl;
+  }
+
+  ACL_CALL(aclrtDestroyStream(stream));
+
+  // release
+  ACL_CALL(aclrtResetDevice(0));
+  ACL_CALL(aclFinalize());
+
+  return 0;
+}
@@ -0,0 +1,155 @@
+#include <iostream>
+#include <vector>
+
+#include "common/nputensor.h"
+#include "common/compare.h"
+#include "common/memplan.h"
+#include "common/random.h"
+#include "common/ref_broadcast.h"
+#include "common/ref_sort.h"
+#include "common/typed_matrix.h"
+
+// Support and performance of Add, BroadcastTo and Sort over fp32, fp16,
+// bf16, int32 and int64 and the storage formats each op takes, in one
+// process (common/typed_matrix.h). Each case is written once for all dtypes;
+// per-dtype copies such as Sort / Sort_int64 and BroadcastTo (int64) /
+// BroadcastToD (float) only cover one cell each. Cells are checked against
+// the CPU references, the table ends with the fastest verified dtype per op.
+//
+// usage: ./Bench_DtypeMatrix [elements] [iters]
+
+typedef TypeList<float, float16, bfloat16, int32_t, int64_t> MatrixTypes;
+
+// output of n elements as {1, 16, n / 1024, 64}
+static std::vector<int64_t> Dims4(int64_t n) { return {1, 16, std::max<int64_t>(n / 1024, 1), 64}; }
+
+static int64_t Numel(const std::vector<int64_t>& dims) {
+  int64_t n = 1;
+  for (auto d : dims) n *= d;
+  return n;
+}
+
+template <typename T>
+static std::vector<T> RandomData(int64_t n, uint64_t seed) {
+  std::vector<T> v(n);
+  RandomUniform(v.data(), n, -100.0, 100.0, seed);
+  return v;
+}
+
+int main(int argc, char* argv[]) {
+  const int64_t elements = argc > 1 ? atoll(argv[1]) : (1 << 20);
+  const int iters = argc > 2 ? atoi(argv[2]) : 20;
+
+  // Init
+  ACL_CALL(aclInit(nullptr));
+  ACL_CALL(aclrtSetDevice(0));
+
+  aclrtStream stream = nullptr;
+  ACL_CALL(aclrtCreateStream(&stream));
+
+  std::cout << "elements " << elements << ", iters " << iters << std::endl;
+  MatrixTable table;
+
+  // Add, x + y of the same shape
+  TypedMatrix<MatrixTypes, FormatList<ACL_FORMAT_ND, ACL_FORMAT_NCHW, ACL_FORMAT_NHWC>>::Run(
+      [&](auto tag, aclFormat format) {
+        typedef typename decltype(tag)::type T;
+        typedef typename compare::Traits<T>::compute C;
+        MatrixCell cell = NewCell<T>("Add", format);
+        const std::vector<int64_t> dims = Dims4(elements);
+        const int64_t n = Numel(dims);
+        const std::vector<T> x_data = RandomData<T>(n, 0);
+        const std::vector<T> y_data = RandomData<T>(n, 1);
+        auto x = new npuTensor<T>(cell.dtype, dims.size(), dims.data(), format, x_data.data());
+        auto y = new npuTensor<T>(cell.dtype, dims.size(), dims.data(), format, y_data.data());
+        auto out = new npuTensor<T>(cell.dtype, dims.size(), dims.data(), format, nullptr);
+        OpSignature<In<T, T>, Out<T>> add("Add");
+        cell.elements = n;
+        cell.bytes = 3 * n * sizeof(T);
+        if (TimeCell([&] { return add.Execute(stream, x, y, out); }, iters, stream, &cell)) {
+          std::vector<C> ref(n);
+          for (int64_t i = 0; i < n; ++i) {
+            ref[i] = static_cast<C>(x_data[i]) + static_cast<C>(y_data[i]);
+          }
+          out->CopyToHost();
+          cell.verified = Compare(out->data(), ref.data(), dims, Tolerance::For(cell.dtype)).ok();
+        }
+        x->Destroy();
+        y->Destroy();
+        out->Destroy();
+        return cell;
+      }, &table);
+
+  // BroadcastTo, {1, 16, 1, 1} to {1, 16, H, W}, shape planned as a const input
+  TypedMatrix<MatrixTypes, FormatList<ACL_FORMAT_ND, ACL_FORMAT_NCHW>>::Run(
+      [&](auto tag, aclFormat format) {
+        typedef typename decltype(tag)::type T;
+        MatrixCell cell = NewCell<T>("BroadcastTo", format);
+        const std::vector<int64_t> x_dims{1, 16, 1, 1};
+        const std::vector<int64_t> shape = Dims4(elements);
+        const std::vector<int64_t> shape_dims{static_cast<int64_t>(shape.size())};
+        const int64_t n = Numel(shape);
+        const std::vector<T> x_data = RandomData<T>(Numel(x_dims), 0);
+        auto x = new npuTensor<T>(cell.dtype, x_dims.size(), x_dims.data(), format, x_data.data());
+        auto s = PlanInput<int64_t>(cell.op, 1, ACL_INT64, shape_dims.size(), shape_dims.data(), ACL_FORMAT_ND,
+                                    shape.data());
+        auto y = new npuTensor<T>(cell.dtype, shape.size(), shape.data(), format, nullptr);
+        OpSignature<In<T, int64_t>, Out<T>> broadcast_to("BroadcastTo");
+        cell.elements = n;
+        cell.bytes = (Numel(x_dims) + n) * sizeof(T);
+        if (TimeCell([&] { return broadcast_to.Execute(stream, x, s, y); }, iters, stream, &cell)) {
+          StrideView<T> view;
+          CHECK(BroadcastToView(x_data.data(), x_dims, shape, &view));
+          std::vector<T> ref(n);
+          Materialize(view, ref.data());
+          y->CopyToHost();
+          cell.verified = Compare(y->data(), ref.data(), shape, Tolerance::Exact()).ok();
+        }
+        x->Destroy();
+        s->Destroy();
+        y->Destroy();
+        return cell;
+      }, &table);
+
+  // Sort, ascending along rows of 1024
+  TypedMatrix<MatrixTypes, FormatList<ACL_FORMAT_ND>>::Run(
+      [&](auto tag, aclFormat format) {
+        typedef typename decltype(tag)::type T;
+        MatrixCell cell = NewCell<T>("Sort", format);
+        const int64_t cols = 1024;
+        const int64_t rows = std::max<int64_t>(elements / cols, 1);
+        const std::vector<int64_t> dims{rows, cols};
+        const int64_t n = rows * cols;
+        const std::vector<T> x_data = RandomData<T>(n, 0);
+        auto x = new npuTensor<T>(cell.dtype, dims.size(), dims.data(), format, x_data.data());
+        auto y = new npuTensor<T>(cell.dtype, dims.size(), dims.data(), format, nullptr);
+        auto indices = new npuTensor<int32_t>(ACL_INT32, dims.size(), dims.data(), format, nullptr);
+        static constexpr auto kAttrs = sig::Names("axis", "descending");
+        OpSignature<In<T>, Out<T, int32_t>, AttrTypes<int64_t, bool>> sort("Sort", kAttrs);
+        cell.elements = n;
+        cell.bytes = n * (2 * sizeof(T) + sizeof(int32_t));
+        if (TimeCell([&] { return sort.Execute(stream, x, y, indices, -1, false); }, iters, stream, &cell)) {
+          std::vector<T> ref(n);
+          std::vector<int32_t> ref_indices(n);
+          RefSort(x_data.data(), rows, cols, false, ref.data(), ref_indices.data());
+          y->CopyToHost();
+          cell.verified = Compare(y->data(), ref.data(), dims, Tolerance::Exact()).ok();
+        }
+        x->Destroy();
+        y->Destroy();
+        indices->Destroy();
+        return cell;
+      }, &table);
+
+  table.Print();
+  std::cout << std::endl;
+  table.PrintBest();
+
+  ACL_CALL(aclrtDestroyStream(stream));
+
+  // release
+  ACL_CALL(aclrtResetDevice(0));
+  ACL_CALL(aclFinalize());
+
+  return 0;
+}
@@ -0,0 +1,189 @@
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#include "common/nputensor.h"
+#include "common/memplan.h"
+#include "common/benchmark.h"
+
+// Compare ref ops with a separate output buffer against outputs planned in
+// place on top of `var`, for a large (default 1 GB) var. Device bytes moved
+// per iteration are computed from the tensor sizes: both variants read the
+// small inputs and write the updated rows, a separate output also reads all
+// of var and writes all of y.
+//
+// usage: ./Bench_Inplace [var_mb] [iters]
+
+struct BenchResult {
+  size_t peak_bytes;
+  size_t saved_bytes;
+  size_t moved_bytes;  // per iteration, analytic
+  double avg_ms;
+};
+
+// `small_bytes` of indices / updates read, `row_bytes` of var rows written,
+// plus the var -> y copy unless y aliases var
+static size_t MovedBytes(size_t var_bytes, size_t small_bytes, size_t row_bytes, bool aliased) {
+  return small_bytes + row_bytes + (aliased ? 0 : 2 * var_bytes);
+}
+
+static BenchResult RunScatterUpdate(int64_t rows, int64_t cols, int64_t num_updates, int iters, bool plan) {
+  const std::string op_type = "ScatterUpdate";
+  const size_t free_before = DeviceFreeBytes();
+  // input - var
+  const std::vector<int64_t> var_dims{rows, cols};
+  std::vector<float> var_data(rows * cols, 1);
+  // input - indices, distinct (num_updates <= rows) and spread over the whole var
+  const std::vector<int64_t> indices_dims{num_updates};
+  std::vector<int64_t> indices_data(num_updates);
+  const int64_t stride = std::max<int64_t>(1, rows / num_updates);
+  for (int64_t i = 0; i < num_updates; ++i) {
+    indices_data[i] = i * stride;
+  }
+  // input - updates
+  const std::vector<int64_t> updates_dims{num_updates, cols};
+  std::vector<float> updates_data(num_updates * cols, 6);
+
+  auto input_var = new npuTensor<float>(ACL_FLOAT, var_dims.size(), var_dims.data(), ACL_FORMAT_ND, var_data.data());
+  auto input_indices = new npuTensor<int64_t>(ACL_INT64, indices_dims.size(), indices_dims.data(), ACL_FORMAT_ND, indices_data.data());
+  auto input_updates = new npuTensor<float>(ACL_FLOAT, updates_dims.size(), updates_dims.data(), ACL_FORMAT_ND, updates_data.data());
+  std::vector<aclTensorDesc *> input_descs{input_var->desc, input_indices->desc, input_updates->desc};
+  std::vector<aclDataBuffer *> input_buffers{input_var->buffer, input_indices->buffer, input_updates->buffer};
+
+  MemPlanner planner(op_type, input_buffers, plan);
+  auto output_y = planner.Output<float>(0, ACL_FLOAT, var_dims.size(), var_dims.data(), ACL_FORMAT_ND);
+  std::vector<aclTensorDesc *> output_descs{output_y->desc};
+  std::vector<aclDataBuffer *> output_buffers{output_y->buffer};
+  const size_t free_after = DeviceFreeBytes();
+
+  auto attr = aclopCreateAttr();
+  ACL_CALL(aclopSetAttrBool(attr, "use_locking", false));
+  aclrtStream stream = nullptr;
+  ACL_CALL(aclrtCreateStream(&stream));
+
+  // first run compiles the op
+  Timer timer;
+  for (int i = 0; i <= iters; ++i) {
+    if (i == 1) {
+      ACL_CALL(aclrtSynchronizeStream(stream));
+      timer.Start();
+    }
+    ACL_CALL(aclopCompileAndExecute(op_type.c_str(),
+              input_descs.size(), input_descs.data(), input_buffers.data(),
+              output_descs.size(), output_descs.data(), output_buffers.data(),
+              attr, ACL_ENGINE_SYS, ACL_COMPILE_SYS, NULL, stream));
+  }
+  ACL_CALL(aclrtSynchronizeStream(stream));
+  const size_t moved = MovedBytes(input_var->size, input_indices->size + input_updates->size, input_updates->size,
+                                  planner.saved_bytes() > 0);
+  BenchResult result{free_before - free_after, planner.saved_bytes(), moved, timer.ElapsedMs() / iters};
+  ACL_CALL(aclrtDestroyStream(stream));
+
+  input_var->Destroy();
+  input_indices->Destroy();
+  input_updates->Destroy();
+  output_y->Destroy();
+  aclopDestroyAttr(attr);
+  return result;
+}
+
+static BenchResult RunStridedSliceAssign(int64_t rows, int64_t cols, int64_t slice_rows, int iters, bool plan) {
+  const std::string op_type = "StridedSliceAssign";
+  const size_t free_before = DeviceFreeBytes();
+  // input - var
+  const std::vector<int64_t> var_dims{rows, cols};
+  std::vector<float> var_data(rows * cols, 1);
+  // input - value
+  const std::vector<int64_t> value_dims{slice_rows, cols};
+  std::vector<float> value_data(slice_rows * cols, 2);
+  // input - begin, end, strides
+  const std::vector<int64_t> index_dims{2};
+  std::vector<int64_t> begin_data{0, 0};
+  std::vector<int64_t> end_data{slice_rows, cols};
+  std::vector<int64_t> stride_data{1, 1};
+
+  auto input_var = new npuTensor<float>(ACL_FLOAT, var_dims.size(), var_dims.data(), ACL_FORMAT_ND, var_data.data());
+  auto input_value = new npuTensor<float>(ACL_FLOAT, value_dims.size(), value_dims.data(), ACL_FORMAT_ND, value_data.data());
+  auto input_begin = new npuTensor<int64_t>(ACL_INT64, index_dims.size(), index_dims.data(), ACL_FORMAT_ND, begin_data.data());
+  auto input_end = new npuTensor<int64_t>(ACL_INT64, index_dims.size(), index_dims.data(), ACL_FORMAT_ND, end_data.data());
+  auto input_stride = new npuTensor<int64_t>(ACL_INT64, index_dims.size(), index_dims.data(), ACL_FORMAT_ND, stride_data.data());
+  std::vector<aclTensorDesc *> input_descs{input_var->desc, input_value->desc, input_begin->desc, input_end->desc, input_stride->desc};
+  std::vector<aclDataBuffer *> input_buffers{input_var->buffer, input_value->buffer, input_begin->buffer, input_end->buffer, input_stride->buffer};
+
+  MemPlanner planner(op_type, input_buffers, plan);
+  auto output_y = planner.Output<float>(0, ACL_FLOAT, var_dims.size(), var_dims.data(), ACL_FORMAT_ND);
+  std::vector<aclTensorDesc *> output_descs{output_y->desc};
+  std::vector<aclDataBuffer *> output_buffers{output_y->buffer};
+  const size_t free_after = DeviceFreeBytes();
+
+  auto attr = aclopCreateAttr();
+  aclrtStream stream = nullptr;
+  ACL_CALL(aclrtCreateStream(&stream));
+
+  Timer timer;
+  for (int i = 0; i <= iters; ++i) {
+    if (i == 1) {
+      ACL_CALL(aclrtSynchronizeStream(stream));
+      timer.Start();
+    }
+    ACL_CALL(aclopCompileAndExecute(op_type.c_str(),
+              input_descs.size(), input_descs.data(), input_buffers.data(),
+              output_descs.size(), output_descs.data(), output_buffers.data(),
+              attr, ACL_ENGINE_SYS, ACL_COMPILE_SYS, NULL, stream));
+  }
+  ACL_CALL(aclrtSynchronizeStream(stream));
+  const size_t small = input_value->size + input_begin->size + input_end->size + input_stride->size;
+  const size_t moved = MovedBytes(input_var->size, small, input_value->size, planner.saved_bytes() > 0);
+  BenchResult result{free_before - free_after, planner.saved_bytes(), moved, timer.ElapsedMs() / iters};
+  ACL_CALL(aclrtDestroyStream(stream));
+
+  input_var->Destroy();
+  input_value->Destroy();
+  input_begin->Destroy();
+  input_end->Destroy();
+  input_stride->Destroy();
+  output_y->Destroy();
+  aclopDestroyAttr(attr);
+  return result;
+}
+
+static void Report(const std::string& name, const BenchResult& separate, const BenchResult& inplace) {
+  std::cout << name << " : separate peak = " << ToMB(separate.peak_bytes) << " MB, " << separate.avg_ms << " ms, "
+            << ToMB(separate.moved_bytes) << " MB moved/iter | in-place peak = " << ToMB(inplace.peak_bytes)
+            << " MB, " << inplace.avg_ms << " ms, " << ToMB(inplace.moved_bytes)
+            << " MB moved/iter | saved = " << ToMB(inplace.saved_bytes) << " MB" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+  const int64_t var_mb = argc > 1 ? atoll(argv[1]) : 1024;
+  const int iters = argc > 2 ? atoi(argv[2]) : 10;
+  if (var_mb < 1 || iters < 1) {
+    LOG(WARNING) << "usage: ./Bench_Inplace [var_mb >= 1] [iters >= 1]";
+    return 1;
+  }
+
+  // Init
+  ACL_CALL(aclInit(nullptr));
+  ACL_CALL(aclrtSetDevice(0));
+
+  // var = {rows, 1024} float, 4 KB per row
+  const int64_t cols = 1024;
+  const int64_t rows = var_mb * 1024 * 1024 / (cols * sizeof(float));
+  // updated rows (ScatterUpdate indices, StridedSliceAssign slice), at most one per var row
+  const int64_t num_updates = std::min<int64_t>(1024, rows);
+  std::cout << "var = {" << rows << ", " << cols << "}, " << var_mb << " MB" << std::endl;
+
+  auto scatter_separate = RunScatterUpdate(rows, cols, num_updates, iters, false);
+  auto scatter_inplace = RunScatterUpdate(rows, cols, num_updates, iters, true);
+  Report("ScatterUpdate", scatter_separate, scatter_inplace);
+
+  auto assign_separate = RunStridedSliceAssign(rows, cols, num_updates, iters, false);
+  auto assign_inplace = RunStridedSliceAssign(rows, cols, num_updates, iters, true);
+  Report("StridedSliceAssign", assign_separate, assign_inplace);
+
+  // release
+  ACL_CALL(aclrtResetDevice(0));
+  ACL_CALL(aclFinalize());
+
+  return 0;
+}
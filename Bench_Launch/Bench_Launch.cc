@@ -0,0 +1,255 @@
+#include <atomic>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <vector>
+
+#include "common/nputensor.h"
+#include "common/benchmark.h"
+#include "common/opsignature.h"
+
+// Host overhead of one op launch, the op files' pattern (descriptor and
+// buffer std::vectors filled per call, aclopAttr created and set by name)
+// vs OpSignature (std::arrays, cached attrs). For Add (no attrs),
+// BatchMatMul (2 bool attrs) and BNTrainingUpdate (7 inputs, 5 outputs,
+// 2 float attrs):
+//   prep_ns    building the call arguments only, no launch
+//   allocs     host heap allocations per prep
+//   launch_us  prep + aclopCompileAndExecute of the warm kernel, launches
+//              queued back to back with one sync at the end
+//
+// usage: ./Bench_Launch [iters]
+
+static std::atomic<int64_t> g_allocs(0);
+
+void* operator new(size_t size) {
+  g_allocs.fetch_add(1, std::memory_order_relaxed);
+  void* p = std::malloc(size);
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+// keeps the prepared arguments from being optimized away
+static volatile uintptr_t g_sink;
+
+struct Tensor {
+  aclTensorDesc* desc;
+  aclDataBuffer* buffer;
+};
+
+// the op files' pattern
+static aclError VectorLaunch(const char* op_type, const std::vector<Tensor>& inputs,
+                             const std::vector<Tensor>& outputs, const std::function<void(aclopAttr *)>& set_attrs,
+                             aclrtStream stream, bool execute) {
+  std::vector<aclTensorDesc *> input_descs;
+  std::vector<aclDataBuffer *> input_buffers;
+  for (const auto& t : inputs) {
+    input_descs.emplace_back(t.desc);
+    input_buffers.emplace_back(t.buffer);
+  }
+  std::vector<aclTensorDesc *> output_descs;
+  std::vector<aclDataBuffer *> output_buffers;
+  for (const auto& t : outputs) {
+    output_descs.emplace_back(t.desc);
+    output_buffers.emplace_back(t.buffer);
+  }
+  auto attr = aclopCreateAttr();
+  if (set_attrs) {
+    set_attrs(attr);
+  }
+  aclError ret = ACL_SUCCESS;
+  if (execute) {
+    ret = aclopCompileAndExecute(op_type, input_descs.size(), input_descs.data(), input_buffers.data(),
+                                 output_descs.size(), output_descs.data(), output_buffers.data(), attr,
+                                 ACL_ENGINE_SYS, ACL_COMPILE_SYS, NULL, stream);
+  } else {
+    g_sink = g_sink + reinterpret_cast<uintptr_t>(input_descs.data()) + reinterpret_cast<uintptr_t>(attr);
+  }
+  aclopDestroyAttr(attr);
+  return ret;
+}
+
+struct Timing {
+  double prep_ns = 0;
+  double allocs = 0;
+  double launch_us = 0;
+  aclError ret = ACL_SUCCESS;
+};
+
+// `run(stream, execute)` prepares a call and launches it when `execute`
+template <typename Run>
+static Timing Measure(Run run, int iters, aclrtStream stream) {
+  Timing t;
+  // first call compiles
+  t.ret = run(stream, true);
+  if (t.ret == ACL_SUCCESS) {
+    t.ret = aclrtSynchronizeStream(stream);
+  }
+  if (t.ret != ACL_SUCCESS) {
+    return t;
+  }
+  const int64_t allocs = g_allocs.load();
+  Timer timer;
+  for (int i = 0; i < iters; ++i) {
+    run(stream, false);
+  }
+  t.prep_ns = timer.ElapsedMs() * 1e6 / iters;
+  t.allocs = static_cast<double>(g_allocs.load() - allocs) / iters;
+
+  timer.Start();
+  for (int i = 0; i < iters && t.ret == ACL_SUCCESS; ++i) {
+    t.ret = run(stream, true);
+  }
+  if (t.ret == ACL_SUCCESS) {
+    t.ret = aclrtSynchronizeStream(stream);
+  }
+  t.launch_us = timer.ElapsedMs() * 1e3 / iters;
+  return t;
+}
+
+static void Print(const char* op, const char* path, const Timing& t) {
+  std::cout << std::setw(18) << op << std::setw(11) << path;
+  if (t.ret != ACL_SUCCESS) {
+    std::cout << "  error " << t.ret << std::endl;
+    return;
+  }
+  std::cout << std::setw(10) << t.prep_ns << std::setw(8) << t.allocs << std::setw(12) << t.launch_us << std::endl;
+}
+
+template <typename Typed>
+static void Compare(const char* op, const std::vector<Tensor>& inputs, const std::vector<Tensor>& outputs,
+                    const std::function<void(aclopAttr *)>& set_attrs, Typed typed, int iters, aclrtStream stream) {
+  Print(op, "vector", Measure([&](aclrtStream s, bool execute) {
+          return VectorLaunch(op, inputs, outputs, set_attrs, s, execute);
+        }, iters, stream));
+  Print(op, "signature", Measure(typed, iters, stream));
+}
+
+template <typename T>
+static npuTensor<T>* NewTensor(const std::vector<int64_t>& dims, aclFormat format, std::vector<T>* data) {
+  int64_t n = 1;
+  for (auto d : dims) n *= d;
+  data->assign(n, T(1));
+  return new npuTensor<T>(sig::DType<T>::value, dims.size(), dims.data(), format, data->data());
+}
+
+int main(int argc, char* argv[]) {
+  const int iters = argc > 1 ? atoi(argv[1]) : 10000;
+
+  // Init
+  ACL_CALL(aclInit(nullptr));
+  ACL_CALL(aclrtSetDevice(0));
+
+  aclrtStream stream = nullptr;
+  ACL_CALL(aclrtCreateStream(&stream));
+
+  std::cout << "iters " << iters << std::endl;
+  std::cout << std::setw(18) << "op" << std::setw(11) << "path" << std::setw(10) << "prep_ns" << std::setw(8)
+            << "allocs" << std::setw(12) << "launch_us" << std::endl;
+
+  // Add, 2 inputs 1 output
+  {
+    std::vector<float> x_data, y_data, out_data;
+    auto x = NewTensor<float>({16, 16}, ACL_FORMAT_ND, &x_data);
+    auto y = NewTensor<float>({16, 16}, ACL_FORMAT_ND, &y_data);
+    auto out = NewTensor<float>({16, 16}, ACL_FORMAT_ND, &out_data);
+    OpSignature<In<float, float>, Out<float>> add("Add");
+    Compare("Add", {{x->desc, x->buffer}, {y->desc, y->buffer}}, {{out->desc, out->buffer}}, nullptr,
+            [&](aclrtStream s, bool execute) {
+              const auto launch = add.Bind(x, y, out);
+              if (execute) {
+                return launch.Execute(s);
+              }
+              g_sink = g_sink + reinterpret_cast<uintptr_t>(launch.input_descs.data()) +
+                       reinterpret_cast<uintptr_t>(launch.attr.get());
+              return ACL_SUCCESS;
+            }, iters, stream);
+    x->Destroy();
+    y->Destroy();
+    out->Destroy();
+  }
+
+  // BatchMatMul, 2 bool attrs
+  {
+    std::vector<float> x1_data, x2_data, y_data;
+    auto x1 = NewTensor<float>({4, 16, 16}, ACL_FORMAT_ND, &x1_data);
+    auto x2 = NewTensor<float>({4, 16, 16}, ACL_FORMAT_ND, &x2_data);
+    auto y = NewTensor<float>({4, 16, 16}, ACL_FORMAT_ND, &y_data);
+    static constexpr auto kAttrs = sig::Names("adj_x1", "adj_x2");
+    OpSignature<In<float, float>, Out<float>, AttrTypes<bool, bool>> bmm("BatchMatMul", kAttrs);
+    Compare("BatchMatMul", {{x1->desc, x1->buffer}, {x2->desc, x2->buffer}}, {{y->desc, y->buffer}},
+            [](aclopAttr* attr) {
+              ACL_CALL(aclopSetAttrBool(attr, "adj_x1", false));
+              ACL_CALL(aclopSetAttrBool(attr, "adj_x2", false));
+            },
+            [&](aclrtStream s, bool execute) {
+              const auto launch = bmm.Bind(x1, x2, y, false, false);
+              if (execute) {
+                return launch.Execute(s);
+              }
+              g_sink = g_sink + reinterpret_cast<uintptr_t>(launch.input_descs.data()) +
+                       reinterpret_cast<uintptr_t>(launch.attr.get());
+              return ACL_SUCCESS;
+            }, iters, stream);
+    x1->Destroy();
+    x2->Destroy();
+    y->Destroy();
+  }
+
+  // BNTrainingUpdate, 7 inputs 5 outputs 2 float attrs
+  {
+    std::vector<float> x_data, y_data;
+    std::vector<std::vector<float>> c_data(10);
+    auto x = NewTensor<float>({2, 16, 8, 8}, ACL_FORMAT_NCHW, &x_data);
+    auto y = NewTensor<float>({2, 16, 8, 8}, ACL_FORMAT_NCHW, &y_data);
+    std::vector<npuTensor<float> *> c(10);
+    for (int i = 0; i < 10; ++i) {
+      c[i] = NewTensor<float>({16}, ACL_FORMAT_ND, &c_data[i]);
+    }
+    std::vector<Tensor> inputs{{x->desc, x->buffer}};
+    std::vector<Tensor> outputs{{y->desc, y->buffer}};
+    for (int i = 0; i < 6; ++i) {
+      inputs.push_back({c[i]->desc, c[i]->buffer});
+    }
+    for (int i = 6; i < 10; ++i) {
+      outputs.push_back({c[i]->desc, c[i]->buffer});
+    }
+    static constexpr auto kAttrs = sig::Names("factor", "epsilon");
+    OpSignature<In<float, float, float, float, float, float, float>, Out<float, float, float, float, float>,
+                AttrTypes<float, float>> bn("BNTrainingUpdate", kAttrs);
+    Compare("BNTrainingUpdate", inputs, outputs,
+            [](aclopAttr* attr) {
+              ACL_CALL(aclopSetAttrFloat(attr, "factor", 0.9f));
+              ACL_CALL(aclopSetAttrFloat(attr, "epsilon", 1e-5f));
+            },
+            [&](aclrtStream s, bool execute) {
+              const auto launch =
+                  bn.Bind(x, c[0], c[1], c[2], c[3], c[4], c[5], y, c[6], c[7], c[8], c[9], 0.9f, 1e-5f);
+              if (execute) {
+                return launch.Execute(s);
+              }
+              g_sink = g_sink + reinterpret_cast<uintptr_t>(launch.input_descs.data()) +
+                       reinterpret_cast<uintptr_t>(launch.attr.get());
+              return ACL_SUCCESS;
+            }, iters, stream);
+    x->Destroy();
+    y->Destroy();
+    for (auto t : c) {
+      t->Destroy();
+    }
+  }
+
+  ACL_CALL(aclrtDestroyStream(stream));
+
+  // release
+  ACL_CALL(aclrtResetDevice(0));
+  ACL_CALL(aclFinalize());
+
+  return 0;
+}
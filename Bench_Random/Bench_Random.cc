@@ -0,0 +1,88 @@
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+
+#include "common/benchmark.h"
+#include "common/parallel.h"
+#include "common/random.h"
+
+// Random input generator (common/random.h): every distribution and element
+// type is filled at 1 thread and at NumHostThreads(), the two buffers and a
+// slice regenerated at its own offset must be bitwise equal. Prints the time
+// per fill and ns/elem for both thread counts. Host only, exits non-zero on
+// any mismatch.
+//
+// usage: ./Bench_Random [n] [iters]
+
+namespace {
+
+// best of iters
+template <typename T>
+double FillMs(T* x, int64_t n, const philox::Params& p, int max_threads, int iters) {
+  double best = 0;
+  for (int i = 0; i < iters; ++i) {
+    Timer timer;
+    philox::Fill(x, n, 7, 0, p, max_threads);
+    const double ms = timer.ElapsedMs();
+    best = i == 0 || ms < best ? ms : best;
+  }
+  return best;
+}
+
+template <typename T>
+bool Run(const char* type, const char* dist, const philox::Params& p, int64_t n, int iters) {
+  // std::vector<bool> has no data()
+  std::unique_ptr<T[]> one(new T[n]);
+  std::unique_ptr<T[]> all(new T[n]);
+  const double one_ms = FillMs(one.get(), n, p, 1, iters);
+  const double all_ms = FillMs(all.get(), n, p, 0, iters);
+  const bool same = std::memcmp(one.get(), all.get(), n * sizeof(T)) == 0;
+
+  // an unaligned slice from the middle reproduces on its own
+  const int64_t offset = n / 3 + 1;
+  const int64_t len = std::min<int64_t>(n - offset, 1000003);
+  std::unique_ptr<T[]> slice(new T[len]);
+  philox::Fill(slice.get(), len, 7, offset, p);
+  const bool slice_same = std::memcmp(slice.get(), all.get() + offset, len * sizeof(T)) == 0;
+
+  const bool ok = same && slice_same;
+  std::cout << std::setw(10) << type << std::setw(10) << dist << std::setw(12) << one_ms << std::setw(12)
+            << one_ms * 1e6 / n << std::setw(12) << all_ms << std::setw(12) << all_ms * 1e6 / n << std::setw(8)
+            << (ok ? "ok" : "FAIL") << std::endl;
+  return ok;
+}
+
+template <typename T>
+bool RunAll(const char* type, int64_t n, int iters) {
+  bool ok = true;
+  ok &= Run<T>(type, "uniform", philox::Params{RANDOM_UNIFORM, -1, 1}, n, iters);
+  ok &= Run<T>(type, "normal", philox::Params{RANDOM_NORMAL, 0, 1}, n, iters);
+  ok &= Run<T>(type, "special", philox::Params{RANDOM_SPECIAL, 0.01, 0}, n, iters);
+  return ok;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  const int64_t n = argc > 1 ? atoll(argv[1]) : 64 * 1024 * 1024;
+  const int iters = argc > 2 ? atoi(argv[2]) : 3;
+  if (n < 1 || iters < 1) {
+    LOG(WARNING) << "usage: ./Bench_Random [n >= 1] [iters >= 1]";
+    return 1;
+  }
+
+  std::cout << "threads " << NumHostThreads() << ", " << n << " elements" << std::endl;
+  std::cout << std::setw(10) << "type" << std::setw(10) << "dist" << std::setw(12) << "1t_ms" << std::setw(12)
+            << "1t_ns/elem" << std::setw(12) << "Nt_ms" << std::setw(12) << "Nt_ns/elem" << std::setw(8) << "same"
+            << std::endl;
+  bool ok = true;
+  ok &= RunAll<float>("float", n, iters);
+  ok &= RunAll<float16>("float16", n, iters);
+  ok &= RunAll<bfloat16>("bfloat16", n, iters);
+  ok &= RunAll<int32_t>("int32", n, iters);
+  ok &= RunAll<int64_t>("int64", n, iters);
+  ok &= RunAll<bool>("bool", n, iters);
+  return ok ? 0 : 1;
+}
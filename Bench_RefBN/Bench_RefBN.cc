@@ -0,0 +1,80 @@
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "common/benchmark.h"
+#include "common/parallel.h"
+#include "common/ref_bn.h"
+
+// Time of the CPU reference BN training reduce / update (common/ref_bn.h) on
+// ResNet-sized batches in NCHW and NC1HWC0, plus the variance error of the
+// shifted Welford reduction against a naive float square_sum / num - mean^2
+// on data with a large mean. Host only.
+//
+// usage: ./Bench_RefBN [N] [C] [H] [W]
+
+static void Run(const char* name, const std::vector<int64_t>& dims, aclFormat format) {
+  const BNLayout l = BNLayout::From(dims, format);
+  std::vector<float> x(l.outer * l.c1 * l.spatial * l.c0);
+  std::mt19937 gen(0);
+  std::normal_distribution<float> dist(0.5f, 2.0f);
+  for (auto& v : x) v = dist(gen);
+  const int64_t C = l.channels();
+  std::vector<float> sum(C), square_sum(C), scale(C, 1), offset(C, 0), mean(C, 0), var(C, 1);
+  std::vector<float> y(x.size()), mean_out(C), var_out(C), saved_mean(C), saved_var(C);
+
+  RefBNTrainingReduce(x.data(), dims, format, sum.data(), square_sum.data());
+  Timer timer;
+  RefBNTrainingReduce(x.data(), dims, format, sum.data(), square_sum.data());
+  const double reduce_ms = timer.ElapsedMs();
+  timer.Start();
+  RefBNTrainingUpdate(x.data(), dims, format, sum.data(), square_sum.data(), scale.data(), offset.data(),
+                      mean.data(), var.data(), 0.9f, 1e-5f, y.data(), mean_out.data(), var_out.data(),
+                      saved_mean.data(), saved_var.data());
+  const double update_ms = timer.ElapsedMs();
+  std::stringstream shape;
+  for (auto d : dims) shape << d << ",";
+  std::cout << std::setw(10) << name << std::setw(20) << shape.str() << std::setw(12) << reduce_ms
+            << std::setw(12) << update_ms << std::setw(12) << x.size() * sizeof(float) / (reduce_ms * 1e6)
+            << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+  const int64_t N = argc > 1 ? atoll(argv[1]) : 256;
+  const int64_t C = argc > 2 ? atoll(argv[2]) : 64;
+  const int64_t H = argc > 3 ? atoll(argv[3]) : 56;
+  const int64_t W = argc > 4 ? atoll(argv[4]) : 56;
+
+  std::cout << "threads " << NumHostThreads() << std::endl;
+  std::cout << std::setw(10) << "format" << std::setw(20) << "x" << std::setw(12) << "reduce_ms"
+            << std::setw(12) << "update_ms" << std::setw(12) << "GB/s" << std::endl;
+  Run("NCHW", {N, C, H, W}, ACL_FORMAT_NCHW);
+  Run("NC1HWC0", {N, (C + 15) / 16, H, W, 16}, ACL_FORMAT_NC1HWC0);
+
+  // one channel around 1e4 with unit variance
+  const int64_t n = N * H * W;
+  std::vector<float> x(n);
+  std::mt19937 gen(1);
+  std::normal_distribution<float> dist(1e4f, 1.0f);
+  double mean = 0;
+  for (auto& v : x) {
+    v = dist(gen);
+    mean += v;
+  }
+  mean /= n;
+  double exact = 0;
+  float naive_sum = 0;
+  float naive_square_sum = 0;
+  for (auto v : x) {
+    exact += (v - mean) * (v - mean);
+    naive_sum += v;
+    naive_square_sum += v * v;
+  }
+  exact /= n;
+  const double naive = naive_square_sum / n - (naive_sum / n) * (naive_sum / n);
+  const double welford = RefBNMoments(x.data(), BNLayout::From({1, 1, n}, ACL_FORMAT_ND))[0].var();
+  std::cout << "variance of " << n << " values ~N(1e4, 1): exact " << exact << ", naive float " << naive
+            << ", welford " << welford << std::endl;
+  return 0;
+}
@@ -0,0 +1,74 @@
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "common/benchmark.h"
+#include "common/float16.h"
+#include "common/parallel.h"
+#include "common/ref_batch_matmul.h"
+
+// Throughput of the CPU reference BatchMatMul (common/ref_batch_matmul.h)
+// for float, float16 and bfloat16 inputs, checked on sampled outputs against
+// a double precision dot product. Host only, no device needed.
+//
+// usage: ./Bench_RefBatchMatMul [M] [K] [N] [batch] [iters]
+
+template <typename T>
+static void Run(const char* name, int64_t batch, int64_t M, int64_t K, int64_t N, int iters) {
+  std::mt19937 gen(0);
+  std::uniform_real_distribution<float> dist(-1, 1);
+  const std::vector<int64_t> x1_dims{batch, M, K};
+  // x2 broadcast over the batch, stored transposed
+  const std::vector<int64_t> x2_dims{1, N, K};
+  std::vector<T> x1(batch * M * K);
+  std::vector<T> x2(N * K);
+  for (auto& v : x1) v = T(dist(gen));
+  for (auto& v : x2) v = T(dist(gen));
+  std::vector<float> y(batch * M * N);
+
+  RefBatchMatMul(x1.data(), x1_dims, x2.data(), x2_dims, false, true, y.data());
+  Timer timer;
+  for (int i = 0; i < iters; ++i) {
+    RefBatchMatMul(x1.data(), x1_dims, x2.data(), x2_dims, false, true, y.data());
+  }
+  const double ms = timer.ElapsedMs() / iters;
+  const double gflops = 2.0 * batch * M * N * K / (ms * 1e6);
+
+  // sampled check
+  double max_err = 0;
+  for (int s = 0; s < 256; ++s) {
+    const int64_t b = gen() % batch;
+    const int64_t i = gen() % M;
+    const int64_t j = gen() % N;
+    double ref = 0;
+    double mag = 0;
+    for (int64_t k = 0; k < K; ++k) {
+      const double p = static_cast<double>(static_cast<float>(x1[(b * M + i) * K + k])) *
+                       static_cast<float>(x2[j * K + k]);
+      ref += p;
+      mag += std::fabs(p);
+    }
+    max_err = std::max(max_err, std::fabs(y[(b * M + i) * N + j] - ref) / std::max(mag, 1e-30));
+  }
+  std::cout << std::setw(8) << name << std::setw(8) << batch << std::setw(8) << M << std::setw(8) << K
+            << std::setw(8) << N << std::setw(12) << ms << std::setw(12) << gflops << std::setw(14) << max_err
+            << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+  const int64_t M = argc > 1 ? atoll(argv[1]) : 1024;
+  const int64_t K = argc > 2 ? atoll(argv[2]) : M;
+  const int64_t N = argc > 3 ? atoll(argv[3]) : M;
+  const int64_t batch = argc > 4 ? atoll(argv[4]) : 1;
+  const int iters = argc > 5 ? atoi(argv[5]) : 3;
+
+  std::cout << "threads " << NumHostThreads() << ", micro-kernel " << gemm::kMR << "x" << gemm::kNR << std::endl;
+  std::cout << std::setw(8) << "dtype" << std::setw(8) << "batch" << std::setw(8) << "M" << std::setw(8) << "K"
+            << std::setw(8) << "N" << std::setw(12) << "ms" << std::setw(12) << "GFLOP/s" << std::setw(14)
+            << "max_rel_err" << std::endl;
+  Run<float>("float", batch, M, K, N, iters);
+  Run<float16>("float16", batch, M, K, N, iters);
+  Run<bfloat16>("bfloat16", batch, M, K, N, iters);
+  return 0;
+}
@@ -0,0 +1,109 @@
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "common/benchmark.h"
+#include "common/parallel.h"
+#include "common/ref_resize.h"
+
+// Throughput of the CPU reference Resize (common/ref_resize.h) per mode on an
+// image batch, checked against a direct 2-D evaluation of the same taps on a
+// small crop of modes and coordinate transforms. Host only.
+//
+// usage: ./Bench_RefResize [batch] [in_h] [in_w] [out_h] [out_w]
+
+// direct, non-separable evaluation in double
+static void DirectResize(const std::vector<float>& x, const std::vector<int64_t>& x_dims, int64_t out_h,
+                         int64_t out_w, const ResizeParams& p, std::vector<double>* y) {
+  const int64_t planes = x_dims[0] * x_dims[1];
+  const int64_t in_h = x_dims[2];
+  const int64_t in_w = x_dims[3];
+  const bool crop = p.coordinate_transformation_mode == "tf_crop_and_resize";
+  const ResizeAxis ah = MakeResizeAxis(p, in_h, out_h, static_cast<float>(out_h) / in_h, crop ? p.roi[0] : 0,
+                                       crop ? p.roi[2] : 1);
+  const ResizeAxis aw = MakeResizeAxis(p, in_w, out_w, static_cast<float>(out_w) / in_w, crop ? p.roi[1] : 0,
+                                       crop ? p.roi[3] : 1);
+  y->assign(planes * out_h * out_w, 0);
+  for (int64_t c = 0; c < planes; ++c) {
+    for (int64_t oy = 0; oy < out_h; ++oy) {
+      for (int64_t ox = 0; ox < out_w; ++ox) {
+        double v = 0;
+        for (int i = 0; i < ah.taps; ++i) {
+          for (int j = 0; j < aw.taps; ++j) {
+            v += static_cast<double>(ah.weight[oy * ah.taps + i]) * aw.weight[ox * aw.taps + j] *
+                 x[(c * in_h + ah.index[oy * ah.taps + i]) * in_w + aw.index[ox * aw.taps + j]];
+          }
+        }
+        (*y)[(c * out_h + oy) * out_w + ox] = (ah.valid[oy] && aw.valid[ox]) ? v : p.extrapolation_value;
+      }
+    }
+  }
+}
+
+static ResizeParams Params(const std::string& mode, const std::string& ctm, const std::string& nearest_mode) {
+  ResizeParams p;
+  p.mode = mode;
+  p.coordinate_transformation_mode = ctm;
+  p.nearest_mode = nearest_mode;
+  p.roi = {0.1f, 0.2f, 0.9f, 0.7f};
+  return p;
+}
+
+int main(int argc, char* argv[]) {
+  const int64_t batch = argc > 1 ? atoll(argv[1]) : 2;
+  const int64_t in_h = argc > 2 ? atoll(argv[2]) : 2160;
+  const int64_t in_w = argc > 3 ? atoll(argv[3]) : 3840;
+  const int64_t out_h = argc > 4 ? atoll(argv[4]) : in_h / 2;
+  const int64_t out_w = argc > 5 ? atoll(argv[5]) : in_w / 2;
+
+  std::mt19937 gen(0);
+  std::uniform_real_distribution<float> dist(-1, 1);
+
+  // correctness on small shapes
+  const std::vector<int64_t> small_dims{1, 2, 7, 11};
+  std::vector<float> small(2 * 7 * 11);
+  for (auto& v : small) v = dist(gen);
+  double max_err = 0;
+  int cases = 0;
+  for (const char* mode : {"nearest", "linear", "cubic"}) {
+    for (const char* ctm : {"half_pixel", "pytorch_half_pixel", "align_corners", "asymmetric",
+                            "tf_half_pixel_for_nn", "tf_crop_and_resize"}) {
+      for (const char* nearest_mode : {"round_prefer_floor", "round_prefer_ceil", "floor", "ceil"}) {
+        for (auto out : std::vector<std::pair<int64_t, int64_t>>{{13, 5}, {3, 23}, {1, 1}}) {
+          const ResizeParams p = Params(mode, ctm, nearest_mode);
+          std::vector<float> y(2 * out.first * out.second);
+          std::vector<double> y_direct;
+          RefResize(small.data(), small_dims, out.first, out.second, p, y.data());
+          DirectResize(small, small_dims, out.first, out.second, p, &y_direct);
+          for (size_t i = 0; i < y.size(); ++i) {
+            max_err = std::max(max_err, std::fabs(y[i] - y_direct[i]));
+          }
+          ++cases;
+        }
+      }
+    }
+  }
+  std::cout << "threads " << NumHostThreads() << ", " << cases << " small cases, max abs err " << max_err
+            << std::endl;
+
+  // throughput
+  const std::vector<int64_t> x_dims{batch, 3, in_h, in_w};
+  std::vector<float> x(batch * 3 * in_h * in_w);
+  for (auto& v : x) v = dist(gen);
+  std::vector<float> y(batch * 3 * out_h * out_w);
+  std::cout << std::setw(10) << "mode" << std::setw(24) << "x -> y" << std::setw(12) << "ms"
+            << std::setw(12) << "Mpix/s" << std::endl;
+  for (const char* mode : {"nearest", "linear", "cubic"}) {
+    const ResizeParams p = Params(mode, "half_pixel", "round_prefer_floor");
+    RefResize(x.data(), x_dims, out_h, out_w, p, y.data());
+    Timer timer;
+    RefResize(x.data(), x_dims, out_h, out_w, p, y.data());
+    const double ms = timer.ElapsedMs();
+    std::stringstream shape;
+    shape << in_h << "x" << in_w << " -> " << out_h << "x" << out_w;
+    std::cout << std::setw(10) << mode << std::setw(24) << shape.str() << std::setw(12) << ms
+              << std::setw(12) << batch * 3 * out_h * out_w / (ms * 1e3) << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,218 @@
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "common/nputensor.h"
+#include "common/memplan.h"
+#include "common/benchmark.h"
+#include "common/ref_scatter.h"
+
+// ScatterUpdate on var = {rows, slice} with num_indices updates drawn from
+// each indexDist (common/ref_scatter.h): random, sorted, clustered and
+// heavy-duplicate, the last one shaped like embedding-table traffic. Reports
+// device updates/s next to the number of distinct rows hit, and which
+// duplicate semantics the device output matches: last or first in index
+// order, any of the duplicates, or none. MaskedScatter follows on
+// rows * slice elements at a few mask densities.
+//
+// usage: ./Bench_Scatter [rows] [slice] [num_indices] [iters]
+
+struct DeviceResult {
+  aclError ret = ACL_SUCCESS;
+  double ms = 0;
+  std::vector<float> y;
+};
+
+static DeviceResult RunScatterUpdate(const std::vector<float>& var, const std::vector<int64_t>& var_dims,
+                                     const std::vector<int64_t>& indices, const std::vector<float>& updates,
+                                     int iters, aclrtStream stream) {
+  const std::string op_type = "ScatterUpdate";
+  const std::vector<int64_t> indices_dims{static_cast<int64_t>(indices.size())};
+  const std::vector<int64_t> updates_dims{indices_dims[0], var_dims[1]};
+  auto input_var = new npuTensor<float>(ACL_FLOAT, var_dims.size(), var_dims.data(), ACL_FORMAT_ND, var.data());
+  auto input_indices = new npuTensor<int64_t>(ACL_INT64, indices_dims.size(), indices_dims.data(), ACL_FORMAT_ND, indices.data());
+  auto input_updates = new npuTensor<float>(ACL_FLOAT, updates_dims.size(), updates_dims.data(), ACL_FORMAT_ND, updates.data());
+  std::vector<aclTensorDesc *> input_descs{input_var->desc, input_indices->desc, input_updates->desc};
+  std::vector<aclDataBuffer *> input_buffers{input_var->buffer, input_indices->buffer, input_updates->buffer};
+  // y aliases var, repeated runs write the same rows again
+  MemPlanner planner(op_type, input_buffers);
+  auto output_y = planner.Output<float>(0, ACL_FLOAT, var_dims.size(), var_dims.data(), ACL_FORMAT_ND);
+  std::vector<aclTensorDesc *> output_descs{output_y->desc};
+  std::vector<aclDataBuffer *> output_buffers{output_y->buffer};
+  auto attr = aclopCreateAttr();
+  ACL_CALL(aclopSetAttrBool(attr, "use_locking", false));
+
+  DeviceResult result;
+  auto run = [&] {
+    aclError ret = aclopCompileAndExecute(op_type.c_str(),
+              input_descs.size(), input_descs.data(), input_buffers.data(),
+              output_descs.size(), output_descs.data(), output_buffers.data(),
+              attr, ACL_ENGINE_SYS, ACL_COMPILE_SYS, NULL, stream);
+    return ret != ACL_SUCCESS ? ret : aclrtSynchronizeStream(stream);
+  };
+  // first call compiles
+  result.ret = run();
+  if (result.ret == ACL_SUCCESS) {
+    Timer timer;
+    for (int i = 0; i < iters && result.ret == ACL_SUCCESS; ++i) {
+      result.ret = run();
+    }
+    result.ms = timer.ElapsedMs() / iters;
+    output_y->CopyToHost();
+    result.y.assign(output_y->data(), output_y->data() + var.size());
+  }
+
+  input_var->Destroy();
+  input_indices->Destroy();
+  input_updates->Destroy();
+  output_y->Destroy();
+  aclopDestroyAttr(attr);
+  return result;
+}
+
+static DeviceResult RunMaskedScatter(const std::vector<float>& x, const std::vector<char>& mask,
+                                     const std::vector<float>& value, int iters, aclrtStream stream) {
+  const std::string op_type = "MaskedScatter";
+  const std::vector<int64_t> dims{static_cast<int64_t>(x.size())};
+  auto input_x = new npuTensor<float>(ACL_FLOAT, dims.size(), dims.data(), ACL_FORMAT_ND, x.data());
+  auto input_mask = new npuTensor<bool>(ACL_BOOL, dims.size(), dims.data(), ACL_FORMAT_ND,
+                                        reinterpret_cast<const bool*>(mask.data()));
+  auto input_value = new npuTensor<float>(ACL_FLOAT, dims.size(), dims.data(), ACL_FORMAT_ND, value.data());
+  auto output_y = new npuTensor<float>(ACL_FLOAT, dims.size(), dims.data(), ACL_FORMAT_ND, nullptr);
+  std::vector<aclTensorDesc *> input_descs{input_x->desc, input_mask->desc, input_value->desc};
+  std::vector<aclDataBuffer *> input_buffers{input_x->buffer, input_mask->buffer, input_value->buffer};
+  std::vector<aclTensorDesc *> output_descs{output_y->desc};
+  std::vector<aclDataBuffer *> output_buffers{output_y->buffer};
+  auto attr = aclopCreateAttr();
+
+  DeviceResult result;
+  auto run = [&] {
+    aclError ret = aclopCompileAndExecute(op_type.c_str(),
+              input_descs.size(), input_descs.data(), input_buffers.data(),
+              output_descs.size(), output_descs.data(), output_buffers.data(),
+              attr, ACL_ENGINE_SYS, ACL_COMPILE_SYS, NULL, stream);
+    return ret != ACL_SUCCESS ? ret : aclrtSynchronizeStream(stream);
+  };
+  result.ret = run();
+  if (result.ret == ACL_SUCCESS) {
+    Timer timer;
+    for (int i = 0; i < iters && result.ret == ACL_SUCCESS; ++i) {
+      result.ret = run();
+    }
+    result.ms = timer.ElapsedMs() / iters;
+    output_y->CopyToHost();
+    result.y.assign(output_y->data(), output_y->data() + x.size());
+  }
+
+  input_x->Destroy();
+  input_mask->Destroy();
+  input_value->Destroy();
+  output_y->Destroy();
+  aclopDestroyAttr(attr);
+  return result;
+}
+
+int main(int argc, char* argv[]) {
+  const int64_t rows = argc > 1 ? atoll(argv[1]) : (1 << 20);
+  const int64_t slice = argc > 2 ? atoll(argv[2]) : 64;
+  const int64_t num_indices = argc > 3 ? atoll(argv[3]) : (1 << 16);
+  const int iters = argc > 4 ? atoi(argv[4]) : 5;
+
+  // Init
+  ACL_CALL(aclInit(nullptr));
+  ACL_CALL(aclrtSetDevice(0));
+
+  aclrtStream stream = nullptr;
+  ACL_CALL(aclrtCreateStream(&stream));
+
+  std::mt19937_64 gen(0);
+  const std::vector<int64_t> var_dims{rows, slice};
+  std::vector<float> var(rows * slice);
+  for (auto& v : var) v = static_cast<float>(gen() % 1024);
+  std::vector<float> updates(num_indices * slice);
+  for (auto& v : updates) v = static_cast<float>(gen() % 1024);
+
+  std::cout << "ScatterUpdate var " << rows << "x" << slice << ", " << num_indices << " indices, host threads "
+            << NumHostThreads() << std::endl;
+  std::cout << std::setw(10) << "indices" << std::setw(10) << "distinct" << std::setw(12) << "npu_ms"
+            << std::setw(14) << "npu_upd/s" << std::setw(12) << "ref_ms" << std::setw(14) << "ref_upd/s"
+            << "  duplicates" << std::endl;
+  for (const indexDist dist : {INDEX_RANDOM, INDEX_SORTED, INDEX_CLUSTERED, INDEX_HEAVY_DUP}) {
+    const std::vector<int64_t> indices = ScatterIndices<int64_t>(dist, num_indices, rows, gen);
+    std::vector<int64_t> distinct = indices;
+    std::sort(distinct.begin(), distinct.end());
+    distinct.erase(std::unique(distinct.begin(), distinct.end()), distinct.end());
+
+    std::vector<float> y_last(var.size());
+    Timer timer;
+    RefScatterUpdate(var.data(), var_dims, indices.data(), num_indices, updates.data(), y_last.data());
+    const double ref_ms = timer.ElapsedMs();
+
+    DeviceResult npu = RunScatterUpdate(var, var_dims, indices, updates, iters, stream);
+    std::cout << std::setw(10) << IndexDistName(dist) << std::setw(10) << distinct.size();
+    if (npu.ret != ACL_SUCCESS) {
+      std::cout << std::setw(12) << "error " << npu.ret << std::setw(12) << ref_ms << std::setw(14)
+                << num_indices / ref_ms * 1e3 << std::endl;
+      continue;
+    }
+    std::vector<float> y_first(var.size());
+    RefScatterUpdate(var.data(), var_dims, indices.data(), num_indices, updates.data(), y_first.data(),
+                     SCATTER_DUP_FIRST);
+    const int64_t invalid =
+        ScatterUpdateFirstInvalidRow(var.data(), var_dims, indices.data(), num_indices, updates.data(), npu.y.data());
+    std::cout << std::setw(12) << npu.ms << std::setw(14) << num_indices / npu.ms * 1e3 << std::setw(12) << ref_ms
+              << std::setw(14) << num_indices / ref_ms * 1e3 << "  ";
+    if (npu.y == y_last) {
+      std::cout << "last" << std::endl;
+    } else if (npu.y == y_first) {
+      std::cout << "first" << std::endl;
+    } else if (invalid < 0) {
+      std::cout << "any" << std::endl;
+    } else {
+      std::cout << "none, row " << invalid << " matches no update" << std::endl;
+    }
+  }
+
+  const int64_t n = rows * slice;
+  std::cout << "MaskedScatter " << n << " elements" << std::endl;
+  std::cout << std::setw(10) << "density" << std::setw(12) << "npu_ms" << std::setw(12) << "npu_GB/s"
+            << std::setw(12) << "ref_ms" << std::setw(12) << "ref_GB/s" << "  first_diff" << std::endl;
+  std::vector<float> value(n);
+  for (auto& v : value) v = -static_cast<float>(gen() % 1024);
+  for (const int percent : {1, 50, 99}) {
+    std::vector<char> mask(n);
+    for (auto& m : mask) m = static_cast<int>(gen() % 100) < percent;
+    const bool* mask_ptr = reinterpret_cast<const bool*>(mask.data());
+    std::vector<float> y_ref(n);
+    Timer timer;
+    RefMaskedScatter(var.data(), mask_ptr, value.data(), n, y_ref.data());
+    const double ref_ms = timer.ElapsedMs();
+    // x, mask and y, value read only where the mask is set
+    const double gb = n * (2 * sizeof(float) + sizeof(bool) + sizeof(float) * percent / 100.0) / 1e6;
+
+    DeviceResult npu = RunMaskedScatter(var, mask, value, iters, stream);
+    std::cout << std::setw(9) << percent << "%";
+    if (npu.ret != ACL_SUCCESS) {
+      std::cout << std::setw(12) << "error " << npu.ret << std::setw(12) << ref_ms << std::setw(12) << gb / ref_ms
+                << std::endl;
+      continue;
+    }
+    std::cout << std::setw(12) << npu.ms << std::setw(12) << gb / npu.ms << std::setw(12) << ref_ms << std::setw(12)
+              << gb / ref_ms;
+    const auto diff = std::mismatch(npu.y.begin(), npu.y.end(), y_ref.begin());
+    if (diff.first == npu.y.end()) {
+      std::cout << "  none" << std::endl;
+    } else {
+      std::cout << "  y[" << diff.first - npu.y.begin() << "] npu " << *diff.first << " ref " << *diff.second
+                << std::endl;
+    }
+  }
+
+  ACL_CALL(aclrtDestroyStream(stream));
+
+  // release
+  ACL_CALL(aclrtResetDevice(0));
+  ACL_CALL(aclFinalize());
+
+  return 0;
+}
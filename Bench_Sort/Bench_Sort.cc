@@ -0,0 +1,152 @@
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <vector>
+
+#include "common/nputensor.h"
+#include "common/benchmark.h"
+#include "common/float16.h"
+#include "common/ref_sort.h"
+
+// Sort throughput on the NPU against the CPU radix-sort reference
+// (common/ref_sort.h) over row length and row count, for float, float16 and
+// int64 keys. Outputs are checked against the reference:
+//   value_err  y differs from the sorted values
+//   index_err  indices point at a different value than y
+//   unstable   index differs but points at an equal value
+// The first mismatch of each case is printed with its row and column.
+//
+// usage: ./Bench_Sort [max_cols] [max_keys] [descending] [iters]
+
+static std::mt19937 gen(0);
+
+template <typename T>
+static T RandomKey();
+template <>
+float RandomKey<float>() { return std::uniform_real_distribution<float>(-1000, 1000)(gen); }
+template <>
+float16 RandomKey<float16>() { return float16(std::uniform_real_distribution<float>(-1000, 1000)(gen)); }
+template <>
+int64_t RandomKey<int64_t>() {
+  // beyond the int32 range, with duplicates
+  return (static_cast<int64_t>(gen() % 100000) - 50000) * (1ll << 33);
+}
+
+static bool Equal(float a, float b) { return a == b || (a != a && b != b); }
+static bool Equal(float16 a, float16 b) { return Equal(static_cast<float>(a), static_cast<float>(b)); }
+static bool Equal(int64_t a, int64_t b) { return a == b; }
+
+template <typename T>
+static void RunCase(const char* name, aclDataType dtype, int64_t rows, int64_t cols, bool descending, int iters,
+                    aclrtStream stream) {
+  const std::vector<int64_t> dims{rows, cols};
+  std::vector<T> x(rows * cols);
+  for (auto& v : x) v = RandomKey<T>();
+
+  auto input_x = new npuTensor<T>(dtype, dims.size(), dims.data(), ACL_FORMAT_ND, x.data());
+  auto output_y1 = new npuTensor<T>(dtype, dims.size(), dims.data(), ACL_FORMAT_ND, nullptr);
+  auto output_y2 = new npuTensor<int32_t>(ACL_INT32, dims.size(), dims.data(), ACL_FORMAT_ND, nullptr);
+  std::vector<aclTensorDesc *> input_descs{input_x->desc};
+  std::vector<aclDataBuffer *> input_buffers{input_x->buffer};
+  std::vector<aclTensorDesc *> output_descs{output_y1->desc, output_y2->desc};
+  std::vector<aclDataBuffer *> output_buffers{output_y1->buffer, output_y2->buffer};
+  auto attr = aclopCreateAttr();
+  ACL_CALL(aclopSetAttrInt(attr, "axis", -1));
+  ACL_CALL(aclopSetAttrBool(attr, "descending", descending));
+
+  auto run = [&] {
+    aclError ret = aclopCompileAndExecute("Sort",
+              input_descs.size(), input_descs.data(), input_buffers.data(),
+              output_descs.size(), output_descs.data(), output_buffers.data(),
+              attr, ACL_ENGINE_SYS, ACL_COMPILE_SYS, NULL, stream);
+    return ret != ACL_SUCCESS ? ret : aclrtSynchronizeStream(stream);
+  };
+  // first call compiles
+  aclError ret = run();
+  double npu_ms = 0;
+  if (ret == ACL_SUCCESS) {
+    Timer timer;
+    for (int i = 0; i < iters && ret == ACL_SUCCESS; ++i) {
+      ret = run();
+    }
+    npu_ms = timer.ElapsedMs() / iters;
+  }
+
+  std::vector<T> y_ref(x.size());
+  std::vector<int32_t> index_ref(x.size());
+  Timer timer;
+  RefSort(x.data(), rows, cols, descending, y_ref.data(), index_ref.data());
+  const double ref_ms = timer.ElapsedMs();
+
+  const double keys = static_cast<double>(rows * cols);
+  std::cout << std::setw(8) << name << std::setw(9) << cols << std::setw(6) << rows;
+  if (ret != ACL_SUCCESS) {
+    std::cout << std::setw(12) << "error " << ret << std::setw(12) << ref_ms << std::setw(12)
+              << keys / (ref_ms * 1e3) << std::endl;
+  } else {
+    output_y1->CopyToHost();
+    output_y2->CopyToHost();
+    const T* y = output_y1->data();
+    const int32_t* index = output_y2->data();
+    int64_t value_err = 0;
+    int64_t index_err = 0;
+    int64_t unstable = 0;
+    std::stringstream first;
+    for (int64_t i = 0; i < rows * cols; ++i) {
+      const int64_t r = i / cols;
+      const bool value_ok = Equal(y[i], y_ref[i]);
+      const bool index_valid = index[i] >= 0 && index[i] < cols;
+      const bool index_ok = index_valid && Equal(x[r * cols + index[i]], y[i]);
+      value_err += !value_ok;
+      index_err += !index_ok;
+      unstable += index_ok && index[i] != index_ref[i];
+      if ((!value_ok || !index_ok) && first.str().empty()) {
+        first << "row " << r << " col " << i % cols << ": npu (" << y[i] << ", " << index[i] << ") ref ("
+              << y_ref[i] << ", " << index_ref[i] << ")";
+      }
+    }
+    std::cout << std::setw(12) << npu_ms << std::setw(12) << keys / (npu_ms * 1e3) << std::setw(12) << ref_ms
+              << std::setw(12) << keys / (ref_ms * 1e3) << std::setw(11) << value_err << std::setw(11) << index_err
+              << std::setw(10) << unstable << "  " << first.str() << std::endl;
+  }
+
+  input_x->Destroy();
+  output_y1->Destroy();
+  output_y2->Destroy();
+  aclopDestroyAttr(attr);
+}
+
+int main(int argc, char* argv[]) {
+  const int64_t max_cols = argc > 1 ? atoll(argv[1]) : (1 << 20);
+  const int64_t max_keys = argc > 2 ? atoll(argv[2]) : (1 << 24);
+  const bool descending = argc > 3 ? atoi(argv[3]) != 0 : false;
+  const int iters = argc > 4 ? atoi(argv[4]) : 3;
+
+  // Init
+  ACL_CALL(aclInit(nullptr));
+  ACL_CALL(aclrtSetDevice(0));
+
+  aclrtStream stream = nullptr;
+  ACL_CALL(aclrtCreateStream(&stream));
+
+  std::cout << "descending " << descending << ", host threads " << NumHostThreads() << std::endl;
+  std::cout << std::setw(8) << "dtype" << std::setw(9) << "cols" << std::setw(6) << "rows" << std::setw(12)
+            << "npu_ms" << std::setw(12) << "npu_Mkey/s" << std::setw(12) << "ref_ms" << std::setw(12)
+            << "ref_Mkey/s" << std::setw(11) << "value_err" << std::setw(11) << "index_err" << std::setw(10)
+            << "unstable" << std::endl;
+  for (int64_t cols = 1024; cols <= max_cols; cols *= 4) {
+    for (int64_t rows = 1; rows * cols <= max_keys && rows <= 1024; rows *= 16) {
+      RunCase<float>("float", ACL_FLOAT, rows, cols, descending, iters, stream);
+      RunCase<float16>("float16", ACL_FLOAT16, rows, cols, descending, iters, stream);
+      RunCase<int64_t>("int64", ACL_INT64, rows, cols, descending, iters, stream);
+    }
+  }
+
+  ACL_CALL(aclrtDestroyStream(stream));
+
+  // release
+  ACL_CALL(aclrtResetDevice(0));
+  ACL_CALL(aclFinalize());
+
+  return 0;
+}
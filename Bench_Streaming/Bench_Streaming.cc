@@ -0,0 +1,185 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "common/nputensor.h"
+#include "common/streaming.h"
+#include "common/benchmark.h"
+#include "common/bandwidth.h"
+
+// Stream Add, Fills, BinaryCrossEntropy and ReduceSum over inputs from 256 MB
+// up to 16 GB and report the achieved H2D and D2H throughput, each against
+// the pinned bandwidth of its own direction, taken from the Bench_Bandwidth
+// model when available.
+//
+// usage: ./Bench_Streaming [max_mb] [chunk_mb] [num_buffers]
+
+static const int64_t kCols = 1024;
+
+static void* AllocPinned(size_t bytes) {
+  void* ptr = nullptr;
+  if (aclrtMallocHost(&ptr, bytes) != ACL_SUCCESS) {
+    return nullptr;
+  }
+  return ptr;
+}
+
+// pinned bandwidth of one direction in GB/s, the PCIe reference for this
+// host; 0 if the buffers cannot be allocated
+static double MeasurePinnedBandwidth(aclrtMemcpyKind kind) {
+  const size_t bytes = 256 << 20;
+  void* host_ptr = AllocPinned(bytes);
+  void* device_ptr = nullptr;
+  if (host_ptr == nullptr || aclrtMalloc(&device_ptr, bytes, ACL_MEM_MALLOC_HUGE_FIRST) != ACL_SUCCESS) {
+    if (host_ptr != nullptr) ACL_CALL(aclrtFreeHost(host_ptr));
+    return 0;
+  }
+  const bool h2d = (kind == ACL_MEMCPY_HOST_TO_DEVICE);
+  void* dst = h2d ? device_ptr : host_ptr;
+  void* src = h2d ? host_ptr : device_ptr;
+  ACL_CALL(aclrtMemcpy(dst, bytes, src, bytes, kind));
+  Timer timer;
+  const int iters = 5;
+  for (int i = 0; i < iters; ++i) {
+    ACL_CALL(aclrtMemcpy(dst, bytes, src, bytes, kind));
+  }
+  double gbps = bytes * iters / (timer.ElapsedMs() * 1e6);
+  ACL_CALL(aclrtFree(device_ptr));
+  ACL_CALL(aclrtFreeHost(host_ptr));
+  return gbps;
+}
+
+static double PinnedBandwidth(const std::string& path, aclrtMemcpyKind kind) {
+  BandwidthModel model;
+  return LoadBandwidthModel(path, &model) ? model.gbps : MeasurePinnedBandwidth(kind);
+}
+
+// "<gbps> GB/s (<percent>% of pinned)" for one direction
+static std::string Throughput(size_t bytes, double ms, double pinned_gbps) {
+  const double gbps = bytes / (ms * 1e6);
+  std::ostringstream s;
+  s << gbps << " GB/s";
+  if (pinned_gbps > 0) {
+    s << " (" << 100.0 * gbps / pinned_gbps << "% of pinned)";
+  }
+  return s.str();
+}
+
+static void Report(const std::string& name, size_t input_bytes, const StreamStats& stats, double ms, double h2d_gbps,
+                   double d2h_gbps) {
+  std::cout << name << " input = " << ToMB(input_bytes) << " MB, chunks = " << stats.chunks
+            << ", time = " << ms << " ms, H2D " << Throughput(stats.h2d_bytes, ms, h2d_gbps) << ", D2H "
+            << Throughput(stats.d2h_bytes, ms, d2h_gbps) << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+  const int64_t max_mb = argc > 1 ? atoll(argv[1]) : 16384;
+  const size_t chunk_bytes = (argc > 2 ? atoll(argv[2]) : 64) << 20;
+  const int num_buffers = argc > 3 ? atoi(argv[3]) : 2;
+
+  // Init
+  ACL_CALL(aclInit(nullptr));
+  ACL_CALL(aclrtSetDevice(0));
+
+  const double h2d_gbps = PinnedBandwidth("h2d_pinned_async", ACL_MEMCPY_HOST_TO_DEVICE);
+  const double d2h_gbps = PinnedBandwidth("d2h_pinned_async", ACL_MEMCPY_DEVICE_TO_HOST);
+  std::cout << "pinned bandwidth H2D = " << h2d_gbps << " GB/s, D2H = " << d2h_gbps << " GB/s, chunk = "
+            << ToMB(chunk_bytes) << " MB, buffers = " << num_buffers << std::endl;
+
+  // resident inputs
+  const std::vector<int64_t> bias_dims{1, kCols};
+  const std::vector<float> bias_data(kCols, 1);
+  auto bias = new npuTensor<float>(ACL_FLOAT, bias_dims.size(), bias_dims.data(), ACL_FORMAT_ND, bias_data.data());
+  const std::vector<int64_t> axes_dims{1};
+  const std::vector<int64_t> axes_outer{0};
+  const std::vector<int64_t> axes_inner{1};
+  auto axes_0 = new npuTensor<int64_t>(ACL_INT64, axes_dims.size(), axes_dims.data(), ACL_FORMAT_ND, axes_outer.data(), memType::HOST);
+  auto axes_1 = new npuTensor<int64_t>(ACL_INT64, axes_dims.size(), axes_dims.data(), ACL_FORMAT_ND, axes_inner.data(), memType::HOST);
+
+  for (int64_t mb = 256; mb <= max_mb; mb *= 4) {
+    const size_t bytes = mb << 20;
+    const int64_t rows = bytes / (kCols * sizeof(float));
+    const std::vector<int64_t> dims{rows, kCols};
+    // outputs are written back over x, which is safe because a chunk is only
+    // downloaded after it has been uploaded and executed
+    float* x = static_cast<float *>(AllocPinned(bytes));
+    float* y = static_cast<float *>(AllocPinned(bytes));
+    if (x == nullptr || y == nullptr) {
+      std::cout << "skip " << mb << " MB, pinned host allocation failed" << std::endl;
+      if (x != nullptr) ACL_CALL(aclrtFreeHost(x));
+      if (y != nullptr) ACL_CALL(aclrtFreeHost(y));
+      break;
+    }
+    std::fill(x, x + rows * kCols, 0.5f);
+    std::fill(y, y + rows * kCols, 1.0f);
+    auto split_x = StreamTensor::Split(ACL_FLOAT, dims, ACL_FORMAT_ND, x);
+    auto split_y = StreamTensor::Split(ACL_FLOAT, dims, ACL_FORMAT_ND, y);
+
+    {
+      auto attr = aclopCreateAttr();
+      StreamingExecutor executor("Add", attr, chunk_bytes, num_buffers);
+      Timer timer;
+      auto stats = executor.Run({split_x, StreamTensor::Resident(bias)}, {split_x});
+      Report("Add", bytes, stats, timer.ElapsedMs(), h2d_gbps, d2h_gbps);
+      aclopDestroyAttr(attr);
+    }
+    {
+      auto attr = aclopCreateAttr();
+      ACL_CALL(aclopSetAttrFloat(attr, "value", 0.5));
+      StreamingExecutor executor("Fills", attr, chunk_bytes, num_buffers);
+      Timer timer;
+      auto stats = executor.Run({split_x}, {split_x});
+      Report("Fills", bytes, stats, timer.ElapsedMs(), h2d_gbps, d2h_gbps);
+      aclopDestroyAttr(attr);
+    }
+    {
+      auto attr = aclopCreateAttr();
+      ACL_CALL(aclopSetAttrString(attr, "reduction", "none"));
+      StreamingExecutor executor("BinaryCrossEntropy", attr, chunk_bytes, num_buffers);
+      Timer timer;
+      auto stats = executor.Run({split_x, split_y}, {split_x});
+      Report("BinaryCrossEntropy", 2 * bytes, stats, timer.ElapsedMs(), h2d_gbps, d2h_gbps);
+      aclopDestroyAttr(attr);
+    }
+    {
+      // reduce over the outer dim, partials combined on device
+      std::vector<float> sum(kCols);
+      const std::vector<int64_t> sum_dims{kCols};
+      auto attr = aclopCreateAttr();
+      ACL_CALL(aclopSetAttrBool(attr, "keep_dims", false));
+      StreamingExecutor executor("ReduceSum", attr, chunk_bytes, num_buffers);
+      Timer timer;
+      auto stats = executor.RunReduce({split_y, StreamTensor::Resident(axes_0)},
+                                      StreamTensor::Split(ACL_FLOAT, sum_dims, ACL_FORMAT_ND, sum.data()));
+      Report("ReduceSum(axis 0)", bytes, stats, timer.ElapsedMs(), h2d_gbps, d2h_gbps);
+      std::cout << "sum[0] = " << sum[0] << ", expected " << rows << std::endl;
+      // reduce over the inner dim, row results stream back
+      auto row_sum = static_cast<float *>(AllocPinned(rows * sizeof(float)));
+      if (row_sum != nullptr) {
+        StreamingExecutor executor_inner("ReduceSum", attr, chunk_bytes, num_buffers);
+        Timer timer_inner;
+        stats = executor_inner.Run({split_y, StreamTensor::Resident(axes_1)},
+                                   {StreamTensor::Split(ACL_FLOAT, {rows}, ACL_FORMAT_ND, row_sum)});
+        Report("ReduceSum(axis 1)", bytes, stats, timer_inner.ElapsedMs(), h2d_gbps, d2h_gbps);
+        ACL_CALL(aclrtFreeHost(row_sum));
+      } else {
+        std::cout << "skip ReduceSum(axis 1), pinned host allocation failed" << std::endl;
+      }
+      aclopDestroyAttr(attr);
+    }
+
+    ACL_CALL(aclrtFreeHost(x));
+    ACL_CALL(aclrtFreeHost(y));
+  }
+
+  bias->Destroy();
+  axes_0->Destroy();
+  axes_1->Destroy();
+
+  // release
+  ACL_CALL(aclrtResetDevice(0));
+  ACL_CALL(aclFinalize());
+
+  return 0;
+}
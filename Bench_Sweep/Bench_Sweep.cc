@@ -0,0 +1,88 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "common/nputensor.h"
+#include "common/cmdline.h"
+#include "common/compile_cache.h"
+#include "common/golden_store.h"
+#include "common/opcase.h"
+#include "common/typed_matrix.h"
+
+// Any op over a sweep of shapes, dtypes, formats and attributes given on the
+// command line or in spec files (common/cmdline.h), the op call itself is
+// described at run time (common/opcase.h), e.g. ReduceSum over 3 batch
+// sizes and 2 dtypes:
+//
+//   ./Bench_Sweep op=ReduceSum B=1:4:*2 dtype=fp32,fp16 x0={dtype}:{B}x64x56x56:NCHW x1=int64:1:ND:[1]
+//                 y0={dtype}:{B}x1x56x56:NCHW a.keep_dims=bool:1
+//
+// or with one case per line of a spec file, the command line arguments apply
+// to every line:
+//
+//   ./Bench_Sweep @cases.txt iters=50
+//
+// All configurations run in one process: each compiles on its first launch
+// unless an earlier configuration already compiled the same kernel, then
+// `iters` warm launches are timed. The table has one row per configuration,
+// labelled with the swept parameters; outputs with an @file golden are
+// compared against it. With `store` every configuration is checked against
+// a golden regression store as in Bench_Cases.
+//
+// usage: ./Bench_Sweep op=<type> x0=<dtype:shape[:format[:data]]> ... y0=<dtype:shape[:format]> ...
+//                      [a.<name>=<type:value> ...] [iters=20] [@spec_file ...]
+//                      [store=<dir> [full=0] [update=0]]
+
+int main(int argc, char* argv[]) {
+  const std::vector<CaseParams> configs = ParseSweep(argc, argv);
+  const std::vector<std::string> swept = SweptKeys(configs);
+
+  // Init
+  ACL_CALL(aclInit(nullptr));
+  ACL_CALL(aclrtSetDevice(0));
+
+  aclrtStream stream = nullptr;
+  ACL_CALL(aclrtCreateStream(&stream));
+
+  GoldenStore* store = nullptr;
+  if (!configs.empty() && configs[0].Has("store")) {
+    store = new GoldenStore(configs[0].Get("store"), configs[0].Bool("full", false),
+                            configs[0].Bool("update", false));
+  }
+
+  MatrixTable table;
+  CompileCounter kernels;
+  ForEachConfig(configs, [&](const CaseParams& p) {
+    const int iters = p.Int("iters", 20);
+    const OpCase c = OpCase::FromParams(p);
+    std::string error;
+    if (!c.CheckFiles(&error)) {
+      LOG(WARNING) << error << ", skipped";
+      return;
+    }
+    OpCaseRun run(c);
+    kernels.Add(run.Key());
+    MatrixCell cell = run.Time(iters, stream);
+    cell.config = Label(p, swept);
+    if (store != nullptr && cell.supported()) {
+      cell.golden = GoldenStatusName(run.CheckGolden(store, c.op + " " + cell.config));
+    }
+    table.Add(cell);
+  });
+
+  std::cout << std::endl;
+  table.Print();
+  std::cout << configs.size() << " configurations, " << kernels.count() << " distinct kernels" << std::endl;
+  if (store != nullptr) {
+    store->Save();
+    delete store;
+  }
+
+  ACL_CALL(aclrtDestroyStream(stream));
+
+  // release
+  ACL_CALL(aclrtResetDevice(0));
+  ACL_CALL(aclFinalize());
+
+  return 0;
+}
@@ -0,0 +1,87 @@
+#include <iostream>
+#include <vector>
+
+#include "common/nputensor.h"
+#include "common/benchmark.h"
+
+// Host-visible Add round trip (write inputs, execute, read output) with
+// staged H2D/D2H copies vs zero-copy binding. Zero-copy is only measured when
+// the process runs in ACL_DEVICE mode.
+//
+// usage: ./Bench_ZeroCopy [numel] [iters]
+
+static double RunAdd(int64_t numel, int iters, copyStrategy strategy) {
+  CopyStrategy() = strategy;
+  const std::string op_type = "Add";
+  const std::vector<int64_t> dims{numel};
+  auto x = new npuTensor<float>(ACL_FLOAT, dims.size(), dims.data(), ACL_FORMAT_ND, nullptr);
+  auto y = new npuTensor<float>(ACL_FLOAT, dims.size(), dims.data(), ACL_FORMAT_ND, nullptr);
+  auto out = new npuTensor<float>(ACL_FLOAT, dims.size(), dims.data(), ACL_FORMAT_ND, nullptr);
+  std::vector<aclTensorDesc *> input_descs{x->desc, y->desc};
+  std::vector<aclDataBuffer *> input_buffers{x->buffer, y->buffer};
+  std::vector<aclTensorDesc *> output_descs{out->desc};
+  std::vector<aclDataBuffer *> output_buffers{out->buffer};
+  auto attr = aclopCreateAttr();
+  aclrtStream stream = nullptr;
+  ACL_CALL(aclrtCreateStream(&stream));
+
+  double total_ms = 0;
+  for (int i = 0; i <= iters; ++i) {
+    Timer timer;
+    std::fill(x->data(), x->data() + numel, static_cast<float>(i));
+    std::fill(y->data(), y->data() + numel, 1.0f);
+    x->CopyToDevice();
+    y->CopyToDevice();
+    ACL_CALL(aclopCompileAndExecute(op_type.c_str(),
+              input_descs.size(), input_descs.data(), input_buffers.data(),
+              output_descs.size(), output_descs.data(), output_buffers.data(),
+              attr, ACL_ENGINE_SYS, ACL_COMPILE_SYS, NULL, stream));
+    ACL_CALL(aclrtSynchronizeStream(stream));
+    out->CopyToHost();
+    volatile float last = out->data()[numel - 1];
+    (void)last;
+    // first iteration compiles the op
+    if (i > 0) {
+      total_ms += timer.ElapsedMs();
+    }
+  }
+
+  ACL_CALL(aclrtDestroyStream(stream));
+  aclopDestroyAttr(attr);
+  x->Destroy();
+  y->Destroy();
+  out->Destroy();
+  return total_ms / iters;
+}
+
+int main(int argc, char* argv[]) {
+  const int64_t numel = argc > 1 ? atoll(argv[1]) : (64 << 20);
+  const int iters = argc > 2 ? atoi(argv[2]) : 10;
+
+  // Init
+  ACL_CALL(aclInit(nullptr));
+  ACL_CALL(aclrtSetDevice(0));
+
+  // Get Run Mode - ACL_HOST
+  aclrtRunMode runMode;
+  ACL_CALL(aclrtGetRunMode(&runMode));
+  std::string run_mode_str = (runMode == ACL_DEVICE) ? "ACL_DEVICE" : "ACL_HOST";
+  std::cout << "aclrtRunMode is : " << run_mode_str << std::endl;
+
+  const size_t bytes = numel * sizeof(float);
+  const double staged_ms = RunAdd(numel, iters, copyStrategy::STAGED);
+  std::cout << "staged    : " << staged_ms << " ms, copies = " << ToMB(3 * bytes) << " MB per run" << std::endl;
+  if (runMode == ACL_DEVICE) {
+    const double zero_copy_ms = RunAdd(numel, iters, copyStrategy::ZERO_COPY);
+    std::cout << "zero-copy : " << zero_copy_ms << " ms, copies = 0 MB per run, speedup = "
+              << staged_ms / zero_copy_ms << "x" << std::endl;
+  } else {
+    std::cout << "zero-copy : not available in ACL_HOST mode, staged copies are required" << std::endl;
+  }
+
+  // release
+  ACL_CALL(aclrtResetDevice(0));
+  ACL_CALL(aclFinalize());
+
+  return 0;
+}
@@ -2,6 +2,8 @@
 #include <vector>
 
 #include "common/nputensor.h"
+#include "common/ref_broadcast.h"
+#include "common/compare.h"
 
 int main() {
   // Init
@@ -65,6 +67,15 @@ int main() {
   // print output
   output_y->Print("y");
 
+  // verify against the CPU reference
+  StrideView<int64_t> view;
+  CHECK(BroadcastToView(x_data.data(), x_dims, sizes_data, &view)) << "x is not broadcastable to sizes";
+  std::vector<int64_t> y_ref(view.numel());
+  Materialize(view, y_ref.data());
+  output_y->CopyToHost();
+  const CompareReport report = Compare(output_y->data(), y_ref.data(), y_dims);
+  report.Print("y");
+
   // destroy
   input_x->Destroy();
   input_sizes->Destroy();
@@ -76,5 +87,5 @@ int main() {
   ACL_CALL(aclrtResetDevice(0));
   ACL_CALL(aclFinalize());
 
-  return 0;
+  return report.ok() ? 0 : 1;
 }
\ No newline at end of file
@@ -2,6 +2,9 @@
 #include <vector>
 
 #include "common/nputensor.h"
+#include "common/ref_deformable_offsets.h"
+#include "common/compare.h"
+#include "common/random.h"
 
 static int64_t get_numel(const std::vector<int64_t>& dims) {
   return std::accumulate(dims.begin(), dims.end(), 1, std::multiplies<int64_t>());
@@ -22,23 +25,34 @@ int main() {
   const std::string op_type = "DeformableOffsets";
   const int64_t kernel_h = 3;
   const int64_t kernel_w = 3;
-  // input - x
+  // input - x, uniform in [-1, 1)
   const std::vector<int64_t> x_dims{4, 3, 10, 10};
   const int64_t x_numel = get_numel(x_dims);
   std::vector<float> x_data(x_numel);
-  std::iota(x_data.begin(), x_data.end(), 0);
-  // input - offset
+  RandomUniform(x_data.data(), x_numel, -1.0, 1.0, 0);
+  // attr
+  DeformableOffsetsParams params;
+  params.ksize = {kernel_h, kernel_w};
+  params.strides = {1, 1, 1, 1};
+  params.pads = {0, 0, 0, 0};
+  params.dilations = {1, 1, 1, 1};
+  params.deformable_groups = 1;
+  params.modulated = true;
+  // input - offset, per batch the x / y offsets in [-2, 2] and then the masks
+  // in [0, 1]; zero masks would make y all zeros and the check trivial, and
+  // offsets up to 2 also sample across the border
   const std::vector<int64_t> offset_dims{4, 3 * kernel_h * kernel_w, 8, 8};
   const int64_t offset_numel = get_numel(offset_dims);
-  const std::vector<float> offset_data(offset_numel, 0.0);
+  const int64_t block = offset_numel / offset_dims[0] / 3;
+  std::vector<float> offset_data(offset_numel);
+  for (int64_t n = 0; n < offset_dims[0]; ++n) {
+    float* off = offset_data.data() + n * 3 * block;
+    RandomUniform(off, 2 * block, -2.0, 2.0, 1, n * 2 * block);
+    RandomUniform(off + 2 * block, block, 0.0, 1.0, 2, n * block);
+  }
   // output
   const std::vector<int64_t> y_dims{4, 3, 8 * 3, 8 * 3};
   const int64_t y_numel = get_numel(y_dims);
-  // attr
-  const std::vector<int64_t> ksize{kernel_h, kernel_w};
-  const std::vector<int64_t> strides{1, 1, 1, 1};
-  const std::vector<int64_t> pads{0, 0, 0, 0};
-  const std::vector<int64_t> dilations{1, 1, 1, 1};
 
   // inputs
   auto input_x = new npuTensor<float>(ACL_FLOAT, x_dims.size(), x_dims.data(), ACL_FORMAT_NCHW, x_data.data());
@@ -61,13 +75,13 @@ int main() {
   
   // attributes
   auto attr = aclopCreateAttr();
-  ACL_CALL(aclopSetAttrListInt(attr, "ksize", ksize.size(), ksize.data()));
-  ACL_CALL(aclopSetAttrListInt(attr, "strides", strides.size(), strides.data()));
-  ACL_CALL(aclopSetAttrListInt(attr, "pads", pads.size(), pads.data()));
-  ACL_CALL(aclopSetAttrListInt(attr, "dilations", dilations.size(), dilations.data()));
-  ACL_CALL(aclopSetAttrInt(attr, "deformable_groups", 1));
+  ACL_CALL(aclopSetAttrListInt(attr, "ksize", params.ksize.size(), params.ksize.data()));
+  ACL_CALL(aclopSetAttrListInt(attr, "strides", params.strides.size(), params.strides.data()));
+  ACL_CALL(aclopSetAttrListInt(attr, "pads", params.pads.size(), params.pads.data()));
+  ACL_CALL(aclopSetAttrListInt(attr, "dilations", params.dilations.size(), params.dilations.data()));
+  ACL_CALL(aclopSetAttrInt(attr, "deformable_groups", params.deformable_groups));
   ACL_CALL(aclopSetAttrString(attr, "data_format", "NCHW"));
-  ACL_CALL(aclopSetAttrBool(attr, "modulated", true));
+  ACL_CALL(aclopSetAttrBool(attr, "modulated", params.modulated));
 
   // create stream
   aclrtStream stream = nullptr;
@@ -86,6 +100,13 @@ int main() {
   // print output
 //   output_y->Print("y");
 
+  // verify against the CPU reference
+  std::vector<float> y_ref(y_numel);
+  RefDeformableOffsets(x_data.data(), x_dims, offset_data.data(), params, y_ref.data());
+  output_y->CopyToHost();
+  const CompareReport report = Compare(output_y->data(), y_ref.data(), y_dims, Tolerance::Abs(1e-3));
+  report.Print("y");
+
   // destroy
   input_x->Destroy();
   input_offset->Destroy();
@@ -97,5 +118,5 @@ int main() {
   ACL_CALL(aclrtResetDevice(0));
   ACL_CALL(aclFinalize());
 
-  return 0;
+  return report.ok() ? 0 : 1;
 }
\ No newline at end of file
@@ -2,6 +2,8 @@
 #include <vector>
 
 #include "common/nputensor.h"
+#include "common/ref_broadcast.h"
+#include "common/compare.h"
 
 int main() {
   // Init
@@ -65,6 +67,20 @@ int main() {
   // print output
   output_y->Print("y");
 
+  // verify against the CPU reference
+  bool ok = true;
+  StrideView<float> view;
+  if (BroadcastToView(x_data.data(), x_dims, sizes_data, &view)) {
+    std::vector<float> y_ref(view.numel());
+    Materialize(view, y_ref.data());
+    output_y->CopyToHost();
+    const CompareReport report = Compare(output_y->data(), y_ref.data(), y_dims);
+    report.Print("y");
+    ok = report.ok();
+  } else {
+    std::cout << "x is not broadcastable to sizes, skip the CPU reference" << std::endl;
+  }
+
   // destroy
   input_x->Destroy();
   input_sizes->Destroy();
@@ -76,5 +92,5 @@ int main() {
   ACL_CALL(aclrtResetDevice(0));
   ACL_CALL(aclFinalize());
 
-  return 0;
+  return ok ? 0 : 1;
 }
\ No newline at end of file
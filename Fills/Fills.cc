@@ -5,27 +5,23 @@
 #include <numeric>
 
 #include "common/nputensor.h"
+#include "common/cmdline.h"
 
-int main() {
-  // Init
-  ACL_CALL(aclInit(nullptr));
-  ACL_CALL(aclrtSetDevice(0));
-
-  // Get Run Mode - ACL_HOST
-  aclrtRunMode runMode;
-  ACL_CALL(aclrtGetRunMode(&runMode));
-  std::string run_mode_str = (runMode == ACL_DEVICE) ? "ACL_DEVICE" : "ACL_HOST";
-  std::cout << "aclrtRunMode is : " << run_mode_str << std::endl;
-
+// usage: ./Fills [key=value ...], any value can be a sweep (common/cmdline.h)
+//   shape  x and y, default 32x32
+//   value  attr value, default 3.0
+void Run(const CaseParams& p) {
   // op type
   const std::string op_type = "Fills";
   // input - dims
-  const std::vector<int64_t> input_dims{32, 32};
-  const std::vector<int64_t> input_data(1024, 1);
+  const std::vector<int64_t> input_dims = p.Ints("shape", {32, 32});
+  int64_t numel = 1;
+  for (auto d : input_dims) numel *= d;
+  const std::vector<int64_t> input_data(numel, 1);
   // output
-  const std::vector<int64_t> output_dims{32, 32};
+  const std::vector<int64_t> output_dims = input_dims;
   // attr
-  const float value = 3.0;
+  const float value = p.Float("value", 3.0);
 
   // input - dims
   auto input = new npuTensor<int64_t>(ACL_INT64, input_dims.size(), input_dims.data(), ACL_FORMAT_ND, input_data.data(), memType::HOST);
@@ -71,6 +67,22 @@ int main() {
   output->Destroy();
 
   aclopDestroyAttr(attr);
+}
+
+int main(int argc, char* argv[]) {
+  const std::vector<CaseParams> configs = ParseSweep(argc, argv);
+
+  // Init
+  ACL_CALL(aclInit(nullptr));
+  ACL_CALL(aclrtSetDevice(0));
+
+  // Get Run Mode - ACL_HOST
+  aclrtRunMode runMode;
+  ACL_CALL(aclrtGetRunMode(&runMode));
+  std::string run_mode_str = (runMode == ACL_DEVICE) ? "ACL_DEVICE" : "ACL_HOST";
+  std::cout << "aclrtRunMode is : " << run_mode_str << std::endl;
+
+  ForEachConfig(configs, Run);
 
   // release
   ACL_CALL(aclrtResetDevice(0));
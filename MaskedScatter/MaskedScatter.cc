@@ -2,6 +2,8 @@
 #include <vector>
 
 #include "common/nputensor.h"
+#include "common/ref_scatter.h"
+#include "common/compare.h"
 
 int main() {
   // Init
@@ -73,6 +75,13 @@ int main() {
   // print output
   output_y->Print("y");
 
+  // verify against the CPU reference
+  std::vector<float> y_ref(x_data.size());
+  RefMaskedScatter(x_data.data(), mask_data, value_data.data(), x_data.size(), y_ref.data());
+  output_y->CopyToHost();
+  const CompareReport report = Compare(output_y->data(), y_ref.data(), y_dims);
+  report.Print("y");
+
   // destroy
   input_x->Destroy();
   input_mask->Destroy();
@@ -85,5 +94,5 @@ int main() {
   ACL_CALL(aclrtResetDevice(0));
   ACL_CALL(aclFinalize());
 
-  return 0;
+  return report.ok() ? 0 : 1;
 }
\ No newline at end of file
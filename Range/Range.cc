@@ -5,6 +5,7 @@
 #include <numeric>
 
 #include "common/nputensor.h"
+#include "common/memplan.h"
 
 int main() {
   // Init
@@ -27,10 +28,10 @@ int main() {
   // output - y
   const std::vector<int64_t> output_dims{7};
 
-  // input - dims
-  auto input_start = new npuTensor<float>(ACL_FLOAT, input_dims.size(), input_dims.data(), ACL_FORMAT_NCHW, input_data_start.data(), memType::DEVICE);
-  auto input_limit = new npuTensor<float>(ACL_FLOAT, input_dims.size(), input_dims.data(), ACL_FORMAT_NCHW, input_data_limit.data(), memType::DEVICE);
-  auto input_delta = new npuTensor<float>(ACL_FLOAT, input_dims.size(), input_dims.data(), ACL_FORMAT_NCHW, input_data_delta.data(), memType::DEVICE);
+  // input - start, limit, delta decide the output shape, planned on host as const
+  auto input_start = PlanInput<float>(op_type, 0, ACL_FLOAT, input_dims.size(), input_dims.data(), ACL_FORMAT_NCHW, input_data_start.data());
+  auto input_limit = PlanInput<float>(op_type, 1, ACL_FLOAT, input_dims.size(), input_dims.data(), ACL_FORMAT_NCHW, input_data_limit.data());
+  auto input_delta = PlanInput<float>(op_type, 2, ACL_FLOAT, input_dims.size(), input_dims.data(), ACL_FORMAT_NCHW, input_data_delta.data());
 
   // set inputs desc and buffer
   std::vector<aclTensorDesc *> input_descs;
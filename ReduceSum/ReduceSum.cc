@@ -2,36 +2,90 @@
 #include <vector>
 
 #include "common/nputensor.h"
-
-int main() {
-  // Init
-  ACL_CALL(aclInit(nullptr));
-  ACL_CALL(aclrtSetDevice(0));
-
-  // Get Run Mode - ACL_HOST
-  aclrtRunMode runMode;
-  ACL_CALL(aclrtGetRunMode(&runMode));
-  std::string run_mode_str = (runMode == ACL_DEVICE) ? "ACL_DEVICE" : "ACL_HOST";
-  std::cout << "aclrtRunMode is : " << run_mode_str << std::endl;
-
+#include "common/benchmark.h"
+#include "common/cmdline.h"
+#include "common/compare.h"
+#include "common/dtype.h"
+#include "common/memplan.h"
+#include "common/random.h"
+
+// usage: ./ReduceSum [dtype] [iters] [key=value ...], any value can be a sweep (common/cmdline.h)
+//   dtype      fp32 (default), fp16 or bf16
+//   iters      warm runs timed after the first, compiling one (default 0)
+//   shape      x, default 3x2x3x2
+//   axes       default [1]
+//   keep_dims  default 1
+//   format     of x and y, default NCHW
+
+// sum of x over the reduced dims, accumulated in double; y keeps the order of
+// the remaining dims, so keep_dims does not change the flat layout
+template <typename T>
+static std::vector<float> RefReduceSum(const std::vector<T>& x, const std::vector<int64_t>& x_dims,
+                                       const std::vector<bool>& reduced) {
+  // row-major strides of y, 0 along reduced dims
+  std::vector<int64_t> y_strides(x_dims.size(), 0);
+  int64_t y_numel = 1;
+  for (size_t d = x_dims.size(); d-- > 0;) {
+    if (!reduced[d]) {
+      y_strides[d] = y_numel;
+      y_numel *= x_dims[d];
+    }
+  }
+  std::vector<double> sum(y_numel, 0.0);
+  std::vector<int64_t> coord(x_dims.size(), 0);
+  int64_t y_index = 0;
+  for (size_t i = 0; i < x.size(); ++i) {
+    sum[y_index] += static_cast<float>(x[i]);
+    for (size_t d = x_dims.size(); d-- > 0;) {
+      y_index += y_strides[d];
+      if (++coord[d] < x_dims[d]) {
+        break;
+      }
+      y_index -= y_strides[d] * x_dims[d];
+      coord[d] = 0;
+    }
+  }
+  return std::vector<float>(sum.begin(), sum.end());
+}
+
+template <typename T>
+bool Run(aclDataType dtype, const CaseParams& p) {
+  const int iters = p.Int("iters", 0);
   // op type
   const std::string op_type = "ReduceSum";
 
-  // input - X
-  const std::vector<int64_t> x_dims{3, 2, 3, 2};
-  std::vector<float> x_data(36);
-  std::iota(x_data.begin(), x_data.end(), 0);
+  // input - X, uniform in [-1, 1): iota leaves the fp16 range beyond tiny shapes
+  const std::vector<int64_t> x_dims = p.Ints("shape", {3, 2, 3, 2});
+  int64_t numel = 1;
+  for (auto d : x_dims) numel *= d;
+  std::vector<T> x_data(numel);
+  RandomUniform(x_data.data(), x_data.size(), -1.0, 1.0, 0);
+  const aclFormat format = p.Format("format", ACL_FORMAT_NCHW);
   // input - axes
-  const std::vector<int64_t> a_dims{1};
-  const std::vector<int64_t> axes{1};
+  const std::vector<int64_t> axes = p.Ints("axes", {1});
+  const std::vector<int64_t> a_dims{static_cast<int64_t>(axes.size())};
   // attr
-  const bool keep_dims = true;
+  const bool keep_dims = p.Bool("keep_dims", true);
   // output - y
-  const std::vector<int64_t> y_dims{3, 1, 3, 2};
+  std::vector<bool> reduced(x_dims.size(), false);
+  for (auto axis : axes) {
+    const int64_t rank = x_dims.size();
+    CHECK(axis >= -rank && axis < rank) << "axis " << axis << " out of range for rank " << rank;
+    reduced[axis < 0 ? axis + rank : axis] = true;
+  }
+  std::vector<int64_t> y_dims;
+  for (size_t d = 0; d < x_dims.size(); ++d) {
+    if (!reduced[d]) {
+      y_dims.push_back(x_dims[d]);
+    } else if (keep_dims) {
+      y_dims.push_back(1);
+    }
+  }
 
   // input - x
-  auto x = new npuTensor<float>(ACL_FLOAT, x_dims.size(), x_dims.data(), ACL_FORMAT_NCHW, x_data.data());
-  auto a =  new npuTensor<int64_t>(ACL_INT64, a_dims.size(), a_dims.data(), ACL_FORMAT_ND, axes.data(), memType::HOST);
+  auto x = new npuTensor<T>(dtype, x_dims.size(), x_dims.data(), format, x_data.data());
+  // axes - shape-like, planned on host as const
+  auto a = PlanInput<int64_t>(op_type, 1, ACL_INT64, a_dims.size(), a_dims.data(), ACL_FORMAT_ND, axes.data());
 
   // set inputs desc and buffer
   std::vector<aclTensorDesc *> input_descs;
@@ -42,7 +96,7 @@ int main() {
   input_buffers.emplace_back(a->buffer);
 
   // output - y
-  auto y = new npuTensor<float>(ACL_FLOAT, y_dims.size(), y_dims.data(), ACL_FORMAT_NCHW, nullptr);
+  auto y = new npuTensor<T>(dtype, y_dims.size(), y_dims.data(), format, nullptr);
 
   // set output desc and buffer
   std::vector<aclTensorDesc *> output_descs;
@@ -58,30 +112,73 @@ int main() {
   aclrtStream stream = nullptr;
   ACL_CALL(aclrtCreateStream(&stream));
 
-  std::cout << "aclopCompileAndExecute : " << op_type << std::endl;
-  ACL_CALL(aclopCompileAndExecute(op_type.c_str(), 
-            input_descs.size(), input_descs.data(), input_buffers.data(), 
-            output_descs.size(), output_descs.data(), output_buffers.data(), 
-            attr, ACL_ENGINE_SYS, ACL_COMPILE_SYS, NULL, stream));
-
-  // sync and destroy stream
-  ACL_CALL(aclrtSynchronizeStream(stream));
+  auto run = [&]() {
+    ACL_CALL(aclopCompileAndExecute(op_type.c_str(), 
+              input_descs.size(), input_descs.data(), input_buffers.data(), 
+              output_descs.size(), output_descs.data(), output_buffers.data(), 
+              attr, ACL_ENGINE_SYS, ACL_COMPILE_SYS, NULL, stream));
+    ACL_CALL(aclrtSynchronizeStream(stream));
+  };
+  std::cout << "aclopCompileAndExecute : " << op_type << " " << DataTypeName(dtype) << std::endl;
+  run();
+  if (iters > 0) {
+    Timer timer;
+    for (int i = 0; i < iters; ++i) {
+      run();
+    }
+    std::cout << op_type << " " << DataTypeName(dtype) << ": " << timer.ElapsedMs() / iters << " ms" << std::endl;
+  }
+
+  // destroy stream
   ACL_CALL(aclrtDestroyStream(stream));
 
   // print output
   x->Print("x");
   y->Print("y");
 
+  // verify against the CPU reference
+  const std::vector<float> y_ref = RefReduceSum(x_data, x_dims, reduced);
+  y->CopyToHost();
+  const Tolerance tol = dtype == ACL_FLOAT ? Tolerance::Rel(1e-4) : Tolerance::For(dtype);
+  const CompareReport report = Compare(y->data(), y_ref.data(), y_dims, tol);
+  report.Print("y");
+
   // destroy - inputs
   x->Destroy();
+  a->Destroy();
   // destroy - outputs
   y->Destroy();
 
   aclopDestroyAttr(attr);
+  return report.ok();
+}
+
+int main(int argc, char* argv[]) {
+  const std::vector<CaseParams> configs = ParseSweep(argc, argv, {"dtype", "iters"});
+
+  // Init
+  ACL_CALL(aclInit(nullptr));
+  ACL_CALL(aclrtSetDevice(0));
+
+  // Get Run Mode - ACL_HOST
+  aclrtRunMode runMode;
+  ACL_CALL(aclrtGetRunMode(&runMode));
+  std::string run_mode_str = (runMode == ACL_DEVICE) ? "ACL_DEVICE" : "ACL_HOST";
+  std::cout << "aclrtRunMode is : " << run_mode_str << std::endl;
+
+  bool ok = true;
+  ForEachConfig(configs, [&ok](const CaseParams& p) {
+    const aclDataType dtype = ParseFloatType(p.Get("dtype"));
+    switch (dtype) {
+      case ACL_FLOAT16: ok = Run<float16>(dtype, p) && ok; break;
+      case ACL_BF16: ok = Run<bfloat16>(dtype, p) && ok; break;
+      default: ok = Run<float>(dtype, p) && ok; break;
+    }
+  });
 
   // release
   ACL_CALL(aclrtResetDevice(0));
   ACL_CALL(aclFinalize());
 
-  return 0;
+  return ok ? 0 : 1;
 }
\ No newline at end of file
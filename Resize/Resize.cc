@@ -2,6 +2,8 @@
 #include <vector>
 
 #include "common/nputensor.h"
+#include "common/memplan.h"
+#include "common/ref_resize.h"
 
 int main() {
   // Init
@@ -33,9 +35,10 @@ int main() {
 
   // input - x
   auto input_x = new npuTensor<float>(ACL_FLOAT, x_dims.size(), x_dims.data(), ACL_FORMAT_NCHW, x_data.data(), memType::HOST);
-  auto input_roi = new npuTensor<float>(ACL_FLOAT, roi_dims.size(), roi_dims.data(), ACL_FORMAT_ND, roi_data.data(), memType::HOST);
-  auto input_scales = new npuTensor<float>(ACL_FLOAT, scales_dims.size(), scales_dims.data(), ACL_FORMAT_ND, scales_data.data(), memType::HOST);
-  auto input_sizes = new npuTensor<int64_t>(ACL_INT64, sizes_dims.size(), sizes_dims.data(), ACL_FORMAT_ND, sizes_data.data(), memType::HOST);
+  // roi, scales, sizes - planned on host as const
+  auto input_roi = PlanInput<float>(op_type, 1, ACL_FLOAT, roi_dims.size(), roi_dims.data(), ACL_FORMAT_ND, roi_data.data());
+  auto input_scales = PlanInput<float>(op_type, 2, ACL_FLOAT, scales_dims.size(), scales_dims.data(), ACL_FORMAT_ND, scales_data.data());
+  auto input_sizes = PlanInput<int64_t>(op_type, 3, ACL_INT64, sizes_dims.size(), sizes_dims.data(), ACL_FORMAT_ND, sizes_data.data());
 
   // set inputs desc and buffer
   std::vector<aclTensorDesc *> input_descs;
@@ -60,12 +63,21 @@ int main() {
 
   // attributes
   auto attr = aclopCreateAttr();
-  ACL_CALL(aclopSetAttrString(attr, "coordinate_transformation_mode", "align_corners"));
-  ACL_CALL(aclopSetAttrFloat(attr, "cubic_coeff_a", -0.75));
-  ACL_CALL(aclopSetAttrInt(attr, "exclude_outside", 0));
-  ACL_CALL(aclopSetAttrFloat(attr, "extrapolation_value", 0));
-  ACL_CALL(aclopSetAttrString(attr, "mode", "nearest"));
-  ACL_CALL(aclopSetAttrString(attr, "nearest_mode", "round_prefer_floor"));
+  ResizeParams params;
+  params.coordinate_transformation_mode = "align_corners";
+  params.cubic_coeff_a = -0.75;
+  params.exclude_outside = false;
+  params.extrapolation_value = 0;
+  params.mode = "nearest";
+  params.nearest_mode = "round_prefer_floor";
+  params.scale_h = scales_data[0];
+  params.scale_w = scales_data[1];
+  ACL_CALL(aclopSetAttrString(attr, "coordinate_transformation_mode", params.coordinate_transformation_mode.c_str()));
+  ACL_CALL(aclopSetAttrFloat(attr, "cubic_coeff_a", params.cubic_coeff_a));
+  ACL_CALL(aclopSetAttrInt(attr, "exclude_outside", params.exclude_outside));
+  ACL_CALL(aclopSetAttrFloat(attr, "extrapolation_value", params.extrapolation_value));
+  ACL_CALL(aclopSetAttrString(attr, "mode", params.mode.c_str()));
+  ACL_CALL(aclopSetAttrString(attr, "nearest_mode", params.nearest_mode.c_str()));
 
 
   std::cout << "aclopInferShape : " << op_type << std::endl;
@@ -104,6 +116,15 @@ int main() {
   // print output
   // output_y->Print("y");
 
+  // CPU reference, to compare against once execution above works
+  std::vector<float> y_ref(y_dims[0] * y_dims[1] * y_dims[2] * y_dims[3]);
+  RefResize(x_data.data(), x_dims, y_dims[2], y_dims[3], params, y_ref.data());
+  std::cout << "y_ref = [";
+  for (float v : y_ref) {
+    std::cout << v << ", ";
+  }
+  std::cout << "]" << std::endl;
+
   // destroy
   input_x->Destroy();
   input_roi->Destroy();
@@ -1,7 +1,11 @@
+#include <cmath>
 #include <iostream>
 #include <vector>
 
 #include "common/nputensor.h"
+#include "common/memplan.h"
+#include "common/ref_resize.h"
+#include "common/compare.h"
 
 int main() {
   // Init
@@ -27,7 +31,7 @@ int main() {
 
   // input - x
   auto input_x = new npuTensor<float>(ACL_FLOAT, x_dims.size(), x_dims.data(), ACL_FORMAT_NCHW, x_data.data());
-  auto input_sizes = new npuTensor<int64_t>(ACL_INT64, sizes_dims.size(), sizes_dims.data(), ACL_FORMAT_ND, sizes_data.data(), memType::HOST);
+  auto input_sizes = PlanInput<int64_t>(op_type, 1, ACL_INT64, sizes_dims.size(), sizes_dims.data(), ACL_FORMAT_ND, sizes_data.data());
 
   // set inputs desc and buffer
   std::vector<aclTensorDesc *> input_descs;
@@ -48,8 +52,10 @@ int main() {
 
   // attributes
   auto attr = aclopCreateAttr();
-  ACL_CALL(aclopSetAttrBool(attr, "align_corners", false));
-  ACL_CALL(aclopSetAttrBool(attr, "half_pixel_centers", false));
+  const bool align_corners = false;
+  const bool half_pixel_centers = false;
+  ACL_CALL(aclopSetAttrBool(attr, "align_corners", align_corners));
+  ACL_CALL(aclopSetAttrBool(attr, "half_pixel_centers", half_pixel_centers));
 
   // create stream
   aclrtStream stream = nullptr;
@@ -70,6 +76,13 @@ int main() {
   input_sizes->Print("sizes");
   output_y->Print("y");
 
+  // verify against the CPU reference
+  std::vector<float> y_ref(output_y->size / sizeof(float));
+  RefResize(x_data.data(), x_dims, y_dims[2], y_dims[3], ResizeParams::FromV2("linear", align_corners, half_pixel_centers), y_ref.data());
+  output_y->CopyToHost();
+  const CompareReport report = Compare(output_y->data(), y_ref.data(), y_dims, Tolerance::Abs(1e-3));
+  report.Print("y");
+
   // destroy
   input_x->Destroy();
   input_sizes->Destroy();
@@ -81,5 +94,5 @@ int main() {
   ACL_CALL(aclrtResetDevice(0));
   ACL_CALL(aclFinalize());
 
-  return 0;
+  return report.ok() ? 0 : 1;
 }
\ No newline at end of file
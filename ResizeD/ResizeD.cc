@@ -1,6 +1,7 @@
 #include <iostream>
 #include <vector>
 #include "common/nputensor.h"
+#include "common/ref_resize.h"
 
 int main() {
   // Init
@@ -48,12 +49,21 @@ int main() {
   ACL_CALL(aclopSetAttrListInt(attr, "sizes", sizes.size(), sizes.data()));
   ACL_CALL(aclopSetAttrListFloat(attr, "scales", scales.size(), scales.data()));
   ACL_CALL(aclopSetAttrListInt(attr, "roi", roi.size(), roi.data()));
-  ACL_CALL(aclopSetAttrString(attr, "coordinate_transformation_mode", "align_corners"));
-  ACL_CALL(aclopSetAttrFloat(attr, "cubic_coeff_a", -0.75));
-  ACL_CALL(aclopSetAttrInt(attr, "exclude_outside", 0));
-  ACL_CALL(aclopSetAttrFloat(attr, "extrapolation_value", 0.0));
-  ACL_CALL(aclopSetAttrString(attr, "mode", "nearest"));
-  ACL_CALL(aclopSetAttrString(attr, "nearest_mode", "round_prefer_floor"));
+  ResizeParams params;
+  params.coordinate_transformation_mode = "align_corners";
+  params.cubic_coeff_a = -0.75;
+  params.exclude_outside = false;
+  params.extrapolation_value = 0;
+  params.mode = "nearest";
+  params.nearest_mode = "round_prefer_floor";
+  params.scale_h = scales[0];
+  params.scale_w = scales[1];
+  ACL_CALL(aclopSetAttrString(attr, "coordinate_transformation_mode", params.coordinate_transformation_mode.c_str()));
+  ACL_CALL(aclopSetAttrFloat(attr, "cubic_coeff_a", params.cubic_coeff_a));
+  ACL_CALL(aclopSetAttrInt(attr, "exclude_outside", params.exclude_outside));
+  ACL_CALL(aclopSetAttrFloat(attr, "extrapolation_value", params.extrapolation_value));
+  ACL_CALL(aclopSetAttrString(attr, "mode", params.mode.c_str()));
+  ACL_CALL(aclopSetAttrString(attr, "nearest_mode", params.nearest_mode.c_str()));
 
   std::cout << "aclopInferShape : " << op_type << std::endl;
   ACL_CALL(aclopInferShape(op_type.c_str(), 
@@ -92,6 +102,15 @@ int main() {
   // print output
   // output_y->Print("y");
 
+  // CPU reference, to compare against once execution above works
+  std::vector<float> y_ref(y_dims[0] * y_dims[1] * y_dims[2] * y_dims[3]);
+  RefResize(x_data.data(), x_dims, y_dims[2], y_dims[3], params, y_ref.data());
+  std::cout << "y_ref = [";
+  for (float v : y_ref) {
+    std::cout << v << ", ";
+  }
+  std::cout << "]" << std::endl;
+
   // destroy
   input_x->Destroy();
   output_y->Destroy();
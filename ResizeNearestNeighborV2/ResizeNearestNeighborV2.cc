@@ -1,11 +1,11 @@
+#include <cmath>
 #include <iostream>
 #include <vector>
 
-#include "acl/acl.h"
-#include "acl/acl_op_compiler.h"
-#include "common/logging.h"
-
-#define ACL_CALL(msg) CHECK_EQ(reinterpret_cast<aclError>(msg), ACL_SUCCESS)
+#include "common/nputensor.h"
+#include "common/memplan.h"
+#include "common/ref_resize.h"
+#include "common/compare.h"
 
 int main() {
   // Init
@@ -28,70 +28,34 @@ int main() {
   const std::vector<int32_t> sizes{3, 3};
   // output
   const std::vector<int64_t> y_dims{1, 1, 3, 3};
-  std::vector<float> y{0, 0, 0, 0, 0, 0, 0, 0, 0};
-
-  // input0 - x - should use device buffer
-  auto x_desc = aclCreateTensorDesc(ACL_FLOAT, x_dims.size(), x_dims.data(), ACL_FORMAT_NCHW);
-  auto x_size = aclGetTensorDescSize(x_desc);
-  // assign host value
-  void* x_host_ptr = nullptr;
-  ACL_CALL(aclrtMallocHost(&x_host_ptr, x_size));
-  ACL_CALL(aclrtMemcpy(x_host_ptr, x_size, x.data(), x_size, ACL_MEMCPY_HOST_TO_HOST));
-  auto x_host_buffer = aclCreateDataBuffer(x_host_ptr, x_size);
-  // memcopy to device
-  void* x_device_ptr = nullptr;
-  ACL_CALL(aclrtMalloc(&x_device_ptr, x_size, ACL_MEM_MALLOC_NORMAL_ONLY));
-  ACL_CALL(aclrtMemcpy(x_device_ptr, x_size, x.data(), x_size, ACL_MEMCPY_HOST_TO_DEVICE));
-  auto x_device_buffer = aclCreateDataBuffer(x_device_ptr, x_size);
-
-  // input1 - sizes - should use host buffer
-  auto sizes_desc = aclCreateTensorDesc(ACL_INT32, sizes_dims.size(), sizes_dims.data(), ACL_FORMAT_NCHW);
-  ACL_CALL(aclSetTensorPlaceMent(sizes_desc, ACL_MEMTYPE_HOST));
-  auto sizes_size = aclGetTensorDescSize(sizes_desc);
-  // host buffer
-  void* sizes_host_ptr = nullptr;
-  ACL_CALL(aclrtMallocHost(&sizes_host_ptr, sizes_size));
-  ACL_CALL(aclrtMemcpy(sizes_host_ptr, sizes_size, sizes.data(), sizes_size, ACL_MEMCPY_HOST_TO_HOST));
-  auto sizes_host_buffer = aclCreateDataBuffer(sizes_host_ptr, sizes_size);
-  // device buffer
-  void* sizes_device_ptr = nullptr;
-  ACL_CALL(aclrtMalloc(&sizes_device_ptr, sizes_size, ACL_MEM_MALLOC_NORMAL_ONLY));
-  ACL_CALL(aclrtMemcpy(sizes_device_ptr, sizes_size, sizes.data(), sizes_size, ACL_MEMCPY_HOST_TO_DEVICE));
-  auto sizes_device_buffer = aclCreateDataBuffer(sizes_device_ptr, sizes_size);
+
+  // input0 - x - device buffer
+  auto input_x = PlanInput<float>(op_type, 0, ACL_FLOAT, x_dims.size(), x_dims.data(), ACL_FORMAT_NCHW, x.data());
+  // input1 - sizes - shape-like, planned on host as const
+  auto input_sizes = PlanInput<int32_t>(op_type, 1, ACL_INT32, sizes_dims.size(), sizes_dims.data(), ACL_FORMAT_NCHW, sizes.data());
 
   // inputs
   std::vector<aclTensorDesc *> input_descs;
   std::vector<aclDataBuffer *> input_buffers;
-  input_descs.emplace_back(x_desc);
-  input_descs.emplace_back(sizes_desc);
-
-  // input_buffers.emplace_back(x_host_buffer);
-  input_buffers.emplace_back(x_device_buffer);
-  input_buffers.emplace_back(sizes_host_buffer);
-  // input_buffers.emplace_back(sizes_device_buffer);
-
-  // output0 - y - should use device buffer
-  auto y_desc = aclCreateTensorDesc(ACL_FLOAT, y_dims.size(), y_dims.data(), ACL_FORMAT_NCHW);
-  auto y_size = aclGetTensorDescSize(y_desc);
-  // host
-  void* y_host_ptr = nullptr;
-  ACL_CALL(aclrtMallocHost(&y_host_ptr, y_size));
-  auto y_host_buffer = aclCreateDataBuffer(y_host_ptr, y_size);
-  // device
-  void* y_device_ptr = nullptr;
-  ACL_CALL(aclrtMalloc(&y_device_ptr, y_size, ACL_MEM_MALLOC_NORMAL_ONLY));
-  auto y_device_buffer = aclCreateDataBuffer(y_device_ptr, y_size);
+  input_descs.emplace_back(input_x->desc);
+  input_descs.emplace_back(input_sizes->desc);
+  input_buffers.emplace_back(input_x->buffer);
+  input_buffers.emplace_back(input_sizes->buffer);
+
+  // output0 - y - device buffer
+  auto output_y = new npuTensor<float>(ACL_FLOAT, y_dims.size(), y_dims.data(), ACL_FORMAT_NCHW, nullptr);
   // outputs
   std::vector<aclTensorDesc *> output_descs;
   std::vector<aclDataBuffer *> output_buffers;
-  output_descs.emplace_back(y_desc);
-  // output_buffers.emplace_back(y_host_buffer);
-  output_buffers.emplace_back(y_device_buffer);
+  output_descs.emplace_back(output_y->desc);
+  output_buffers.emplace_back(output_y->buffer);
   
   // attributes
   auto attr = aclopCreateAttr();
-  ACL_CALL(aclopSetAttrBool(attr, "align_corners", true));
-  ACL_CALL(aclopSetAttrBool(attr, "half_pixel_centers", false));
+  const bool align_corners = true;
+  const bool half_pixel_centers = false;
+  ACL_CALL(aclopSetAttrBool(attr, "align_corners", align_corners));
+  ACL_CALL(aclopSetAttrBool(attr, "half_pixel_centers", half_pixel_centers));
 
   // create stream
   aclrtStream stream = nullptr;
@@ -106,32 +70,21 @@ int main() {
   // sync and destroy stream
   ACL_CALL(aclrtSynchronizeStream(stream));
   ACL_CALL(aclrtDestroyStream(stream));
-  // copy output from device to host
-  ACL_CALL(aclrtMemcpy(y.data(), y_size, y_device_ptr, y_size, ACL_MEMCPY_DEVICE_TO_HOST));
 
   // print output
-  std::cout << "y = [";
-  for (size_t i = 0; i < y.size(); ++i) {
-    std::cout << y[i] << ", ";
-  }
-  std::cout << "]" << std::endl;
-
-  ACL_CALL(aclDestroyDataBuffer(x_host_buffer));
-  ACL_CALL(aclDestroyDataBuffer(x_device_buffer));
-  ACL_CALL(aclDestroyDataBuffer(sizes_host_buffer));
-  ACL_CALL(aclDestroyDataBuffer(sizes_device_buffer));
-  ACL_CALL(aclDestroyDataBuffer(y_host_buffer));
-  ACL_CALL(aclDestroyDataBuffer(y_device_buffer));
-  ACL_CALL(aclrtFree(x_device_ptr));
-  ACL_CALL(aclrtFree(sizes_device_ptr));
-  ACL_CALL(aclrtFree(y_device_ptr));
-  ACL_CALL(aclrtFreeHost(x_host_ptr));
-  ACL_CALL(aclrtFreeHost(sizes_host_ptr));
-  ACL_CALL(aclrtFreeHost(y_host_ptr));
-
-  aclDestroyTensorDesc(x_desc);
-  aclDestroyTensorDesc(sizes_desc);
-  aclDestroyTensorDesc(y_desc);
+  output_y->Print("y");
+
+  // verify against the CPU reference
+  std::vector<float> y_ref(output_y->size / sizeof(float));
+  RefResize(x.data(), x_dims, y_dims[2], y_dims[3], ResizeParams::FromV2("nearest", align_corners, half_pixel_centers), y_ref.data());
+  output_y->CopyToHost();
+  const CompareReport report = Compare(output_y->data(), y_ref.data(), y_dims, Tolerance::Abs(1e-3));
+  report.Print("y");
+
+  // destroy
+  input_x->Destroy();
+  input_sizes->Destroy();
+  output_y->Destroy();
 
   aclopDestroyAttr(attr);
 
@@ -139,5 +92,5 @@ int main() {
   ACL_CALL(aclrtResetDevice(0));
   ACL_CALL(aclFinalize());
 
-  return 0;
-}
\ No newline at end of file
+  return report.ok() ? 0 : 1;
+}
@@ -2,6 +2,9 @@
 #include <vector>
 
 #include "common/nputensor.h"
+#include "common/memplan.h"
+#include "common/ref_scatter.h"
+#include "common/compare.h"
 
 int main() {
   // Init
@@ -41,8 +44,10 @@ int main() {
   input_buffers.emplace_back(input_indices->buffer);
   input_buffers.emplace_back(input_updates->buffer);
 
-  // output
-  auto output_y = new npuTensor<float>(ACL_FLOAT, y_dims.size(), y_dims.data(), ACL_FORMAT_ND, nullptr);
+  // output - y is updated in place, planner binds it to var's device memory
+  MemPlanner planner(op_type, input_buffers);
+  auto output_y = planner.Output<float>(0, ACL_FLOAT, y_dims.size(), y_dims.data(), ACL_FORMAT_ND);
+  std::cout << "planner saved bytes : " << planner.saved_bytes() << std::endl;
   // set output desc and buffer
   std::vector<aclTensorDesc *> output_descs;
   std::vector<aclDataBuffer *> output_buffers;
@@ -70,6 +75,14 @@ int main() {
   // print output
   output_y->Print("y");
 
+  // verify against the CPU reference
+  std::vector<float> y_ref(var_data.size());
+  RefScatterUpdate(var_data.data(), var_dims, indices_data.data(), indices_data.size(), updates_data.data(),
+                   y_ref.data());
+  output_y->CopyToHost();
+  const CompareReport report = Compare(output_y->data(), y_ref.data(), y_dims);
+  report.Print("y");
+
   // destroy
   input_var->Destroy();
   input_indices->Destroy();
@@ -82,5 +95,5 @@ int main() {
   ACL_CALL(aclrtResetDevice(0));
   ACL_CALL(aclFinalize());
 
-  return 0;
+  return report.ok() ? 0 : 1;
 }
\ No newline at end of file
@@ -2,6 +2,8 @@
 #include <vector>
 
 #include "common/nputensor.h"
+#include "common/ref_sort.h"
+#include "common/compare.h"
 
 int main() {
   // Init
@@ -65,6 +67,27 @@ int main() {
   output_y1->Print("y1");
   output_y2->Print("y2");
 
+  // verify against the CPU reference, indices only need to point at an equal value
+  const int64_t rows = y_dims[0];
+  const int64_t cols = y_dims[1];
+  std::vector<int64_t> y_ref(x_data.size());
+  std::vector<int32_t> index_ref(x_data.size());
+  RefSort(x_data.data(), rows, cols, false, y_ref.data(), index_ref.data());
+  output_y1->CopyToHost();
+  output_y2->CopyToHost();
+  const CompareReport report = Compare(output_y1->data(), y_ref.data(), y_dims);
+  report.Print("y1");
+  int64_t bad_indices = 0;
+  for (int64_t i = 0; i < rows * cols; ++i) {
+    const int32_t index = output_y2->data()[i];
+    const bool index_ok = index >= 0 && index < cols && x_data[i / cols * cols + index] == y_ref[i];
+    if (!index_ok && bad_indices++ == 0) {
+      std::cout << "first bad index at row " << i / cols << " col " << i % cols << ": npu " << index << " ref "
+                << index_ref[i] << std::endl;
+    }
+  }
+  std::cout << "y2 indices not pointing at the sorted value : " << bad_indices << std::endl;
+
   // destroy
   input_x->Destroy();
   output_y1->Destroy();
@@ -76,5 +99,5 @@ int main() {
   ACL_CALL(aclrtResetDevice(0));
   ACL_CALL(aclFinalize());
 
-  return 0;
+  return report.ok() ? 0 : 1;
 }
\ No newline at end of file
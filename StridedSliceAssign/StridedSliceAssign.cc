@@ -2,6 +2,7 @@
 #include <vector>
 
 #include "common/nputensor.h"
+#include "common/memplan.h"
 
 int main() {
   // Init
@@ -37,9 +38,10 @@ int main() {
   // inputs
   auto input_var = new npuTensor<float>(ACL_FLOAT, var_dims.size(), var_dims.data(), ACL_FORMAT_ND, var_data.data());
   auto input_value = new npuTensor<float>(ACL_FLOAT, value_dims.size(), value_dims.data(), ACL_FORMAT_ND, value_data.data());
-  auto input_begin = new npuTensor<int64_t>(ACL_INT64, begin_dims.size(), begin_dims.data(), ACL_FORMAT_ND, begin_data.data());
-  auto input_end = new npuTensor<int64_t>(ACL_INT64, end_dims.size(), end_dims.data(), ACL_FORMAT_ND, end_data.data());
-  auto input_stride = new npuTensor<int64_t>(ACL_INT64, stride_dims.size(), stride_dims.data(), ACL_FORMAT_ND, stride_data.data());
+  // begin, end, stride - planned on host as const
+  auto input_begin = PlanInput<int64_t>(op_type, 2, ACL_INT64, begin_dims.size(), begin_dims.data(), ACL_FORMAT_ND, begin_data.data());
+  auto input_end = PlanInput<int64_t>(op_type, 3, ACL_INT64, end_dims.size(), end_dims.data(), ACL_FORMAT_ND, end_data.data());
+  auto input_stride = PlanInput<int64_t>(op_type, 4, ACL_INT64, stride_dims.size(), stride_dims.data(), ACL_FORMAT_ND, stride_data.data());
   // set inputs desc and buffer
   std::vector<aclTensorDesc *> input_descs;
   std::vector<aclDataBuffer *> input_buffers;
@@ -54,8 +56,10 @@ int main() {
   input_buffers.emplace_back(input_end->buffer);
   input_buffers.emplace_back(input_stride->buffer);
 
-  // output
-  auto output_y = new npuTensor<float>(ACL_FLOAT, y_dims.size(), y_dims.data(), ACL_FORMAT_ND, nullptr);
+  // output - y is updated in place, planner binds it to var's device memory
+  MemPlanner planner(op_type, input_buffers);
+  auto output_y = planner.Output<float>(0, ACL_FLOAT, y_dims.size(), y_dims.data(), ACL_FORMAT_ND);
+  std::cout << "planner saved bytes : " << planner.saved_bytes() << std::endl;
   // set output desc and buffer
   std::vector<aclTensorDesc *> output_descs;
   std::vector<aclDataBuffer *> output_buffers;
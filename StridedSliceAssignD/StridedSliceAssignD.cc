@@ -2,6 +2,7 @@
 #include <vector>
 
 #include "common/nputensor.h"
+#include "common/memplan.h"
 
 int main() {
   // Init
@@ -49,8 +50,10 @@ int main() {
   // input_buffers.emplace_back(input_end->buffer);
   // input_buffers.emplace_back(input_stride->buffer);
 
-  // output
-  auto output_y = new npuTensor<float>(ACL_FLOAT, y_dims.size(), y_dims.data(), ACL_FORMAT_ND, nullptr);
+  // output - y is updated in place, planner binds it to var's device memory
+  MemPlanner planner(op_type, input_buffers);
+  auto output_y = planner.Output<float>(0, ACL_FLOAT, y_dims.size(), y_dims.data(), ACL_FORMAT_ND);
+  std::cout << "planner saved bytes : " << planner.saved_bytes() << std::endl;
   // set output desc and buffer
   std::vector<aclTensorDesc *> output_descs;
   std::vector<aclDataBuffer *> output_buffers;
@@ -2,6 +2,8 @@
 #include <vector>
 
 #include "common/nputensor.h"
+#include "common/ref_broadcast.h"
+#include "common/compare.h"
 
 int main() {
   // Init
@@ -71,6 +73,14 @@ int main() {
   // input_m->Print("m");
   // output_y->Print("y");
 
+  // verify against the CPU reference
+  const auto view = TileView(x_data, x_dims, m_data);
+  bool y_ref[2 * 6];
+  Materialize(view, y_ref);
+  output_y->CopyToHost();
+  const CompareReport report = Compare(output_y->data(), y_ref, y_dims);
+  report.Print("y");
+
   // destroy
   input_x->Destroy();
   input_m->Destroy();
@@ -82,5 +92,5 @@ int main() {
   ACL_CALL(aclrtResetDevice(0));
   ACL_CALL(aclFinalize());
 
-  return 0;
+  return report.ok() ? 0 : 1;
 }
\ No newline at end of file
@@ -2,6 +2,8 @@
 #include <vector>
 
 #include "common/nputensor.h"
+#include "common/ref_broadcast.h"
+#include "common/compare.h"
 
 int main() {
   // Init
@@ -65,6 +67,14 @@ int main() {
   input_x->Print("x");
   output_y->Print("y");
 
+  // verify against the CPU reference
+  const auto view = TileWithAxisView(x_data.data(), x_dims, axis, tiles);
+  std::vector<float> y_ref(view.numel());
+  Materialize(view, y_ref.data());
+  output_y->CopyToHost();
+  const CompareReport report = Compare(output_y->data(), y_ref.data(), y_dims);
+  report.Print("y");
+
   // destroy
   input_x->Destroy();
   output_y->Destroy();
@@ -75,5 +85,5 @@ int main() {
   ACL_CALL(aclrtResetDevice(0));
   ACL_CALL(aclFinalize());
 
-  return 0;
+  return report.ok() ? 0 : 1;
 }
\ No newline at end of file
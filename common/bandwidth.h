@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "common/logging.h"
+
+// Latency + bandwidth model of one transfer path: time(bytes) = latency + bytes / bandwidth.
+struct BandwidthModel {
+  double latency_us;
+  double gbps;
+
+  double PredictMs(size_t bytes) const { return latency_us * 1e-3 + bytes / (gbps * 1e6); }
+
+  // percentage of the modelled time a measured transfer/op of `bytes` reaches
+  double PercentOfPeak(size_t bytes, double ms) const { return 100.0 * PredictMs(bytes) / ms; }
+};
+
+// Fit the model to {bytes, ms} samples by least squares on relative error,
+// so the 4 KB points pin the latency and the GB points pin the bandwidth.
+inline BandwidthModel FitBandwidthModel(const std::vector<std::pair<size_t, double>>& samples) {
+  double sw = 0, sx = 0, sy = 0, sxx = 0, sxy = 0;
+  for (const auto& s : samples) {
+    const double x = static_cast<double>(s.first);
+    const double y = s.second;
+    const double w = 1.0 / (y * y);
+    sw += w;
+    sx += w * x;
+    sy += w * y;
+    sxx += w * x * x;
+    sxy += w * x * y;
+  }
+  const double det = sw * sxx - sx * sx;
+  CHECK_GT(det, 0) << "need at least two distinct sizes";
+  double slope = (sw * sxy - sx * sy) / det;      // ms per byte
+  double intercept = (sy - slope * sx) / sw;      // ms
+  if (intercept < 0) {
+    // noise on tiny transfers, refit through the origin
+    intercept = 0;
+    slope = sxy / sxx;
+  }
+  return BandwidthModel{intercept * 1e3, 1.0 / (slope * 1e6)};
+}
+
+// The model file keeps one "<path> <latency_us> <gbps>" line per transfer
+// path, written by Bench_Bandwidth and read by the other benchmarks.
+inline std::string BandwidthModelFile() {
+  const char* env = std::getenv("NPU_BANDWIDTH_MODEL");
+  return env != nullptr ? env : "/tmp/npu_bandwidth_model.txt";
+}
+
+inline void SaveBandwidthModels(const std::map<std::string, BandwidthModel>& models,
+                                const std::string& file = BandwidthModelFile()) {
+  std::ofstream out(file);
+  CHECK(out.good()) << "cannot write " << file;
+  for (const auto& it : models) {
+    out << it.first << " " << it.second.latency_us << " " << it.second.gbps << "\n";
+  }
+}
+
+// returns false if the file does not exist or has no entry for `path`
+inline bool LoadBandwidthModel(const std::string& path, BandwidthModel* model,
+                               const std::string& file = BandwidthModelFile()) {
+  std::ifstream in(file);
+  std::string name;
+  BandwidthModel m;
+  while (in >> name >> m.latency_us >> m.gbps) {
+    if (name == path) {
+      *model = m;
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <chrono>
+
+#include "acl/acl.h"
+#include "common/logging.h"
+
+// Wall-clock timer for host side measurements.
+class Timer {
+ public:
+  Timer() { Start(); }
+  void Start() { start_ = std::chrono::steady_clock::now(); }
+  double ElapsedMs() const {
+    auto now = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(now - start_).count();
+  }
+
+ private:
+  std::chrono::steady_clock::time_point start_;
+};
+
+// Free HBM on the current device, used to measure peak footprint.
+inline size_t DeviceFreeBytes() {
+  size_t free_bytes = 0;
+  size_t total_bytes = 0;
+  CHECK_EQ(aclrtGetMemInfo(ACL_HBM_MEM, &free_bytes, &total_bytes), ACL_SUCCESS);
+  return free_bytes;
+}
+
+inline double ToMB(size_t bytes) { return bytes / (1024.0 * 1024.0); }
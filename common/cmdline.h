@@ -0,0 +1,442 @@
+#pragma once
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "acl/acl.h"
+#include "common/dtype.h"
+#include "common/logging.h"
+
+// Shapes, dtypes, formats and attributes of an op case from the command
+// line, `key=value` each:
+//
+//   ./BatchMatMul M=1024 K=1024 N=1024 dtype=fp16 iters=10
+//
+// Bare values fill the case's positional keys in order, so
+// `./BatchMatMul 1024 1024 1024 fp16 10` still works. Any value can be a
+// sweep:
+//
+//   a,b,c      list, commas inside [] or () do not split, e.g. axes=[1],[1,2]
+//   lo:hi      integers lo .. hi, both included
+//   lo:hi:s    step s (also written +s)
+//   lo:hi:*f   geometric, lo, lo * f, lo * f * f, ... up to hi
+//
+// and `{key}` is replaced by the value of another key of the same
+// configuration, e.g. shape={B}x1024. The configurations are the Cartesian
+// product of all keys, the first key outermost:
+//
+//   ./BatchMatMul M=128:4096:*2 K=1024 N={M} dtype=fp32,fp16 iters=20   # 12 configurations
+//
+// `@file` reads a spec file with one set of arguments per line (# starts a
+// comment), each line is swept on its own on top of the other arguments.
+// All configurations run in one process, a kernel compiled for one of them
+// stays in the op compiler's cache for the later ones.
+class CaseParams {
+ public:
+  // replaces an existing value, the key keeps its position
+  void Set(const std::string& key, const std::string& value) {
+    for (auto& item : items_) {
+      if (item.first == key) {
+        item.second = value;
+        return;
+      }
+    }
+    items_.emplace_back(key, value);
+  }
+
+  bool Has(const std::string& key) const { return Find(key) != nullptr; }
+
+  std::string Get(const std::string& key, const std::string& def = "") const {
+    const std::string* v = Find(key);
+    return v != nullptr ? *v : def;
+  }
+
+  int64_t Int(const std::string& key, int64_t def) const {
+    const std::string* v = Find(key);
+    return v != nullptr ? ParseInt(key, *v) : def;
+  }
+
+  double Float(const std::string& key, double def) const {
+    const std::string* v = Find(key);
+    if (v == nullptr) {
+      return def;
+    }
+    char* end = nullptr;
+    const double d = std::strtod(v->c_str(), &end);
+    CHECK(!v->empty() && *end == '\0') << key << "=" << *v << " is not a number";
+    return d;
+  }
+
+  // 1 / 0 / true / false
+  bool Bool(const std::string& key, bool def) const {
+    const std::string* v = Find(key);
+    if (v == nullptr) {
+      return def;
+    }
+    if (*v == "true") {
+      return true;
+    }
+    if (*v == "false") {
+      return false;
+    }
+    return ParseInt(key, *v) != 0;
+  }
+
+  // 3x2x3x2, [3,2,3,2] or 3; [] is empty, the shape of a scalar
+  std::vector<int64_t> Ints(const std::string& key, const std::vector<int64_t>& def) const {
+    const std::string* v = Find(key);
+    if (v == nullptr) {
+      return def;
+    }
+    std::vector<int64_t> ints;
+    for (const auto& s : SplitList(*v)) {
+      ints.push_back(ParseInt(key, s));
+    }
+    return ints;
+  }
+
+  // [0.5,1.5] or 0.5
+  std::vector<float> Floats(const std::string& key, const std::vector<float>& def) const {
+    const std::string* v = Find(key);
+    if (v == nullptr) {
+      return def;
+    }
+    std::vector<float> floats;
+    for (const auto& s : SplitList(*v)) {
+      char* end = nullptr;
+      floats.push_back(std::strtof(s.c_str(), &end));
+      CHECK(!s.empty() && *end == '\0') << key << "=" << *v << " is not a list of numbers";
+    }
+    return floats;
+  }
+
+  aclDataType DType(const std::string& key, aclDataType def) const {
+    const std::string* v = Find(key);
+    return v != nullptr ? ParseDataType(*v) : def;
+  }
+
+  aclFormat Format(const std::string& key, aclFormat def) const {
+    const std::string* v = Find(key);
+    return v != nullptr ? ParseFormat(*v) : def;
+  }
+
+  const std::vector<std::pair<std::string, std::string>>& items() const { return items_; }
+
+  // keys no getter has asked for, mostly typos
+  std::vector<std::string> Unused() const {
+    std::vector<std::string> keys;
+    for (const auto& item : items_) {
+      if (used_.count(item.first) == 0) {
+        keys.push_back(item.first);
+      }
+    }
+    return keys;
+  }
+
+  // [a,b] / (a,b) / axb -> {a, b}, [] -> {}
+  static std::vector<std::string> SplitList(const std::string& v) {
+    std::string s = v;
+    if (s.size() >= 2 && (s.front() == '[' || s.front() == '(')) {
+      s = s.substr(1, s.size() - 2);
+      return s.empty() ? std::vector<std::string>() : Split(s, ',');
+    }
+    return Split(s, s.find(',') != std::string::npos ? ',' : 'x');
+  }
+
+  // splits on `sep` outside [] and ()
+  static std::vector<std::string> Split(const std::string& s, char sep) {
+    std::vector<std::string> parts(1);
+    int depth = 0;
+    for (char c : s) {
+      if (c == '[' || c == '(') {
+        ++depth;
+      } else if (c == ']' || c == ')') {
+        --depth;
+      }
+      if (c == sep && depth == 0) {
+        parts.emplace_back();
+      } else {
+        parts.back() += c;
+      }
+    }
+    return parts;
+  }
+
+ private:
+  const std::string* Find(const std::string& key) const {
+    for (const auto& item : items_) {
+      if (item.first == key) {
+        used_.insert(key);
+        return &item.second;
+      }
+    }
+    return nullptr;
+  }
+
+  static int64_t ParseInt(const std::string& key, const std::string& v) {
+    char* end = nullptr;
+    const int64_t i = std::strtoll(v.c_str(), &end, 10);
+    CHECK(!v.empty() && *end == '\0') << key << "=" << v << " is not an integer";
+    return i;
+  }
+
+  std::vector<std::pair<std::string, std::string>> items_;
+  mutable std::set<std::string> used_;
+};
+
+inline std::ostream& operator<<(std::ostream& os, const CaseParams& p) {
+  const char* sep = "";
+  for (const auto& item : p.items()) {
+    os << sep << item.first << "=" << item.second;
+    sep = " ";
+  }
+  return os;
+}
+
+namespace cmdline {
+
+inline bool ToInt(const std::string& s, int64_t* v) {
+  char* end = nullptr;
+  *v = std::strtoll(s.c_str(), &end, 10);
+  return !s.empty() && *end == '\0';
+}
+
+// values of one sweep item: lo:hi[:step] / lo:hi:*f, anything else as is
+inline std::vector<std::string> ExpandRange(const std::string& item) {
+  const std::vector<std::string> parts = CaseParams::Split(item, ':');
+  int64_t lo = 0;
+  int64_t hi = 0;
+  if ((parts.size() != 2 && parts.size() != 3) || !ToInt(parts[0], &lo) || !ToInt(parts[1], &hi)) {
+    return {item};
+  }
+  int64_t step = 1;
+  bool geometric = false;
+  if (parts.size() == 3) {
+    std::string s = parts[2];
+    if (!s.empty() && (s[0] == '*' || s[0] == '+')) {
+      geometric = (s[0] == '*');
+      s = s.substr(1);
+    }
+    if (!ToInt(s, &step)) {
+      return {item};
+    }
+  }
+  CHECK(geometric ? (step > 1 && lo > 0) : step > 0) << "bad range " << item;
+  std::vector<std::string> values;
+  for (int64_t v = lo; v <= hi; v = geometric ? v * step : v + step) {
+    values.push_back(std::to_string(v));
+  }
+  CHECK(!values.empty()) << "empty range " << item;
+  return values;
+}
+
+inline std::vector<std::string> ExpandValue(const std::string& value) {
+  std::vector<std::string> values;
+  for (const auto& item : CaseParams::Split(value, ',')) {
+    for (auto& v : ExpandRange(item)) {
+      values.push_back(v);
+    }
+  }
+  return values;
+}
+
+// {key} -> value of key in `p`, repeated until nothing changes; keys only
+// referenced this way count as used
+inline void Substitute(CaseParams* p) {
+  std::set<std::string> referenced;
+  for (size_t round = 0; round <= p->items().size(); ++round) {
+    bool changed = false;
+    CaseParams out;
+    for (const auto& item : p->items()) {
+      std::string v = item.second;
+      size_t open = 0;
+      while ((open = v.find('{', open)) != std::string::npos) {
+        const size_t close = v.find('}', open);
+        CHECK(close != std::string::npos) << "unbalanced { in " << item.first << "=" << item.second;
+        const std::string key = v.substr(open + 1, close - open - 1);
+        CHECK(key != item.first && p->Has(key)) << "unknown {" << key << "} in " << item.first << "=" << item.second;
+        const std::string sub = p->Get(key);
+        referenced.insert(key);
+        v.replace(open, close - open + 1, sub);
+        open += sub.size();
+        changed = true;
+      }
+      out.Set(item.first, v);
+    }
+    *p = out;
+    if (!changed) {
+      for (const auto& key : referenced) {
+        p->Has(key);
+      }
+      return;
+    }
+  }
+  LOG(FATAL) << "circular {key} references in " << *p;
+}
+
+// Cartesian product of the swept values of `args`, first key outermost
+inline std::vector<CaseParams> Expand(const std::vector<std::pair<std::string, std::string>>& args) {
+  std::vector<std::pair<std::string, std::vector<std::string>>> keys;
+  for (const auto& arg : args) {
+    keys.emplace_back(arg.first, ExpandValue(arg.second));
+  }
+  std::vector<CaseParams> configs(1);
+  for (const auto& key : keys) {
+    std::vector<CaseParams> next;
+    next.reserve(configs.size() * key.second.size());
+    for (const auto& config : configs) {
+      for (const auto& v : key.second) {
+        next.push_back(config);
+        next.back().Set(key.first, v);
+      }
+    }
+    configs.swap(next);
+  }
+  for (auto& config : configs) {
+    Substitute(&config);
+  }
+  return configs;
+}
+
+// key=value, a bare value takes the next of `positional`
+inline void AddArg(const std::string& arg, const std::vector<std::string>& positional, size_t* next,
+                   std::vector<std::pair<std::string, std::string>>* args) {
+  std::string key;
+  std::string value;
+  const size_t eq = arg.find('=');
+  if (eq == std::string::npos) {
+    CHECK(*next < positional.size()) << "unexpected argument " << arg << ", use key=value";
+    key = positional[(*next)++];
+    value = arg;
+  } else {
+    key = arg.substr(0, eq);
+    value = arg.substr(eq + 1);
+  }
+  for (auto& a : *args) {
+    if (a.first == key) {
+      a.second = value;
+      return;
+    }
+  }
+  args->emplace_back(key, value);
+}
+
+}  // namespace cmdline
+
+// All configurations of the command line, see CaseParams. `positional` names
+// the keys bare values fill, in order.
+inline std::vector<CaseParams> ParseSweep(int argc, char* argv[], const std::vector<std::string>& positional = {}) {
+  std::vector<std::pair<std::string, std::string>> args;
+  std::vector<std::string> files;
+  size_t next = 0;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (!arg.empty() && arg[0] == '@') {
+      files.push_back(arg.substr(1));
+    } else {
+      cmdline::AddArg(arg, positional, &next, &args);
+    }
+  }
+  if (files.empty()) {
+    return cmdline::Expand(args);
+  }
+  std::vector<CaseParams> configs;
+  for (const auto& file : files) {
+    std::ifstream in(file);
+    CHECK(in.good()) << "cannot open spec file " << file;
+    std::string line;
+    while (std::getline(in, line)) {
+      line = line.substr(0, line.find('#'));
+      std::istringstream tokens(line);
+      std::vector<std::pair<std::string, std::string>> line_args = args;
+      size_t line_next = next;
+      std::string arg;
+      bool empty = true;
+      while (tokens >> arg) {
+        cmdline::AddArg(arg, positional, &line_next, &line_args);
+        empty = false;
+      }
+      if (empty) {
+        continue;
+      }
+      for (auto& config : cmdline::Expand(line_args)) {
+        configs.push_back(config);
+      }
+    }
+  }
+  return configs;
+}
+
+// keys whose value differs between `configs` or that only some of them
+// have, e.g. to label results with
+inline std::vector<std::string> SweptKeys(const std::vector<CaseParams>& configs) {
+  std::vector<std::string> order;
+  std::map<std::string, std::string> first;
+  std::map<std::string, size_t> count;
+  std::set<std::string> swept;
+  for (const auto& config : configs) {
+    for (const auto& item : config.items()) {
+      auto it = first.find(item.first);
+      if (it == first.end()) {
+        first[item.first] = item.second;
+        order.push_back(item.first);
+      } else if (it->second != item.second) {
+        swept.insert(item.first);
+      }
+      ++count[item.first];
+    }
+  }
+  std::vector<std::string> keys;
+  for (const auto& key : order) {
+    if (swept.count(key) != 0 || count[key] != configs.size()) {
+      keys.push_back(key);
+    }
+  }
+  return keys;
+}
+
+// `keys` of `p` as key=value, not counted as used
+inline std::string Label(const CaseParams& p, const std::vector<std::string>& keys) {
+  std::string label;
+  for (const auto& key : keys) {
+    for (const auto& item : p.items()) {
+      if (item.first == key) {
+        label += (label.empty() ? "" : " ") + key + "=" + item.second;
+      }
+    }
+  }
+  return label;
+}
+
+// 1-based index of the configuration ForEachConfig is running, 0 outside a
+// sweep of several (tensor dumps are named after it)
+inline size_t& CurrentConfig() {
+  static size_t index = 0;
+  return index;
+}
+
+// `run(params)` for every configuration, each named when there are several;
+// unknown keys are reported after the first one
+template <typename Run>
+void ForEachConfig(const std::vector<CaseParams>& configs, Run run) {
+  for (size_t i = 0; i < configs.size(); ++i) {
+    if (configs.size() > 1) {
+      std::cout << "---- [" << i + 1 << "/" << configs.size() << "] " << configs[i] << std::endl;
+      CurrentConfig() = i + 1;
+    }
+    run(configs[i]);
+    if (i == 0) {
+      for (const auto& key : configs[i].Unused()) {
+        LOG(WARNING) << "unused parameter " << key;
+      }
+    }
+  }
+  CurrentConfig() = 0;
+}
@@ -0,0 +1,426 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "acl/acl.h"
+#include "common/float16.h"
+#include "common/parallel.h"
+
+// Compares a device result against a host reference, elementwise.
+//
+// An element passes when it equals the reference, or when its error d is
+// within any of the tolerances:
+//   d <= atol,  d <= rtol * |expected|,  ulp distance <= ulp (floating types)
+// rtol with atol = rtol, as Tolerance::Rel builds it, is d <= rtol * max(1,
+// |expected|). NaN passes against NaN when nan_equal is set and fails
+// against anything else; Inf only passes against the same Inf. Integers and
+// bool are compared in the integer domain, so with the default (exact)
+// tolerance they must match exactly, also beyond 2^53; only the error
+// statistics are kept in double.
+//
+// Chunks run on ParallelFor, each in blocks converted to one compute type
+// (float for float / float16 / bfloat16, double otherwise) so the error and statistics
+// loops vectorize. With stop_at_first_failure the remaining chunks are
+// skipped once a failure is seen. The report then covers what was compared,
+// and first_failure is a failure but not necessarily the lowest index.
+struct Tolerance {
+  double atol = 0;
+  double rtol = 0;
+  int64_t ulp = 0;
+  bool nan_equal = true;
+
+  static Tolerance Exact() { return Tolerance(); }
+  static Tolerance Abs(double atol) {
+    Tolerance t;
+    t.atol = atol;
+    return t;
+  }
+  // relative to max(1, |expected|)
+  static Tolerance Rel(double rtol) {
+    Tolerance t;
+    t.atol = rtol;
+    t.rtol = rtol;
+    return t;
+  }
+  static Tolerance Ulp(int64_t ulp) {
+    Tolerance t;
+    t.ulp = ulp;
+    return t;
+  }
+  // defaults per output dtype, exact for integers and bool
+  static Tolerance For(aclDataType dtype) {
+    switch (dtype) {
+      case ACL_FLOAT: return Rel(1e-5);
+      case ACL_FLOAT16: return Rel(1e-3);
+      case ACL_BF16: return Rel(8e-3);
+      case ACL_DOUBLE: return Rel(1e-12);
+      default: return Exact();
+    }
+  }
+};
+
+namespace compare {
+
+constexpr int64_t kChunk = 1 << 16;
+constexpr int64_t kBlock = 1024;
+constexpr int kLanes = 16;
+// |err| histogram: exact, (0, 1e-7], (1e-7, 1e-6] ... (1e-1, 1], above 1 or
+// not finite
+constexpr int kBins = 10;
+constexpr double kEdges[kBins - 1] = {0, 1e-7, 1e-6, 1e-5, 1e-4, 1e-3, 1e-2, 1e-1, 1};
+
+template <typename T>
+struct Traits {
+  static constexpr bool kFloat = false;
+  typedef double compute;
+};
+template <>
+struct Traits<float> {
+  static constexpr bool kFloat = true;
+  typedef float compute;
+  // bit patterns mapped to integers in value order, +0 and -0 both 0
+  static int64_t Ordered(float v) {
+    int32_t i;
+    std::memcpy(&i, &v, sizeof(i));
+    return i >= 0 ? i : -static_cast<int64_t>(i & 0x7fffffff);
+  }
+};
+template <>
+struct Traits<float16> {
+  static constexpr bool kFloat = true;
+  typedef float compute;
+  static int64_t Ordered(float16 v) { return v.bits & 0x8000 ? -static_cast<int64_t>(v.bits & 0x7fff) : v.bits; }
+};
+template <>
+struct Traits<bfloat16> {
+  static constexpr bool kFloat = true;
+  typedef float compute;
+  static int64_t Ordered(bfloat16 v) { return v.bits & 0x8000 ? -static_cast<int64_t>(v.bits & 0x7fff) : v.bits; }
+};
+template <>
+struct Traits<double> {
+  static constexpr bool kFloat = true;
+  typedef double compute;
+  static int64_t Ordered(double v) {
+    int64_t i;
+    std::memcpy(&i, &v, sizeof(i));
+    return i >= 0 ? i : -(i & 0x7fffffffffffffffLL);
+  }
+};
+
+template <typename A, typename E>
+using Compute = typename std::conditional<std::is_same<typename Traits<A>::compute, float>::value &&
+                                              std::is_same<typename Traits<E>::compute, float>::value,
+                                          float, double>::type;
+
+template <typename T, typename C>
+void Load(const T* src, int64_t n, C* dst) {
+  for (int64_t i = 0; i < n; ++i) {
+    dst[i] = static_cast<C>(src[i]);
+  }
+}
+inline void Load(const float16* src, int64_t n, float* dst) { HalfToFloat(src, dst, n); }
+inline void Load(const bfloat16* src, int64_t n, float* dst) { BFloat16ToFloat(src, dst, n); }
+
+// ulp distance saturating at int64 max
+inline int64_t UlpDistance(int64_t x, int64_t y) {
+  const uint64_t d = x > y ? static_cast<uint64_t>(x) - static_cast<uint64_t>(y)
+                           : static_cast<uint64_t>(y) - static_cast<uint64_t>(x);
+  return static_cast<int64_t>(std::min<uint64_t>(d, std::numeric_limits<int64_t>::max()));
+}
+
+// statistics of one chunk
+struct Partial {
+  int64_t count = 0;
+  int64_t failures = 0;
+  int64_t nonfinite = 0;
+  int64_t first_failure = -1;
+  int64_t worst_index = -1;
+  double max_abs = -1;
+  double max_rel = 0;
+  double sum_abs = 0;
+  int64_t max_ulp = 0;
+  int64_t over[kBins - 1] = {0};
+};
+
+// pairs failing atol / rtol may still be within tol.ulp, measured in the
+// format of the actual values
+template <typename A, typename C>
+void Ulp(const A* a, const C* av, const C* ev, int64_t n, const Tolerance& tol, int32_t* fail, Partial* p,
+         std::true_type) {
+  for (int64_t i = 0; i < n; ++i) {
+    if (!std::isfinite(av[i]) || !std::isfinite(ev[i])) {
+      continue;
+    }
+    const int64_t ulp = UlpDistance(Traits<A>::Ordered(a[i]), Traits<A>::Ordered(static_cast<A>(ev[i])));
+    p->max_ulp = std::max(p->max_ulp, ulp);
+    fail[i] &= !(tol.ulp > 0 && ulp <= tol.ulp);
+  }
+}
+template <typename A, typename C>
+void Ulp(const A*, const C*, const C*, int64_t, const Tolerance&, int32_t*, Partial*, std::false_type) {}
+// float against float, branch-free over the whole padded block
+inline void Ulp(const float*, const float* av, const float* ev, int64_t, const Tolerance& tol, int32_t* fail,
+                Partial* p, std::true_type) {
+  const int32_t use = tol.ulp > 0;
+  const uint32_t limit = static_cast<uint32_t>(std::min<int64_t>(tol.ulp, std::numeric_limits<uint32_t>::max()));
+  uint32_t max_ulp[kLanes] = {0};
+  for (int64_t i = 0; i < kBlock; i += kLanes) {
+    for (int l = 0; l < kLanes; ++l) {
+      int32_t x;
+      int32_t y;
+      std::memcpy(&x, av + i + l, sizeof(x));
+      std::memcpy(&y, ev + i + l, sizeof(y));
+      const int32_t finite = ((x & 0x7f800000) != 0x7f800000) & ((y & 0x7f800000) != 0x7f800000);
+      const int32_t ox = x >= 0 ? x : -(x & 0x7fffffff);
+      const int32_t oy = y >= 0 ? y : -(y & 0x7fffffff);
+      const uint32_t d = ox > oy ? static_cast<uint32_t>(ox) - static_cast<uint32_t>(oy)
+                                 : static_cast<uint32_t>(oy) - static_cast<uint32_t>(ox);
+      max_ulp[l] = (finite && d > max_ulp[l]) ? d : max_ulp[l];
+      fail[i + l] &= !(use & finite & (d <= limit));
+    }
+  }
+  for (int l = 0; l < kLanes; ++l) {
+    p->max_ulp = std::max<int64_t>(p->max_ulp, max_ulp[l]);
+  }
+}
+
+// integer against integer: |a - e| taken exactly in 128 bits, the double
+// compute type would round int64 values beyond 2^53 to equal
+template <typename A, typename E, typename C>
+void IntegerErrors(const A* a, const E* e, int64_t n, const Tolerance& tol, C* err, C* rel, int32_t* fail,
+                   std::true_type) {
+  for (int64_t i = 0; i < n; ++i) {
+    const __int128 diff = static_cast<__int128>(a[i]) - static_cast<__int128>(e[i]);
+    const unsigned __int128 d = diff < 0 ? -diff : diff;
+    const double dd = static_cast<double>(d);
+    const double ay = std::fabs(static_cast<double>(e[i]));
+    err[i] = static_cast<C>(dd);
+    rel[i] = d == 0 ? C(0) : static_cast<C>(ay > 0 ? dd / ay : std::numeric_limits<double>::infinity());
+    fail[i] = d != 0 && !(dd <= tol.atol || dd <= tol.rtol * ay);
+  }
+}
+template <typename A, typename E, typename C>
+void IntegerErrors(const A*, const E*, int64_t, const Tolerance&, C*, C*, int32_t*, std::false_type) {}
+
+template <typename A, typename E>
+void Block(const A* a, const E* e, int64_t n, int64_t base, const Tolerance& tol, Partial* p) {
+  typedef Compute<A, E> C;
+  const C inf = std::numeric_limits<C>::infinity();
+  C av[kBlock];
+  C ev[kBlock];
+  C err[kBlock];
+  C rel[kBlock];
+  int32_t fail[kBlock];
+  // the tail of a short block is padded with equal zeros, which add nothing,
+  // so every loop below has the constant trip count -O2 vectorizes
+  Load(a, n, av);
+  Load(e, n, ev);
+  std::fill(av + n, av + kBlock, C(0));
+  std::fill(ev + n, ev + kBlock, C(0));
+  const C atol = static_cast<C>(tol.atol);
+  const C rtol = static_cast<C>(tol.rtol);
+  const int32_t nan_equal = tol.nan_equal;
+  for (int64_t i = 0; i < kBlock; ++i) {
+    const C x = av[i];
+    const C y = ev[i];
+    const int32_t nan_x = x != x;
+    const int32_t nan_y = y != y;
+    const C ay = std::fabs(y);
+    // a NaN or Inf on either side only passes with no error, i.e. against
+    // the same Inf or, with nan_equal, NaN against NaN; rtol * |Inf| must not
+    // let anything pass against an Inf reference
+    const int32_t finite = (std::fabs(x) < inf) & (ay < inf);
+    // equal values, including same-signed Inf, have no error
+    C d = x == y ? C(0) : std::fabs(x - y);
+    d = (nan_x | nan_y) ? ((nan_x & nan_y & nan_equal) ? C(0) : inf) : d;
+    err[i] = d;
+    rel[i] = d == C(0) ? C(0) : (ay > C(0) ? d / ay : inf);
+    fail[i] = (d > atol) & (d > (finite ? rtol * ay : C(0)));
+  }
+  Ulp(a, av, ev, n, tol, fail, p, std::integral_constant<bool, Traits<A>::kFloat>());
+  IntegerErrors(a, e, n, tol, err, rel, fail,
+                std::integral_constant<bool, std::is_integral<A>::value && std::is_integral<E>::value>());
+
+  // integer counts are plain reductions; the floating point ones run over
+  // fixed lanes, which the vectorizer takes without reassociating
+  int32_t block_failures = 0;
+  int32_t nonfinite = 0;
+  for (int64_t i = 0; i < kBlock; ++i) {
+    block_failures += fail[i];
+    nonfinite += !(err[i] < inf);
+  }
+  for (int b = 0; b < kBins - 1; ++b) {
+    const C edge = static_cast<C>(kEdges[b]);
+    int32_t over = 0;
+    for (int64_t i = 0; i < kBlock; ++i) {
+      over += err[i] > edge;
+    }
+    p->over[b] += over;
+  }
+  C max_abs[kLanes];
+  C max_rel[kLanes];
+  C sum_abs[kLanes];
+  for (int l = 0; l < kLanes; ++l) {
+    max_abs[l] = max_rel[l] = sum_abs[l] = C(0);
+  }
+  auto reduce = [&](int64_t i, int l) {
+    const C d = err[i];
+    max_abs[l] = d > max_abs[l] ? d : max_abs[l];
+    max_rel[l] = rel[i] > max_rel[l] ? rel[i] : max_rel[l];
+    sum_abs[l] += d < inf ? d : C(0);
+  };
+  for (int64_t i = 0; i < kBlock; i += kLanes) {
+    for (int l = 0; l < kLanes; ++l) {
+      reduce(i + l, l);
+    }
+  }
+  C block_max = C(0);
+  for (int l = 0; l < kLanes; ++l) {
+    block_max = std::max(block_max, max_abs[l]);
+    p->max_rel = std::max(p->max_rel, static_cast<double>(max_rel[l]));
+    p->sum_abs += sum_abs[l];
+  }
+  p->nonfinite += nonfinite;
+  p->count += n;
+  // the indices need a second look only when they change
+  if (static_cast<double>(block_max) > p->max_abs) {
+    p->max_abs = block_max;
+    p->worst_index = base + (std::find(err, err + n, block_max) - err);
+  }
+  if (block_failures > 0 && p->first_failure < 0) {
+    p->first_failure = base + (std::find(fail, fail + n, 1) - fail);
+  }
+  p->failures += block_failures;
+}
+
+}  // namespace compare
+
+struct CompareReport {
+  std::vector<int64_t> dims;
+  Tolerance tol;
+  int64_t count = 0;          // elements compared
+  int64_t failures = 0;
+  int64_t nonfinite = 0;      // errors that are not finite, NaN or Inf mismatches
+  int64_t first_failure = -1;
+  int64_t worst_index = -1;   // largest abs error, the first one on ties
+  double worst_actual = 0;
+  double worst_expected = 0;
+  double first_actual = 0;
+  double first_expected = 0;
+  double max_abs_err = 0;
+  double max_rel_err = 0;
+  double mean_abs_err = 0;    // over finite errors
+  int64_t max_ulp = 0;        // floating types only
+  int64_t histogram[compare::kBins] = {0};
+  bool stopped = false;       // stop_at_first_failure skipped part of the data
+
+  bool ok() const { return failures == 0; }
+
+  // row-major coordinate of a flat index
+  std::vector<int64_t> Coord(int64_t index) const {
+    std::vector<int64_t> coord(dims.size());
+    for (size_t d = dims.size(); d-- > 0;) {
+      coord[d] = dims[d] > 0 ? index % dims[d] : 0;
+      index = dims[d] > 0 ? index / dims[d] : 0;
+    }
+    return coord;
+  }
+
+  void Print(const std::string& name, std::ostream& os = std::cout) const {
+    auto coord = [this](int64_t index) {
+      std::string s = "[";
+      for (auto c : Coord(index)) s += (s.size() > 1 ? ", " : "") + std::to_string(c);
+      return s + "]";
+    };
+    os << name << " : " << count << " elements, " << failures << " failures" << (stopped ? " (stopped early)" : "")
+       << ", atol " << tol.atol << " rtol " << tol.rtol << " ulp " << tol.ulp << std::endl;
+    if (count == 0) {
+      return;
+    }
+    os << "  max abs err " << max_abs_err << " at " << coord(worst_index) << " (npu " << worst_actual << ", ref "
+       << worst_expected << "), mean abs err " << mean_abs_err << ", max rel err " << max_rel_err << ", max ulp "
+       << max_ulp << ", non-finite " << nonfinite << std::endl;
+    os << "  |err| histogram :";
+    const char* bins[compare::kBins] = {"0", "1e-7", "1e-6", "1e-5", "1e-4", "1e-3", "1e-2", "1e-1", "1", ">1"};
+    for (int b = 0; b < compare::kBins; ++b) {
+      if (histogram[b] > 0) {
+        os << " " << (b == 0 || b == compare::kBins - 1 ? "" : "<=") << bins[b] << ":" << histogram[b];
+      }
+    }
+    os << std::endl;
+    if (first_failure >= 0) {
+      os << "  first failure at " << coord(first_failure) << " (npu " << first_actual << ", ref " << first_expected
+         << ")" << std::endl;
+    }
+  }
+};
+
+// actual and expected hold prod(dims) elements
+template <typename A, typename E>
+CompareReport Compare(const A* actual, const E* expected, const std::vector<int64_t>& dims,
+                      const Tolerance& tol = Tolerance(), bool stop_at_first_failure = false) {
+  int64_t n = 1;
+  for (auto d : dims) n *= d;
+  const int64_t chunks = (n + compare::kChunk - 1) / compare::kChunk;
+  std::vector<compare::Partial> partials(chunks);
+  std::atomic<bool> stop(false);
+  ParallelFor(chunks, [&](int64_t c) {
+    const int64_t i1 = std::min(n, (c + 1) * compare::kChunk);
+    for (int64_t i = c * compare::kChunk; i < i1 && !stop.load(std::memory_order_relaxed);
+         i += compare::kBlock) {
+      compare::Block(actual + i, expected + i, std::min(compare::kBlock, i1 - i), i, tol, &partials[c]);
+      if (stop_at_first_failure && partials[c].failures > 0) {
+        stop = true;
+      }
+    }
+  });
+
+  CompareReport r;
+  r.dims = dims;
+  r.tol = tol;
+  r.max_abs_err = 0;
+  int64_t over[compare::kBins - 1] = {0};
+  double sum_abs = 0;
+  for (const auto& p : partials) {
+    r.count += p.count;
+    r.failures += p.failures;
+    r.nonfinite += p.nonfinite;
+    sum_abs += p.sum_abs;
+    r.max_rel_err = std::max(r.max_rel_err, p.max_rel);
+    r.max_ulp = std::max(r.max_ulp, p.max_ulp);
+    if (p.worst_index >= 0 && (r.worst_index < 0 || p.max_abs > r.max_abs_err)) {
+      r.max_abs_err = p.max_abs;
+      r.worst_index = p.worst_index;
+    }
+    if (p.first_failure >= 0 && r.first_failure < 0) {
+      r.first_failure = p.first_failure;
+    }
+    for (int b = 0; b < compare::kBins - 1; ++b) over[b] += p.over[b];
+  }
+  r.stopped = r.count < n;
+  r.mean_abs_err = r.count > r.nonfinite ? sum_abs / (r.count - r.nonfinite) : 0;
+  r.histogram[0] = r.count - over[0];
+  for (int b = 1; b < compare::kBins - 1; ++b) {
+    r.histogram[b] = over[b - 1] - over[b];
+  }
+  r.histogram[compare::kBins - 1] = over[compare::kBins - 2];
+  if (r.worst_index >= 0) {
+    r.worst_actual = static_cast<double>(actual[r.worst_index]);
+    r.worst_expected = static_cast<double>(expected[r.worst_index]);
+  }
+  if (r.first_failure >= 0) {
+    r.first_actual = static_cast<double>(actual[r.first_failure]);
+    r.first_expected = static_cast<double>(expected[r.first_failure]);
+  }
+  return r;
+}
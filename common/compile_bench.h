@@ -0,0 +1,111 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "acl/acl.h"
+#include "common/benchmark.h"
+#include "common/nputensor.h"
+
+// Compile counts of an op sweep, measured rather than predicted. Each call
+// launches twice back to back: the second launch always hits the op
+// compiler's cache, so the first one compiled if it took well over the
+// second (kCompileFactor times it plus kCompileMarginMs, a compile costs tens
+// of ms or more). `predicted` counts the calls whose CompileKey was new,
+// i.e. what the harness expects, to check the key against the compiler.
+constexpr double kCompileFactor = 4;
+constexpr double kCompileMarginMs = 2;
+
+struct CompileStats {
+  int calls = 0;
+  int errors = 0;
+  int compiles = 0;    // measured
+  int predicted = 0;   // new CompileKeys
+  double compile_ms = 0;
+  double cached_ms = 0;
+
+  // `launch` returns the aclError of one synchronized launch
+  template <typename Launch>
+  void Add(Launch launch, bool predicted_compile) {
+    ++calls;
+    predicted += predicted_compile;
+    Timer timer;
+    if (launch() != ACL_SUCCESS) {
+      ++errors;
+      return;
+    }
+    const double first_ms = timer.ElapsedMs();
+    timer.Start();
+    if (launch() != ACL_SUCCESS) {
+      ++errors;
+      return;
+    }
+    const double cached = timer.ElapsedMs();
+    cached_ms += cached;
+    if (first_ms > kCompileFactor * cached + kCompileMarginMs) {
+      ++compiles;
+      compile_ms += first_ms;
+    }
+  }
+
+  double avg_compile_ms() const { return compiles ? compile_ms / compiles : 0; }
+  double avg_cached_ms() const { return calls > errors ? cached_ms / (calls - errors) : 0; }
+};
+
+// npuTensors destroyed and deleted with the owner
+class TensorOwner {
+ public:
+  TensorOwner() = default;
+  ~TensorOwner() {
+    for (auto& destroy : destroy_) {
+      destroy();
+    }
+  }
+  TensorOwner(const TensorOwner&) = delete;
+  TensorOwner& operator=(const TensorOwner&) = delete;
+
+  template <typename T>
+  npuTensor<T>* Own(npuTensor<T>* tensor) {
+    destroy_.push_back([tensor] { tensor->Destroy(); delete tensor; });
+    return tensor;
+  }
+
+ private:
+  std::vector<std::function<void()>> destroy_;
+};
+
+// tensors and attrs of one op call, destroyed with the call
+class OpCall : public TensorOwner {
+ public:
+  explicit OpCall(const std::string& op_type) : op_type(op_type), attr(aclopCreateAttr()) {}
+  ~OpCall() { aclopDestroyAttr(attr); }
+
+  template <typename T>
+  void Input(npuTensor<T>* tensor) {
+    input_descs.push_back(Own(tensor)->desc);
+    input_buffers.push_back(tensor->buffer);
+  }
+
+  template <typename T>
+  void Output(npuTensor<T>* tensor) {
+    output_descs.push_back(Own(tensor)->desc);
+    output_buffers.push_back(tensor->buffer);
+  }
+
+  // one launch, synchronized
+  aclError Execute(aclrtStream stream) {
+    aclError ret = aclopCompileAndExecute(op_type.c_str(),
+              input_descs.size(), input_descs.data(), input_buffers.data(),
+              output_descs.size(), output_descs.data(), output_buffers.data(),
+              attr, ACL_ENGINE_SYS, ACL_COMPILE_SYS, NULL, stream);
+    return ret != ACL_SUCCESS ? ret : aclrtSynchronizeStream(stream);
+  }
+
+  std::string op_type;
+  aclopAttr* attr;
+  std::vector<aclTensorDesc *> input_descs;
+  std::vector<aclDataBuffer *> input_buffers;
+  std::vector<aclTensorDesc *> output_descs;
+  std::vector<aclDataBuffer *> output_buffers;
+};
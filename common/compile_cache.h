@@ -0,0 +1,62 @@
+#pragma once
+
+#include <iomanip>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "acl/acl.h"
+#include "common/opinfo.h"
+
+// Key under which the op compiler caches a kernel: op type, attrs and the
+// dtype/format/shape of every tensor. Const inputs (OpInfo::const_inputs
+// placed on host) are folded into the kernel, so their values are part of the
+// key as well. `attr_key` is a caller-built string of the attribute values.
+// Pass `const_inputs` = false when the inputs were not planned with
+// PlanInput, their buffers are then device memory and are not read.
+inline std::string CompileKey(const std::string& op_type,
+                              const std::vector<aclTensorDesc *>& input_descs,
+                              const std::vector<aclDataBuffer *>& input_buffers,
+                              const std::vector<aclTensorDesc *>& output_descs,
+                              const std::string& attr_key = "", bool const_inputs = true) {
+  std::stringstream ss;
+  ss << op_type << "|" << attr_key;
+  auto append_desc = [&ss](const aclTensorDesc* desc) {
+    ss << "|" << aclGetTensorDescType(desc) << ":" << aclGetTensorDescFormat(desc) << ":";
+    for (size_t d = 0; d < aclGetTensorDescNumDims(desc); ++d) {
+      int64_t dim = 0;
+      aclGetTensorDescDimV2(desc, d, &dim);
+      ss << dim << ",";
+    }
+  };
+  for (size_t i = 0; i < input_descs.size(); ++i) {
+    append_desc(input_descs[i]);
+    if (const_inputs && IsConstInput(op_type, i) && i < input_buffers.size()) {
+      // host buffer of a const input, hex dump its bytes
+      const unsigned char* data = static_cast<const unsigned char *>(aclGetDataBufferAddr(input_buffers[i]));
+      const size_t bytes = aclGetDataBufferSizeV2(input_buffers[i]);
+      ss << "=" << std::hex << std::setfill('0');
+      for (size_t b = 0; b < bytes; ++b) {
+        ss << std::setw(2) << static_cast<int>(data[b]);
+      }
+      ss << std::dec << std::setfill(' ');
+    }
+  }
+  ss << "->";
+  for (auto desc : output_descs) {
+    append_desc(desc);
+  }
+  return ss.str();
+}
+
+// Counts distinct compile keys, i.e. how many compiles a sequence of calls costs.
+class CompileCounter {
+ public:
+  // returns true if `key` has not been seen, i.e. this call compiles
+  bool Add(const std::string& key) { return keys_.insert(key).second; }
+  size_t count() const { return keys_.size(); }
+
+ private:
+  std::set<std::string> keys_;
+};
@@ -0,0 +1,389 @@
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <initializer_list>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "common/nputensor.h"
+#include "common/memplan.h"
+#include "common/compare.h"
+
+// Compares a device result against a golden tensor that is already on the
+// device, with Sub / Abs / Muls / Maximum / Greater / IsNan / IsFinite and
+// reductions, so only a few scalars per chunk come back instead of the whole
+// output.
+//
+// An element fails when |actual - expected| > max(atol, rtol * |expected|),
+// i.e. the atol / rtol rules of Compare() (common/compare.h), with the bound
+// capped at FLT_MAX so that nothing but the same Inf passes against an Inf
+// (equal Infs give a NaN difference). NaN fails against any value that is
+// not NaN, on either side, and NaN against NaN passes (nan_equal). The ulp
+// rule is not applied. The check passes when there are no failures and
+// actual and expected hold the same number of non-finite values. float16
+// differences are taken in float16 and cast to float for the comparison and
+// the reductions.
+//
+// The tensors are walked in chunks of max_chunk_elems through ALIAS views,
+// scratch is 17 bytes per chunk element and is kept by a DeviceComparer
+// between calls. All chunks are queued on `stream` and their scalars come
+// back in one copy after a single synchronize.
+struct DeviceCompareReport {
+  int64_t count = 0;                // elements compared
+  int64_t failures = 0;
+  int64_t nonfinite = 0;            // non-finite values in actual
+  int64_t expected_nonfinite = 0;   // and in expected
+  double max_abs_err = 0;
+  double mean_abs_err = 0;          // NaN if any error is NaN
+  aclError ret = ACL_SUCCESS;       // first failed launch or copy
+
+  bool ok() const { return ret == ACL_SUCCESS && failures == 0 && nonfinite == expected_nonfinite; }
+
+  void Print(const std::string& name, std::ostream& os = std::cout) const {
+    if (ret != ACL_SUCCESS) {
+      os << name << " : device compare failed with " << ret << std::endl;
+      return;
+    }
+    os << name << " : " << count << " elements, " << failures << " failures (on device), max abs err "
+       << max_abs_err << ", mean abs err " << mean_abs_err << ", non-finite " << nonfinite << " (ref "
+       << expected_nonfinite << ")" << std::endl;
+  }
+};
+
+namespace device_compare {
+
+// scalar results of one chunk, one 32-byte aligned cell each
+enum { MAX_ERR, SUM_ERR, FAILURES, FINITE_ACTUAL, FINITE_EXPECTED, NUM_FIELDS };
+constexpr size_t kCell = 32;
+
+// Queues ops on a stream and keeps their tensors and attrs alive until the
+// stream has been synchronized. A failed launch skips the remaining ones.
+class Launcher {
+ public:
+  typedef npuTensor<char> View;
+  typedef std::function<void(aclopAttr *)> AttrSetter;
+
+  explicit Launcher(aclrtStream stream) : stream_(stream), ret_(ACL_SUCCESS) {}
+  ~Launcher() {
+    for (auto view : views_) {
+      view->Destroy();
+      delete view;
+    }
+    for (auto attr : attrs_) {
+      aclopDestroyAttr(attr);
+    }
+  }
+
+  // `n` elements of device memory at `ptr`, a 0-d scalar if n < 0
+  View* Alias(aclDataType dtype, int64_t n, void* ptr) {
+    const int64_t dims[1] = {n};
+    views_.push_back(new View(dtype, n < 0 ? 0 : 1, dims, ACL_FORMAT_ND, static_cast<const char *>(ptr),
+                              memType::ALIAS));
+    return views_.back();
+  }
+
+  // axes = {0} of a 1-D input, host const when OpInfo lists it
+  View* Axes(const std::string& op_type) {
+    auto it = axes_.find(op_type);
+    if (it != axes_.end()) {
+      return it->second;
+    }
+    static const int64_t axes[1] = {0};
+    const int64_t dims[1] = {1};
+    views_.push_back(PlanInput<char>(op_type, 1, ACL_INT64, 1, dims, ACL_FORMAT_ND,
+                                     reinterpret_cast<const char *>(axes)));
+    axes_[op_type] = views_.back();
+    return views_.back();
+  }
+
+  void Run(const std::string& op_type, std::initializer_list<View *> inputs, std::initializer_list<View *> outputs,
+           AttrSetter set_attrs = nullptr) {
+    if (ret_ != ACL_SUCCESS) {
+      return;
+    }
+    std::vector<aclTensorDesc *> input_descs;
+    std::vector<aclDataBuffer *> input_buffers;
+    for (auto view : inputs) {
+      input_descs.push_back(view->desc);
+      input_buffers.push_back(view->buffer);
+    }
+    std::vector<aclTensorDesc *> output_descs;
+    std::vector<aclDataBuffer *> output_buffers;
+    for (auto view : outputs) {
+      output_descs.push_back(view->desc);
+      output_buffers.push_back(view->buffer);
+    }
+    auto attr = aclopCreateAttr();
+    attrs_.push_back(attr);
+    if (set_attrs) {
+      set_attrs(attr);
+    }
+    ret_ = aclopCompileAndExecute(op_type.c_str(),
+              input_descs.size(), input_descs.data(), input_buffers.data(),
+              output_descs.size(), output_descs.data(), output_buffers.data(),
+              attr, ACL_ENGINE_SYS, ACL_COMPILE_SYS, NULL, stream_);
+    if (ret_ != ACL_SUCCESS) {
+      LOG(ERROR) << "device compare : " << op_type << " failed with " << ret_;
+    }
+  }
+
+  // y = sum / max of x over its only axis, as a 0-d scalar
+  void Reduce(const std::string& op_type, View* x, View* y) {
+    Run(op_type, {x, Axes(op_type)}, {y}, [](aclopAttr* attr) {
+      ACL_CALL(aclopSetAttrBool(attr, "keep_dims", false));
+    });
+  }
+
+  // y = x cast to `dtype`
+  void Cast(View* x, View* y, aclDataType dtype) {
+    Run("Cast", {x}, {y}, [dtype](aclopAttr* attr) { ACL_CALL(aclopSetAttrInt(attr, "dst_type", dtype)); });
+  }
+
+  // y = number of true elements of the bool `mask`, counted through int32 `count`
+  void CountTrue(View* mask, View* count, View* y) {
+    Cast(mask, count, ACL_INT32);
+    Reduce("ReduceSum", count, y);
+  }
+
+  aclError ret() const { return ret_; }
+
+ private:
+  aclrtStream stream_;
+  aclError ret_;
+  std::vector<View *> views_;
+  std::map<std::string, View *> axes_;
+  std::vector<aclopAttr *> attrs_;
+};
+
+}  // namespace device_compare
+
+// Owns the device scratch of DeviceCompare() so repeated comparisons, e.g.
+// of every step of a loop, only queue the ops and download the per-chunk
+// scalars. Buffers are allocated by the first Compare() and only grow when a
+// later tensor needs more chunks or a larger chunk.
+class DeviceComparer {
+ public:
+  explicit DeviceComparer(int64_t max_chunk_elems = 1 << 24)
+      // 64K multiples keep every chunk view 32-byte aligned
+      : chunk_(std::max<int64_t>(1 << 16, max_chunk_elems / (1 << 16) * (1 << 16))) {}
+  ~DeviceComparer() { Release(); }
+  DeviceComparer(const DeviceComparer&) = delete;
+  DeviceComparer& operator=(const DeviceComparer&) = delete;
+
+  // actual and expected are device tensors of the same shape, float or float16
+  template <typename T>
+  DeviceCompareReport Compare(npuTensor<T>* actual, npuTensor<T>* expected, const Tolerance& tol,
+                              aclrtStream stream) {
+    using namespace device_compare;
+    DeviceCompareReport report;
+    const aclDataType dtype = aclGetTensorDescType(actual->desc);
+    CHECK(dtype == ACL_FLOAT || dtype == ACL_FLOAT16) << "device compare supports float and float16 only";
+    CHECK_EQ(actual->size, expected->size);
+    CHECK(actual->mem_type_ != memType::HOST && expected->mem_type_ != memType::HOST);
+    const int64_t n = aclGetTensorDescElementCount(actual->desc);
+    const size_t elem = aclDataTypeSize(dtype);
+    report.count = n;
+    if (n == 0) {
+      return report;
+    }
+    const int64_t num_chunks = (n + chunk_ - 1) / chunk_;
+    const size_t results_size = num_chunks * NUM_FIELDS * kCell;
+    report.ret = Reserve(std::min(chunk_, n), num_chunks);
+    const float atol = static_cast<float>(tol.atol);
+    if (report.ret == ACL_SUCCESS && !(atol_uploaded_ && atol == atol_)) {
+      report.ret = aclrtMemcpy(atol_buf_, sizeof(float), &atol, sizeof(float), ACL_MEMCPY_HOST_TO_DEVICE);
+      atol_uploaded_ = report.ret == ACL_SUCCESS;
+      atol_ = atol;
+    }
+    if (report.ret != ACL_SUCCESS) {
+      return report;
+    }
+    const float rtol = static_cast<float>(tol.rtol);
+
+    {
+      Launcher launcher(stream);
+      auto atol_view = launcher.Alias(ACL_FLOAT, 1, atol_buf_);
+      auto max_view = launcher.Alias(ACL_FLOAT, 1, static_cast<char *>(atol_buf_) + kCell);
+      for (int64_t c = 0; c < num_chunks && launcher.ret() == ACL_SUCCESS; ++c) {
+        const int64_t begin = c * chunk_;
+        const int64_t len = std::min(chunk_, n - begin);
+        auto a = launcher.Alias(dtype, len, static_cast<char *>(actual->device_ptr) + begin * elem);
+        auto e = launcher.Alias(dtype, len, static_cast<char *>(expected->device_ptr) + begin * elem);
+        auto a_t = launcher.Alias(dtype, len, buf_[0]);
+        auto b_t = launcher.Alias(dtype, len, buf_[1]);
+        auto a_f = launcher.Alias(ACL_FLOAT, len, buf_[0]);
+        auto b_f = launcher.Alias(ACL_FLOAT, len, buf_[1]);
+        auto c_f = launcher.Alias(ACL_FLOAT, len, buf_[2]);
+        auto mask = launcher.Alias(ACL_BOOL, len, mask_buf_);
+        auto count = launcher.Alias(ACL_INT32, len, count_buf_);
+        char* slot = static_cast<char *>(results_buf_) + c * NUM_FIELDS * kCell;
+        auto field = [&](int f, aclDataType type) { return launcher.Alias(type, -1, slot + f * kCell); };
+
+        // err = |actual - expected| in c_f
+        launcher.Run("Sub", {a, e}, {a_t});
+        if (dtype == ACL_FLOAT) {
+          launcher.Run("Abs", {a_t}, {c_f});
+        } else {
+          launcher.Run("Abs", {a_t}, {b_t});
+          launcher.Cast(b_t, c_f, ACL_FLOAT);
+        }
+        launcher.Reduce("ReduceMax", c_f, field(MAX_ERR, ACL_FLOAT));
+        launcher.Reduce("ReduceSum", c_f, field(SUM_ERR, ACL_FLOAT));
+
+        // bound = min(max(atol, rtol * |expected|), FLT_MAX)
+        auto set_rtol = [rtol](aclopAttr* attr) { ACL_CALL(aclopSetAttrFloat(attr, "value", rtol)); };
+        Launcher::View* bound = nullptr;
+        launcher.Run("Abs", {e}, {a_t});
+        if (dtype == ACL_FLOAT) {
+          launcher.Run("Muls", {a_f}, {b_f}, set_rtol);
+          launcher.Run("Maximum", {b_f, atol_view}, {a_f});
+          launcher.Run("Minimum", {a_f, max_view}, {b_f});
+          bound = b_f;
+        } else {
+          launcher.Run("Muls", {a_t}, {b_t}, set_rtol);
+          launcher.Cast(b_t, a_f, ACL_FLOAT);
+          launcher.Run("Maximum", {a_f, atol_view}, {b_f});
+          launcher.Run("Minimum", {b_f, max_view}, {a_f});
+          bound = a_f;
+        }
+
+        // a NaN difference is never greater, so NaN on one side only is
+        // added: IsNan(actual) != IsNan(expected), compared as uint8
+        launcher.Run("Greater", {c_f, bound}, {mask});
+        auto nan_a = launcher.Alias(ACL_BOOL, len, buf_[0]);
+        auto nan_e = launcher.Alias(ACL_BOOL, len, buf_[1]);
+        auto nan_fail = launcher.Alias(ACL_BOOL, len, buf_[2]);
+        launcher.Run("IsNan", {a}, {nan_a});
+        launcher.Run("IsNan", {e}, {nan_e});
+        launcher.Run("NotEqual", {launcher.Alias(ACL_UINT8, len, buf_[0]), launcher.Alias(ACL_UINT8, len, buf_[1])},
+                     {nan_fail});
+        launcher.Run("LogicalOr", {mask, nan_fail}, {nan_a});
+        launcher.CountTrue(nan_a, count, field(FAILURES, ACL_INT32));
+        launcher.Run("IsFinite", {a}, {mask});
+        launcher.CountTrue(mask, count, field(FINITE_ACTUAL, ACL_INT32));
+        launcher.Run("IsFinite", {e}, {mask});
+        launcher.CountTrue(mask, count, field(FINITE_EXPECTED, ACL_INT32));
+      }
+      // also after a failed launch: the queued kernels read the views and
+      // axes the launcher frees
+      const aclError sync = aclrtSynchronizeStream(stream);
+      report.ret = launcher.ret() != ACL_SUCCESS ? launcher.ret() : sync;
+    }
+
+    if (report.ret == ACL_SUCCESS) {
+      results_.resize(results_size);
+      report.ret = aclrtMemcpy(results_.data(), results_size, results_buf_, results_size, ACL_MEMCPY_DEVICE_TO_HOST);
+      double sum = 0;
+      for (int64_t c = 0; c < num_chunks; ++c) {
+        const char* slot = results_.data() + c * NUM_FIELDS * kCell;
+        const float max_err = *reinterpret_cast<const float *>(slot + MAX_ERR * kCell);
+        const int64_t len = std::min(chunk_, n - c * chunk_);
+        // NaN propagates through max
+        report.max_abs_err = (max_err > report.max_abs_err || max_err != max_err) ? max_err : report.max_abs_err;
+        sum += *reinterpret_cast<const float *>(slot + SUM_ERR * kCell);
+        report.failures += *reinterpret_cast<const int32_t *>(slot + FAILURES * kCell);
+        report.nonfinite += len - *reinterpret_cast<const int32_t *>(slot + FINITE_ACTUAL * kCell);
+        report.expected_nonfinite += len - *reinterpret_cast<const int32_t *>(slot + FINITE_EXPECTED * kCell);
+      }
+      report.mean_abs_err = sum / n;
+    }
+    return report;
+  }
+
+  // device bytes Compare() holds for a tensor of n elements
+  size_t ScratchBytes(int64_t n) const {
+    const int64_t num_chunks = (n + chunk_ - 1) / chunk_;
+    return std::min(chunk_, n) * kScratchPerElem + 2 * device_compare::kCell +
+           num_chunks * device_compare::NUM_FIELDS * device_compare::kCell;
+  }
+
+ private:
+  // three float buffers, the bool mask and its int32 count
+  static constexpr size_t kScratchPerElem = 3 * sizeof(float) + 1 + sizeof(int32_t);
+
+  // chunk buffers of `scratch` elements and result cells for `num_chunks`
+  aclError Reserve(int64_t scratch, int64_t num_chunks) {
+    aclError ret = ACL_SUCCESS;
+    if (scratch > scratch_) {
+      FreeChunkBuffers();
+      for (auto& b : buf_) {
+        ret = ret == ACL_SUCCESS ? aclrtMalloc(&b, scratch * sizeof(float), ACL_MEM_MALLOC_NORMAL_ONLY) : ret;
+      }
+      ret = ret == ACL_SUCCESS ? aclrtMalloc(&mask_buf_, scratch, ACL_MEM_MALLOC_NORMAL_ONLY) : ret;
+      ret = ret == ACL_SUCCESS ? aclrtMalloc(&count_buf_, scratch * sizeof(int32_t), ACL_MEM_MALLOC_NORMAL_ONLY)
+                               : ret;
+      if (ret != ACL_SUCCESS) {
+        FreeChunkBuffers();
+        return ret;
+      }
+      scratch_ = scratch;
+    }
+    if (num_chunks > num_chunks_) {
+      FreeBuffer(&results_buf_);
+      ret = aclrtMalloc(&results_buf_, num_chunks * device_compare::NUM_FIELDS * device_compare::kCell,
+                        ACL_MEM_MALLOC_NORMAL_ONLY);
+      num_chunks_ = ret == ACL_SUCCESS ? num_chunks : 0;
+    }
+    // atol, then FLT_MAX as the cap of the bound
+    if (ret == ACL_SUCCESS && atol_buf_ == nullptr) {
+      ret = aclrtMalloc(&atol_buf_, 2 * device_compare::kCell, ACL_MEM_MALLOC_NORMAL_ONLY);
+      const float max = std::numeric_limits<float>::max();
+      ret = ret == ACL_SUCCESS ? aclrtMemcpy(static_cast<char *>(atol_buf_) + device_compare::kCell, sizeof(float),
+                                             &max, sizeof(float), ACL_MEMCPY_HOST_TO_DEVICE)
+                               : ret;
+      if (ret != ACL_SUCCESS) {
+        FreeBuffer(&atol_buf_);
+      }
+    }
+    return ret;
+  }
+
+  static void FreeBuffer(void** b) {
+    if (*b != nullptr) {
+      ACL_CALL(aclrtFree(*b));
+      *b = nullptr;
+    }
+  }
+
+  void FreeChunkBuffers() {
+    for (auto& b : buf_) {
+      FreeBuffer(&b);
+    }
+    FreeBuffer(&mask_buf_);
+    FreeBuffer(&count_buf_);
+    scratch_ = 0;
+  }
+
+  void Release() {
+    FreeChunkBuffers();
+    FreeBuffer(&results_buf_);
+    FreeBuffer(&atol_buf_);
+    num_chunks_ = 0;
+    atol_uploaded_ = false;
+  }
+
+  int64_t chunk_;
+  int64_t scratch_ = 0;     // elements of the chunk buffers
+  int64_t num_chunks_ = 0;  // result cells allocated
+  void* buf_[3] = {nullptr, nullptr, nullptr};
+  void* mask_buf_ = nullptr;
+  void* count_buf_ = nullptr;
+  void* atol_buf_ = nullptr;
+  void* results_buf_ = nullptr;
+  float atol_ = 0;          // value in atol_buf_, once uploaded
+  bool atol_uploaded_ = false;
+  std::vector<char> results_;
+};
+
+// one-off comparison, allocates and frees its scratch; use a DeviceComparer
+// to compare repeatedly
+template <typename T>
+DeviceCompareReport DeviceCompare(npuTensor<T>* actual, npuTensor<T>* expected, const Tolerance& tol,
+                                  aclrtStream stream, int64_t max_chunk_elems = 1 << 24) {
+  DeviceComparer comparer(max_chunk_elems);
+  return comparer.Compare(actual, expected, tol, stream);
+}
@@ -0,0 +1,228 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "common/nputensor.h"
+#include "common/opinfo.h"
+#include "common/compile_cache.h"
+
+// One op call that runs either as the tensor form or as its static-attribute
+// "D" variant (OpInfo::d_variant).
+//
+// The D variant is picked when every input it takes as an attribute is a
+// host const tensor (see PlanInput) and the data dtype is listed in
+// OpInfo::d_dtypes, e.g. BroadcastTo with DT_INT64 stays on the tensor form.
+// If the D variant still fails to run, the call falls back to the tensor form
+// and that op/dtype pair is not tried again in this process.
+class DispatchCall {
+ public:
+  typedef std::function<void(aclopAttr *)> AttrSetter;
+
+  // `set_attrs` sets the attributes common to both forms
+  DispatchCall(const std::string& op_type, AttrSetter set_attrs = nullptr, bool enable = true)
+      : op_type_(op_type), set_attrs_(set_attrs), enable_(enable) {}
+
+  template <typename T>
+  void Input(npuTensor<T>* tensor) {
+    inputs_.push_back(Arg{tensor->desc, tensor->buffer, tensor->is_const()});
+  }
+
+  template <typename T>
+  void Output(npuTensor<T>* tensor) {
+    outputs_.push_back(Arg{tensor->desc, tensor->buffer, false});
+  }
+
+  // op type Execute() will launch
+  std::string Selected() const { return UseDVariant() ? GetOpInfo(op_type_).d_variant : op_type_; }
+
+  // compile key of the selected form, const values / attrs included
+  std::string Key() const {
+    std::vector<aclTensorDesc *> input_descs;
+    std::vector<aclDataBuffer *> input_buffers;
+    std::vector<aclTensorDesc *> output_descs;
+    const bool d = UseDVariant();
+    std::stringstream attr_key;
+    for (size_t i = 0; i < inputs_.size(); ++i) {
+      if (d && IsDAttr(i)) {
+        attr_key << FindDAttr(i)->name << "=" << ListKey(inputs_[i], FindDAttr(i)->type) << ";";
+        continue;
+      }
+      input_descs.push_back(inputs_[i].desc);
+      input_buffers.push_back(inputs_[i].buffer);
+    }
+    for (const auto& arg : outputs_) {
+      output_descs.push_back(arg.desc);
+    }
+    return CompileKey(Selected(), input_descs, input_buffers, output_descs, attr_key.str(), !d && AllConst());
+  }
+
+  aclError Execute(aclrtStream stream) {
+    if (UseDVariant()) {
+      aclError ret = Launch(true, stream);
+      if (ret == ACL_SUCCESS) {
+        return ret;
+      }
+      LOG(WARNING) << GetOpInfo(op_type_).d_variant << " failed with " << ret << ", falling back to " << op_type_;
+      Unsupported().insert(UnsupportedKey());
+    }
+    return Launch(false, stream);
+  }
+
+ private:
+  struct Arg {
+    aclTensorDesc* desc;
+    aclDataBuffer* buffer;
+    bool host_const;
+  };
+
+  static std::set<std::string>& Unsupported() {
+    static std::set<std::string> unsupported;
+    return unsupported;
+  }
+
+  bool IsDAttr(size_t index) const { return FindDAttr(index) != nullptr; }
+
+  const DAttr* FindDAttr(size_t index) const {
+    for (const auto& it : GetOpInfo(op_type_).d_attrs) {
+      if (it.input == static_cast<int>(index)) {
+        return &it;
+      }
+    }
+    return nullptr;
+  }
+
+  // dtype of the first data input, or of the first output for ops whose
+  // inputs are all attributes in the D form (FillV2)
+  aclDataType DataType() const {
+    for (size_t i = 0; i < inputs_.size(); ++i) {
+      if (!IsDAttr(i)) {
+        return aclGetTensorDescType(inputs_[i].desc);
+      }
+    }
+    return outputs_.empty() ? ACL_DT_UNDEFINED : aclGetTensorDescType(outputs_[0].desc);
+  }
+
+  std::string UnsupportedKey() const { return op_type_ + ":" + std::to_string(DataType()); }
+
+  bool AllConst() const {
+    for (size_t i = 0; i < inputs_.size(); ++i) {
+      if (IsConstInput(op_type_, i) && !inputs_[i].host_const) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool UseDVariant() const {
+    const OpInfo& info = GetOpInfo(op_type_);
+    if (!enable_ || info.d_variant.empty()) {
+      return false;
+    }
+    for (const auto& it : info.d_attrs) {
+      if (it.input >= static_cast<int>(inputs_.size()) || !inputs_[it.input].host_const) {
+        return false;
+      }
+      aclDataType type = aclGetTensorDescType(inputs_[it.input].desc);
+      if (type != ACL_INT32 && type != ACL_INT64 && type != ACL_FLOAT) {
+        return false;
+      }
+      // float values of a list-of-int attribute must be integral
+      if (type == ACL_FLOAT && it.type == LIST_INT) {
+        for (float v : FloatValues(inputs_[it.input])) {
+          if (v != std::trunc(v)) {
+            return false;
+          }
+        }
+      }
+    }
+    if (!info.d_dtypes.empty() &&
+        std::find(info.d_dtypes.begin(), info.d_dtypes.end(), DataType()) == info.d_dtypes.end()) {
+      return false;
+    }
+    return Unsupported().count(UnsupportedKey()) == 0;
+  }
+
+  // host values of a const int32/int64/float input
+  static size_t Numel(const Arg& arg) {
+    return aclGetDataBufferSizeV2(arg.buffer) / aclDataTypeSize(aclGetTensorDescType(arg.desc));
+  }
+  // values converted to the attribute type, whatever the tensor dtype
+  static std::vector<int64_t> IntValues(const Arg& arg) {
+    const void* data = aclGetDataBufferAddr(arg.buffer);
+    const aclDataType type = aclGetTensorDescType(arg.desc);
+    std::vector<int64_t> values(Numel(arg));
+    for (size_t i = 0; i < values.size(); ++i) {
+      values[i] = type == ACL_INT32 ? static_cast<const int32_t *>(data)[i]
+                : type == ACL_FLOAT ? static_cast<int64_t>(static_cast<const float *>(data)[i])
+                                    : static_cast<const int64_t *>(data)[i];
+    }
+    return values;
+  }
+  static std::vector<float> FloatValues(const Arg& arg) {
+    if (aclGetTensorDescType(arg.desc) != ACL_FLOAT) {
+      const std::vector<int64_t> ints = IntValues(arg);
+      return std::vector<float>(ints.begin(), ints.end());
+    }
+    const float* data = static_cast<const float *>(aclGetDataBufferAddr(arg.buffer));
+    return std::vector<float>(data, data + Numel(arg));
+  }
+  static std::string ListKey(const Arg& arg, dAttrType type) {
+    std::stringstream ss;
+    if (type == LIST_FLOAT) {
+      for (float v : FloatValues(arg)) ss << v << ",";
+    } else {
+      for (int64_t v : IntValues(arg)) ss << v << ",";
+    }
+    return ss.str();
+  }
+
+  aclError Launch(bool d, aclrtStream stream) {
+    auto attr = aclopCreateAttr();
+    if (set_attrs_) {
+      set_attrs_(attr);
+    }
+    std::vector<aclTensorDesc *> input_descs;
+    std::vector<aclDataBuffer *> input_buffers;
+    for (size_t i = 0; i < inputs_.size(); ++i) {
+      if (d && IsDAttr(i)) {
+        const DAttr* d_attr = FindDAttr(i);
+        if (d_attr->type == LIST_FLOAT) {
+          auto values = FloatValues(inputs_[i]);
+          ACL_CALL(aclopSetAttrListFloat(attr, d_attr->name.c_str(), values.size(), values.data()));
+        } else {
+          auto values = IntValues(inputs_[i]);
+          ACL_CALL(aclopSetAttrListInt(attr, d_attr->name.c_str(), values.size(), values.data()));
+        }
+        continue;
+      }
+      input_descs.push_back(inputs_[i].desc);
+      input_buffers.push_back(inputs_[i].buffer);
+    }
+    std::vector<aclTensorDesc *> output_descs;
+    std::vector<aclDataBuffer *> output_buffers;
+    for (const auto& arg : outputs_) {
+      output_descs.push_back(arg.desc);
+      output_buffers.push_back(arg.buffer);
+    }
+    const std::string op = d ? GetOpInfo(op_type_).d_variant : op_type_;
+    VLOG(1) << "dispatch " << op_type_ << " -> " << op;
+    aclError ret = aclopCompileAndExecute(op.c_str(),
+              input_descs.size(), input_descs.data(), input_buffers.data(),
+              output_descs.size(), output_descs.data(), output_buffers.data(),
+              attr, ACL_ENGINE_SYS, ACL_COMPILE_SYS, NULL, stream);
+    aclopDestroyAttr(attr);
+    return ret;
+  }
+
+  std::string op_type_;
+  AttrSetter set_attrs_;
+  bool enable_;
+  std::vector<Arg> inputs_;
+  std::vector<Arg> outputs_;
+};
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "acl/acl.h"
+#include "common/float16.h"
+#include "common/logging.h"
+
+// Float dtype switch of the op tests: `fp32` (default), `fp16` or `bf16` on
+// the command line picks the host type the test is instantiated with,
+// float, float16 or bfloat16. Host data is generated in float and rounded to
+// the chosen type once, so the CPU reference sees the same inputs as the
+// device.
+inline aclDataType ParseFloatType(const std::string& name) {
+  if (name.empty() || name == "fp32" || name == "float" || name == "float32") {
+    return ACL_FLOAT;
+  }
+  if (name == "fp16" || name == "float16" || name == "half") {
+    return ACL_FLOAT16;
+  }
+  if (name == "bf16" || name == "bfloat16") {
+    return ACL_BF16;
+  }
+  LOG(FATAL) << "unknown dtype " << name << ", expected fp32, fp16 or bf16";
+  return ACL_FLOAT;
+}
+
+inline const char* DataTypeName(aclDataType dtype) {
+  switch (dtype) {
+    case ACL_FLOAT: return "fp32";
+    case ACL_FLOAT16: return "fp16";
+    case ACL_BF16: return "bf16";
+    case ACL_DOUBLE: return "fp64";
+    case ACL_INT8: return "int8";
+    case ACL_UINT8: return "uint8";
+    case ACL_INT16: return "int16";
+    case ACL_UINT16: return "uint16";
+    case ACL_INT32: return "int32";
+    case ACL_UINT32: return "uint32";
+    case ACL_INT64: return "int64";
+    case ACL_UINT64: return "uint64";
+    case ACL_BOOL: return "bool";
+    default: return "unknown";
+  }
+}
+
+// any dtype by its DataTypeName or one of the float aliases above
+inline aclDataType ParseDataType(const std::string& name) {
+  static const aclDataType kTypes[] = {ACL_FLOAT, ACL_FLOAT16, ACL_BF16,  ACL_DOUBLE, ACL_INT8,  ACL_UINT8, ACL_INT16,
+                                       ACL_UINT16, ACL_INT32, ACL_UINT32, ACL_INT64, ACL_UINT64, ACL_BOOL};
+  for (aclDataType dtype : kTypes) {
+    if (name == DataTypeName(dtype)) {
+      return dtype;
+    }
+  }
+  return ParseFloatType(name);
+}
+
+inline const char* FormatName(aclFormat format) {
+  switch (format) {
+    case ACL_FORMAT_ND: return "ND";
+    case ACL_FORMAT_NCHW: return "NCHW";
+    case ACL_FORMAT_NHWC: return "NHWC";
+    case ACL_FORMAT_NC1HWC0: return "NC1HWC0";
+    case ACL_FORMAT_NCDHW: return "NCDHW";
+    case ACL_FORMAT_NDHWC: return "NDHWC";
+    case ACL_FORMAT_HWCN: return "HWCN";
+    case ACL_FORMAT_FRACTAL_Z: return "FRACTAL_Z";
+    case ACL_FORMAT_FRACTAL_NZ: return "FRACTAL_NZ";
+    default: return "unknown";
+  }
+}
+
+inline aclFormat ParseFormat(const std::string& name) {
+  static const aclFormat kFormats[] = {ACL_FORMAT_ND,    ACL_FORMAT_NCHW,      ACL_FORMAT_NHWC,      ACL_FORMAT_NC1HWC0,
+                                       ACL_FORMAT_NCDHW, ACL_FORMAT_NDHWC,     ACL_FORMAT_HWCN,      ACL_FORMAT_FRACTAL_Z,
+                                       ACL_FORMAT_FRACTAL_NZ};
+  for (aclFormat format : kFormats) {
+    if (name == FormatName(format)) {
+      return format;
+    }
+  }
+  LOG(FATAL) << "unknown format " << name;
+  return ACL_FORMAT_ND;
+}
+
+inline void ConvertFromFloat(const float* src, float* dst, size_t n) { std::copy(src, src + n, dst); }
+inline void ConvertFromFloat(const float* src, float16* dst, size_t n) { FloatToHalf(src, dst, n); }
+inline void ConvertFromFloat(const float* src, bfloat16* dst, size_t n) { FloatToBFloat16(src, dst, n); }
+
+// `v` rounded to T
+template <typename T>
+std::vector<T> FromFloat(const std::vector<float>& v) {
+  std::vector<T> out(v.size());
+  ConvertFromFloat(v.data(), out.data(), v.size());
+  return out;
+}
@@ -0,0 +1,302 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+
+#include "common/parallel.h"
+
+#if defined(__F16C__) || defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// IEEE 754 binary16 <-> binary32, round to nearest even.
+inline float HalfToFloat(uint16_t h) {
+#if defined(__F16C__)
+  return _cvtsh_ss(h);
+#else
+  const uint32_t sign = (h & 0x8000u) << 16;
+  uint32_t exp = (h >> 10) & 0x1f;
+  uint32_t mant = h & 0x3ffu;
+  uint32_t bits;
+  if (exp == 0x1f) {
+    // inf / nan
+    bits = sign | 0x7f800000u | (mant << 13);
+  } else if (exp != 0) {
+    bits = sign | ((exp + 112) << 23) | (mant << 13);
+  } else if (mant == 0) {
+    bits = sign;
+  } else {
+    // subnormal, normalize
+    exp = 113;
+    while ((mant & 0x400u) == 0) {
+      mant <<= 1;
+      --exp;
+    }
+    bits = sign | (exp << 23) | ((mant & 0x3ffu) << 13);
+  }
+  float f;
+  std::memcpy(&f, &bits, sizeof(f));
+  return f;
+#endif
+}
+
+inline uint16_t FloatToHalf(float f) {
+#if defined(__F16C__)
+  return _cvtss_sh(f, _MM_FROUND_TO_NEAREST_INT);
+#else
+  uint32_t bits;
+  std::memcpy(&bits, &f, sizeof(bits));
+  const uint16_t sign = (bits >> 16) & 0x8000u;
+  const uint32_t abs = bits & 0x7fffffffu;
+  if (abs >= 0x7f800000u) {
+    // inf / nan, keep nan quiet
+    return sign | 0x7c00u | (abs > 0x7f800000u ? 0x200u : 0);
+  }
+  if (abs >= 0x477ff000u) {
+    // rounds above 65504
+    return sign | 0x7c00u;
+  }
+  if (abs < 0x38800000u) {
+    // subnormal or zero in half precision
+    if (abs < 0x33000000u) {
+      return sign;
+    }
+    const uint32_t exp = abs >> 23;
+    const uint32_t mant = (abs & 0x7fffffu) | 0x800000u;
+    const uint32_t shift = 126 - exp;
+    uint32_t h = mant >> shift;
+    const uint32_t rem = mant & ((1u << shift) - 1);
+    const uint32_t half = 1u << (shift - 1);
+    if (rem > half || (rem == half && (h & 1))) {
+      ++h;
+    }
+    return sign | h;
+  }
+  uint32_t h = ((abs >> 13) - (112u << 10));
+  const uint32_t rem = abs & 0x1fffu;
+  if (rem > 0x1000u || (rem == 0x1000u && (h & 1))) {
+    ++h;
+  }
+  return sign | h;
+#endif
+}
+
+// Storage type for ACL_FLOAT16 host data, distinct from uint16_t so
+// templates can tell them apart.
+struct float16 {
+  uint16_t bits;
+
+  float16() = default;
+  explicit float16(float f) : bits(FloatToHalf(f)) {}
+  operator float() const { return HalfToFloat(bits); }
+
+  static float16 FromBits(uint16_t b) {
+    float16 h;
+    h.bits = b;
+    return h;
+  }
+};
+
+inline std::ostream& operator<<(std::ostream& os, const float16& h) { return os << static_cast<float>(h); }
+
+// bfloat16 -> IEEE 754 binary32, exact: the bits become the upper half.
+inline float BFloat16ToFloat(uint16_t b) {
+  const uint32_t bits = static_cast<uint32_t>(b) << 16;
+  float f;
+  std::memcpy(&f, &bits, sizeof(f));
+  return f;
+}
+
+// IEEE 754 binary32 -> bfloat16 (the upper 16 bits), round to nearest even,
+// NaN stays a quiet NaN.
+inline uint16_t FloatToBFloat16(float f) {
+  uint32_t bits;
+  std::memcpy(&bits, &f, sizeof(bits));
+  if ((bits & 0x7fffffffu) > 0x7f800000u) {
+    return static_cast<uint16_t>((bits >> 16) | 0x40u);
+  }
+  bits += 0x7fffu + ((bits >> 16) & 1);
+  return static_cast<uint16_t>(bits >> 16);
+}
+
+// Storage type for ACL_BF16 host data.
+struct bfloat16 {
+  uint16_t bits;
+
+  bfloat16() = default;
+  explicit bfloat16(float f) : bits(FloatToBFloat16(f)) {}
+  operator float() const { return BFloat16ToFloat(bits); }
+
+  static bfloat16 FromBits(uint16_t b) {
+    bfloat16 h;
+    h.bits = b;
+    return h;
+  }
+};
+
+inline std::ostream& operator<<(std::ostream& os, const bfloat16& h) { return os << static_cast<float>(h); }
+
+// Bulk conversions, F16C / AVX-512 / AVX2 or NEON where the build enables
+// them. Buffers of kParallelConvert elements
+// or more are split over ParallelFor.
+// GCC 12 reports the _mm512_undefined_* sources of the AVX-512 intrinsics as
+// maybe-uninitialized
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+namespace convert {
+
+constexpr size_t kParallelConvert = 1 << 20;
+constexpr size_t kChunk = 1 << 18;
+
+inline void HalfToFloat(const float16* src, float* dst, size_t n) {
+  size_t i = 0;
+#if defined(__AVX512F__)
+  for (; i + 16 <= n; i += 16) {
+    __m256i h = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+    _mm512_storeu_ps(dst + i, _mm512_cvtph_ps(h));
+  }
+#endif
+#if defined(__F16C__)
+  for (; i + 8 <= n; i += 8) {
+    __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+    _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(h));
+  }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  for (; i + 4 <= n; i += 4) {
+    float16x4_t h = vreinterpret_f16_u16(vld1_u16(reinterpret_cast<const uint16_t *>(src + i)));
+    vst1q_f32(dst + i, vcvt_f32_f16(h));
+  }
+#endif
+  for (; i < n; ++i) {
+    dst[i] = ::HalfToFloat(src[i].bits);
+  }
+}
+
+inline void FloatToHalf(const float* src, float16* dst, size_t n) {
+  size_t i = 0;
+#if defined(__AVX512F__)
+  for (; i + 16 <= n; i += 16) {
+    __m256i h = _mm512_cvtps_ph(_mm512_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), h);
+  }
+#endif
+#if defined(__F16C__)
+  for (; i + 8 <= n; i += 8) {
+    __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), h);
+  }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  for (; i + 4 <= n; i += 4) {
+    float16x4_t h = vcvt_f16_f32(vld1q_f32(src + i));
+    vst1_u16(reinterpret_cast<uint16_t *>(dst + i), vreinterpret_u16_f16(h));
+  }
+#endif
+  for (; i < n; ++i) {
+    dst[i].bits = ::FloatToHalf(src[i]);
+  }
+}
+
+inline void BFloat16ToFloat(const bfloat16* src, float* dst, size_t n) {
+  size_t i = 0;
+#if defined(__AVX512F__)
+  for (; i + 16 <= n; i += 16) {
+    __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+    _mm512_storeu_si512(dst + i, _mm512_slli_epi32(_mm512_cvtepu16_epi32(b), 16));
+  }
+#endif
+#if defined(__AVX2__)
+  for (; i + 8 <= n; i += 8) {
+    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_slli_epi32(_mm256_cvtepu16_epi32(b), 16));
+  }
+#elif defined(__ARM_NEON)
+  for (; i + 4 <= n; i += 4) {
+    uint32x4_t b = vshll_n_u16(vld1_u16(reinterpret_cast<const uint16_t *>(src + i)), 16);
+    vst1q_f32(dst + i, vreinterpretq_f32_u32(b));
+  }
+#endif
+  for (; i < n; ++i) {
+    dst[i] = ::BFloat16ToFloat(src[i].bits);
+  }
+}
+
+inline void FloatToBFloat16(const float* src, bfloat16* dst, size_t n) {
+  size_t i = 0;
+#if defined(__AVX512F__)
+  // integer rounding, vcvtneps2bf16 would flush denormals to zero
+  for (; i + 16 <= n; i += 16) {
+    const __m512 f = _mm512_loadu_ps(src + i);
+    const __m512i bits = _mm512_castps_si512(f);
+    const __m512i lsb = _mm512_and_si512(_mm512_srli_epi32(bits, 16), _mm512_set1_epi32(1));
+    __m512i r = _mm512_srli_epi32(_mm512_add_epi32(bits, _mm512_add_epi32(lsb, _mm512_set1_epi32(0x7fff))), 16);
+    const __mmask16 nan = _mm512_cmp_ps_mask(f, f, _CMP_UNORD_Q);
+    r = _mm512_mask_or_epi32(r, nan, _mm512_srli_epi32(bits, 16), _mm512_set1_epi32(0x40));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm512_cvtepi32_epi16(r));
+  }
+#endif
+#if defined(__AVX2__)
+  for (; i + 8 <= n; i += 8) {
+    const __m256 f = _mm256_loadu_ps(src + i);
+    const __m256i bits = _mm256_castps_si256(f);
+    const __m256i lsb = _mm256_and_si256(_mm256_srli_epi32(bits, 16), _mm256_set1_epi32(1));
+    const __m256i r = _mm256_srli_epi32(_mm256_add_epi32(bits, _mm256_add_epi32(lsb, _mm256_set1_epi32(0x7fff))), 16);
+    const __m256i q = _mm256_or_si256(_mm256_srli_epi32(bits, 16), _mm256_set1_epi32(0x40));
+    const __m256i nan = _mm256_castps_si256(_mm256_cmp_ps(f, f, _CMP_UNORD_Q));
+    const __m256i v = _mm256_blendv_epi8(r, q, nan);
+    // values fit in 16 bits, packus works per 128-bit lane
+    const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(v, v), 0xd8);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm256_castsi256_si128(packed));
+  }
+#elif defined(__ARM_NEON)
+  for (; i + 4 <= n; i += 4) {
+    const float32x4_t f = vld1q_f32(src + i);
+    const uint32x4_t bits = vreinterpretq_u32_f32(f);
+    const uint32x4_t lsb = vandq_u32(vshrq_n_u32(bits, 16), vdupq_n_u32(1));
+    const uint32x4_t r = vaddq_u32(bits, vaddq_u32(lsb, vdupq_n_u32(0x7fff)));
+    const uint32x4_t q = vorrq_u32(bits, vdupq_n_u32(0x400000));
+    const uint32x4_t v = vbslq_u32(vceqq_f32(f, f), r, q);
+    vst1_u16(reinterpret_cast<uint16_t *>(dst + i), vshrn_n_u32(v, 16));
+  }
+#endif
+  for (; i < n; ++i) {
+    dst[i].bits = ::FloatToBFloat16(src[i]);
+  }
+}
+
+template <typename S, typename D>
+void Parallel(void (*kernel)(const S*, D*, size_t), const S* src, D* dst, size_t n) {
+  if (n < kParallelConvert) {
+    kernel(src, dst, n);
+    return;
+  }
+  ParallelFor((n + kChunk - 1) / kChunk, [&](int64_t c) {
+    const size_t begin = c * kChunk;
+    kernel(src + begin, dst + begin, std::min(kChunk, n - begin));
+  });
+}
+
+}  // namespace convert
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+inline void HalfToFloat(const float16* src, float* dst, size_t n) {
+  convert::Parallel(convert::HalfToFloat, src, dst, n);
+}
+inline void FloatToHalf(const float* src, float16* dst, size_t n) {
+  convert::Parallel(convert::FloatToHalf, src, dst, n);
+}
+inline void BFloat16ToFloat(const bfloat16* src, float* dst, size_t n) {
+  convert::Parallel(convert::BFloat16ToFloat, src, dst, n);
+}
+inline void FloatToBFloat16(const float* src, bfloat16* dst, size_t n) {
+  convert::Parallel(convert::FloatToBFloat16, src, dst, n);
+}
@@ -0,0 +1,295 @@
+#pragma once
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "acl/acl.h"
+#include "common/compare.h"
+#include "common/dtype.h"
+#include "common/logging.h"
+#include "common/mapped_file.h"
+#include "common/npy.h"
+#include "common/summary.h"
+
+// Local regression store of op outputs, keyed by a case signature (op,
+// attrs, tensor descriptors and a content hash of the inputs). Each output
+// keeps a compact digest: its TensorSummary (statistics and content hash)
+// and kSamples values at fixed positions, and optionally the full output as
+// <dir>/<key>.npy.
+//
+// A later run, e.g. after a CANN upgrade, compares the digest first: an
+// equal hash means a bit-identical output and nothing else is read. On a
+// different hash the full golden, if stored, is mapped and compared with
+// Compare(); otherwise the samples and statistics are checked against the
+// tolerance. An output is then "same", "close" (within tolerance) or
+// "changed", or "new" when the store had no entry, which records it. The
+// digest alone can miss a few changed elements between the samples that
+// leave the statistics within tolerance, keep full outputs to catch those.
+//
+// The index is <dir>/index.txt, one line per output:
+//   <key> <dtype> <count> <nan> <inf> <min> <max> <mean> <std> <hash> <full> <k> <samples...> <label>
+// Each entry is appended as soon as it is recorded, so a run that crashes
+// keeps the digests recorded so far; a later line for the same key wins.
+// Save() compacts the index to one line per key.
+struct GoldenDigest {
+  aclDataType dtype = ACL_DT_UNDEFINED;
+  TensorSummary summary;
+  std::vector<double> samples;
+  bool full = false;  // <key>.npy holds the whole output
+  std::string label;  // case the entry was recorded from, for reports
+};
+
+// in increasing severity, a case reports the worst status of its outputs
+typedef enum { SAME = 0, NEW = 1, CLOSE = 2, CHANGED = 3 } goldenStatus;
+
+inline const char* GoldenStatusName(goldenStatus s) {
+  static const char* kNames[] = {"same", "new", "close", "changed"};
+  return kNames[s];
+}
+
+namespace golden {
+
+constexpr int kSamples = 16;
+
+// kSamples values spread evenly over x, fewer for short tensors
+template <typename T>
+std::vector<double> Samples(const T* x, int64_t n) {
+  typedef typename compare::Traits<T>::compute C;
+  std::vector<double> samples;
+  const int64_t k = std::min<int64_t>(n, kSamples);
+  for (int64_t i = 0; i < k; ++i) {
+    C v;
+    compare::Load(x + i * n / k, 1, &v);
+    samples.push_back(static_cast<double>(v));
+  }
+  return samples;
+}
+
+// |actual - expected| <= max(atol, rtol * |scale|), the atol / rtol rule of
+// Compare(); NaN matches NaN
+inline bool Close(double actual, double expected, double scale, const Tolerance& tol) {
+  if (std::isnan(actual) || std::isnan(expected)) {
+    return std::isnan(actual) && std::isnan(expected);
+  }
+  if (actual == expected) {
+    return true;
+  }
+  return std::fabs(actual - expected) <= std::max(tol.atol, tol.rtol * std::fabs(scale));
+}
+
+inline std::string Hex(uint64_t h) {
+  char buf[17];
+  snprintf(buf, sizeof(buf), "%016" PRIx64, h);
+  return buf;
+}
+
+}  // namespace golden
+
+template <typename T>
+GoldenDigest Digest(const T* x, int64_t n, aclDataType dtype) {
+  GoldenDigest d;
+  d.dtype = dtype;
+  d.summary = Summarize(x, n);
+  d.samples = golden::Samples(x, n);
+  return d;
+}
+
+class GoldenStore {
+ public:
+  // `full`: keep whole outputs of new entries, `update`: re-record changed
+  // entries instead of only reporting them
+  explicit GoldenStore(const std::string& dir, bool full = false, bool update = false)
+      : dir_(dir), full_(full), update_(update) {
+    mkdir(dir.c_str(), 0755);
+    std::ifstream in(IndexFile());
+    std::string line;
+    while (std::getline(in, line)) {
+      std::string key;
+      GoldenDigest d;
+      if (Parse(line, &key, &d)) {
+        entries_[key] = d;
+      }
+    }
+  }
+
+  const std::string& dir() const { return dir_; }
+  size_t size() const { return entries_.size(); }
+
+  // output `x` of entry `key` against the store; reports of changed outputs
+  // and the digest differences are printed
+  template <typename T>
+  goldenStatus Check(const std::string& key, const std::string& label, const T* x, const std::vector<int64_t>& dims,
+                     aclDataType dtype, const Tolerance& tol, std::ostream& os = std::cout) {
+    int64_t n = 1;
+    for (auto d : dims) n *= d;
+    GoldenDigest digest = Digest(x, n, dtype);
+    digest.label = label;
+    auto it = entries_.find(key);
+    if (it == entries_.end()) {
+      Record(key, digest, x, dims);
+      return NEW;
+    }
+    const GoldenDigest& golden = it->second;
+    if (golden.dtype == dtype && golden.summary.count == n && golden.summary.hash == digest.summary.hash) {
+      return SAME;
+    }
+    goldenStatus status = CLOSE;
+    if (golden.dtype != dtype || golden.summary.count != n) {
+      os << label << ": " << DataTypeName(dtype) << " x " << n << ", golden " << DataTypeName(golden.dtype) << " x "
+         << golden.summary.count << std::endl;
+      status = CHANGED;
+    } else if (golden.full) {
+      status = CompareFull(key, golden, digest, x, dims, tol, os);
+    } else {
+      status = CompareDigest(golden, digest, tol, os);
+    }
+    if (status == CHANGED && update_) {
+      Record(key, digest, x, dims);
+    }
+    return status;
+  }
+
+  // rewrites the index with one line per key, through a temporary file so a
+  // crash leaves the appended index intact
+  bool Save() const {
+    const std::string tmp = IndexFile() + ".tmp";
+    std::ofstream out(tmp);
+    for (const auto& it : entries_) {
+      Write(out, it.first, it.second);
+    }
+    out.close();
+    if (out.fail() || std::rename(tmp.c_str(), IndexFile().c_str()) != 0) {
+      LOG(WARNING) << "cannot write " << IndexFile();
+      return false;
+    }
+    return true;
+  }
+
+ private:
+  std::string IndexFile() const { return dir_ + "/index.txt"; }
+  std::string DataFile(const std::string& key) const { return dir_ + "/" + key + ".npy"; }
+
+  static std::string Format(double v) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.17g", v);
+    return buf;
+  }
+
+  static void Write(std::ostream& out, const std::string& key, const GoldenDigest& d) {
+    const TensorSummary& s = d.summary;
+    out << key << " " << DataTypeName(d.dtype) << " " << s.count << " " << s.nan << " " << s.inf;
+    for (double v : {s.min, s.max, s.mean, s.std}) {
+      out << " " << Format(v);
+    }
+    out << " " << golden::Hex(s.hash) << " " << d.full << " " << d.samples.size();
+    for (double v : d.samples) {
+      out << " " << Format(v);
+    }
+    out << " " << d.label << "\n";
+  }
+
+  static bool Parse(const std::string& line, std::string* key, GoldenDigest* d) {
+    std::istringstream in(line);
+    std::string dtype;
+    std::string hash;
+    std::string v;
+    size_t k = 0;
+    TensorSummary& s = d->summary;
+    in >> *key >> dtype >> s.count >> s.nan >> s.inf;
+    for (double* x : {&s.min, &s.max, &s.mean, &s.std}) {
+      in >> v;
+      *x = std::strtod(v.c_str(), nullptr);  // also reads nan / inf
+    }
+    in >> hash >> d->full >> k;
+    for (size_t i = 0; i < k && in >> v; ++i) {
+      d->samples.push_back(std::strtod(v.c_str(), nullptr));
+    }
+    if (in.fail()) {
+      return false;
+    }
+    std::getline(in >> std::ws, d->label);
+    d->dtype = ParseDataType(dtype);
+    s.hash = std::strtoull(hash.c_str(), nullptr, 16);
+    return d->dtype != ACL_DT_UNDEFINED;
+  }
+
+  template <typename T>
+  void Record(const std::string& key, GoldenDigest digest, const T* x, const std::vector<int64_t>& dims) {
+    std::string error;
+    digest.full = full_ && WriteNpy(DataFile(key), digest.dtype, dims, x, digest.summary.count * sizeof(T), &error);
+    if (full_ && !digest.full) {
+      LOG(WARNING) << error;
+    }
+    entries_[key] = digest;
+    // closed, and so flushed, before the next case runs
+    std::ofstream out(IndexFile(), std::ios::app);
+    Write(out, key, digest);
+    out.close();
+    if (out.fail()) {
+      LOG(WARNING) << "cannot append to " << IndexFile();
+    }
+  }
+
+  // the full golden is only read here, on a hash mismatch
+  template <typename T>
+  goldenStatus CompareFull(const std::string& key, const GoldenDigest& golden, const GoldenDigest& digest, const T* x,
+                           const std::vector<int64_t>& dims, const Tolerance& tol, std::ostream& os) const {
+    MappedFile mapped(DataFile(key));
+    NpyHeader h;
+    std::string error = mapped.error();
+    if (!mapped.ok() || !ParseNpyHeader(mapped.data(), mapped.size(), &h, &error) ||
+        !npy::Compatible(h.dtype, golden.dtype) || h.numel() != golden.summary.count) {
+      os << digest.label << ": cannot read the full golden, " << (error.empty() ? "size mismatch" : error)
+         << std::endl;
+      return CompareDigest(golden, digest, tol, os);
+    }
+    const CompareReport report = Compare(x, reinterpret_cast<const T *>(mapped.data() + h.data_offset), dims, tol);
+    if (report.ok()) {
+      return CLOSE;
+    }
+    report.Print(digest.label, os);
+    return CHANGED;
+  }
+
+  static goldenStatus CompareDigest(const GoldenDigest& golden, const GoldenDigest& digest, const Tolerance& tol,
+                                    std::ostream& os) {
+    const std::string& label = digest.label;
+    const TensorSummary& g = golden.summary;
+    const TensorSummary& s = digest.summary;
+    const double scale = std::max(std::fabs(g.min), std::fabs(g.max));
+    bool close = g.nan == s.nan && g.inf == s.inf && golden.samples.size() == digest.samples.size() &&
+                 golden::Close(s.min, g.min, g.min, tol) && golden::Close(s.max, g.max, g.max, tol) &&
+                 golden::Close(s.mean, g.mean, scale, tol) && golden::Close(s.std, g.std, scale, tol);
+    for (size_t i = 0; close && i < golden.samples.size(); ++i) {
+      close = golden::Close(digest.samples[i], golden.samples[i], golden.samples[i], tol);
+    }
+    if (close) {
+      return CLOSE;
+    }
+    os << label << ": golden  ";
+    g.Print(os);
+    os << label << ": now     ";
+    s.Print(os);
+    for (size_t i = 0; i < std::min(golden.samples.size(), digest.samples.size()); ++i) {
+      if (!golden::Close(digest.samples[i], golden.samples[i], golden.samples[i], tol)) {
+        os << label << ": sample " << i << " " << golden.samples[i] << " -> " << digest.samples[i] << std::endl;
+      }
+    }
+    return CHANGED;
+  }
+
+  std::string dir_;
+  bool full_;
+  bool update_;
+  std::map<std::string, GoldenDigest> entries_;
+};
@@ -0,0 +1,239 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Minimal JSON reader for the case spec files (common/opcase.h): objects,
+// arrays, strings, numbers, true / false / null. Numbers keep their source
+// text so integers stay exact; \u escapes outside ASCII are not decoded.
+class JsonValue {
+ public:
+  typedef enum { NUL = 0, BOOL, NUMBER, STRING, ARRAY, OBJECT } jsonType;
+
+  jsonType type() const { return type_; }
+  bool is_null() const { return type_ == NUL; }
+  bool is_bool() const { return type_ == BOOL; }
+  bool is_number() const { return type_ == NUMBER; }
+  bool is_string() const { return type_ == STRING; }
+  bool is_array() const { return type_ == ARRAY; }
+  bool is_object() const { return type_ == OBJECT; }
+
+  bool as_bool() const { return bool_; }
+  double as_double() const { return std::strtod(text_.c_str(), nullptr); }
+  int64_t as_int() const { return std::strtoll(text_.c_str(), nullptr, 10); }
+  // numbers without fraction or exponent
+  bool is_integer() const { return type_ == NUMBER && text_.find_first_of(".eE") == std::string::npos; }
+  // string contents, or the source text of a number
+  const std::string& text() const { return text_; }
+
+  const std::vector<JsonValue>& items() const { return items_; }
+  const std::vector<std::pair<std::string, JsonValue>>& members() const { return members_; }
+  bool Has(const std::string& key) const { return Find(key) != nullptr; }
+  // member `key`, a null value if missing
+  const JsonValue& operator[](const std::string& key) const {
+    static const JsonValue null;
+    const JsonValue* v = Find(key);
+    return v != nullptr ? *v : null;
+  }
+
+  // false with `error` set on malformed input
+  static bool Parse(const std::string& s, JsonValue* out, std::string* error) {
+    size_t pos = 0;
+    if (!ParseValue(s, &pos, out, error)) {
+      return false;
+    }
+    SkipSpace(s, &pos);
+    if (pos != s.size()) {
+      return Fail(s, pos, "trailing characters", error);
+    }
+    return true;
+  }
+
+  static bool ParseFile(const std::string& path, JsonValue* out, std::string* error) {
+    std::ifstream in(path);
+    if (!in.good()) {
+      *error = "cannot open " + path;
+      return false;
+    }
+    std::stringstream ss;
+    ss << in.rdbuf();
+    if (!Parse(ss.str(), out, error)) {
+      *error = path + ": " + *error;
+      return false;
+    }
+    return true;
+  }
+
+ private:
+  const JsonValue* Find(const std::string& key) const {
+    for (const auto& m : members_) {
+      if (m.first == key) {
+        return &m.second;
+      }
+    }
+    return nullptr;
+  }
+
+  static void SkipSpace(const std::string& s, size_t* pos) {
+    while (*pos < s.size() && (s[*pos] == ' ' || s[*pos] == '\t' || s[*pos] == '\n' || s[*pos] == '\r')) {
+      ++*pos;
+    }
+  }
+
+  static bool Fail(const std::string& s, size_t pos, const char* what, std::string* error) {
+    size_t line = 1;
+    for (size_t i = 0; i < pos && i < s.size(); ++i) {
+      line += (s[i] == '\n');
+    }
+    *error = std::string(what) + " at line " + std::to_string(line);
+    return false;
+  }
+
+  static bool ParseString(const std::string& s, size_t* pos, std::string* out, std::string* error) {
+    ++*pos;  // opening quote
+    while (*pos < s.size() && s[*pos] != '"') {
+      char c = s[(*pos)++];
+      if (c == '\\') {
+        if (*pos >= s.size()) {
+          break;
+        }
+        c = s[(*pos)++];
+        switch (c) {
+          case 'n': c = '\n'; break;
+          case 't': c = '\t'; break;
+          case 'r': c = '\r'; break;
+          case 'b': c = '\b'; break;
+          case 'f': c = '\f'; break;
+          case 'u':
+            if (*pos + 4 > s.size()) {
+              return Fail(s, *pos, "bad \\u escape", error);
+            }
+            c = static_cast<char>(std::strtol(s.substr(*pos, 4).c_str(), nullptr, 16));
+            *pos += 4;
+            break;
+          default: break;  // \" \\ \/
+        }
+      }
+      *out += c;
+    }
+    if (*pos >= s.size()) {
+      return Fail(s, *pos, "unterminated string", error);
+    }
+    ++*pos;  // closing quote
+    return true;
+  }
+
+  static bool ParseValue(const std::string& s, size_t* pos, JsonValue* out, std::string* error) {
+    SkipSpace(s, pos);
+    if (*pos >= s.size()) {
+      return Fail(s, *pos, "unexpected end", error);
+    }
+    const char c = s[*pos];
+    if (c == '{') {
+      out->type_ = OBJECT;
+      ++*pos;
+      SkipSpace(s, pos);
+      if (*pos < s.size() && s[*pos] == '}') {
+        ++*pos;
+        return true;
+      }
+      while (true) {
+        SkipSpace(s, pos);
+        if (*pos >= s.size() || s[*pos] != '"') {
+          return Fail(s, *pos, "expected a member name", error);
+        }
+        std::string key;
+        if (!ParseString(s, pos, &key, error)) {
+          return false;
+        }
+        SkipSpace(s, pos);
+        if (*pos >= s.size() || s[*pos] != ':') {
+          return Fail(s, *pos, "expected ':'", error);
+        }
+        ++*pos;
+        JsonValue v;
+        if (!ParseValue(s, pos, &v, error)) {
+          return false;
+        }
+        out->members_.emplace_back(key, std::move(v));
+        SkipSpace(s, pos);
+        if (*pos < s.size() && s[*pos] == ',') {
+          ++*pos;
+          continue;
+        }
+        if (*pos < s.size() && s[*pos] == '}') {
+          ++*pos;
+          return true;
+        }
+        return Fail(s, *pos, "expected ',' or '}'", error);
+      }
+    }
+    if (c == '[') {
+      out->type_ = ARRAY;
+      ++*pos;
+      SkipSpace(s, pos);
+      if (*pos < s.size() && s[*pos] == ']') {
+        ++*pos;
+        return true;
+      }
+      while (true) {
+        JsonValue v;
+        if (!ParseValue(s, pos, &v, error)) {
+          return false;
+        }
+        out->items_.push_back(std::move(v));
+        SkipSpace(s, pos);
+        if (*pos < s.size() && s[*pos] == ',') {
+          ++*pos;
+          continue;
+        }
+        if (*pos < s.size() && s[*pos] == ']') {
+          ++*pos;
+          return true;
+        }
+        return Fail(s, *pos, "expected ',' or ']'", error);
+      }
+    }
+    if (c == '"') {
+      out->type_ = STRING;
+      return ParseString(s, pos, &out->text_, error);
+    }
+    if (s.compare(*pos, 4, "true") == 0 || s.compare(*pos, 5, "false") == 0) {
+      out->type_ = BOOL;
+      out->bool_ = (c == 't');
+      *pos += out->bool_ ? 4 : 5;
+      return true;
+    }
+    if (s.compare(*pos, 4, "null") == 0) {
+      out->type_ = NUL;
+      *pos += 4;
+      return true;
+    }
+    const size_t start = *pos;
+    while (*pos < s.size() && std::string("+-0123456789.eE").find(s[*pos]) != std::string::npos) {
+      ++*pos;
+    }
+    if (*pos == start) {
+      return Fail(s, *pos, "unexpected character", error);
+    }
+    out->type_ = NUMBER;
+    out->text_ = s.substr(start, *pos - start);
+    char* end = nullptr;
+    std::strtod(out->text_.c_str(), &end);
+    if (*end != '\0') {
+      return Fail(s, start, "bad number", error);
+    }
+    return true;
+  }
+
+  jsonType type_ = NUL;
+  bool bool_ = false;
+  std::string text_;
+  std::vector<JsonValue> items_;
+  std::vector<std::pair<std::string, JsonValue>> members_;
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// Read-only mapping of a whole file, unmapped with the object. Tensor inputs
+// are uploaded straight from the mapping, so a file of several GB is read
+// once by the copy to the device (or to the pinned host buffer of a const
+// input) and never held in a std::vector. `sequential` tells the kernel to
+// read ahead and drop pages behind the copy.
+class MappedFile {
+ public:
+  explicit MappedFile(const std::string& path, bool sequential = true) : path_(path) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      error_ = path + ": " + std::strerror(errno);
+      return;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+      error_ = path + ": " + std::strerror(errno);
+      close(fd);
+      return;
+    }
+    size_ = static_cast<size_t>(st.st_size);
+    if (size_ > 0) {
+      void* p = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (p == MAP_FAILED) {
+        error_ = path + ": mmap failed, " + std::strerror(errno);
+        size_ = 0;
+      } else {
+        data_ = static_cast<const uint8_t *>(p);
+        if (sequential) {
+          madvise(p, size_, MADV_SEQUENTIAL);
+          madvise(p, size_, MADV_WILLNEED);
+        }
+      }
+    }
+    close(fd);
+  }
+  ~MappedFile() {
+    if (data_ != nullptr) {
+      munmap(const_cast<uint8_t *>(data_), size_);
+    }
+  }
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  bool ok() const { return error_.empty(); }
+  const std::string& error() const { return error_; }
+  const std::string& path() const { return path_; }
+  const uint8_t* data() const { return data_; }
+  size_t size() const { return size_; }
+
+ private:
+  std::string path_;
+  std::string error_;
+  const uint8_t* data_ = nullptr;
+  size_t size_ = 0;
+};
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "common/nputensor.h"
+#include "common/opinfo.h"
+
+// Create input `index` of `op_type`. Shape/axis-like inputs declared in
+// OpInfo are placed on host and set const, everything else goes to device.
+// NPU_CONST_INPUTS=0 keeps all inputs on device.
+template <typename T>
+npuTensor<T>* PlanInput(const std::string& op_type, int index, aclDataType dataType, int numDims,
+                        const int64_t *dims, aclFormat format, const T *ptr, bool enable = true) {
+  const char* env = std::getenv("NPU_CONST_INPUTS");
+  if (env != nullptr && atoi(env) == 0) {
+    enable = false;
+  }
+  if (!enable || !IsConstInput(op_type, index) || ptr == nullptr) {
+    return new npuTensor<T>(dataType, numDims, dims, format, ptr, memType::DEVICE);
+  }
+  auto tensor = new npuTensor<T>(dataType, numDims, dims, format, ptr, memType::HOST);
+  tensor->SetConst();
+  return tensor;
+}
+
+// Static memory planner for op outputs.
+//
+// Outputs declared in-place in OpInfo are bound to the device memory of the
+// input they alias instead of getting a fresh allocation, so ref ops such as
+// ScatterUpdate and StridedSliceAssign neither hold a second copy of `var`
+// nor copy it into the output.
+class MemPlanner {
+ public:
+  MemPlanner(const std::string& op_type, const std::vector<aclDataBuffer *>& input_buffers,
+             bool enable = true)
+      : op_type_(op_type), input_buffers_(input_buffers), enable_(enable), saved_bytes_(0) {
+    const char* env = std::getenv("NPU_MEM_PLAN");
+    if (env != nullptr && atoi(env) == 0) {
+      enable_ = false;
+    }
+  }
+
+  template <typename T>
+  npuTensor<T>* Output(int index, aclDataType dataType, int numDims, const int64_t *dims, aclFormat format) {
+    int src = enable_ ? GetInplaceInput(op_type_, index) : -1;
+    if (src >= 0 && src < static_cast<int>(input_buffers_.size())) {
+      auto out = new npuTensor<T>(dataType, numDims, dims, format,
+                                  static_cast<const T *>(aclGetDataBufferAddr(input_buffers_[src])),
+                                  memType::ALIAS);
+      if (out->size == aclGetDataBufferSizeV2(input_buffers_[src])) {
+        VLOG(1) << op_type_ << " output " << index << " aliases input " << src;
+        saved_bytes_ += out->size;
+        return out;
+      }
+      LOG(WARNING) << op_type_ << " output " << index << " size " << out->size
+                   << " differs from input " << src << ", not aliasing";
+      out->Destroy();
+      delete out;
+    }
+    return new npuTensor<T>(dataType, numDims, dims, format, nullptr);
+  }
+
+  // device bytes not allocated thanks to aliasing
+  size_t saved_bytes() const { return saved_bytes_; }
+
+ private:
+  std::string op_type_;
+  std::vector<aclDataBuffer *> input_buffers_;
+  bool enable_;
+  size_t saved_bytes_;
+};
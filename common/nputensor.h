@@ -1,16 +1,64 @@
+#pragma once
+
 #include "acl/acl.h"
 // #include "acl/acl_op.h" // aclopExecuteV2 可以支持动态Shape算子
 #include "acl/acl_op_compiler.h" // aclopCompileAndExecute 只能支持固定Shape算子
 
+#include <errno.h>  // program_invocation_short_name
+
+#include "common/cmdline.h"
 #include "common/logging.h"
+#include "common/mapped_file.h"
+#include "common/npy.h"
+#include "common/summary.h"
 
 #define ACL_CALL(msg) CHECK_EQ(reinterpret_cast<aclError>(msg), ACL_SUCCESS)
 
 typedef enum {
     DEVICE = 0,
     HOST = 1,
+    ALIAS = 2, // bind to existing device memory passed as ptr, not owned
 } memType;
 
+typedef enum {
+    STAGED = 0,    // separate host buffer, aclrtMemcpy H2D / D2H
+    ZERO_COPY = 1, // ACL_DEVICE run mode, the process shares memory with the device
+} copyStrategy;
+
+// Copy strategy for DEVICE tensors, picked from the run mode on first use
+// (after aclrtSetDevice). NPU_ZERO_COPY=0 forces staged copies.
+inline copyStrategy& CopyStrategy() {
+  static copyStrategy strategy = [] {
+    aclrtRunMode run_mode;
+    ACL_CALL(aclrtGetRunMode(&run_mode));
+    const char* env = std::getenv("NPU_ZERO_COPY");
+    const bool allow = (env == nullptr || atoi(env) != 0);
+    return (run_mode == ACL_DEVICE && allow) ? copyStrategy::ZERO_COPY : copyStrategy::STAGED;
+  }();
+  return strategy;
+}
+
+// Directory npuTensor::Print also saves tensors to, empty unless
+// NPU_DUMP_DIR is set.
+inline const std::string& DumpDir() {
+  static const std::string dir = [] {
+    const char* env = std::getenv("NPU_DUMP_DIR");
+    return std::string(env != nullptr ? env : "");
+  }();
+  return dir;
+}
+
+// <dir>/<op>[_<config>]_<dtype>_<msg>.npy: the op is the demo binary, the
+// config the ForEachConfig index when several are swept, so configs and
+// dtypes of one run do not overwrite each other
+inline std::string DumpPath(const std::string& msg, aclDataType dtype) {
+  std::string name = program_invocation_short_name;
+  if (CurrentConfig() > 0) {
+    name += "_" + std::to_string(CurrentConfig());
+  }
+  return DumpDir() + "/" + name + "_" + DataTypeName(dtype) + "_" + msg + ".npy";
+}
+
 template <typename T>
 class npuTensor {
  public:
@@ -21,10 +69,16 @@ class npuTensor {
     device_ptr = nullptr;
     host_ptr = nullptr;
     mem_type_ = mem_type;
+    owned_ = (mem_type != memType::ALIAS);
+    strategy_ = CopyStrategy();
+    mirror_ptr_ = nullptr;
+    const_ = false;
 
     if (mem_type == memType::DEVICE) {
       ACL_CALL(aclrtMalloc(&device_ptr, size, ACL_MEM_MALLOC_NORMAL_ONLY));
-      if (ptr != nullptr) {
+      if (ptr != nullptr && strategy_ == copyStrategy::ZERO_COPY) {
+        std::memcpy(device_ptr, ptr, size);
+      } else if (ptr != nullptr) {
         ACL_CALL(aclrtMemcpy(device_ptr, size, ptr, size, ACL_MEMCPY_HOST_TO_DEVICE));
       }
       buffer =  aclCreateDataBuffer(device_ptr, size);
@@ -39,34 +93,173 @@ class npuTensor {
       buffer =  aclCreateDataBuffer(host_ptr, size);
       // ACL_CALL(aclSetTensorConst(desc, buffer, size));
     }
+
+    if (mem_type == memType::ALIAS) {
+      CHECK(ptr != nullptr) << "ALIAS tensor requires a device pointer";
+      device_ptr = const_cast<T *>(ptr);
+      buffer =  aclCreateDataBuffer(device_ptr, size);
+    }
   }
 
   ~npuTensor() {}
   void Destroy() {
     ACL_CALL(aclDestroyDataBuffer(buffer));
-    if(device_ptr != nullptr) {
+    if(device_ptr != nullptr && owned_) {
       ACL_CALL(aclrtFree(device_ptr));
     }
     if (host_ptr != nullptr) {
       ACL_CALL(aclrtFreeHost(host_ptr));
     }
+    if (mirror_ptr_ != nullptr) {
+      ACL_CALL(aclrtFreeHost(mirror_ptr_));
+    }
     aclDestroyTensorDesc(desc);
   }
 
+  // Mark a HOST tensor as compile-time constant so the op compiler can fold it.
+  void SetConst() {
+    CHECK(mem_type_ == memType::HOST) << "only host tensors can be const";
+    ACL_CALL(aclSetTensorConst(desc, host_ptr, size));
+    const_ = true;
+  }
+  bool is_const() const { return const_; }
+
+  // Host-visible view of the tensor contents. With ZERO_COPY this is the
+  // device memory itself, otherwise a pinned mirror that CopyToDevice() and
+  // CopyToHost() keep in sync.
+  T* data() {
+    if (mem_type_ == memType::HOST) {
+      return static_cast<T *>(host_ptr);
+    }
+    if (strategy_ == copyStrategy::ZERO_COPY) {
+      return static_cast<T *>(device_ptr);
+    }
+    if (mirror_ptr_ == nullptr) {
+      ACL_CALL(aclrtMallocHost(&mirror_ptr_, size));
+    }
+    return static_cast<T *>(mirror_ptr_);
+  }
+
+  // no-ops unless the tensor is staged through a mirror; CopyToHost()
+  // allocates the mirror, so data() is valid after it without a prior call
+  void CopyToDevice() {
+    if (mirror_ptr_ != nullptr) {
+      ACL_CALL(aclrtMemcpy(device_ptr, size, mirror_ptr_, size, ACL_MEMCPY_HOST_TO_DEVICE));
+    }
+  }
+  void CopyToHost() {
+    if (mem_type_ != memType::HOST && strategy_ == copyStrategy::STAGED) {
+      ACL_CALL(aclrtMemcpy(data(), size, device_ptr, size, ACL_MEMCPY_DEVICE_TO_HOST));
+    }
+  }
+
+  // Small tensors print every element, larger ones a head / tail preview
+  // and summary statistics (see PrintTensor in common/summary.h).
   void Print(std::string msg) {
-    size_t numel = size / sizeof(T);
-    std::vector<T> cpu_data(numel, 0);
-    if (mem_type_ == memType::DEVICE) {
+    const int64_t numel = size / sizeof(T);
+    if (!DumpDir().empty() && Save(DumpPath(msg, aclGetTensorDescType(desc)))) {
+      PrintTensor(msg, data(), numel);  // Save() downloaded the tensor
+    } else if (mem_type_ == memType::HOST) {
+      PrintTensor(msg, static_cast<const T *>(host_ptr), numel);
+    } else if (strategy_ == copyStrategy::ZERO_COPY) {
+      PrintTensor(msg, static_cast<const T *>(device_ptr), numel);
+    } else {
+      std::vector<T> cpu_data(numel);
       ACL_CALL(aclrtMemcpy(cpu_data.data(), size, device_ptr, size, ACL_MEMCPY_DEVICE_TO_HOST));
+      PrintTensor(msg, cpu_data.data(), numel);
+    }
+  }
+  std::vector<int64_t> dims() const {
+    std::vector<int64_t> d(aclGetTensorDescNumDims(desc));
+    for (size_t i = 0; i < d.size(); ++i) {
+      ACL_CALL(aclGetTensorDescDimV2(desc, i, &d[i]));
+    }
+    return d;
+  }
+
+  // Writes the contents as a .npy (common/npy.h) for offline analysis:
+  // downloaded into the pinned mirror (in place with ZERO_COPY or HOST
+  // memory) and written from there with a few large sequential writes, so a
+  // multi-GB output is dumped near disk bandwidth. data() holds the contents
+  // afterwards.
+  bool Save(const std::string& path) {
+    CopyToHost();
+    std::string error;
+    if (!WriteNpy(path, aclGetTensorDescType(desc), dims(), data(), size, &error)) {
+      LOG(WARNING) << "cannot save tensor: " << error;
+      return false;
+    }
+    return true;
+  }
+
+  // Reads a .npy written by Save() or NumPy into the tensor. The file must
+  // hold the same number of elements of the tensor dtype (a '<u2' file for
+  // bf16), the shape may differ. With `use_mmap` a device tensor is uploaded
+  // straight from the mapping, otherwise the file is read into the pinned
+  // mirror in large chunks and uploaded from there.
+  bool Load(const std::string& path, bool use_mmap = true) {
+    std::string error;
+    const bool ok = use_mmap ? LoadMapped(path, &error) : LoadRead(path, &error);
+    if (!ok) {
+      LOG(WARNING) << "cannot load tensor: " << error;
+    }
+    return ok;
+  }
+
+ private:
+  bool CheckNpy(const NpyHeader& h, std::string* error) const {
+    const aclDataType dtype = aclGetTensorDescType(desc);
+    if (!npy::Compatible(h.dtype, dtype)) {
+      *error = std::string("file holds ") + DataTypeName(h.dtype) + ", tensor is " + DataTypeName(dtype);
+      return false;
+    }
+    if (h.numel() * aclDataTypeSize(h.dtype) != size) {
+      *error = "file holds " + std::to_string(h.numel()) + " elements, tensor " +
+               std::to_string(aclGetTensorDescElementCount(desc));
+      return false;
+    }
+    return true;
+  }
+
+  bool LoadMapped(const std::string& path, std::string* error) {
+    MappedFile mapped(path);
+    if (!mapped.ok()) {
+      *error = mapped.error();
+      return false;
+    }
+    NpyHeader h;
+    if (!ParseNpyHeader(mapped.data(), mapped.size(), &h, error) || !CheckNpy(h, error)) {
+      *error = path + ": " + *error;
+      return false;
+    }
+    const uint8_t* src = mapped.data() + h.data_offset;
+    if (mem_type_ != memType::HOST && strategy_ == copyStrategy::STAGED && mirror_ptr_ == nullptr) {
+      ACL_CALL(aclrtMemcpy(device_ptr, size, src, size, ACL_MEMCPY_HOST_TO_DEVICE));
     } else {
-      ACL_CALL(aclrtMemcpy(cpu_data.data(), size, host_ptr, size, ACL_MEMCPY_HOST_TO_HOST));
+      std::memcpy(data(), src, size);
+      CopyToDevice();
     }
-    std::cout << msg << " = [";
-    for (size_t i = 0; i < cpu_data.size(); ++i) {
-      std::cout << cpu_data[i] << ", ";
+    return true;
+  }
+
+  bool LoadRead(const std::string& path, std::string* error) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      *error = path + ": " + std::strerror(errno);
+      return false;
     }
-    std::cout << "]" << std::endl;
+    NpyHeader h;
+    const bool ok = ReadNpyHeader(fd, &h, error) && CheckNpy(h, error) &&
+                    npy::ReadAll(fd, h.data_offset, data(), size, error);
+    close(fd);
+    if (!ok) {
+      *error = path + ": " + *error;
+      return false;
+    }
+    CopyToDevice();
+    return true;
   }
+
 public:
   size_t size;
   void * host_ptr;
@@ -74,4 +267,8 @@ public:
   aclTensorDesc* desc;
   aclDataBuffer* buffer;
   memType mem_type_;
+  bool owned_;
+  copyStrategy strategy_;
+  void * mirror_ptr_;
+  bool const_;
 };
@@ -0,0 +1,284 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "acl/acl.h"
+#include "common/dtype.h"
+
+// NumPy .npy header: magic "\x93NUMPY", version, header length (2 bytes in
+// version 1, 4 in 2 and 3), then a Python dict literal such as
+//   {'descr': '<f4', 'fortran_order': False, 'shape': (3, 2), }
+// padded so the data starts 64-byte aligned. bf16 has no NumPy dtype and is
+// kept as its '<u2' bit patterns; a '<u2' file is accepted where bf16 is
+// expected.
+struct NpyHeader {
+  aclDataType dtype = ACL_DT_UNDEFINED;
+  std::vector<int64_t> dims;
+  bool fortran_order = false;
+  size_t data_offset = 0;
+
+  int64_t numel() const {
+    int64_t n = 1;
+    for (auto d : dims) n *= d;
+    return n;
+  }
+};
+
+namespace npy {
+
+// little-endian descr of a dtype, empty if NumPy has no equivalent
+inline const char* Descr(aclDataType dtype) {
+  switch (dtype) {
+    case ACL_FLOAT: return "<f4";
+    case ACL_FLOAT16: return "<f2";
+    case ACL_BF16: return "<u2";
+    case ACL_DOUBLE: return "<f8";
+    case ACL_INT8: return "|i1";
+    case ACL_UINT8: return "|u1";
+    case ACL_INT16: return "<i2";
+    case ACL_UINT16: return "<u2";
+    case ACL_INT32: return "<i4";
+    case ACL_UINT32: return "<u4";
+    case ACL_INT64: return "<i8";
+    case ACL_UINT64: return "<u8";
+    case ACL_BOOL: return "|b1";
+    default: return "";
+  }
+}
+
+inline aclDataType FromDescr(const std::string& descr) {
+  static const aclDataType kTypes[] = {ACL_FLOAT,  ACL_FLOAT16, ACL_DOUBLE, ACL_INT8,   ACL_UINT8, ACL_INT16,
+                                       ACL_UINT16, ACL_INT32,   ACL_UINT32, ACL_INT64, ACL_UINT64, ACL_BOOL};
+  // '<' little-endian, '=' native (little-endian here), '|' single byte
+  if (descr.size() < 2 || descr[0] == '>') {
+    return ACL_DT_UNDEFINED;
+  }
+  for (aclDataType dtype : kTypes) {
+    if (descr.substr(1) == Descr(dtype) + 1) {
+      return dtype;
+    }
+  }
+  return ACL_DT_UNDEFINED;
+}
+
+// a file of dtype `stored` can be read as `wanted`
+inline bool Compatible(aclDataType stored, aclDataType wanted) {
+  return stored == wanted || (wanted == ACL_BF16 && stored == ACL_UINT16);
+}
+
+// value of 'key': in the header dict, up to the next top-level ',' or '}'
+inline std::string DictValue(const std::string& dict, const std::string& key) {
+  size_t pos = dict.find("'" + key + "'");
+  if (pos == std::string::npos) {
+    return "";
+  }
+  pos = dict.find(':', pos);
+  if (pos == std::string::npos) {
+    return "";
+  }
+  ++pos;
+  int depth = 0;
+  size_t end = pos;
+  for (; end < dict.size(); ++end) {
+    const char c = dict[end];
+    if (c == '(' || c == '[') {
+      ++depth;
+    } else if (c == ')' || c == ']') {
+      --depth;
+    } else if ((c == ',' || c == '}') && depth == 0) {
+      break;
+    }
+  }
+  std::string v = dict.substr(pos, end - pos);
+  v.erase(0, v.find_first_not_of(" '\""));
+  v.erase(v.find_last_not_of(" '\"") + 1);
+  return v;
+}
+
+// Header of a C-order .npy holding `dims` of `dtype`, version 1 unless the
+// dict needs the 4-byte length of version 2, padded to 64 bytes.
+inline std::string HeaderBytes(aclDataType dtype, const std::vector<int64_t>& dims) {
+  std::string dict = std::string("{'descr': '") + Descr(dtype) + "', 'fortran_order': False, 'shape': (";
+  for (size_t i = 0; i < dims.size(); ++i) {
+    dict += (i > 0 ? ", " : "") + std::to_string(dims[i]);
+  }
+  dict += dims.size() == 1 ? ",), }" : "), }";  // Python tuples: (), (3,), (3, 2)
+  size_t prefix = 10;
+  if (prefix + dict.size() + 1 > 65535) {
+    prefix = 12;
+  }
+  const size_t total = (prefix + dict.size() + 1 + 63) / 64 * 64;
+  dict.append(total - prefix - dict.size() - 1, ' ');
+  dict += '\n';
+  const size_t len = dict.size();
+  std::string header("\x93NUMPY", 6);
+  header += static_cast<char>(prefix == 10 ? 1 : 2);
+  header += '\0';
+  for (size_t i = 0; i < prefix - 8; ++i) {
+    header += static_cast<char>((len >> (8 * i)) & 0xff);
+  }
+  return header + dict;
+}
+
+// Tensor files are read and written in chunks of this size, large enough to
+// run at disk bandwidth, below the ~2 GB a single read() / write() transfers.
+constexpr size_t kIoChunk = 64 << 20;
+
+inline bool WriteAll(int fd, const void* src, size_t bytes, std::string* error) {
+  const char* p = static_cast<const char *>(src);
+  while (bytes > 0) {
+    const ssize_t n = write(fd, p, std::min(bytes, kIoChunk));
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      *error = std::string("write failed, ") + std::strerror(errno);
+      return false;
+    }
+    p += n;
+    bytes -= n;
+  }
+  return true;
+}
+
+inline bool ReadAll(int fd, size_t offset, void* dst, size_t bytes, std::string* error) {
+  char* p = static_cast<char *>(dst);
+  while (bytes > 0) {
+    const ssize_t n = pread(fd, p, std::min(bytes, kIoChunk), offset);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      *error = n == 0 ? std::string("unexpected end of file") : std::string("read failed, ") + std::strerror(errno);
+      return false;
+    }
+    p += n;
+    offset += n;
+    bytes -= n;
+  }
+  return true;
+}
+
+}  // namespace npy
+
+// false with `error` set if `p` (the first `size` bytes of a file of
+// `file_size` bytes, 0 if `p` is the whole file) is not a little-endian
+// C-order .npy of a supported dtype or is shorter than its data
+inline bool ParseNpyHeader(const uint8_t* p, size_t size, NpyHeader* h, std::string* error,
+                           size_t file_size = 0) {
+  if (size < 10 || std::memcmp(p, "\x93NUMPY", 6) != 0) {
+    *error = "not a .npy file";
+    return false;
+  }
+  const int major = p[6];
+  size_t header_len = 0;
+  size_t prefix = 0;
+  if (major == 1) {
+    header_len = p[8] | (p[9] << 8);
+    prefix = 10;
+  } else if (major == 2 || major == 3) {
+    if (size < 12) {
+      *error = "truncated .npy header";
+      return false;
+    }
+    header_len = p[8] | (p[9] << 8) | (p[10] << 16) | (static_cast<size_t>(p[11]) << 24);
+    prefix = 12;
+  } else {
+    *error = ".npy version " + std::to_string(major) + " is not supported";
+    return false;
+  }
+  if (prefix + header_len > size) {
+    *error = "truncated .npy header";
+    return false;
+  }
+  const std::string dict(reinterpret_cast<const char *>(p + prefix), header_len);
+  const std::string descr = npy::DictValue(dict, "descr");
+  h->dtype = npy::FromDescr(descr);
+  if (h->dtype == ACL_DT_UNDEFINED) {
+    *error = "unsupported .npy descr '" + descr + "'";
+    return false;
+  }
+  h->fortran_order = (npy::DictValue(dict, "fortran_order") == "True");
+  if (h->fortran_order) {
+    *error = "fortran_order .npy files are not supported";
+    return false;
+  }
+  const std::string shape = npy::DictValue(dict, "shape");
+  h->dims.clear();
+  for (size_t i = 0; i < shape.size();) {
+    if (shape[i] >= '0' && shape[i] <= '9') {
+      size_t end = i;
+      h->dims.push_back(std::stoll(shape.substr(i), &end));
+      i += end;
+    } else {
+      ++i;
+    }
+  }
+  h->data_offset = prefix + header_len;
+  const size_t bytes = h->numel() * aclDataTypeSize(h->dtype);
+  if (h->data_offset + bytes > (file_size > 0 ? file_size : size)) {
+    *error = ".npy data is shorter than its shape";
+    return false;
+  }
+  return true;
+}
+
+// Writes `bytes` of `data` as a .npy of `dims` / `dtype` with a few large
+// sequential writes, false with `error` set on failure.
+inline bool WriteNpy(const std::string& path, aclDataType dtype, const std::vector<int64_t>& dims,
+                     const void* data, size_t bytes, std::string* error) {
+  if (*npy::Descr(dtype) == '\0') {
+    *error = std::string("no .npy dtype for ") + DataTypeName(dtype);
+    return false;
+  }
+  const int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    *error = path + ": " + std::strerror(errno);
+    return false;
+  }
+  const std::string header = npy::HeaderBytes(dtype, dims);
+  const bool ok = npy::WriteAll(fd, header.data(), header.size(), error) && npy::WriteAll(fd, data, bytes, error);
+  if (close(fd) != 0 && ok) {
+    *error = std::string("close failed, ") + std::strerror(errno);
+    return false;
+  }
+  if (!ok) {
+    *error = path + ": " + *error;
+  }
+  return ok;
+}
+
+// Header of the .npy open as `fd`, without mapping the file.
+inline bool ReadNpyHeader(int fd, NpyHeader* h, std::string* error) {
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    *error = std::strerror(errno);
+    return false;
+  }
+  const size_t file_size = static_cast<size_t>(st.st_size);
+  std::vector<uint8_t> head(std::min<size_t>(file_size, 12));
+  if (!npy::ReadAll(fd, 0, head.data(), head.size(), error)) {
+    return false;
+  }
+  if (head.size() >= 12 && std::memcmp(head.data(), "\x93NUMPY", 6) == 0) {
+    const size_t prefix = head[6] == 1 ? 10 : 12;
+    size_t header_len = head[8] | (head[9] << 8);
+    if (prefix == 12) {
+      header_len |= (head[10] << 16) | (static_cast<size_t>(head[11]) << 24);
+    }
+    head.resize(std::min(file_size, prefix + header_len));
+    if (!npy::ReadAll(fd, 0, head.data(), head.size(), error)) {
+      return false;
+    }
+  }
+  return ParseNpyHeader(head.data(), head.size(), h, error, file_size);
+}
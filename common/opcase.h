@@ -0,0 +1,613 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "acl/acl.h"
+#include "acl/acl_op_compiler.h"
+#include "common/cmdline.h"
+#include "common/compare.h"
+#include "common/compile_cache.h"
+#include "common/dtype.h"
+#include "common/golden_store.h"
+#include "common/json.h"
+#include "common/mapped_file.h"
+#include "common/memplan.h"
+#include "common/npy.h"
+#include "common/nputensor.h"
+#include "common/random.h"
+#include "common/typed_matrix.h"
+
+// An op call described at run time instead of in code, for ops without an op
+// file and for sweeps over any op:
+//
+//   op=ReduceSum x0=fp32:3x2x3x2:NCHW x1=int64:1:ND:[1] y0=fp32:3x1x3x2:NCHW a.keep_dims=bool:1
+//
+// Inputs are x0, x1, ..., outputs y0, y1, ..., each `dtype:shape[:format[:data]]`
+// with format ND by default. Input data is rand (uniform [-1, 1), default),
+// normal, special (RandomSpecial), iota, zeros, ones, a value list [v0,v1,...]
+// repeated to the tensor size or @file; an output's @file is its golden.
+// Attributes are `a.<name>=<type>:<value>` with type bool, int, float, str,
+// dtype, ints or floats, atol / rtol / ulp set the tolerance of the goldens.
+// Inputs the op lists in OpInfo::const_inputs are created with PlanInput,
+// i.e. as host consts.
+//
+// The same case as a JSON spec file (OpCase::FromJson), e.g. to replay
+// tensors captured from a model:
+//
+//   {
+//     "op": "ReduceSum",
+//     "inputs": [{"file": "x.npy", "format": "NCHW"},
+//                {"dtype": "int64", "shape": [1], "data": [1]}],
+//     "outputs": [{"dtype": "fp32", "shape": [3, 1, 3, 2], "format": "NCHW", "golden": "y.npy"}],
+//     "attrs": {"keep_dims": true},
+//     "tolerance": {"atol": 1e-5, "rtol": 1e-5}
+//   }
+//
+// Files are .npy (dtype and shape may then be left out) or raw little-endian
+// data at "offset" bytes, paths relative to the spec. They are memory-mapped
+// and uploaded / compared straight from the mapping (common/mapped_file.h).
+// Attribute types follow the JSON value: bool, integer -> int, number ->
+// float, string -> str, array of integers -> ints, array -> floats, or
+// {"type": "dtype", "value": "fp16"} to name the type.
+struct TensorSpec {
+  aclDataType dtype = ACL_FLOAT;
+  std::vector<int64_t> dims;
+  aclFormat format = ACL_FORMAT_ND;
+  std::string data = "rand";
+  // input data / output golden, .npy or raw from `offset`
+  std::string file;
+  int64_t offset = 0;
+  bool has_tol = false;
+  Tolerance tol;
+
+  int64_t numel() const {
+    int64_t n = 1;
+    for (auto d : dims) n *= d;
+    return n;
+  }
+  int64_t bytes() const { return numel() * aclDataTypeSize(dtype); }
+
+  static TensorSpec Parse(const std::string& key, const std::string& spec) {
+    const std::vector<std::string> parts = CaseParams::Split(spec, ':');
+    CHECK(parts.size() >= 2 && parts.size() <= 4) << key << "=" << spec << ", expected dtype:shape[:format[:data]]";
+    CaseParams p;
+    p.Set(key, parts[1]);
+    TensorSpec t;
+    t.dtype = ParseDataType(parts[0]);
+    t.dims = p.Ints(key, {});
+    if (parts.size() > 2 && !parts[2].empty()) {
+      t.format = ParseFormat(parts[2]);
+    }
+    if (parts.size() > 3 && !parts[3].empty() && parts[3][0] == '@') {
+      t.file = parts[3].substr(1);
+    } else if (parts.size() > 3) {
+      t.data = parts[3];
+    }
+    return t;
+  }
+
+  bool is_npy() const { return file.size() > 4 && file.compare(file.size() - 4, 4, ".npy") == 0; }
+
+  // start of the tensor's data in the mapping of `file`, checked against
+  // dtype and shape; nullptr with `error` set if it does not match
+  const uint8_t* FileData(const MappedFile& mapped, std::string* error) const {
+    if (!mapped.ok()) {
+      *error = mapped.error();
+      return nullptr;
+    }
+    size_t offset_bytes = offset;
+    if (is_npy()) {
+      NpyHeader h;
+      if (!ParseNpyHeader(mapped.data(), mapped.size(), &h, error)) {
+        *error = file + ": " + *error;
+        return nullptr;
+      }
+      if (!npy::Compatible(h.dtype, dtype) || h.numel() != numel()) {
+        *error = file + ": holds " + DataTypeName(h.dtype) + " x " + std::to_string(h.numel()) + ", expected " +
+                 DataTypeName(dtype) + " x " + std::to_string(numel());
+        return nullptr;
+      }
+      offset_bytes = h.data_offset;
+    }
+    if (offset_bytes + bytes() > mapped.size()) {
+      *error = file + ": " + std::to_string(mapped.size()) + " bytes, expected " +
+               std::to_string(offset_bytes + bytes());
+      return nullptr;
+    }
+    return mapped.data() + offset_bytes;
+  }
+};
+
+struct AttrSpec {
+  std::string name;
+  std::string type;
+  std::string value;
+
+  aclError Set(aclopAttr* attr) const {
+    CaseParams p;
+    p.Set(name, value);
+    const char* n = name.c_str();
+    if (type == "bool") {
+      return aclopSetAttrBool(attr, n, p.Bool(name, false));
+    }
+    if (type == "int") {
+      return aclopSetAttrInt(attr, n, p.Int(name, 0));
+    }
+    if (type == "float") {
+      return aclopSetAttrFloat(attr, n, static_cast<float>(p.Float(name, 0)));
+    }
+    if (type == "str") {
+      return aclopSetAttrString(attr, n, value.c_str());
+    }
+    if (type == "dtype") {
+      return aclopSetAttrDataType(attr, n, p.DType(name, ACL_FLOAT));
+    }
+    if (type == "ints") {
+      const std::vector<int64_t> v = p.Ints(name, {});
+      return aclopSetAttrListInt(attr, n, v.size(), v.data());
+    }
+    if (type == "floats") {
+      const std::vector<float> v = p.Floats(name, {});
+      return aclopSetAttrListFloat(attr, n, v.size(), v.data());
+    }
+    LOG(FATAL) << "attr " << name << ": unknown type " << type << ", expected bool, int, float, str, dtype, ints or floats";
+    return ACL_SUCCESS;
+  }
+};
+
+namespace opcase {
+
+// a JSON scalar / array in the text form CaseParams parses
+inline std::string Text(const JsonValue& v) {
+  if (v.is_bool()) {
+    return v.as_bool() ? "1" : "0";
+  }
+  if (!v.is_array()) {
+    return v.text();
+  }
+  std::string s = "[";
+  for (const auto& item : v.items()) {
+    s += (s.size() > 1 ? "," : "") + Text(item);
+  }
+  return s + "]";
+}
+
+inline bool ParseTolerance(const JsonValue& v, Tolerance* tol) {
+  if (!v.is_object()) {
+    return false;
+  }
+  *tol = Tolerance();
+  tol->atol = v["atol"].is_number() ? v["atol"].as_double() : 0;
+  tol->rtol = v["rtol"].is_number() ? v["rtol"].as_double() : 0;
+  tol->ulp = v["ulp"].is_number() ? v["ulp"].as_int() : 0;
+  return true;
+}
+
+// directory part of `path` with a trailing '/', empty for a bare file name
+inline std::string DirName(const std::string& path) {
+  const size_t slash = path.rfind('/');
+  return slash == std::string::npos ? "" : path.substr(0, slash + 1);
+}
+
+inline bool ParseTensor(const JsonValue& v, const std::string& dir, TensorSpec* t, std::string* error) {
+  if (!v.is_object()) {
+    *error = "tensors are JSON objects";
+    return false;
+  }
+  const JsonValue& file = v.Has("golden") ? v["golden"] : v["file"];
+  if (file.is_string()) {
+    t->file = (file.text().empty() || file.text()[0] == '/') ? file.text() : dir + file.text();
+    t->offset = v["offset"].is_number() ? v["offset"].as_int() : 0;
+  }
+  bool has_dtype = v["dtype"].is_string();
+  bool has_shape = v["shape"].is_array();
+  if ((!has_dtype || !has_shape) && t->is_npy()) {
+    // from the .npy header
+    MappedFile mapped(t->file, false);
+    NpyHeader h;
+    if (!mapped.ok() || !ParseNpyHeader(mapped.data(), mapped.size(), &h, error)) {
+      *error = mapped.ok() ? t->file + ": " + *error : mapped.error();
+      return false;
+    }
+    t->dtype = h.dtype;
+    t->dims = h.dims;
+    has_dtype = has_shape = true;
+  }
+  if (!has_dtype || !has_shape) {
+    *error = "dtype and shape are required without a .npy file";
+    return false;
+  }
+  if (v["dtype"].is_string()) {
+    t->dtype = ParseDataType(v["dtype"].text());
+  }
+  if (v["shape"].is_array()) {
+    t->dims.clear();
+    for (const auto& d : v["shape"].items()) {
+      t->dims.push_back(d.as_int());
+    }
+  }
+  if (v["format"].is_string()) {
+    t->format = ParseFormat(v["format"].text());
+  }
+  if (!v["data"].is_null()) {
+    t->data = opcase::Text(v["data"]);
+  }
+  t->has_tol = ParseTolerance(v["tolerance"], &t->tol);
+  return true;
+}
+
+}  // namespace opcase
+
+struct OpCase {
+  std::string name;
+  std::string op;
+  std::vector<TensorSpec> inputs;
+  std::vector<TensorSpec> outputs;
+  std::vector<AttrSpec> attrs;
+
+  bool has_golden() const {
+    for (const auto& t : outputs) {
+      if (!t.file.empty()) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // false with `error` set if the spec is malformed
+  static bool FromJson(const std::string& path, OpCase* c, std::string* error) {
+    JsonValue v;
+    if (!JsonValue::ParseFile(path, &v, error)) {
+      return false;
+    }
+    c->name = path;
+    c->op = v["op"].text();
+    if (!v["op"].is_string() || c->op.empty()) {
+      *error = path + ": \"op\" is required";
+      return false;
+    }
+    const std::string dir = opcase::DirName(path);
+    Tolerance tol;
+    const bool has_tol = opcase::ParseTolerance(v["tolerance"], &tol);
+    for (const char* list : {"inputs", "outputs"}) {
+      for (const auto& item : v[list].items()) {
+        TensorSpec t;
+        if (!opcase::ParseTensor(item, dir, &t, error)) {
+          *error = path + ": " + list + "[" + std::to_string(&item - v[list].items().data()) + "]: " + *error;
+          return false;
+        }
+        if (!t.has_tol && has_tol) {
+          t.has_tol = true;
+          t.tol = tol;
+        }
+        (std::string(list) == "inputs" ? c->inputs : c->outputs).push_back(t);
+      }
+    }
+    if (c->outputs.empty()) {
+      *error = path + ": no outputs";
+      return false;
+    }
+    for (const auto& m : v["attrs"].members()) {
+      const JsonValue& a = m.second;
+      std::string type;
+      std::string value = opcase::Text(a);
+      if (a.is_object()) {
+        type = a["type"].text();
+        value = opcase::Text(a["value"]);
+      } else if (a.is_bool()) {
+        type = "bool";
+      } else if (a.is_number()) {
+        type = a.is_integer() ? "int" : "float";
+      } else if (a.is_string()) {
+        type = "str";
+      } else if (a.is_array()) {
+        type = "ints";
+        for (const auto& item : a.items()) {
+          if (!item.is_integer()) {
+            type = "floats";
+          }
+        }
+      }
+      c->attrs.push_back(AttrSpec{m.first, type, value});
+    }
+    return true;
+  }
+
+  // false with `error` set if a file is missing or does not match its tensor
+  bool CheckFiles(std::string* error) const {
+    for (const auto* list : {&inputs, &outputs}) {
+      for (const auto& t : *list) {
+        if (!t.file.empty() && t.FileData(MappedFile(t.file, false), error) == nullptr) {
+          *error = name.empty() ? *error : name + ": " + *error;
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  static OpCase FromParams(const CaseParams& p) {
+    OpCase c;
+    c.op = p.Get("op");
+    CHECK(!c.op.empty()) << "op=<type> is required";
+    for (int i = 0; p.Has("x" + std::to_string(i)); ++i) {
+      const std::string key = "x" + std::to_string(i);
+      c.inputs.push_back(TensorSpec::Parse(key, p.Get(key)));
+    }
+    for (int i = 0; p.Has("y" + std::to_string(i)); ++i) {
+      const std::string key = "y" + std::to_string(i);
+      c.outputs.push_back(TensorSpec::Parse(key, p.Get(key)));
+    }
+    CHECK(!c.outputs.empty()) << c.op << ": no outputs, y0=dtype:shape is required";
+    if (p.Has("atol") || p.Has("rtol") || p.Has("ulp")) {
+      for (auto& t : c.outputs) {
+        t.has_tol = true;
+        t.tol.atol = p.Float("atol", 0);
+        t.tol.rtol = p.Float("rtol", 0);
+        t.tol.ulp = p.Int("ulp", 0);
+      }
+    }
+    for (const auto& item : p.items()) {
+      if (item.first.compare(0, 2, "a.") != 0) {
+        continue;
+      }
+      const std::string spec = p.Get(item.first);
+      const size_t colon = spec.find(':');
+      CHECK(colon != std::string::npos) << item.first << "=" << spec << ", expected type:value";
+      c.attrs.push_back(AttrSpec{item.first.substr(2), spec.substr(0, colon), spec.substr(colon + 1)});
+    }
+    return c;
+  }
+};
+
+namespace opcase {
+
+// f(TypeTag<T>()) with the host type of `dtype`
+template <typename F>
+void VisitDType(aclDataType dtype, F f) {
+  switch (dtype) {
+    case ACL_FLOAT: f(TypeTag<float>()); break;
+    case ACL_FLOAT16: f(TypeTag<float16>()); break;
+    case ACL_BF16: f(TypeTag<bfloat16>()); break;
+    case ACL_DOUBLE: f(TypeTag<double>()); break;
+    case ACL_INT8: f(TypeTag<int8_t>()); break;
+    case ACL_UINT8: f(TypeTag<uint8_t>()); break;
+    case ACL_INT16: f(TypeTag<int16_t>()); break;
+    case ACL_UINT16: f(TypeTag<uint16_t>()); break;
+    case ACL_INT32: f(TypeTag<int32_t>()); break;
+    case ACL_UINT32: f(TypeTag<uint32_t>()); break;
+    case ACL_INT64: f(TypeTag<int64_t>()); break;
+    case ACL_UINT64: f(TypeTag<uint64_t>()); break;
+    case ACL_BOOL: f(TypeTag<bool>()); break;
+    default: LOG(FATAL) << "no host type for " << DataTypeName(dtype);
+  }
+}
+
+template <typename T>
+T FromDouble(double v) {
+  return philox::Kind<T>::kFloat ? T(static_cast<float>(v)) : static_cast<T>(static_cast<int64_t>(v));
+}
+template <>
+inline double FromDouble<double>(double v) {
+  return v;
+}
+
+template <typename T>
+void Fill(const TensorSpec& spec, uint64_t seed, T* x) {
+  const int64_t n = spec.numel();
+  if (spec.data == "rand") {
+    RandomUniform(x, n, -1.0, 1.0, seed);
+  } else if (spec.data == "normal") {
+    RandomNormal(x, n, 0.0, 1.0, seed);
+  } else if (spec.data == "special") {
+    RandomSpecial(x, n, 0.1, seed);
+  } else if (spec.data == "iota") {
+    for (int64_t i = 0; i < n; ++i) {
+      x[i] = FromDouble<T>(static_cast<double>(i));
+    }
+  } else if (spec.data == "zeros" || spec.data == "ones") {
+    std::fill(x, x + n, FromDouble<T>(spec.data == "ones" ? 1 : 0));
+  } else {
+    std::vector<double> values;
+    for (const auto& s : CaseParams::SplitList(spec.data)) {
+      char* end = nullptr;
+      values.push_back(std::strtod(s.c_str(), &end));
+      CHECK(!s.empty() && *end == '\0') << "bad input data " << spec.data;
+    }
+    CHECK(!values.empty()) << "empty input data " << spec.data;
+    for (int64_t i = 0; i < n; ++i) {
+      x[i] = FromDouble<T>(values[i % values.size()]);
+    }
+  }
+}
+
+}  // namespace opcase
+
+// The tensors and attributes of an OpCase on the device, freed with the
+// object. Input i is seeded with `seed` + i, file inputs are uploaded from
+// their mapping; check them first with OpCase::CheckFiles.
+class OpCaseRun {
+ public:
+  explicit OpCaseRun(const OpCase& c, uint64_t seed = 0) : case_(c) {
+    for (size_t i = 0; i < c.inputs.size(); ++i) {
+      const TensorSpec& spec = c.inputs[i];
+      if (!spec.file.empty()) {
+        MappedFile mapped(spec.file);
+        std::string error;
+        const uint8_t* data = spec.FileData(mapped, &error);
+        CHECK(data != nullptr) << error;
+        input_hashes_.push_back(HashBytes(data, spec.bytes()));
+        inputs_.push_back(PlanInput<uint8_t>(c.op, i, spec.dtype, spec.dims.size(), spec.dims.data(), spec.format,
+                                             data));
+        continue;
+      }
+      std::vector<uint8_t> host(spec.bytes());
+      opcase::VisitDType(spec.dtype, [&](auto tag) {
+        typedef typename decltype(tag)::type T;
+        opcase::Fill(spec, seed + i, reinterpret_cast<T *>(host.data()));
+      });
+      input_hashes_.push_back(HashBytes(host.data(), host.size()));
+      inputs_.push_back(PlanInput<uint8_t>(c.op, i, spec.dtype, spec.dims.size(), spec.dims.data(), spec.format,
+                                           host.data()));
+    }
+    for (const auto& spec : c.outputs) {
+      outputs_.push_back(new npuTensor<uint8_t>(spec.dtype, spec.dims.size(), spec.dims.data(), spec.format, nullptr));
+    }
+    attr_ = aclopCreateAttr();
+    for (const auto& a : c.attrs) {
+      ACL_CALL(a.Set(attr_));
+    }
+    for (auto t : inputs_) {
+      input_descs_.push_back(t->desc);
+      input_buffers_.push_back(t->buffer);
+    }
+    for (auto t : outputs_) {
+      output_descs_.push_back(t->desc);
+      output_buffers_.push_back(t->buffer);
+    }
+  }
+  ~OpCaseRun() {
+    for (auto t : inputs_) {
+      t->Destroy();
+    }
+    for (auto t : outputs_) {
+      t->Destroy();
+    }
+    aclopDestroyAttr(attr_);
+  }
+  OpCaseRun(const OpCaseRun&) = delete;
+  OpCaseRun& operator=(const OpCaseRun&) = delete;
+
+  const std::vector<npuTensor<uint8_t> *>& inputs() const { return inputs_; }
+  const std::vector<npuTensor<uint8_t> *>& outputs() const { return outputs_; }
+
+  aclError Execute(aclrtStream stream) const {
+    return aclopCompileAndExecute(case_.op.c_str(), input_descs_.size(), input_descs_.data(), input_buffers_.data(),
+                                  output_descs_.size(), output_descs_.data(), output_buffers_.data(), attr_,
+                                  ACL_ENGINE_SYS, ACL_COMPILE_SYS, NULL, stream);
+  }
+
+  // compile key, equal for cases that share a kernel
+  std::string Key() const {
+    std::stringstream attr_key;
+    for (const auto& a : case_.attrs) {
+      attr_key << a.name << "=" << a.type << ":" << a.value << ";";
+    }
+    bool const_inputs = true;
+    for (size_t i = 0; i < inputs_.size(); ++i) {
+      if (IsConstInput(case_.op, i) && !inputs_[i]->is_const()) {
+        const_inputs = false;
+      }
+    }
+    return CompileKey(case_.op, input_descs_, input_buffers_, output_descs_, attr_key.str(), const_inputs);
+  }
+
+  // regression store key: the compile key and the content hash of every
+  // input, hashed
+  std::string Signature() const {
+    std::string sig = Key();
+    for (auto h : input_hashes_) {
+      sig += "|" + golden::Hex(h);
+    }
+    return golden::Hex(HashBytes(sig.data(), sig.size()));
+  }
+
+  // outputs against the regression store (common/golden_store.h) as
+  // <Signature()>.y<i>, the worst status of any output
+  goldenStatus CheckGolden(GoldenStore* store, const std::string& label, std::ostream& os = std::cout) const {
+    const std::string sig = Signature();
+    goldenStatus worst = SAME;
+    for (size_t i = 0; i < outputs_.size(); ++i) {
+      const TensorSpec& spec = case_.outputs[i];
+      const Tolerance tol = spec.has_tol ? spec.tol : Tolerance::For(spec.dtype);
+      outputs_[i]->CopyToHost();
+      opcase::VisitDType(spec.dtype, [&](auto tag) {
+        typedef typename decltype(tag)::type T;
+        const goldenStatus s = store->Check(sig + ".y" + std::to_string(i), label + " y" + std::to_string(i),
+                                            reinterpret_cast<const T *>(outputs_[i]->data()), spec.dims, spec.dtype,
+                                            tol, os);
+        worst = std::max(worst, s);
+      });
+    }
+    return worst;
+  }
+
+  // first, compiling launch and `iters` warm ones (TimeCell), no reference
+  MatrixCell Time(int iters, aclrtStream stream) const {
+    MatrixCell cell;
+    cell.op = case_.op;
+    const TensorSpec& first = case_.inputs.empty() ? case_.outputs[0] : case_.inputs[0];
+    cell.dtype = first.dtype;
+    cell.format = first.format;
+    cell.elements = case_.outputs[0].numel();
+    for (const auto& t : case_.inputs) {
+      cell.bytes += t.bytes();
+    }
+    for (const auto& t : case_.outputs) {
+      cell.bytes += t.bytes();
+    }
+    cell.reference = case_.has_golden();
+    if (TimeCell([&] { return Execute(stream); }, iters, stream, &cell) && cell.reference) {
+      cell.verified = Verify();
+    }
+    return cell;
+  }
+
+  // outputs as <prefix>.y<i>.npy, e.g. to capture goldens or look at a
+  // mismatching result offline
+  bool SaveOutputs(const std::string& prefix) const {
+    bool ok = true;
+    for (size_t i = 0; i < outputs_.size(); ++i) {
+      ok = outputs_[i]->Save(prefix + ".y" + std::to_string(i) + ".npy") && ok;
+    }
+    return ok;
+  }
+
+  // outputs against their goldens, compared from the mapping; reports of
+  // mismatching outputs are printed
+  bool Verify(std::ostream& os = std::cout) const {
+    bool ok = true;
+    for (size_t i = 0; i < outputs_.size(); ++i) {
+      const TensorSpec& spec = case_.outputs[i];
+      if (spec.file.empty()) {
+        continue;
+      }
+      MappedFile mapped(spec.file);
+      std::string error;
+      const uint8_t* golden = spec.FileData(mapped, &error);
+      if (golden == nullptr) {
+        os << case_.name << " y" << i << ": " << error << std::endl;
+        ok = false;
+        continue;
+      }
+      outputs_[i]->CopyToHost();
+      const Tolerance tol = spec.has_tol ? spec.tol : Tolerance::For(spec.dtype);
+      opcase::VisitDType(spec.dtype, [&](auto tag) {
+        typedef typename decltype(tag)::type T;
+        const CompareReport report = Compare(reinterpret_cast<const T *>(outputs_[i]->data()),
+                                             reinterpret_cast<const T *>(golden), spec.dims, tol);
+        if (!report.ok()) {
+          report.Print(case_.name + " y" + std::to_string(i), os);
+          ok = false;
+        }
+      });
+    }
+    return ok;
+  }
+
+ private:
+  const OpCase case_;
+  std::vector<npuTensor<uint8_t> *> inputs_;
+  std::vector<npuTensor<uint8_t> *> outputs_;
+  std::vector<uint64_t> input_hashes_;
+  aclopAttr* attr_;
+  std::vector<aclTensorDesc *> input_descs_;
+  std::vector<aclDataBuffer *> input_buffers_;
+  std::vector<aclTensorDesc *> output_descs_;
+  std::vector<aclDataBuffer *> output_buffers_;
+};
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "acl/acl.h"
+
+// attribute list type of an input passed as an attribute to a D variant
+typedef enum {
+  LIST_INT = 0,
+  LIST_FLOAT = 1,
+} dAttrType;
+
+struct DAttr {
+  int input;
+  std::string name;
+  dAttrType type;  // as the D variant declares it, not the dtype of the input tensor
+};
+
+// Static metadata about an operator, keyed by op type.
+struct OpInfo {
+  // {output index, input index}: the op updates that input in place, so the
+  // output may share the input's device memory.
+  std::vector<std::pair<int, int>> inplace;
+  // shape/axis-like inputs: placed on host and marked const so the compiler
+  // can fold them, their values become part of the compile key
+  std::vector<int> const_inputs;
+  // static-attribute "D" variant, e.g. ReduceSum -> ReduceSumD, which takes
+  // the inputs listed in d_attrs as attributes of the same name and of the
+  // list type the D variant declares
+  std::string d_variant;
+  std::vector<DAttr> d_attrs;
+  // data dtypes the D variant supports, empty means all
+  std::vector<aclDataType> d_dtypes;
+};
+
+inline const std::map<std::string, OpInfo>& OpInfoRegistry() {
+  static const std::map<std::string, OpInfo> registry = [] {
+    std::map<std::string, OpInfo> r;
+    // ref ops - var is updated in place and returned as output y
+    r["ScatterUpdate"].inplace = {{0, 0}};
+    r["StridedSliceAssign"].inplace = {{0, 0}};
+    r["StridedSliceAssignD"].inplace = {{0, 0}};
+    // begin, end, strides
+    r["StridedSliceAssign"].const_inputs = {2, 3, 4};
+    // axes
+    r["ReduceSum"].const_inputs = {1};
+    r["ReduceMax"].const_inputs = {1};
+    // dimension
+    r["ArgMaxV2"].const_inputs = {1};
+    r["ArgMin"].const_inputs = {1};
+    // start, limit, delta
+    r["Range"].const_inputs = {0, 1, 2};
+    // roi, scales, sizes
+    r["Resize"].const_inputs = {1, 2, 3};
+    // size
+    r["ResizeNearestNeighborV2"].const_inputs = {1};
+    r["ResizeBilinearV2"].const_inputs = {1};
+    // shape / multiples
+    r["BroadcastTo"].const_inputs = {1};
+    r["Expand"].const_inputs = {1};
+    r["Tile"].const_inputs = {1};
+    // dims
+    r["Fill"].const_inputs = {0};
+    r["FillV2"].const_inputs = {0};
+
+    // D variants, dtypes from the op information library
+    r["ReduceSum"].d_variant = "ReduceSumD";
+    r["ReduceSum"].d_attrs = {{1, "axes", LIST_INT}};
+    r["ReduceSum"].d_dtypes = {ACL_FLOAT16, ACL_FLOAT};
+    // BroadcastToD rejects DT_INT64, see BroadcastToD/BroadcastToD.cc
+    r["BroadcastTo"].d_variant = "BroadcastToD";
+    r["BroadcastTo"].d_attrs = {{1, "shape", LIST_INT}};
+    r["BroadcastTo"].d_dtypes = {ACL_FLOAT16, ACL_FLOAT, ACL_INT32, ACL_INT8, ACL_UINT8};
+    r["StridedSliceAssign"].d_variant = "StridedSliceAssignD";
+    r["StridedSliceAssign"].d_attrs = {{2, "begin", LIST_INT}, {3, "end", LIST_INT}, {4, "strides", LIST_INT}};
+    r["StridedSliceAssign"].d_dtypes = {ACL_FLOAT16, ACL_FLOAT, ACL_INT32};
+    r["Resize"].d_variant = "ResizeD";
+    // roi is a float tensor of Resize but a list of ints of ResizeD, see ResizeD/ResizeD.cc
+    r["Resize"].d_attrs = {{1, "roi", LIST_INT}, {2, "scales", LIST_FLOAT}, {3, "sizes", LIST_INT}};
+    r["Resize"].d_dtypes = {ACL_FLOAT16, ACL_FLOAT};
+    r["FillV2"].d_variant = "FillV2D";
+    r["FillV2"].d_attrs = {{0, "dims", LIST_INT}};
+    return r;
+  }();
+  return registry;
+}
+
+inline const OpInfo& GetOpInfo(const std::string& op_type) {
+  static const OpInfo empty;
+  const auto& registry = OpInfoRegistry();
+  auto it = registry.find(op_type);
+  return it == registry.end() ? empty : it->second;
+}
+
+// input index aliased by output `index`, or -1 if the output needs its own memory
+inline int GetInplaceInput(const std::string& op_type, int index) {
+  for (const auto& alias : GetOpInfo(op_type).inplace) {
+    if (alias.first == index) {
+      return alias.second;
+    }
+  }
+  return -1;
+}
+
+inline bool IsConstInput(const std::string& op_type, int index) {
+  for (int i : GetOpInfo(op_type).const_inputs) {
+    if (i == index) {
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,255 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "acl/acl.h"
+#include "acl/acl_op_compiler.h"
+#include "common/dtype.h"
+#include "common/float16.h"
+#include "common/nputensor.h"
+
+// Typed op call: the element types of the inputs and outputs and the value
+// types of the attributes are template arguments, e.g.
+//
+//   OpSignature<In<float, float>, Out<float>, AttrTypes<bool, bool>> bmm(
+//       "BatchMatMul", sig::Names("adj_x1", "adj_x2"));
+//   ACL_CALL(bmm.Execute(stream, x1, x2, y, false, false));
+//
+// Execute() takes exactly one npuTensor<T>* per input / output and one value
+// per attribute, so a wrong count or element type fails to compile instead of
+// failing in aclopCompileAndExecute; Bind() also checks that each tensor's
+// desc has the dtype of its host type, as an npuTensor<float> can carry an
+// ACL_FLOAT16 desc. Descriptors and buffers go into std::arrays on the stack,
+// Bind() keeps them for repeated launches. Attribute name hashes are computed
+// at compile time, and each set of attribute values gets one aclopAttr,
+// cached by the hash of the values and reused by later launches, so a warm
+// launch does not allocate on the host. The attrs are shared with the
+// Launches bound to them, a Launch stays valid after its attr set has been
+// evicted from the cache.
+template <typename... T>
+struct In {};
+template <typename... T>
+struct Out {};
+template <typename... T>
+struct AttrTypes {};
+
+namespace sig {
+
+constexpr uint64_t kFnvOffset = 0xcbf29ce484222325ULL;
+constexpr uint64_t kFnvPrime = 0x100000001b3ULL;
+
+constexpr uint64_t Fnv1a(const char* s, uint64_t h = kFnvOffset) {
+  for (; *s != '\0'; ++s) {
+    h = (h ^ static_cast<unsigned char>(*s)) * kFnvPrime;
+  }
+  return h;
+}
+
+inline uint64_t Fnv1a(const void* p, size_t bytes, uint64_t h) {
+  const unsigned char* c = static_cast<const unsigned char *>(p);
+  for (size_t i = 0; i < bytes; ++i) {
+    h = (h ^ c[i]) * kFnvPrime;
+  }
+  return h;
+}
+
+// aclDataType of a host element type, undefined types do not compile
+template <typename T>
+struct DType;
+template <>
+struct DType<float> {
+  static constexpr aclDataType value = ACL_FLOAT;
+};
+template <>
+struct DType<float16> {
+  static constexpr aclDataType value = ACL_FLOAT16;
+};
+template <>
+struct DType<bfloat16> {
+  static constexpr aclDataType value = ACL_BF16;
+};
+template <>
+struct DType<double> {
+  static constexpr aclDataType value = ACL_DOUBLE;
+};
+template <>
+struct DType<int8_t> {
+  static constexpr aclDataType value = ACL_INT8;
+};
+template <>
+struct DType<uint8_t> {
+  static constexpr aclDataType value = ACL_UINT8;
+};
+template <>
+struct DType<int32_t> {
+  static constexpr aclDataType value = ACL_INT32;
+};
+template <>
+struct DType<int64_t> {
+  static constexpr aclDataType value = ACL_INT64;
+};
+template <>
+struct DType<bool> {
+  static constexpr aclDataType value = ACL_BOOL;
+};
+
+// attribute names and their hashes
+template <size_t N>
+struct AttrNames {
+  std::array<const char *, N> names;
+  std::array<uint64_t, N> hashes;
+};
+
+template <typename... S>
+constexpr AttrNames<sizeof...(S)> Names(S... names) {
+  return AttrNames<sizeof...(S)>{{{names...}}, {{Fnv1a(names)...}}};
+}
+
+// attribute value types: hash of the value and the matching aclopSetAttr*
+inline uint64_t ValueHash(bool v, uint64_t h) { return Fnv1a(&v, sizeof(v), h); }
+inline uint64_t ValueHash(int64_t v, uint64_t h) { return Fnv1a(&v, sizeof(v), h); }
+inline uint64_t ValueHash(float v, uint64_t h) { return Fnv1a(&v, sizeof(v), h); }
+inline uint64_t ValueHash(aclDataType v, uint64_t h) { return Fnv1a(&v, sizeof(v), h); }
+inline uint64_t ValueHash(const std::string& v, uint64_t h) { return Fnv1a(v.data(), v.size(), h); }
+inline uint64_t ValueHash(const std::vector<int64_t>& v, uint64_t h) {
+  return Fnv1a(v.data(), v.size() * sizeof(int64_t), h);
+}
+inline uint64_t ValueHash(const std::vector<float>& v, uint64_t h) {
+  return Fnv1a(v.data(), v.size() * sizeof(float), h);
+}
+
+inline aclError SetAttr(aclopAttr* attr, const char* name, bool v) { return aclopSetAttrBool(attr, name, v); }
+inline aclError SetAttr(aclopAttr* attr, const char* name, int64_t v) { return aclopSetAttrInt(attr, name, v); }
+inline aclError SetAttr(aclopAttr* attr, const char* name, float v) { return aclopSetAttrFloat(attr, name, v); }
+inline aclError SetAttr(aclopAttr* attr, const char* name, aclDataType v) {
+  return aclopSetAttrDataType(attr, name, v);
+}
+inline aclError SetAttr(aclopAttr* attr, const char* name, const std::string& v) {
+  return aclopSetAttrString(attr, name, v.c_str());
+}
+inline aclError SetAttr(aclopAttr* attr, const char* name, const std::vector<int64_t>& v) {
+  return aclopSetAttrListInt(attr, name, v.size(), v.data());
+}
+inline aclError SetAttr(aclopAttr* attr, const char* name, const std::vector<float>& v) {
+  return aclopSetAttrListFloat(attr, name, v.size(), v.data());
+}
+
+}  // namespace sig
+
+template <typename Inputs, typename Outputs, typename Attrs = AttrTypes<>>
+class OpSignature;
+
+template <typename... I, typename... O, typename... A>
+class OpSignature<In<I...>, Out<O...>, AttrTypes<A...>> {
+ public:
+  static constexpr size_t kNumInputs = sizeof...(I);
+  static constexpr size_t kNumOutputs = sizeof...(O);
+  static constexpr size_t kNumAttrs = sizeof...(A);
+  // attr value sets cached, the oldest is dropped beyond this; Launches
+  // still holding it keep it alive
+  static constexpr size_t kMaxAttrSets = 16;
+
+  // element types, e.g. to create the tensors with
+  static constexpr std::array<aclDataType, kNumInputs> InputTypes() { return {{sig::DType<I>::value...}}; }
+  static constexpr std::array<aclDataType, kNumOutputs> OutputTypes() { return {{sig::DType<O>::value...}}; }
+
+  OpSignature(const char* op_type, const sig::AttrNames<kNumAttrs>& attrs) : op_type_(op_type), attrs_(attrs) {}
+  explicit OpSignature(const char* op_type) : op_type_(op_type), attrs_() {
+    static_assert(kNumAttrs == 0, "attribute names are required");
+  }
+  OpSignature(const OpSignature&) = delete;
+  OpSignature& operator=(const OpSignature&) = delete;
+
+  const char* op_type() const { return op_type_; }
+
+  // aclopAttr holding `values`, created on first use
+  std::shared_ptr<aclopAttr> Attr(const A&... values) {
+    const uint64_t hash = Hash(std::index_sequence_for<A...>(), values...);
+    for (auto& e : attr_sets_) {
+      if (e.hash == hash && e.values == std::tie(values...)) {
+        return e.attr;
+      }
+    }
+    if (attr_sets_.size() == kMaxAttrSets) {
+      attr_sets_.erase(attr_sets_.begin());
+    }
+    std::shared_ptr<aclopAttr> attr(aclopCreateAttr(), [](aclopAttr* a) { aclopDestroyAttr(a); });
+    Set(attr.get(), std::index_sequence_for<A...>(), values...);
+    attr_sets_.push_back(AttrSet{hash, std::tuple<A...>(values...), attr});
+    return attr;
+  }
+
+  // one bound call, can be executed any number of times while the tensors
+  // live, it shares ownership of its attr
+  struct Launch {
+    const char* op_type;
+    std::array<aclTensorDesc *, kNumInputs> input_descs;
+    std::array<aclDataBuffer *, kNumInputs> input_buffers;
+    std::array<aclTensorDesc *, kNumOutputs> output_descs;
+    std::array<aclDataBuffer *, kNumOutputs> output_buffers;
+    std::shared_ptr<aclopAttr> attr;
+
+    aclError Execute(aclrtStream stream) const {
+      return aclopCompileAndExecute(op_type, kNumInputs, input_descs.data(), input_buffers.data(), kNumOutputs,
+                                    output_descs.data(), output_buffers.data(), attr.get(), ACL_ENGINE_SYS,
+                                    ACL_COMPILE_SYS, NULL, stream);
+    }
+  };
+
+  Launch Bind(npuTensor<I>*... inputs, npuTensor<O>*... outputs, const A&... attrs) {
+    Launch launch{op_type_, {{inputs->desc...}}, {{inputs->buffer...}}, {{outputs->desc...}},
+                  {{outputs->buffer...}}, Attr(attrs...)};
+    CheckTypes("input", launch.input_descs, InputTypes());
+    CheckTypes("output", launch.output_descs, OutputTypes());
+    return launch;
+  }
+
+  aclError Execute(aclrtStream stream, npuTensor<I>*... inputs, npuTensor<O>*... outputs, const A&... attrs) {
+    return Bind(inputs..., outputs..., attrs...).Execute(stream);
+  }
+
+ private:
+  struct AttrSet {
+    uint64_t hash;
+    std::tuple<A...> values;
+    std::shared_ptr<aclopAttr> attr;
+  };
+
+  template <size_t N>
+  void CheckTypes(const char* kind, const std::array<aclTensorDesc *, N>& descs,
+                  const std::array<aclDataType, N>& types) const {
+    for (size_t i = 0; i < N; ++i) {
+      const aclDataType dtype = aclGetTensorDescType(descs[i]);
+      CHECK(dtype == types[i]) << op_type_ << " " << kind << " " << i << " has a " << DataTypeName(dtype)
+                               << " desc, the signature expects " << DataTypeName(types[i]);
+    }
+  }
+
+  template <size_t... Is>
+  uint64_t Hash(std::index_sequence<Is...>, const A&... values) const {
+    uint64_t h = sig::kFnvOffset;
+    // name hashes are constants, only the values are hashed per call
+    const int unused[] = {0, (h = sig::ValueHash(values, h ^ attrs_.hashes[Is]), 0)...};
+    (void)unused;
+    return h;
+  }
+
+  template <size_t... Is>
+  void Set(aclopAttr* attr, std::index_sequence<Is...>, const A&... values) const {
+    const aclError ret[] = {ACL_SUCCESS, sig::SetAttr(attr, attrs_.names[Is], values)...};
+    for (aclError r : ret) {
+      ACL_CALL(r);
+    }
+  }
+
+  const char* op_type_;
+  const sig::AttrNames<kNumAttrs> attrs_;
+  std::vector<AttrSet> attr_sets_;
+};
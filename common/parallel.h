@@ -0,0 +1,46 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+// Host threads for CPU reference kernels, NPU_HOST_THREADS overrides the
+// hardware concurrency.
+inline int NumHostThreads() {
+  static int threads = [] {
+    const char* env = std::getenv("NPU_HOST_THREADS");
+    int n = env != nullptr ? atoi(env) : static_cast<int>(std::thread::hardware_concurrency());
+    return std::max(n, 1);
+  }();
+  return threads;
+}
+
+// Runs fn(task) for task in [0, num_tasks). Tasks are handed out dynamically
+// so uneven tiles balance; returns once all tasks are done.
+template <typename Fn>
+void ParallelFor(int64_t num_tasks, Fn fn, int max_threads = 0) {
+  int threads = max_threads > 0 ? std::min(max_threads, NumHostThreads()) : NumHostThreads();
+  threads = static_cast<int>(std::min<int64_t>(threads, num_tasks));
+  if (threads <= 1) {
+    for (int64_t task = 0; task < num_tasks; ++task) {
+      fn(task);
+    }
+    return;
+  }
+  std::atomic<int64_t> next(0);
+  auto worker = [&] {
+    for (int64_t task = next++; task < num_tasks; task = next++) {
+      fn(task);
+    }
+  };
+  std::vector<std::thread> pool;
+  for (int t = 1; t < threads; ++t) {
+    pool.emplace_back(worker);
+  }
+  worker();
+  for (auto& th : pool) {
+    th.join();
+  }
+}
@@ -0,0 +1,328 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#include "common/float16.h"
+#include "common/logging.h"
+#include "common/parallel.h"
+
+// Counter-based random inputs: Philox4x32-10 keyed by the seed, element e
+// (= offset + i) takes word e % 4 of block e / 4. A value depends only on
+// (seed, offset + i), so any slice of a tensor can be generated on its own
+// and the result is the same for every thread count.
+//
+// Blocks are generated 16 at a time over fixed lanes so the 32x32->64
+// multiplies vectorize, chunks run on ParallelFor. Supported element types
+// are float, float16, bfloat16, double, the integer types and bool:
+//   RandomUniform  float types in [lo, hi), integers in [lo, hi)
+//   RandomNormal   mean + stddev * N(0, 1) by Box-Muller over word pairs,
+//                  rounded for integers
+//   RandomSpecial  uniform [-1, 1) with a `fraction` of the elements replaced
+//                  by +-0, +-Inf, NaN, denormals and the largest finite
+//                  value of T (integers: 0, +-1, min, max and their
+//                  neighbours)
+// bool is a fair coin for every distribution. double values are built in
+// float, its specials are the float ones.
+typedef enum {
+  RANDOM_UNIFORM = 0,
+  RANDOM_NORMAL = 1,
+  RANDOM_SPECIAL = 2,
+} randomDist;
+
+namespace philox {
+
+constexpr int kLanes = 16;                 // Philox blocks per batch
+constexpr int64_t kBatch = 4 * kLanes;     // elements per batch
+constexpr int64_t kChunk = 1 << 16;        // elements per ParallelFor task
+constexpr uint32_t kM0 = 0xD2511F53u;
+constexpr uint32_t kM1 = 0xCD9E8D57u;
+constexpr uint32_t kW0 = 0x9E3779B9u;
+constexpr uint32_t kW1 = 0xBB67AE85u;
+
+// words of blocks [block, block + kLanes) of `stream`, u[4 * l + w] is word w
+// of block + l
+inline void Philox(uint64_t seed, uint64_t block, uint32_t stream, uint32_t* u) {
+  uint32_t c0[kLanes], c1[kLanes], c2[kLanes], c3[kLanes];
+  for (int l = 0; l < kLanes; ++l) {
+    const uint64_t ctr = block + l;
+    c0[l] = static_cast<uint32_t>(ctr);
+    c1[l] = static_cast<uint32_t>(ctr >> 32);
+    c2[l] = stream;
+    c3[l] = 0;
+  }
+  uint32_t k0 = static_cast<uint32_t>(seed);
+  uint32_t k1 = static_cast<uint32_t>(seed >> 32);
+  for (int round = 0; round < 10; ++round) {
+    for (int l = 0; l < kLanes; ++l) {
+      const uint64_t p0 = static_cast<uint64_t>(kM0) * c0[l];
+      const uint64_t p1 = static_cast<uint64_t>(kM1) * c2[l];
+      const uint32_t n0 = static_cast<uint32_t>(p1 >> 32) ^ c1[l] ^ k0;
+      const uint32_t n2 = static_cast<uint32_t>(p0 >> 32) ^ c3[l] ^ k1;
+      c1[l] = static_cast<uint32_t>(p1);
+      c3[l] = static_cast<uint32_t>(p0);
+      c0[l] = n0;
+      c2[l] = n2;
+    }
+    k0 += kW0;
+    k1 += kW1;
+  }
+  for (int l = 0; l < kLanes; ++l) {
+    u[4 * l] = c0[l];
+    u[4 * l + 1] = c1[l];
+    u[4 * l + 2] = c2[l];
+    u[4 * l + 3] = c3[l];
+  }
+}
+
+// [0, 1) with 24 random bits
+inline float Unit(uint32_t u) { return (u >> 8) * (1.0f / 16777216.0f); }
+
+// Branch-free log and sin / cos so the Box-Muller loops vectorize, within a
+// few float ulp over the arguments used here.
+// log(x) for normal x > 0, the cephes logf polynomial
+inline float Log(float x) {
+  uint32_t bits;
+  std::memcpy(&bits, &x, sizeof(bits));
+  // x = m * 2^e with m in [0.5, 1)
+  float e = static_cast<float>(static_cast<int32_t>((bits >> 23) & 0xff) - 126);
+  bits = (bits & 0x7fffffu) | 0x3f000000u;
+  float m;
+  std::memcpy(&m, &bits, sizeof(m));
+  const bool low = m < 0.70710678f;
+  e = low ? e - 1.0f : e;
+  const float t = low ? m + m - 1.0f : m - 1.0f;
+  const float t2 = t * t;
+  float y = 7.0376836292e-2f;
+  y = y * t - 1.1514610310e-1f;
+  y = y * t + 1.1676998740e-1f;
+  y = y * t - 1.2420140846e-1f;
+  y = y * t + 1.4249322787e-1f;
+  y = y * t - 1.6668057665e-1f;
+  y = y * t + 2.0000714765e-1f;
+  y = y * t - 2.4999993993e-1f;
+  y = y * t + 3.3333331174e-1f;
+  y = y * t * t2 - 2.12194440e-4f * e - 0.5f * t2;
+  return t + y + 0.693359375f * e;
+}
+
+// sin and cos of 2 pi * turns, turns in [0, 1) given as a 24-bit fraction
+inline void SinCos2Pi(uint32_t turns, float* sin_out, float* cos_out) {
+  // nearest quadrant q and r in [-pi/4, pi/4)
+  const uint32_t q = (turns + (1u << 21)) >> 22;
+  const float r = static_cast<int32_t>(turns - (q << 22)) * (1.57079632679f / 4194304.0f);
+  const float r2 = r * r;
+  const float s = r + r * r2 * (-1.6666654611e-1f + r2 * (8.3321608736e-3f + r2 * -1.9515295891e-4f));
+  const float c = 1.0f - 0.5f * r2 + r2 * r2 * (4.166664568298827e-2f + r2 * (-1.388731625493765e-3f + r2 * 2.443315711809948e-5f));
+  const float sv = (q & 1) ? c : s;
+  const float cv = (q & 1) ? s : c;
+  *sin_out = (q & 2) ? -sv : sv;
+  *cos_out = ((q + 1) & 2) ? -cv : cv;
+}
+
+// sqrt(x) for x >= 0 as x / sqrt(x) from three Newton steps, std::sqrt
+// keeps the loop scalar while errno is live
+inline float Sqrt(float x) {
+  uint32_t bits;
+  std::memcpy(&bits, &x, sizeof(bits));
+  bits = 0x5f375a86u - (bits >> 1);
+  float y;
+  std::memcpy(&y, &bits, sizeof(y));
+  y = y * (1.5f - 0.5f * x * y * y);
+  y = y * (1.5f - 0.5f * x * y * y);
+  y = y * (1.5f - 0.5f * x * y * y);
+  return x * y;
+}
+
+// standard normals from word pairs (u[2i], u[2i + 1]) by Box-Muller
+inline void Normal(const uint32_t* u, float* z) {
+  constexpr int64_t kPairs = kBatch / 2;
+  float r[kPairs];
+  uint32_t t[kPairs];
+  float s[kPairs];
+  float c[kPairs];
+  for (int64_t i = 0; i < kPairs; ++i) {
+    // 1 - Unit keeps the log argument in (0, 1]
+    r[i] = 1.0f - Unit(u[2 * i]);
+    t[i] = u[2 * i + 1] >> 8;
+  }
+  for (int64_t i = 0; i < kPairs; ++i) {
+    r[i] = Sqrt(-2.0f * Log(r[i]));
+    SinCos2Pi(t[i], &s[i], &c[i]);
+  }
+  for (int64_t i = 0; i < kPairs; ++i) {
+    z[2 * i] = r[i] * c[i];
+    z[2 * i + 1] = r[i] * s[i];
+  }
+}
+
+// element type traits: values are built as float for float / float16 /
+// bfloat16 / double and as int64 for integers, then stored
+template <typename T>
+struct Kind {
+  static constexpr bool kFloat = std::is_same<T, float>::value || std::is_same<T, float16>::value ||
+                                 std::is_same<T, bfloat16>::value || std::is_same<T, double>::value;
+  typedef typename std::conditional<kFloat, float, int64_t>::type value;
+};
+
+// values RandomSpecial mixes in, per element type
+template <typename T>
+struct Specials {
+  static constexpr int kCount = 8;
+  static const int64_t* Values() {
+    static const int64_t v[kCount] = {0, 1, -1, 0, static_cast<int64_t>(std::numeric_limits<T>::min()),
+                                      static_cast<int64_t>(std::numeric_limits<T>::max()),
+                                      static_cast<int64_t>(std::numeric_limits<T>::min()) + 1,
+                                      static_cast<int64_t>(std::numeric_limits<T>::max()) - 1};
+    return v;
+  }
+};
+template <>
+struct Specials<float> {
+  static constexpr int kCount = 8;
+  static const float* Values() {
+    static const float v[kCount] = {0.0f, -0.0f, std::numeric_limits<float>::infinity(),
+                                    -std::numeric_limits<float>::infinity(), std::numeric_limits<float>::quiet_NaN(),
+                                    std::numeric_limits<float>::denorm_min(), -std::numeric_limits<float>::min() * 0.5f,
+                                    std::numeric_limits<float>::max()};
+    return v;
+  }
+};
+// float16 denormals are 2^-24 .. 2^-14 - 2^-24, the largest finite is 65504
+template <>
+struct Specials<float16> {
+  static constexpr int kCount = 8;
+  static const float* Values() {
+    static const float v[kCount] = {0.0f, -0.0f, std::numeric_limits<float>::infinity(),
+                                    -std::numeric_limits<float>::infinity(), std::numeric_limits<float>::quiet_NaN(),
+                                    5.9604645e-8f, -3.0517578e-5f, 65504.0f};
+    return v;
+  }
+};
+// bfloat16 keeps the float exponent range with 8 significand bits
+template <>
+struct Specials<bfloat16> {
+  static constexpr int kCount = 8;
+  static const float* Values() {
+    static const float v[kCount] = {0.0f, -0.0f, std::numeric_limits<float>::infinity(),
+                                    -std::numeric_limits<float>::infinity(), std::numeric_limits<float>::quiet_NaN(),
+                                    9.1835496e-41f, -5.8774718e-39f, 3.3895314e38f};
+    return v;
+  }
+};
+template <>
+struct Specials<double> : Specials<float> {};
+
+inline void Store(const float* v, float* out, int64_t n) { std::copy(v, v + n, out); }
+inline void Store(const float* v, double* out, int64_t n) { std::copy(v, v + n, out); }
+inline void Store(const float* v, float16* out, int64_t n) { FloatToHalf(v, out, n); }
+inline void Store(const float* v, bfloat16* out, int64_t n) { FloatToBFloat16(v, out, n); }
+template <typename T>
+void Store(const int64_t* v, T* out, int64_t n) {
+  for (int64_t i = 0; i < n; ++i) {
+    out[i] = static_cast<T>(v[i]);
+  }
+}
+
+struct Params {
+  randomDist dist;
+  double a;   // lo / mean / fraction
+  double b;   // hi / stddev
+};
+
+// values of elements [batch * kBatch, (batch + 1) * kBatch)
+template <typename T>
+void Batch(uint64_t seed, uint64_t batch, const Params& p, typename Kind<T>::value* v) {
+  typedef typename Kind<T>::value V;
+  uint32_t u[kBatch];
+  Philox(seed, batch * kLanes, 0, u);
+  if (std::is_same<T, bool>::value) {
+    for (int64_t i = 0; i < kBatch; ++i) {
+      v[i] = u[i] >> 31;
+    }
+    return;
+  }
+  if (p.dist == RANDOM_NORMAL) {
+    float z[kBatch];
+    Normal(u, z);
+    const float mean = static_cast<float>(p.a);
+    const float stddev = static_cast<float>(p.b);
+    for (int64_t i = 0; i < kBatch; ++i) {
+      z[i] = mean + stddev * z[i];
+    }
+    for (int64_t i = 0; i < kBatch; ++i) {
+      v[i] = Kind<T>::kFloat ? static_cast<V>(z[i]) : static_cast<V>(std::llround(z[i]));
+    }
+    return;
+  }
+  const double lo = p.dist == RANDOM_SPECIAL ? -1 : p.a;
+  const double hi = p.dist == RANDOM_SPECIAL ? 1 : p.b;
+  if (Kind<T>::kFloat) {
+    const float flo = static_cast<float>(lo);
+    const float span = static_cast<float>(hi - lo);
+    for (int64_t i = 0; i < kBatch; ++i) {
+      v[i] = static_cast<V>(flo + span * Unit(u[i]));
+    }
+  } else {
+    // multiply-shift into [lo, hi), integer ranges up to 2^32
+    const uint64_t span = static_cast<uint64_t>(hi - lo);
+    CHECK(span <= (1ULL << 32)) << "integer range must be at most 2^32";
+    const int64_t ilo = static_cast<int64_t>(lo);
+    for (int64_t i = 0; i < kBatch; ++i) {
+      v[i] = static_cast<V>(ilo + static_cast<int64_t>((u[i] * span) >> 32));
+    }
+  }
+  if (p.dist == RANDOM_SPECIAL) {
+    // a second stream picks which elements are special and which value they take
+    uint32_t s[kBatch];
+    Philox(seed, batch * kLanes, 1, s);
+    const uint32_t threshold = static_cast<uint32_t>(std::min(p.a, 1.0) * 16777216.0);
+    const auto* specials = Specials<T>::Values();
+    for (int64_t i = 0; i < kBatch; ++i) {
+      const V special = static_cast<V>(specials[s[i] % Specials<T>::kCount]);
+      v[i] = (s[i] >> 8) < threshold ? special : v[i];
+    }
+  }
+}
+
+// max_threads > 0 caps the ParallelFor threads, the output does not depend on it
+template <typename T>
+void Fill(T* x, int64_t n, uint64_t seed, uint64_t offset, const Params& p, int max_threads = 0) {
+  typedef typename Kind<T>::value V;
+  const int64_t chunks = (n + kChunk - 1) / kChunk;
+  ParallelFor(chunks, [&](int64_t c) {
+    const int64_t i0 = c * kChunk;
+    const int64_t i1 = std::min(n, i0 + kChunk);
+    V v[kBatch];
+    for (int64_t i = i0; i < i1;) {
+      const uint64_t e = offset + i;
+      const int64_t first = e % kBatch;
+      const int64_t len = std::min<int64_t>(kBatch - first, i1 - i);
+      Batch<T>(seed, e / kBatch, p, v);
+      Store(v + first, x + i, len);
+      i += len;
+    }
+  }, max_threads);
+}
+
+}  // namespace philox
+
+// x[i] for i in [0, n) is element offset + i of the stream for `seed`
+template <typename T>
+void RandomUniform(T* x, int64_t n, double lo, double hi, uint64_t seed, uint64_t offset = 0) {
+  philox::Fill(x, n, seed, offset, philox::Params{RANDOM_UNIFORM, lo, hi});
+}
+
+template <typename T>
+void RandomNormal(T* x, int64_t n, double mean, double stddev, uint64_t seed, uint64_t offset = 0) {
+  philox::Fill(x, n, seed, offset, philox::Params{RANDOM_NORMAL, mean, stddev});
+}
+
+template <typename T>
+void RandomSpecial(T* x, int64_t n, double fraction, uint64_t seed, uint64_t offset = 0) {
+  philox::Fill(x, n, seed, offset, philox::Params{RANDOM_SPECIAL, fraction, 0});
+}
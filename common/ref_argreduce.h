@@ -0,0 +1,215 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "common/logging.h"
+#include "common/float16.h"
+#include "common/parallel.h"
+
+// CPU reference for ArgMaxV2 / ArgMin along one axis, reading x in place as
+// [outer, len, inner] without a transpose.
+//   inner > 1: rows of the axis are swept in order and every inner position
+//              keeps its own running value, a contiguous update
+//   inner = 1: kLanes interleaved running values, merged at the end
+// Ties resolve to the smallest index. NaN handling follows argNanMode:
+// NAN_PROPAGATE (default) returns the first NaN, the framework convention;
+// NAN_IGNORE skips NaNs, index 0 if the whole slice is NaN. Bench_ArgReduce
+// reports which of the two the device matches.
+typedef enum {
+    NAN_PROPAGATE = 0,
+    NAN_IGNORE = 1,
+} argNanMode;
+
+namespace argreduce {
+
+constexpr int kLanes = 16;
+constexpr int64_t kInnerBlock = 1024;
+
+// compared as float for float/float16, as themselves for integers
+template <typename T>
+struct Value {
+  typedef float type;
+};
+template <>
+struct Value<int32_t> {
+  typedef int32_t type;
+};
+template <>
+struct Value<int64_t> {
+  typedef int64_t type;
+};
+
+template <typename V>
+inline bool IsNan(V v) {
+  return v != v;
+}
+
+// running extreme before the first element: -inf / +inf for floats, so a
+// slice whose only non-NaN values are infinite still finds them, lowest /
+// max for integers
+template <bool kMax, typename V>
+V Init() {
+  typedef std::numeric_limits<V> L;
+  return L::has_infinity ? (kMax ? -L::infinity() : L::infinity()) : (kMax ? L::lowest() : L::max());
+}
+
+// Two passes, both branch-free so they vectorize: the extreme value
+// ignoring NaNs (and whether there is a NaN), then the first index holding
+// it, or holding a NaN when NaNs propagate.
+template <bool kMax, typename T, typename I>
+void Contiguous(const T* x, int64_t len, argNanMode nan_mode, I* y) {
+  typedef typename Value<T>::type V;
+  const V init = Init<kMax, V>();
+  V best[kLanes];
+  int nan[kLanes];
+  for (int l = 0; l < kLanes; ++l) {
+    best[l] = init;
+    nan[l] = 0;
+  }
+  int64_t k = 0;
+  for (; k + kLanes <= len; k += kLanes) {
+    for (int l = 0; l < kLanes; ++l) {
+      const V v = static_cast<V>(x[k + l]);
+      best[l] = (kMax ? v > best[l] : v < best[l]) ? v : best[l];
+      nan[l] |= IsNan(v);
+    }
+  }
+  for (int l = 0; k < len; ++k, ++l) {
+    const V v = static_cast<V>(x[k]);
+    best[l] = (kMax ? v > best[l] : v < best[l]) ? v : best[l];
+    nan[l] |= IsNan(v);
+  }
+  V b = best[0];
+  bool any_nan = nan[0];
+  for (int l = 1; l < kLanes; ++l) {
+    b = (kMax ? best[l] > b : best[l] < b) ? best[l] : b;
+    any_nan = any_nan || nan[l];
+  }
+  const bool want_nan = any_nan && nan_mode == NAN_PROPAGATE;
+  // index 0 if nothing matches, i.e. the slice is all NaN
+  *y = 0;
+  for (k = 0; k < len; ++k) {
+    const V v = static_cast<V>(x[k]);
+    if (want_nan ? IsNan(v) : v == b) {
+      *y = static_cast<I>(k);
+      return;
+    }
+  }
+}
+
+// columns [j0, j0 + n) of a [len, inner] slice, n <= kInnerBlock, same two
+// passes with one running value per column; index is 32-bit like the values
+// so the loop stays in one vector width
+template <bool kMax, typename T, typename I>
+void Strided(const T* x, int64_t len, int64_t inner, int64_t j0, int64_t n, argNanMode nan_mode, I* y) {
+  typedef typename Value<T>::type V;
+  const V init = Init<kMax, V>();
+  // on the stack so the compiler knows they do not alias x
+  V best[kInnerBlock];
+  int32_t nan[kInnerBlock];
+  int32_t index[kInnerBlock];
+  for (int64_t j = 0; j < n; ++j) {
+    best[j] = init;
+    nan[j] = 0;
+    index[j] = -1;
+  }
+  // j runs in full kLanes groups plus a tail, fixed-length inner loops are
+  // what the vectorizer takes at -O2
+  const int64_t n_full = n / kLanes * kLanes;
+  auto update = [&](const T* row, int64_t j) {
+    const V v = static_cast<V>(row[j]);
+    best[j] = (kMax ? v > best[j] : v < best[j]) ? v : best[j];
+    nan[j] |= IsNan(v);
+  };
+  for (int64_t k = 0; k < len; ++k) {
+    const T* row = x + k * inner + j0;
+    for (int64_t jb = 0; jb < n_full; jb += kLanes) {
+      for (int l = 0; l < kLanes; ++l) {
+        update(row, jb + l);
+      }
+    }
+    for (int64_t j = n_full; j < n; ++j) {
+      update(row, j);
+    }
+  }
+  // columns that look for their first NaN get a NaN target, which never
+  // compares equal, so the match is one select
+  if (nan_mode == NAN_PROPAGATE) {
+    for (int64_t j = 0; j < n; ++j) {
+      best[j] = nan[j] ? std::numeric_limits<V>::quiet_NaN() : best[j];
+    }
+  } else {
+    std::fill(nan, nan + n, 0);
+  }
+  auto match = [&](const T* row, int64_t j, int32_t k) {
+    const V v = static_cast<V>(row[j]);
+    const int32_t hit = (v == best[j]) | (nan[j] & IsNan(v));
+    index[j] = ((index[j] < 0) & hit) ? k : index[j];
+  };
+  for (int64_t k = 0; k < len; ++k) {
+    const T* row = x + k * inner + j0;
+    const int32_t kk = static_cast<int32_t>(k);
+    for (int64_t jb = 0; jb < n_full; jb += kLanes) {
+      for (int l = 0; l < kLanes; ++l) {
+        match(row, jb + l, kk);
+      }
+    }
+    for (int64_t j = n_full; j < n; ++j) {
+      match(row, j, kk);
+    }
+  }
+  for (int64_t j = 0; j < n; ++j) {
+    y[j0 + j] = static_cast<I>(std::max<int32_t>(index[j], 0));
+  }
+}
+
+}  // namespace argreduce
+
+// y: x_dims without `axis`, index type I (int32 or int64 as the op's dtype)
+template <bool kMax, typename T, typename I>
+void RefArgReduce(const T* x, const std::vector<int64_t>& x_dims, int64_t axis, I* y,
+                  argNanMode nan_mode = NAN_PROPAGATE) {
+  const int64_t rank = static_cast<int64_t>(x_dims.size());
+  if (axis < 0) {
+    axis += rank;
+  }
+  CHECK(axis >= 0 && axis < rank) << "axis " << axis << " out of range";
+  int64_t outer = 1;
+  int64_t inner = 1;
+  for (int64_t d = 0; d < axis; ++d) {
+    outer *= x_dims[d];
+  }
+  for (int64_t d = axis + 1; d < rank; ++d) {
+    inner *= x_dims[d];
+  }
+  const int64_t len = x_dims[axis];
+  CHECK_GT(len, 0);
+  CHECK_LE(len, std::numeric_limits<int32_t>::max());
+  if (inner == 1) {
+    ParallelFor(outer, [&](int64_t o) { argreduce::Contiguous<kMax>(x + o * len, len, nan_mode, y + o); });
+    return;
+  }
+  const int64_t blocks = (inner + argreduce::kInnerBlock - 1) / argreduce::kInnerBlock;
+  ParallelFor(outer * blocks, [&](int64_t task) {
+    const int64_t o = task / blocks;
+    const int64_t j0 = (task % blocks) * argreduce::kInnerBlock;
+    argreduce::Strided<kMax>(x + o * len * inner, len, inner, j0,
+                             std::min(argreduce::kInnerBlock, inner - j0), nan_mode, y + o * inner);
+  });
+}
+
+template <typename T, typename I>
+void RefArgMax(const T* x, const std::vector<int64_t>& x_dims, int64_t axis, I* y,
+               argNanMode nan_mode = NAN_PROPAGATE) {
+  RefArgReduce<true>(x, x_dims, axis, y, nan_mode);
+}
+
+template <typename T, typename I>
+void RefArgMin(const T* x, const std::vector<int64_t>& x_dims, int64_t axis, I* y,
+               argNanMode nan_mode = NAN_PROPAGATE) {
+  RefArgReduce<false>(x, x_dims, axis, y, nan_mode);
+}
@@ -0,0 +1,274 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "common/logging.h"
+#include "common/float16.h"
+#include "common/parallel.h"
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// CPU reference for BatchMatMul: y = op(x1) @ op(x2), op() transposes the
+// last two dims when adj_x1 / adj_x2 is set, batch dims broadcast like numpy.
+// float, float16 and bfloat16 inputs, fp32 accumulation and output.
+//
+// Blocked GEMM in the usual packed-panel form: a KC x NC panel of op(x2) and
+// an MC x KC block of op(x1) are packed to fp32 so the MR x NR micro-kernel
+// streams both with unit stride. Threads split the batch when there are
+// enough batches, otherwise the tiles of each GEMM.
+namespace gemm {
+
+#if defined(__AVX512F__)
+typedef __m512 Vec;
+constexpr int kW = 16;
+constexpr int kMR = 6;
+inline Vec VZero() { return _mm512_setzero_ps(); }
+inline Vec VLoad(const float* p) { return _mm512_loadu_ps(p); }
+inline void VStore(float* p, Vec v) { _mm512_storeu_ps(p, v); }
+inline Vec VSet1(float a) { return _mm512_set1_ps(a); }
+inline Vec VFma(Vec a, Vec b, Vec c) { return _mm512_fmadd_ps(a, b, c); }
+inline Vec VAdd(Vec a, Vec b) { return _mm512_add_ps(a, b); }
+#elif defined(__AVX2__) && defined(__FMA__)
+typedef __m256 Vec;
+constexpr int kW = 8;
+constexpr int kMR = 6;
+inline Vec VZero() { return _mm256_setzero_ps(); }
+inline Vec VLoad(const float* p) { return _mm256_loadu_ps(p); }
+inline void VStore(float* p, Vec v) { _mm256_storeu_ps(p, v); }
+inline Vec VSet1(float a) { return _mm256_set1_ps(a); }
+inline Vec VFma(Vec a, Vec b, Vec c) { return _mm256_fmadd_ps(a, b, c); }
+inline Vec VAdd(Vec a, Vec b) { return _mm256_add_ps(a, b); }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+typedef float32x4_t Vec;
+constexpr int kW = 4;
+constexpr int kMR = 8;
+inline Vec VZero() { return vdupq_n_f32(0); }
+inline Vec VLoad(const float* p) { return vld1q_f32(p); }
+inline void VStore(float* p, Vec v) { vst1q_f32(p, v); }
+inline Vec VSet1(float a) { return vdupq_n_f32(a); }
+inline Vec VFma(Vec a, Vec b, Vec c) { return vfmaq_f32(c, a, b); }
+inline Vec VAdd(Vec a, Vec b) { return vaddq_f32(a, b); }
+#else
+// portable fallback, left to the auto-vectorizer
+struct Vec {
+  float v[4];
+};
+constexpr int kW = 4;
+constexpr int kMR = 4;
+inline Vec VZero() { return Vec{{0, 0, 0, 0}}; }
+inline Vec VLoad(const float* p) { return Vec{{p[0], p[1], p[2], p[3]}}; }
+inline void VStore(float* p, Vec v) { std::copy(v.v, v.v + 4, p); }
+inline Vec VSet1(float a) { return Vec{{a, a, a, a}}; }
+inline Vec VFma(Vec a, Vec b, Vec c) {
+  for (int i = 0; i < 4; ++i) c.v[i] += a.v[i] * b.v[i];
+  return c;
+}
+inline Vec VAdd(Vec a, Vec b) {
+  for (int i = 0; i < 4; ++i) a.v[i] += b.v[i];
+  return a;
+}
+#endif
+
+constexpr int kNR = 2 * kW;
+constexpr int64_t kKC = 256;
+constexpr int64_t kMC = kMR * 16;
+constexpr int64_t kNC = kNR * 128;
+
+inline float Load(const float* p) { return *p; }
+inline float Load(const float16* p) { return HalfToFloat(p->bits); }
+inline float Load(const bfloat16* p) { return BFloat16ToFloat(p->bits); }
+
+// c[kMR x kNR] (row stride ldc) += a[kc x kMR] * b[kc x kNR]
+inline void MicroKernel(int64_t kc, const float* a, const float* b, float* c, int64_t ldc) {
+  Vec acc[kMR][2];
+  for (int i = 0; i < kMR; ++i) {
+    acc[i][0] = VZero();
+    acc[i][1] = VZero();
+  }
+  for (int64_t k = 0; k < kc; ++k) {
+    const Vec b0 = VLoad(b);
+    const Vec b1 = VLoad(b + kW);
+    for (int i = 0; i < kMR; ++i) {
+      const Vec ai = VSet1(a[i]);
+      acc[i][0] = VFma(ai, b0, acc[i][0]);
+      acc[i][1] = VFma(ai, b1, acc[i][1]);
+    }
+    a += kMR;
+    b += kNR;
+  }
+  for (int i = 0; i < kMR; ++i) {
+    VStore(c + i * ldc, VAdd(VLoad(c + i * ldc), acc[i][0]));
+    VStore(c + i * ldc + kW, VAdd(VLoad(c + i * ldc + kW), acc[i][1]));
+  }
+}
+
+// rows [i0, i0 + mc) x cols [k0, k0 + kc) of op(A) into kMR-row panels,
+// zero padded
+template <typename T>
+void PackA(const T* A, int64_t M, int64_t K, bool adj, int64_t i0, int64_t mc, int64_t k0, int64_t kc,
+           float* ap) {
+  for (int64_t ip = 0; ip < mc; ip += kMR) {
+    const int64_t rows = std::min<int64_t>(kMR, mc - ip);
+    for (int64_t k = 0; k < kc; ++k) {
+      for (int64_t r = 0; r < kMR; ++r) {
+        const int64_t i = i0 + ip + r;
+        const int64_t kk = k0 + k;
+        *ap++ = r < rows ? Load(adj ? A + kk * M + i : A + i * K + kk) : 0.0f;
+      }
+    }
+  }
+}
+
+// rows [k0, k0 + kc) x cols of the given kNR panel of op(B), zero padded
+template <typename T>
+void PackBPanel(const T* B, int64_t K, int64_t N, bool adj, int64_t k0, int64_t kc, int64_t j0, int64_t cols,
+                float* bp) {
+  for (int64_t k = 0; k < kc; ++k) {
+    const int64_t kk = k0 + k;
+    for (int64_t c = 0; c < kNR; ++c) {
+      const int64_t j = j0 + c;
+      *bp++ = c < cols ? Load(adj ? B + j * K + kk : B + kk * N + j) : 0.0f;
+    }
+  }
+}
+
+// C[M x N] = op(A) @ op(B), C row-major fp32
+template <typename T>
+void Gemm(const T* A, const T* B, float* C, int64_t M, int64_t N, int64_t K, bool adj_a, bool adj_b,
+          bool parallel) {
+  std::fill(C, C + M * N, 0.0f);
+  const int threads = parallel ? NumHostThreads() : 1;
+  const int64_t ncap = std::min(kNC, (N + kNR - 1) / kNR * kNR);
+  std::vector<float> bpack(std::min(kKC, K) * ncap);
+  for (int64_t jc = 0; jc < N; jc += kNC) {
+    const int64_t nc = std::min(kNC, N - jc);
+    const int64_t panels = (nc + kNR - 1) / kNR;
+    for (int64_t pc = 0; pc < K; pc += kKC) {
+      const int64_t kc = std::min(kKC, K - pc);
+      ParallelFor(panels, [&](int64_t p) {
+        PackBPanel(B, K, N, adj_b, pc, kc, jc + p * kNR, std::min<int64_t>(kNR, nc - p * kNR),
+                   bpack.data() + p * kc * kNR);
+      }, threads);
+
+      // tasks are MC row blocks x runs of B panels, split finer when M alone
+      // does not give every thread work
+      const int64_t mblocks = (M + kMC - 1) / kMC;
+      const int64_t chunk = std::max<int64_t>(1, panels * mblocks / (4 * threads));
+      const int64_t nchunks = (panels + chunk - 1) / chunk;
+      ParallelFor(mblocks * nchunks, [&](int64_t task) {
+        thread_local std::vector<float> apack;
+        const int64_t ic = (task / nchunks) * kMC;
+        const int64_t mc = std::min(kMC, M - ic);
+        apack.resize(kMC * kKC);
+        PackA(A, M, K, adj_a, ic, mc, pc, kc, apack.data());
+        const int64_t p_end = std::min(panels, (task % nchunks + 1) * chunk);
+        for (int64_t p = (task % nchunks) * chunk; p < p_end; ++p) {
+          const int64_t j = jc + p * kNR;
+          const int64_t cols = std::min<int64_t>(kNR, N - j);
+          for (int64_t ir = 0; ir < mc; ir += kMR) {
+            const int64_t rows = std::min<int64_t>(kMR, mc - ir);
+            const float* a = apack.data() + ir * kc;
+            const float* b = bpack.data() + p * kc * kNR;
+            float* c = C + (ic + ir) * N + j;
+            if (rows == kMR && cols == kNR) {
+              MicroKernel(kc, a, b, c, N);
+              continue;
+            }
+            // edge tile
+            float tile[kMR * kNR] = {0};
+            MicroKernel(kc, a, b, tile, kNR);
+            for (int64_t r = 0; r < rows; ++r) {
+              for (int64_t s = 0; s < cols; ++s) {
+                c[r * N + s] += tile[r * kNR + s];
+              }
+            }
+          }
+        }
+      }, threads);
+    }
+  }
+}
+
+}  // namespace gemm
+
+// output dims of BatchMatMul, batch dims broadcast
+inline std::vector<int64_t> BatchMatMulDims(const std::vector<int64_t>& x1_dims, const std::vector<int64_t>& x2_dims,
+                                            bool adj_x1, bool adj_x2) {
+  CHECK_GE(x1_dims.size(), 2);
+  CHECK_GE(x2_dims.size(), 2);
+  const size_t r1 = x1_dims.size();
+  const size_t r2 = x2_dims.size();
+  const int64_t M = adj_x1 ? x1_dims[r1 - 1] : x1_dims[r1 - 2];
+  const int64_t K = adj_x1 ? x1_dims[r1 - 2] : x1_dims[r1 - 1];
+  const int64_t K2 = adj_x2 ? x2_dims[r2 - 1] : x2_dims[r2 - 2];
+  const int64_t N = adj_x2 ? x2_dims[r2 - 2] : x2_dims[r2 - 1];
+  CHECK_EQ(K, K2) << "contracted dims differ";
+  const size_t batch_rank = std::max(r1, r2) - 2;
+  std::vector<int64_t> y_dims(batch_rank + 2);
+  for (size_t d = 0; d < batch_rank; ++d) {
+    // right aligned, missing dims are 1
+    const int64_t b1 = d + r1 >= batch_rank + 2 ? x1_dims[d + r1 - 2 - batch_rank] : 1;
+    const int64_t b2 = d + r2 >= batch_rank + 2 ? x2_dims[d + r2 - 2 - batch_rank] : 1;
+    CHECK(b1 == b2 || b1 == 1 || b2 == 1) << "batch dims " << b1 << " and " << b2 << " do not broadcast";
+    y_dims[d] = std::max(b1, b2);
+  }
+  y_dims[batch_rank] = M;
+  y_dims[batch_rank + 1] = N;
+  return y_dims;
+}
+
+template <typename T>
+void RefBatchMatMul(const T* x1, const std::vector<int64_t>& x1_dims, const T* x2,
+                    const std::vector<int64_t>& x2_dims, bool adj_x1, bool adj_x2, float* y) {
+  const std::vector<int64_t> y_dims = BatchMatMulDims(x1_dims, x2_dims, adj_x1, adj_x2);
+  const size_t batch_rank = y_dims.size() - 2;
+  const size_t r1 = x1_dims.size();
+  const size_t r2 = x2_dims.size();
+  const int64_t M = y_dims[batch_rank];
+  const int64_t N = y_dims[batch_rank + 1];
+  const int64_t K = adj_x1 ? x1_dims[r1 - 2] : x1_dims[r1 - 1];
+
+  // batch strides in matrices, 0 along broadcast dims
+  std::vector<int64_t> s1(batch_rank, 0);
+  std::vector<int64_t> s2(batch_rank, 0);
+  int64_t stride1 = 1;
+  int64_t stride2 = 1;
+  for (size_t d = batch_rank; d-- > 0;) {
+    const int64_t b1 = d + r1 >= batch_rank + 2 ? x1_dims[d + r1 - 2 - batch_rank] : 1;
+    const int64_t b2 = d + r2 >= batch_rank + 2 ? x2_dims[d + r2 - 2 - batch_rank] : 1;
+    s1[d] = b1 == 1 ? 0 : stride1;
+    s2[d] = b2 == 1 ? 0 : stride2;
+    stride1 *= b1;
+    stride2 *= b2;
+  }
+  int64_t batches = 1;
+  for (size_t d = 0; d < batch_rank; ++d) {
+    batches *= y_dims[d];
+  }
+
+  auto run = [&](int64_t b, bool parallel) {
+    int64_t o1 = 0;
+    int64_t o2 = 0;
+    for (size_t d = batch_rank, rest = b; d-- > 0;) {
+      const int64_t idx = rest % y_dims[d];
+      rest /= y_dims[d];
+      o1 += idx * s1[d];
+      o2 += idx * s2[d];
+    }
+    gemm::Gemm(x1 + o1 * M * K, x2 + o2 * K * N, y + b * M * N, M, N, K, adj_x1, adj_x2, parallel);
+  };
+  if (batches >= NumHostThreads()) {
+    ParallelFor(batches, [&](int64_t b) { run(b, false); });
+  } else {
+    for (int64_t b = 0; b < batches; ++b) {
+      run(b, true);
+    }
+  }
+}
@@ -0,0 +1,236 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "acl/acl.h"
+#include "common/logging.h"
+#include "common/float16.h"
+#include "common/parallel.h"
+
+// CPU reference for BNTrainingReduce / BN3DTrainingReduce / BNTrainingUpdate.
+//
+// x is viewed as [outer, C1, S, C0] with channel c1 * C0 + c0:
+//   NCHW, NCDHW   outer = N,     C1 = C,  S = H*W (D*H*W), C0 = 1
+//   NC1HWC0       outer = N,     C1 = C1, S = H*W,         C0 = C0
+//   NDC1HWC0      outer = N * D, C1 = C1, S = H*W,         C0 = C0
+// Tasks are (outer, c1, S block); each reads its block once, accumulating
+// sums of values shifted by the block's first value, and the per-block
+// moments are merged with Chan's parallel Welford update in a fixed order,
+// so results do not depend on the thread count.
+struct BNLayout {
+  int64_t outer = 1;
+  int64_t c1 = 1;
+  int64_t spatial = 1;
+  int64_t c0 = 1;
+
+  int64_t channels() const { return c1 * c0; }
+  // values reduced per channel
+  int64_t count() const { return outer * spatial; }
+
+  static BNLayout From(const std::vector<int64_t>& dims, aclFormat format) {
+    BNLayout l;
+    if (format == ACL_FORMAT_NC1HWC0) {
+      CHECK_EQ(dims.size(), 5);
+      l.outer = dims[0];
+      l.c1 = dims[1];
+      l.spatial = dims[2] * dims[3];
+      l.c0 = dims[4];
+    } else if (format == ACL_FORMAT_NDC1HWC0) {
+      CHECK_EQ(dims.size(), 6);
+      l.outer = dims[0] * dims[1];
+      l.c1 = dims[2];
+      l.spatial = dims[3] * dims[4];
+      l.c0 = dims[5];
+    } else {
+      CHECK(format == ACL_FORMAT_NCHW || format == ACL_FORMAT_NCDHW || format == ACL_FORMAT_ND)
+          << "unsupported BN layout " << format;
+      CHECK_GE(dims.size(), 2);
+      l.outer = dims[0];
+      l.c1 = dims[1];
+      for (size_t d = 2; d < dims.size(); ++d) {
+        l.spatial *= dims[d];
+      }
+    }
+    return l;
+  }
+};
+
+// count, mean and sum of squared deviations of one channel
+struct BNMoments {
+  double count = 0;
+  double mean = 0;
+  double m2 = 0;
+
+  void Merge(const BNMoments& b) {
+    if (b.count == 0) {
+      return;
+    }
+    const double n = count + b.count;
+    const double delta = b.mean - mean;
+    mean += delta * b.count / n;
+    m2 += b.m2 + delta * delta * count * b.count / n;
+    count = n;
+  }
+  double sum() const { return mean * count; }
+  double square_sum() const { return m2 + mean * mean * count; }
+  // biased, as BN training uses
+  double var() const { return count > 0 ? m2 / count : 0; }
+};
+
+namespace bn {
+
+constexpr int64_t kBlock = 4096;
+constexpr int kLanes = 16;
+
+// moments of n contiguous values, kLanes independent accumulators so the
+// loop vectorizes without reassociating a single sum
+template <typename T>
+BNMoments Contiguous(const T* x, int64_t n) {
+  const float shift = static_cast<float>(x[0]);
+  float s[kLanes] = {0};
+  float q[kLanes] = {0};
+  int64_t i = 0;
+  for (; i + kLanes <= n; i += kLanes) {
+    for (int l = 0; l < kLanes; ++l) {
+      const float d = static_cast<float>(x[i + l]) - shift;
+      s[l] += d;
+      q[l] += d * d;
+    }
+  }
+  double sd = 0;
+  double qd = 0;
+  for (int l = 0; l < kLanes; ++l) {
+    sd += s[l];
+    qd += q[l];
+  }
+  for (; i < n; ++i) {
+    const double d = static_cast<float>(x[i]) - shift;
+    sd += d;
+    qd += d * d;
+  }
+  BNMoments m;
+  m.count = n;
+  m.mean = shift + sd / n;
+  m.m2 = std::max(0.0, qd - sd * sd / n);
+  return m;
+}
+
+// moments of n rows of c0 interleaved channels
+template <typename T>
+void Interleaved(const T* x, int64_t n, int64_t c0, BNMoments* out) {
+  std::vector<float> shift(c0);
+  std::vector<float> s(c0, 0.0f);
+  std::vector<float> q(c0, 0.0f);
+  for (int64_t c = 0; c < c0; ++c) {
+    shift[c] = static_cast<float>(x[c]);
+  }
+  for (int64_t i = 0; i < n; ++i) {
+    const T* row = x + i * c0;
+    for (int64_t c = 0; c < c0; ++c) {
+      const float d = static_cast<float>(row[c]) - shift[c];
+      s[c] += d;
+      q[c] += d * d;
+    }
+  }
+  for (int64_t c = 0; c < c0; ++c) {
+    out[c].count = n;
+    out[c].mean = shift[c] + static_cast<double>(s[c]) / n;
+    out[c].m2 = std::max(0.0, q[c] - static_cast<double>(s[c]) * s[c] / n);
+  }
+}
+
+}  // namespace bn
+
+// per-channel moments of x
+template <typename T>
+std::vector<BNMoments> RefBNMoments(const T* x, const BNLayout& l) {
+  // bound the rows per block so float partial sums stay short
+  const int64_t rows = std::max<int64_t>(1, bn::kBlock / l.c0);
+  const int64_t blocks = (l.spatial + rows - 1) / rows;
+  const int64_t tasks = l.outer * l.c1 * blocks;
+  std::vector<BNMoments> partial(tasks * l.c0);
+  ParallelFor(tasks, [&](int64_t task) {
+    const int64_t b = task % blocks;
+    const int64_t c1 = (task / blocks) % l.c1;
+    const int64_t o = task / (blocks * l.c1);
+    const int64_t n = std::min(rows, l.spatial - b * rows);
+    const T* src = x + ((o * l.c1 + c1) * l.spatial + b * rows) * l.c0;
+    if (l.c0 == 1) {
+      partial[task] = bn::Contiguous(src, n);
+    } else {
+      bn::Interleaved(src, n, l.c0, partial.data() + task * l.c0);
+    }
+  });
+  std::vector<BNMoments> moments(l.channels());
+  for (int64_t o = 0; o < l.outer; ++o) {
+    for (int64_t c1 = 0; c1 < l.c1; ++c1) {
+      for (int64_t b = 0; b < blocks; ++b) {
+        const int64_t task = (o * l.c1 + c1) * blocks + b;
+        for (int64_t c = 0; c < l.c0; ++c) {
+          moments[c1 * l.c0 + c].Merge(partial[task * l.c0 + c]);
+        }
+      }
+    }
+  }
+  return moments;
+}
+
+// sum, square_sum: channels() values
+template <typename T>
+void RefBNTrainingReduce(const T* x, const std::vector<int64_t>& x_dims, aclFormat format, float* sum,
+                         float* square_sum) {
+  const std::vector<BNMoments> moments = RefBNMoments(x, BNLayout::From(x_dims, format));
+  for (size_t c = 0; c < moments.size(); ++c) {
+    sum[c] = static_cast<float>(moments[c].sum());
+    square_sum[c] = static_cast<float>(moments[c].square_sum());
+  }
+}
+
+// BNTrainingUpdate from the reduced sum / square_sum:
+//   saved_mean = sum / num
+//   saved_var  = square_sum / num - saved_mean^2
+//   y          = scale * (x - saved_mean) / sqrt(saved_var + epsilon) + offset
+//   mean_out   = factor * saved_mean + (1 - factor) * mean
+//   var_out    = factor * saved_var * num / (num - 1) + (1 - factor) * var
+template <typename T>
+void RefBNTrainingUpdate(const T* x, const std::vector<int64_t>& x_dims, aclFormat format, const float* sum,
+                         const float* square_sum, const float* scale, const float* offset, const float* mean,
+                         const float* var, float factor, float epsilon, float* y, float* mean_out, float* var_out,
+                         float* saved_mean, float* saved_var) {
+  const BNLayout l = BNLayout::From(x_dims, format);
+  const double num = static_cast<double>(l.count());
+  std::vector<float> a(l.channels());
+  std::vector<float> b(l.channels());
+  for (int64_t c = 0; c < l.channels(); ++c) {
+    const double m = sum[c] / num;
+    const double v = std::max(0.0, square_sum[c] / num - m * m);
+    saved_mean[c] = static_cast<float>(m);
+    saved_var[c] = static_cast<float>(v);
+    mean_out[c] = static_cast<float>(factor * m + (1 - factor) * mean[c]);
+    var_out[c] = static_cast<float>(factor * v * (num > 1 ? num / (num - 1) : 1) + (1 - factor) * var[c]);
+    // y = x * a + b
+    a[c] = static_cast<float>(scale[c] / std::sqrt(v + epsilon));
+    b[c] = static_cast<float>(offset[c] - m * a[c]);
+  }
+  ParallelFor(l.outer * l.c1, [&](int64_t task) {
+    const int64_t c1 = task % l.c1;
+    const T* src = x + task * l.spatial * l.c0;
+    float* dst = y + task * l.spatial * l.c0;
+    const float* ac = a.data() + c1 * l.c0;
+    const float* bc = b.data() + c1 * l.c0;
+    if (l.c0 == 1) {
+      for (int64_t i = 0; i < l.spatial; ++i) {
+        dst[i] = static_cast<float>(src[i]) * ac[0] + bc[0];
+      }
+      return;
+    }
+    for (int64_t i = 0; i < l.spatial; ++i) {
+      for (int64_t c = 0; c < l.c0; ++c) {
+        dst[i * l.c0 + c] = static_cast<float>(src[i * l.c0 + c]) * ac[c] + bc[c];
+      }
+    }
+  });
+}
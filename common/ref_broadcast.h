@@ -0,0 +1,175 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "common/logging.h"
+#include "common/parallel.h"
+
+// Host reference for ops that materialize a larger tensor from a smaller one
+// (BroadcastTo, Expand, Tile, TileWithAxis). The output is described as a
+// view of the input with per-dim element strides, 0 along repeated dims, and
+// only written out by Materialize() when it is compared.
+//
+// Tile is a view too: each axis i splits into (multiples[i], x_dims[i]) with
+// strides (0, stride_i), whose row-major order is the tiled layout.
+template <typename T>
+struct StrideView {
+  const T* data = nullptr;
+  std::vector<int64_t> dims;
+  std::vector<int64_t> strides;
+
+  int64_t numel() const {
+    int64_t n = 1;
+    for (auto d : dims) n *= d;
+    return n;
+  }
+};
+
+inline std::vector<int64_t> ContiguousStrides(const std::vector<int64_t>& dims) {
+  std::vector<int64_t> strides(dims.size(), 1);
+  for (size_t d = dims.size(); d-- > 1;) {
+    strides[d - 1] = strides[d] * dims[d];
+  }
+  return strides;
+}
+
+// numpy broadcast of x to shape, dims aligned from the right; false if the
+// shapes are not compatible
+template <typename T>
+bool BroadcastToView(const T* x, const std::vector<int64_t>& x_dims, const std::vector<int64_t>& shape,
+                     StrideView<T>* view) {
+  if (shape.size() < x_dims.size()) {
+    return false;
+  }
+  const std::vector<int64_t> x_strides = ContiguousStrides(x_dims);
+  const size_t lead = shape.size() - x_dims.size();
+  view->data = x;
+  view->dims = shape;
+  view->strides.assign(shape.size(), 0);
+  for (size_t d = 0; d < x_dims.size(); ++d) {
+    if (x_dims[d] == shape[lead + d]) {
+      view->strides[lead + d] = x_strides[d];
+    } else if (x_dims[d] != 1) {
+      return false;
+    }
+  }
+  return true;
+}
+
+template <typename T>
+StrideView<T> TileView(const T* x, const std::vector<int64_t>& x_dims, const std::vector<int64_t>& multiples) {
+  CHECK_EQ(multiples.size(), x_dims.size());
+  const std::vector<int64_t> x_strides = ContiguousStrides(x_dims);
+  StrideView<T> view;
+  view.data = x;
+  for (size_t d = 0; d < x_dims.size(); ++d) {
+    view.dims.push_back(multiples[d]);
+    view.strides.push_back(0);
+    view.dims.push_back(x_dims[d]);
+    view.strides.push_back(x_strides[d]);
+  }
+  return view;
+}
+
+template <typename T>
+StrideView<T> TileWithAxisView(const T* x, const std::vector<int64_t>& x_dims, int64_t axis, int64_t tiles) {
+  if (axis < 0) {
+    axis += x_dims.size();
+  }
+  std::vector<int64_t> multiples(x_dims.size(), 1);
+  multiples[axis] = tiles;
+  return TileView(x, x_dims, multiples);
+}
+
+// output dims of a view made by TileView / TileWithAxisView, i.e. pairs merged
+inline std::vector<int64_t> TileDims(const std::vector<int64_t>& x_dims, const std::vector<int64_t>& multiples) {
+  std::vector<int64_t> dims(x_dims.size());
+  for (size_t d = 0; d < x_dims.size(); ++d) {
+    dims[d] = x_dims[d] * multiples[d];
+  }
+  return dims;
+}
+
+namespace broadcast {
+
+// drops size-1 dims and merges neighbours that walk memory as one dim
+template <typename T>
+StrideView<T> Coalesce(const StrideView<T>& v) {
+  StrideView<T> c;
+  c.data = v.data;
+  for (size_t d = 0; d < v.dims.size(); ++d) {
+    if (v.dims[d] == 1) {
+      continue;
+    }
+    if (!c.dims.empty() && c.strides.back() == v.strides[d] * v.dims[d]) {
+      c.dims.back() *= v.dims[d];
+      c.strides.back() = v.strides[d];
+      continue;
+    }
+    c.dims.push_back(v.dims[d]);
+    c.strides.push_back(v.strides[d]);
+  }
+  if (c.dims.empty()) {
+    c.dims.push_back(1);
+    c.strides.push_back(0);
+  }
+  return c;
+}
+
+// writes dims [d, rank) of v starting at src into dst, block elements
+template <typename T>
+void Fill(const StrideView<T>& v, const std::vector<int64_t>& block, size_t d, const T* src, T* dst) {
+  const int64_t n = v.dims[d];
+  const int64_t stride = v.strides[d];
+  if (d + 1 == v.dims.size()) {
+    if (stride == 1) {
+      std::memcpy(dst, src, n * sizeof(T));
+    } else if (stride == 0) {
+      std::fill(dst, dst + n, *src);
+    } else {
+      for (int64_t i = 0; i < n; ++i) {
+        dst[i] = src[i * stride];
+      }
+    }
+    return;
+  }
+  if (stride == 0) {
+    // write one block, then replicate it from the output
+    Fill(v, block, d + 1, src, dst);
+    for (int64_t i = 1; i < n; ++i) {
+      std::memcpy(dst + i * block[d], dst, block[d] * sizeof(T));
+    }
+    return;
+  }
+  for (int64_t i = 0; i < n; ++i) {
+    Fill(v, block, d + 1, src + i * stride, dst + i * block[d]);
+  }
+}
+
+}  // namespace broadcast
+
+// writes the view row-major into out (numel() elements)
+template <typename T>
+void Materialize(const StrideView<T>& view, T* out) {
+  const StrideView<T> v = broadcast::Coalesce(view);
+  const size_t rank = v.dims.size();
+  // block[d]: output elements of one step along d
+  const std::vector<int64_t> block = ContiguousStrides(v.dims);
+  // tasks over leading dims, enough of them to spread across threads
+  size_t depth = 0;
+  int64_t tasks = 1;
+  while (depth + 1 < rank && tasks < 4 * NumHostThreads()) {
+    tasks *= v.dims[depth++];
+  }
+  ParallelFor(tasks, [&](int64_t task) {
+    int64_t src = 0;
+    for (size_t d = depth, rest = task; d-- > 0;) {
+      src += static_cast<int64_t>(rest % v.dims[d]) * v.strides[d];
+      rest /= v.dims[d];
+    }
+    broadcast::Fill(v, block, depth, v.data + src, out + (depth > 0 ? task * block[depth - 1] : 0));
+  });
+}
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "common/logging.h"
+#include "common/parallel.h"
+
+// CPU reference for DeformableOffsets on NCHW input.
+//
+// For output position (ho, wo) and kernel tap (i, j) of deformable group g,
+// the sample point is
+//   h = ho * stride_h - pad_top  + i * dilation_h + offset_y
+//   w = wo * stride_w - pad_left + j * dilation_w + offset_x
+// and y[n, c, ho * kh + i, wo * kw + j] = mask * bilinear(x[n, c], h, w) for
+// every channel c of g. Corners outside the input count as 0, a point with
+// h <= -1, h >= H, w <= -1 or w >= W samples 0.
+//
+// offsets is [N, 3 * groups * kh * kw, Ho, Wo]: the x offsets of all groups
+// and taps, then the y offsets, then the masks, each block indexed by
+// g * kh * kw + i * kw + j. modulated = false ignores the masks.
+//
+// A sample's corners and weights depend on (n, g, ho, wo, i, j) only, so they
+// are computed once per output row and reused for each channel of the group.
+struct DeformableOffsetsParams {
+  // attributes as the op takes them, strides / dilations in NCHW order,
+  // pads {top, bottom, left, right}
+  std::vector<int64_t> ksize{3, 3};
+  std::vector<int64_t> strides{1, 1, 1, 1};
+  std::vector<int64_t> pads{0, 0, 0, 0};
+  std::vector<int64_t> dilations{1, 1, 1, 1};
+  int64_t deformable_groups = 1;
+  bool modulated = true;
+
+  int64_t OutH(int64_t h) const { return (h + pads[0] + pads[1] - (dilations[2] * (ksize[0] - 1) + 1)) / strides[2] + 1; }
+  int64_t OutW(int64_t w) const { return (w + pads[2] + pads[3] - (dilations[3] * (ksize[1] - 1) + 1)) / strides[3] + 1; }
+};
+
+// {N, 3 * groups * kh * kw, Ho, Wo}
+inline std::vector<int64_t> DeformableOffsetsOffsetDims(const std::vector<int64_t>& x_dims,
+                                                        const DeformableOffsetsParams& p) {
+  return {x_dims[0], 3 * p.deformable_groups * p.ksize[0] * p.ksize[1], p.OutH(x_dims[2]), p.OutW(x_dims[3])};
+}
+
+// {N, C, Ho * kh, Wo * kw}
+inline std::vector<int64_t> DeformableOffsetsOutputDims(const std::vector<int64_t>& x_dims,
+                                                        const DeformableOffsetsParams& p) {
+  return {x_dims[0], x_dims[1], p.OutH(x_dims[2]) * p.ksize[0], p.OutW(x_dims[3]) * p.ksize[1]};
+}
+
+namespace deformable {
+
+// corners of the samples of one output row, structure of arrays so the
+// channel loop is four gathers and a dot product
+struct Samples {
+  std::vector<int32_t> index[4];
+  std::vector<float> weight[4];
+
+  void Resize(int64_t n) {
+    for (int k = 0; k < 4; ++k) {
+      index[k].resize(n);
+      weight[k].resize(n);
+    }
+  }
+
+  // bilinear corners of (h, w) in an H x W plane, times mask
+  void Set(int64_t s, float h, float w, float mask, int64_t H, int64_t W) {
+    for (int k = 0; k < 4; ++k) {
+      index[k][s] = 0;
+      weight[k][s] = 0.0f;
+    }
+    if (!(h > -1.0f && h < H && w > -1.0f && w < W)) {
+      return;
+    }
+    const float h_floor = std::floor(h);
+    const float w_floor = std::floor(w);
+    const int64_t h0 = static_cast<int64_t>(h_floor);
+    const int64_t w0 = static_cast<int64_t>(w_floor);
+    const float lh = h - h_floor;
+    const float lw = w - w_floor;
+    const int64_t hs[2] = {h0, h0 + 1};
+    const int64_t ws[2] = {w0, w0 + 1};
+    const float wh[2] = {1.0f - lh, lh};
+    const float ww[2] = {1.0f - lw, lw};
+    for (int a = 0; a < 2; ++a) {
+      for (int b = 0; b < 2; ++b) {
+        if (hs[a] >= 0 && hs[a] < H && ws[b] >= 0 && ws[b] < W) {
+          index[2 * a + b][s] = static_cast<int32_t>(hs[a] * W + ws[b]);
+          weight[2 * a + b][s] = wh[a] * ww[b] * mask;
+        }
+      }
+    }
+  }
+};
+
+}  // namespace deformable
+
+// x NCHW, offsets as above, y DeformableOffsetsOutputDims
+template <typename T>
+void RefDeformableOffsets(const T* x, const std::vector<int64_t>& x_dims, const T* offsets,
+                          const DeformableOffsetsParams& p, float* y) {
+  CHECK_EQ(x_dims.size(), 4);
+  const int64_t N = x_dims[0];
+  const int64_t C = x_dims[1];
+  const int64_t H = x_dims[2];
+  const int64_t W = x_dims[3];
+  const int64_t groups = p.deformable_groups;
+  CHECK(groups > 0 && C % groups == 0) << "channels " << C << " not divisible by deformable_groups " << groups;
+  CHECK_LE(H * W, std::numeric_limits<int32_t>::max());
+  const int64_t kh = p.ksize[0];
+  const int64_t kw = p.ksize[1];
+  const int64_t Ho = p.OutH(H);
+  const int64_t Wo = p.OutW(W);
+  const int64_t taps = kh * kw;
+  const int64_t group_c = C / groups;
+  const int64_t y_w = Wo * kw;
+  const int64_t y_plane = Ho * kh * y_w;
+  const int64_t offset_plane = Ho * Wo;
+
+  // one task per output row band (n, g, ho): kh output rows of every channel
+  ParallelFor(N * groups * Ho, [&](int64_t task) {
+    const int64_t ho = task % Ho;
+    const int64_t g = task / Ho % groups;
+    const int64_t n = task / Ho / groups;
+    // sample s = (i * Wo + wo) * kw + j, so output row ho * kh + i of a
+    // channel is samples [i * y_w, (i + 1) * y_w)
+    deformable::Samples samples;
+    samples.Resize(kh * y_w);
+    const T* off = offsets + n * 3 * groups * taps * offset_plane;
+    for (int64_t i = 0; i < kh; ++i) {
+      for (int64_t wo = 0; wo < Wo; ++wo) {
+        for (int64_t j = 0; j < kw; ++j) {
+          const int64_t tap = g * taps + i * kw + j;
+          const int64_t at = ho * Wo + wo;
+          const float dx = static_cast<float>(off[tap * offset_plane + at]);
+          const float dy = static_cast<float>(off[(groups * taps + tap) * offset_plane + at]);
+          const float mask = p.modulated ? static_cast<float>(off[(2 * groups * taps + tap) * offset_plane + at]) : 1.0f;
+          const float h = static_cast<float>(ho * p.strides[2] - p.pads[0] + i * p.dilations[2]) + dy;
+          const float w = static_cast<float>(wo * p.strides[3] - p.pads[2] + j * p.dilations[3]) + dx;
+          samples.Set((i * Wo + wo) * kw + j, h, w, mask, H, W);
+        }
+      }
+    }
+    const int64_t count = kh * y_w;
+    for (int64_t c = g * group_c; c < (g + 1) * group_c; ++c) {
+      const T* plane = x + (n * C + c) * H * W;
+      float* out = y + (n * C + c) * y_plane + ho * kh * y_w;
+      for (int64_t s = 0; s < count; ++s) {
+        out[s] = samples.weight[0][s] * static_cast<float>(plane[samples.index[0][s]]) +
+                 samples.weight[1][s] * static_cast<float>(plane[samples.index[1][s]]) +
+                 samples.weight[2][s] * static_cast<float>(plane[samples.index[2][s]]) +
+                 samples.weight[3][s] * static_cast<float>(plane[samples.index[3][s]]);
+      }
+    }
+  });
+}
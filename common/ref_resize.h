@@ -0,0 +1,225 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "common/logging.h"
+#include "common/float16.h"
+#include "common/parallel.h"
+
+// CPU reference for the Resize family on NCHW input, fp32 output.
+//
+// Separable: each spatial axis gets a table of source taps and weights, built
+// once per call and shared by every N*C plane. A row is produced by blending
+// the tapped input rows (contiguous, vectorizes) and then gathering along W.
+struct ResizeParams {
+  // nearest | linear | cubic ("bilinear" is accepted for linear)
+  std::string mode = "nearest";
+  // half_pixel | pytorch_half_pixel | align_corners | asymmetric |
+  // tf_half_pixel_for_nn | tf_crop_and_resize
+  std::string coordinate_transformation_mode = "half_pixel";
+  // round_prefer_floor | round_prefer_ceil | floor | ceil
+  std::string nearest_mode = "round_prefer_floor";
+  float cubic_coeff_a = -0.75f;
+  bool exclude_outside = false;
+  // tf_crop_and_resize only, for samples outside the input
+  float extrapolation_value = 0.0f;
+  // tf_crop_and_resize only, normalized {h_start, w_start, h_end, w_end}
+  std::vector<float> roi;
+  // output / input, 0 derives them from the sizes
+  float scale_h = 0.0f;
+  float scale_w = 0.0f;
+
+  // attributes of ResizeBilinearV2 / ResizeNearestNeighborV2
+  static ResizeParams FromV2(const std::string& mode, bool align_corners, bool half_pixel_centers) {
+    ResizeParams p;
+    p.mode = mode;
+    if (align_corners) {
+      p.coordinate_transformation_mode = "align_corners";
+      // TF rounds half away from zero
+      p.nearest_mode = "round_prefer_ceil";
+    } else if (half_pixel_centers) {
+      p.coordinate_transformation_mode = mode == "nearest" ? "tf_half_pixel_for_nn" : "half_pixel";
+      p.nearest_mode = "floor";
+    } else {
+      p.coordinate_transformation_mode = "asymmetric";
+      p.nearest_mode = "floor";
+    }
+    return p;
+  }
+};
+
+// taps and weights of one output coordinate along one axis
+struct ResizeAxis {
+  int taps = 1;
+  std::vector<int64_t> index;  // out_size * taps, clamped to the input
+  std::vector<float> weight;   // out_size * taps
+  std::vector<char> valid;     // false: sample is extrapolation_value
+};
+
+// source coordinate of output index x along an axis
+inline float ResizeSourceCoord(const ResizeParams& p, int64_t x, int64_t in_size, int64_t out_size, float scale,
+                               float roi_start, float roi_end) {
+  const std::string& ctm = p.coordinate_transformation_mode;
+  if (ctm == "half_pixel") {
+    return (x + 0.5f) / scale - 0.5f;
+  }
+  if (ctm == "pytorch_half_pixel") {
+    return out_size > 1 ? (x + 0.5f) / scale - 0.5f : 0.0f;
+  }
+  if (ctm == "align_corners") {
+    return out_size > 1 ? x * static_cast<float>(in_size - 1) / (out_size - 1) : 0.0f;
+  }
+  if (ctm == "asymmetric") {
+    return x / scale;
+  }
+  if (ctm == "tf_half_pixel_for_nn") {
+    return (x + 0.5f) / scale;
+  }
+  if (ctm == "tf_crop_and_resize") {
+    return out_size > 1 ? roi_start * (in_size - 1) + x * (roi_end - roi_start) * (in_size - 1) / (out_size - 1)
+                        : 0.5f * (roi_start + roi_end) * (in_size - 1);
+  }
+  LOG(FATAL) << "unknown coordinate_transformation_mode " << ctm;
+  return 0.0f;
+}
+
+inline int64_t ResizeNearestIndex(const std::string& nearest_mode, float x) {
+  if (nearest_mode == "floor") {
+    return static_cast<int64_t>(std::floor(x));
+  }
+  if (nearest_mode == "ceil") {
+    return static_cast<int64_t>(std::ceil(x));
+  }
+  const float f = std::floor(x);
+  if (x - f == 0.5f) {
+    return static_cast<int64_t>(nearest_mode == "round_prefer_floor" ? f : f + 1);
+  }
+  return static_cast<int64_t>(std::round(x));
+}
+
+// Keys cubic convolution kernel
+inline float ResizeCubicWeight(float d, float a) {
+  d = std::fabs(d);
+  if (d <= 1) {
+    return ((a + 2) * d - (a + 3)) * d * d + 1;
+  }
+  if (d < 2) {
+    return ((a * d - 5 * a) * d + 8 * a) * d - 4 * a;
+  }
+  return 0;
+}
+
+inline ResizeAxis MakeResizeAxis(const ResizeParams& p, int64_t in_size, int64_t out_size, float scale,
+                                 float roi_start, float roi_end) {
+  ResizeAxis axis;
+  const bool linear = p.mode == "linear" || p.mode == "bilinear";
+  const bool cubic = p.mode == "cubic";
+  CHECK(linear || cubic || p.mode == "nearest") << "unknown resize mode " << p.mode;
+  axis.taps = cubic ? 4 : linear ? 2 : 1;
+  axis.index.resize(out_size * axis.taps);
+  axis.weight.resize(out_size * axis.taps);
+  axis.valid.resize(out_size, 1);
+  auto clamp = [in_size](int64_t i) { return std::min(std::max<int64_t>(i, 0), in_size - 1); };
+  for (int64_t x = 0; x < out_size; ++x) {
+    const float src = ResizeSourceCoord(p, x, in_size, out_size, scale, roi_start, roi_end);
+    int64_t* index = axis.index.data() + x * axis.taps;
+    float* weight = axis.weight.data() + x * axis.taps;
+    if (p.coordinate_transformation_mode == "tf_crop_and_resize" && (src < 0 || src > in_size - 1)) {
+      axis.valid[x] = 0;
+    }
+    if (axis.taps == 1) {
+      index[0] = clamp(ResizeNearestIndex(p.nearest_mode, src));
+      weight[0] = 1;
+      continue;
+    }
+    const float f = std::floor(src);
+    const float t = src - f;
+    const int64_t base = static_cast<int64_t>(f);
+    if (axis.taps == 2) {
+      index[0] = clamp(base);
+      index[1] = clamp(base + 1);
+      weight[0] = 1 - t;
+      weight[1] = t;
+      continue;
+    }
+    float sum = 0;
+    for (int k = 0; k < 4; ++k) {
+      const int64_t i = base - 1 + k;
+      float w = ResizeCubicWeight(t - (k - 1), p.cubic_coeff_a);
+      if (p.exclude_outside && (i < 0 || i >= in_size)) {
+        w = 0;
+      }
+      index[k] = clamp(i);
+      weight[k] = w;
+      sum += w;
+    }
+    if (p.exclude_outside && sum != 0) {
+      for (int k = 0; k < 4; ++k) {
+        weight[k] /= sum;
+      }
+    }
+  }
+  return axis;
+}
+
+// y: N x C x out_h x out_w
+template <typename T>
+void RefResize(const T* x, const std::vector<int64_t>& x_dims, int64_t out_h, int64_t out_w,
+               const ResizeParams& p, float* y) {
+  CHECK_EQ(x_dims.size(), 4) << "RefResize expects NCHW";
+  const int64_t planes = x_dims[0] * x_dims[1];
+  const int64_t in_h = x_dims[2];
+  const int64_t in_w = x_dims[3];
+  const float scale_h = p.scale_h > 0 ? p.scale_h : static_cast<float>(out_h) / in_h;
+  const float scale_w = p.scale_w > 0 ? p.scale_w : static_cast<float>(out_w) / in_w;
+  const bool crop = p.coordinate_transformation_mode == "tf_crop_and_resize";
+  CHECK(!crop || p.roi.size() == 4) << "tf_crop_and_resize needs roi {h_start, w_start, h_end, w_end}";
+  const ResizeAxis ah = MakeResizeAxis(p, in_h, out_h, scale_h, crop ? p.roi[0] : 0, crop ? p.roi[2] : 1);
+  const ResizeAxis aw = MakeResizeAxis(p, in_w, out_w, scale_w, crop ? p.roi[1] : 0, crop ? p.roi[3] : 1);
+
+  // tasks are row bands of a plane, enough of them to keep every thread busy
+  const int64_t bands = std::max<int64_t>(1, std::min<int64_t>(out_h, 4 * NumHostThreads() / planes));
+  const int64_t band_rows = (out_h + bands - 1) / bands;
+  ParallelFor(planes * bands, [&](int64_t task) {
+    thread_local std::vector<float> row;
+    row.resize(in_w);
+    const T* src = x + (task / bands) * in_h * in_w;
+    float* dst = y + (task / bands) * out_h * out_w;
+    const int64_t oy_end = std::min(out_h, (task % bands + 1) * band_rows);
+    for (int64_t oy = (task % bands) * band_rows; oy < oy_end; ++oy) {
+      float* out = dst + oy * out_w;
+      if (!ah.valid[oy]) {
+        std::fill(out, out + out_w, p.extrapolation_value);
+        continue;
+      }
+      // vertical pass over contiguous input rows
+      const int64_t* iy = ah.index.data() + oy * ah.taps;
+      const float* wy = ah.weight.data() + oy * ah.taps;
+      const T* r0 = src + iy[0] * in_w;
+      for (int64_t i = 0; i < in_w; ++i) {
+        row[i] = wy[0] * static_cast<float>(r0[i]);
+      }
+      for (int k = 1; k < ah.taps; ++k) {
+        const T* rk = src + iy[k] * in_w;
+        const float w = wy[k];
+        for (int64_t i = 0; i < in_w; ++i) {
+          row[i] += w * static_cast<float>(rk[i]);
+        }
+      }
+      // horizontal gather
+      const int64_t* ix = aw.index.data();
+      const float* wx = aw.weight.data();
+      for (int64_t ox = 0; ox < out_w; ++ox, ix += aw.taps, wx += aw.taps) {
+        float v = 0;
+        for (int k = 0; k < aw.taps; ++k) {
+          v += wx[k] * row[ix[k]];
+        }
+        out[ox] = aw.valid[ox] ? v : p.extrapolation_value;
+      }
+    }
+  });
+}
@@ -0,0 +1,250 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "common/logging.h"
+#include "common/parallel.h"
+
+// CPU references for the scatter family and the index workloads used to
+// stress them.
+//
+// ScatterUpdate: var is [rows, slice...], y = var with y[indices[i]] =
+// updates[i]. Duplicate indices follow scatterDupMode: SCATTER_DUP_LAST and
+// SCATTER_DUP_FIRST keep the last / first update in index order,
+// SCATTER_DUP_ADD sums them onto var (ScatterAdd). Rows are split into
+// ranges, each range scans the indices in order and applies only its own
+// rows, so every mode is deterministic without atomics.
+//
+// MaskedScatter: y[i] = mask[i] ? value[k] : x[i] with k the number of set
+// mask elements before i, an exclusive prefix sum computed per chunk.
+typedef enum {
+    SCATTER_DUP_LAST = 0,
+    SCATTER_DUP_FIRST = 1,
+    SCATTER_DUP_ADD = 2,
+} scatterDupMode;
+
+// index distributions of ScatterIndices
+typedef enum {
+    INDEX_RANDOM = 0,     // uniform over all rows
+    INDEX_SORTED = 1,     // uniform, ascending
+    INDEX_CLUSTERED = 2,  // runs of nearby rows around a few centers
+    INDEX_HEAVY_DUP = 3,  // most indices hit a small hot set, as embedding lookups do
+} indexDist;
+
+inline const char* IndexDistName(indexDist dist) {
+  switch (dist) {
+    case INDEX_RANDOM: return "random";
+    case INDEX_SORTED: return "sorted";
+    case INDEX_CLUSTERED: return "clustered";
+    case INDEX_HEAVY_DUP: return "heavy_dup";
+  }
+  return "unknown";
+}
+
+namespace scatter {
+
+constexpr int64_t kMaskChunk = 1 << 16;
+// a row range per task is at least this many elements of var
+constexpr int64_t kMinRangeElems = 1 << 16;
+
+// rows [0, rows) split into about 4 ranges per thread
+inline int64_t RangeRows(int64_t rows, int64_t slice) {
+  const int64_t ranges = std::max<int64_t>(1, std::min<int64_t>(4 * NumHostThreads(), rows * slice / kMinRangeElems));
+  return (rows + ranges - 1) / ranges;
+}
+
+// bit j set when mask[j], for 64 bools (bytes 0 or 1, little endian): the
+// multiply gathers the low bit of each byte of a word into its top byte
+inline uint64_t PackMask64(const bool* mask) {
+  uint64_t bits = 0;
+  for (int b = 0; b < 8; ++b) {
+    uint64_t word;
+    std::memcpy(&word, mask + 8 * b, sizeof(word));
+    bits |= ((word * 0x0102040810204080ULL) >> 56) << (8 * b);
+  }
+  return bits;
+}
+
+// set elements of mask[0, n)
+inline int64_t CountSet(const bool* mask, int64_t n) {
+  int64_t total = 0;
+  int64_t i = 0;
+  for (; i + 64 <= n; i += 64) {
+    total += __builtin_popcountll(PackMask64(mask + i));
+  }
+  for (; i < n; ++i) {
+    total += mask[i];
+  }
+  return total;
+}
+
+}  // namespace scatter
+
+// var_dims[0] rows of slice = prod(var_dims[1:]) elements; updates holds
+// num_indices slices. Out-of-range indices are reported and skipped.
+template <typename T, typename I>
+void RefScatterUpdate(const T* var, const std::vector<int64_t>& var_dims, const I* indices, int64_t num_indices,
+                      const T* updates, T* y, scatterDupMode mode = SCATTER_DUP_LAST) {
+  CHECK(!var_dims.empty());
+  const int64_t rows = var_dims[0];
+  int64_t slice = 1;
+  for (size_t d = 1; d < var_dims.size(); ++d) {
+    slice *= var_dims[d];
+  }
+  for (int64_t i = 0; i < num_indices; ++i) {
+    CHECK(indices[i] >= 0 && indices[i] < rows) << "indices[" << i << "] = " << indices[i] << " out of range";
+  }
+  const int64_t range = scatter::RangeRows(rows, slice);
+  ParallelFor((rows + range - 1) / range, [&](int64_t task) {
+    const int64_t r0 = task * range;
+    const int64_t r1 = std::min(rows, r0 + range);
+    std::memcpy(y + r0 * slice, var + r0 * slice, (r1 - r0) * slice * sizeof(T));
+    // rows of this range already written, for SCATTER_DUP_FIRST
+    std::vector<char> written(mode == SCATTER_DUP_FIRST ? r1 - r0 : 0, 0);
+    for (int64_t i = 0; i < num_indices; ++i) {
+      const int64_t r = static_cast<int64_t>(indices[i]);
+      if (r < r0 || r >= r1) {
+        continue;
+      }
+      T* dst = y + r * slice;
+      const T* src = updates + i * slice;
+      if (mode == SCATTER_DUP_ADD) {
+        for (int64_t k = 0; k < slice; ++k) {
+          dst[k] += src[k];
+        }
+      } else if (mode == SCATTER_DUP_LAST || !written[r - r0]) {
+        std::memcpy(dst, src, slice * sizeof(T));
+        if (mode == SCATTER_DUP_FIRST) {
+          written[r - r0] = 1;
+        }
+      }
+    }
+  });
+}
+
+// When the order of duplicate writes is unspecified, any of them is a valid
+// result. Returns the first row of y that is neither var (row not indexed)
+// nor one of the updates aimed at it, -1 if there is none.
+template <typename T, typename I>
+int64_t ScatterUpdateFirstInvalidRow(const T* var, const std::vector<int64_t>& var_dims, const I* indices,
+                                     int64_t num_indices, const T* updates, const T* y) {
+  const int64_t rows = var_dims[0];
+  int64_t slice = 1;
+  for (size_t d = 1; d < var_dims.size(); ++d) {
+    slice *= var_dims[d];
+  }
+  const int64_t range = scatter::RangeRows(rows, slice);
+  const int64_t tasks = (rows + range - 1) / range;
+  std::vector<int64_t> first_invalid(tasks, -1);
+  ParallelFor(tasks, [&](int64_t task) {
+    const int64_t r0 = task * range;
+    const int64_t r1 = std::min(rows, r0 + range);
+    // 0 not indexed, 1 indexed without a match yet, 2 matched
+    std::vector<char> state(r1 - r0, 0);
+    for (int64_t i = 0; i < num_indices; ++i) {
+      const int64_t r = static_cast<int64_t>(indices[i]);
+      if (r < r0 || r >= r1 || state[r - r0] == 2) {
+        continue;
+      }
+      const bool same = std::memcmp(y + r * slice, updates + i * slice, slice * sizeof(T)) == 0;
+      state[r - r0] = same ? 2 : 1;
+    }
+    for (int64_t r = r0; r < r1; ++r) {
+      const bool ok = state[r - r0] == 2 ||
+                      (state[r - r0] == 0 && std::memcmp(y + r * slice, var + r * slice, slice * sizeof(T)) == 0);
+      if (!ok) {
+        first_invalid[task] = r;
+        return;
+      }
+    }
+  });
+  for (auto r : first_invalid) {
+    if (r >= 0) {
+      return r;
+    }
+  }
+  return -1;
+}
+
+// x, mask and y have n elements; value has at least as many as mask has set
+template <typename T>
+void RefMaskedScatter(const T* x, const bool* mask, const T* value, int64_t n, T* y) {
+  const int64_t chunks = (n + scatter::kMaskChunk - 1) / scatter::kMaskChunk;
+  std::vector<int64_t> offset(chunks + 1, 0);
+  ParallelFor(chunks, [&](int64_t c) {
+    const int64_t i0 = c * scatter::kMaskChunk;
+    offset[c + 1] = scatter::CountSet(mask + i0, std::min(scatter::kMaskChunk, n - i0));
+  });
+  for (int64_t c = 0; c < chunks; ++c) {
+    offset[c + 1] += offset[c];
+  }
+  ParallelFor(chunks, [&](int64_t c) {
+    const int64_t i0 = c * scatter::kMaskChunk;
+    const int64_t i1 = std::min(n, i0 + scatter::kMaskChunk);
+    std::memcpy(y + i0, x + i0, (i1 - i0) * sizeof(T));
+    // then visit only the set elements, 64 mask bytes at a time as a bit
+    // word, so a random mask costs no mispredicted branch per element
+    int64_t k = offset[c];
+    int64_t i = i0;
+    for (; i + 64 <= i1; i += 64) {
+      uint64_t bits = scatter::PackMask64(mask + i);
+      if (bits == ~0ULL) {
+        std::memcpy(y + i, value + k, 64 * sizeof(T));
+        k += 64;
+        continue;
+      }
+      for (; bits != 0; bits &= bits - 1) {
+        y[i + __builtin_ctzll(bits)] = value[k++];
+      }
+    }
+    for (; i < i1; ++i) {
+      if (mask[i]) {
+        y[i] = value[k++];
+      }
+    }
+  });
+}
+
+// num_indices row indices in [0, rows) drawn from dist
+template <typename I>
+std::vector<I> ScatterIndices(indexDist dist, int64_t num_indices, int64_t rows, std::mt19937_64& gen) {
+  std::vector<I> indices(num_indices);
+  std::uniform_int_distribution<int64_t> uniform(0, rows - 1);
+  switch (dist) {
+    case INDEX_RANDOM:
+    case INDEX_SORTED:
+      for (auto& v : indices) v = static_cast<I>(uniform(gen));
+      if (dist == INDEX_SORTED) {
+        std::sort(indices.begin(), indices.end());
+      }
+      break;
+    case INDEX_CLUSTERED: {
+      // 16 centers, each index within +-64 rows of one of them
+      const int64_t window = std::min<int64_t>(64, rows);
+      std::vector<int64_t> centers(16);
+      for (auto& c : centers) c = uniform(gen);
+      std::uniform_int_distribution<int64_t> offset(-window, window);
+      for (int64_t i = 0; i < num_indices; ++i) {
+        const int64_t r = centers[(i * centers.size()) / num_indices] + offset(gen);
+        indices[i] = static_cast<I>(std::min(rows - 1, std::max<int64_t>(0, r)));
+      }
+      break;
+    }
+    case INDEX_HEAVY_DUP: {
+      // 90% of the indices on 16 hot rows, the rest uniform
+      std::vector<int64_t> hot(16);
+      for (auto& h : hot) h = uniform(gen);
+      std::uniform_int_distribution<int> pick(0, 9);
+      for (auto& v : indices) {
+        v = static_cast<I>(pick(gen) != 0 ? hot[gen() % hot.size()] : uniform(gen));
+      }
+      break;
+    }
+  }
+  return indices;
+}
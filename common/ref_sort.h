@@ -0,0 +1,186 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "common/float16.h"
+#include "common/parallel.h"
+
+// CPU reference for Sort over the last axis: LSD radix sort with 8-bit
+// digits on order-preserving unsigned keys, stable, so equal values keep
+// their input order in both directions.
+//
+// Floats: -0.0 sorts equal to +0.0 and every NaN sorts above +inf, i.e. last
+// ascending and first descending. Rows are sorted in parallel; a row long
+// enough to be worth it is split into chunks that histogram and scatter in
+// parallel, the chunk order keeps the sort stable.
+template <typename T>
+struct SortKey;
+
+template <>
+struct SortKey<float> {
+  typedef uint32_t type;
+  static type Encode(float v) {
+    uint32_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    if ((bits & 0x7fffffffu) > 0x7f800000u) {
+      bits = 0x7fc00000u;  // canonical NaN
+    } else if (bits == 0x80000000u) {
+      bits = 0;  // -0.0
+    }
+    return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+  }
+};
+
+template <>
+struct SortKey<float16> {
+  typedef uint16_t type;
+  static type Encode(float16 v) {
+    uint16_t bits = v.bits;
+    if ((bits & 0x7fffu) > 0x7c00u) {
+      bits = 0x7e00u;
+    } else if (bits == 0x8000u) {
+      bits = 0;
+    }
+    return (bits & 0x8000u) ? static_cast<uint16_t>(~bits) : static_cast<uint16_t>(bits | 0x8000u);
+  }
+};
+
+template <>
+struct SortKey<bfloat16> {
+  typedef uint16_t type;
+  static type Encode(bfloat16 v) {
+    uint16_t bits = v.bits;
+    if ((bits & 0x7fffu) > 0x7f80u) {
+      bits = 0x7fc0u;
+    } else if (bits == 0x8000u) {
+      bits = 0;
+    }
+    return (bits & 0x8000u) ? static_cast<uint16_t>(~bits) : static_cast<uint16_t>(bits | 0x8000u);
+  }
+};
+
+template <>
+struct SortKey<int64_t> {
+  typedef uint64_t type;
+  static type Encode(int64_t v) { return static_cast<uint64_t>(v) ^ (1ull << 63); }
+};
+
+template <>
+struct SortKey<int32_t> {
+  typedef uint32_t type;
+  static type Encode(int32_t v) { return static_cast<uint32_t>(v) ^ (1u << 31); }
+};
+
+namespace radix {
+
+// rows at least this long are split into chunks
+constexpr int64_t kChunkMin = 1 << 16;
+
+// stable sort of (keys, index) by keys, n elements; tmp buffers of n are
+// used as the other half of a ping-pong pair
+template <typename K>
+void SortRow(K* keys, int32_t* index, K* tmp_keys, int32_t* tmp_index, int64_t n, int threads) {
+  constexpr int kPasses = sizeof(K);
+  const int chunks = static_cast<int>(std::max<int64_t>(1, std::min<int64_t>(threads, n / kChunkMin)));
+  const int64_t chunk_len = (n + chunks - 1) / chunks;
+  // hist[chunk][pass][digit]; a single chunk counts every digit in one read,
+  // chunked rows recount per pass since the keys move between chunks
+  std::vector<int64_t> hist(chunks * kPasses * 256, 0);
+  auto count = [&](const K* src, int first_pass, int last_pass) {
+    ParallelFor(chunks, [&](int64_t c) {
+      int64_t* h = hist.data() + c * kPasses * 256;
+      const int64_t end = std::min(n, (c + 1) * chunk_len);
+      for (int64_t i = c * chunk_len; i < end; ++i) {
+        for (int p = first_pass; p < last_pass; ++p) {
+          ++h[p * 256 + ((src[i] >> (8 * p)) & 0xff)];
+        }
+      }
+    }, chunks);
+  };
+  if (chunks == 1) {
+    count(keys, 0, kPasses);
+  }
+  K* src_keys = keys;
+  int32_t* src_index = index;
+  K* dst_keys = tmp_keys;
+  int32_t* dst_index = tmp_index;
+  for (int p = 0; p < kPasses; ++p) {
+    if (chunks > 1) {
+      count(src_keys, p, p + 1);
+    }
+    // digit-major, chunk-minor offsets keep equal digits in input order
+    int64_t total = 0;
+    bool trivial = false;
+    for (int d = 0; d < 256; ++d) {
+      int64_t digit_count = 0;
+      for (int c = 0; c < chunks; ++c) {
+        int64_t& h = hist[(c * kPasses + p) * 256 + d];
+        const int64_t count = h;
+        h = total;
+        total += count;
+        digit_count += count;
+      }
+      trivial = trivial || digit_count == n;
+    }
+    // every key has the same digit, the pass would not move anything
+    if (trivial) {
+      continue;
+    }
+    const int shift = 8 * p;
+    ParallelFor(chunks, [&](int64_t c) {
+      int64_t* h = hist.data() + (c * kPasses + p) * 256;
+      const int64_t end = std::min(n, (c + 1) * chunk_len);
+      for (int64_t i = c * chunk_len; i < end; ++i) {
+        const int64_t pos = h[(src_keys[i] >> shift) & 0xff]++;
+        dst_keys[pos] = src_keys[i];
+        dst_index[pos] = src_index[i];
+      }
+    }, chunks);
+    std::swap(src_keys, dst_keys);
+    std::swap(src_index, dst_index);
+  }
+  if (src_keys != keys) {
+    std::copy(src_keys, src_keys + n, keys);
+    std::copy(src_index, src_index + n, index);
+  }
+}
+
+}  // namespace radix
+
+// x, y: rows x cols; indices: position of y in the input row, as Sort's
+// int32 output
+template <typename T>
+void RefSort(const T* x, int64_t rows, int64_t cols, bool descending, T* y, int32_t* indices) {
+  typedef typename SortKey<T>::type K;
+  const int row_threads = rows >= NumHostThreads() ? 1 : NumHostThreads();
+  auto sort_row = [&](int64_t r, int threads) {
+    thread_local std::vector<K> keys;
+    thread_local std::vector<K> tmp_keys;
+    thread_local std::vector<int32_t> tmp_index;
+    keys.resize(cols);
+    tmp_keys.resize(cols);
+    tmp_index.resize(cols);
+    const T* src = x + r * cols;
+    int32_t* index = indices + r * cols;
+    for (int64_t i = 0; i < cols; ++i) {
+      const K k = SortKey<T>::Encode(src[i]);
+      // inverted keys sort descending and stay stable
+      keys[i] = descending ? static_cast<K>(~k) : k;
+      index[i] = static_cast<int32_t>(i);
+    }
+    radix::SortRow(keys.data(), index, tmp_keys.data(), tmp_index.data(), cols, threads);
+    for (int64_t i = 0; i < cols; ++i) {
+      y[r * cols + i] = src[index[i]];
+    }
+  };
+  if (row_threads == 1) {
+    ParallelFor(rows, [&](int64_t r) { sort_row(r, 1); });
+  } else {
+    for (int64_t r = 0; r < rows; ++r) {
+      sort_row(r, row_threads);
+    }
+  }
+}
@@ -0,0 +1,287 @@
+#pragma once
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "common/nputensor.h"
+
+// Tensor handed to the StreamingExecutor.
+//
+// Split tensors live in host memory (allocate with aclrtMallocHost so the
+// async copies can overlap) and are cut into chunks along dim 0. Resident
+// tensors (broadcast operands, host-placed axes, ...) are passed to every
+// chunk unchanged.
+struct StreamTensor {
+  aclDataType data_type;
+  std::vector<int64_t> dims;
+  aclFormat format;
+  void* host_ptr;
+  aclTensorDesc* desc;
+  aclDataBuffer* buffer;
+
+  static StreamTensor Split(aclDataType data_type, const std::vector<int64_t>& dims, aclFormat format, void* host_ptr) {
+    return StreamTensor{data_type, dims, format, host_ptr, nullptr, nullptr};
+  }
+
+  template <typename T>
+  static StreamTensor Resident(npuTensor<T>* tensor) {
+    return StreamTensor{ACL_DT_UNDEFINED, {}, ACL_FORMAT_ND, nullptr, tensor->desc, tensor->buffer};
+  }
+
+  bool split() const { return host_ptr != nullptr; }
+
+  // bytes of one dim-0 slice
+  size_t row_bytes() const {
+    size_t numel = 1;
+    for (size_t i = 1; i < dims.size(); ++i) {
+      numel *= dims[i];
+    }
+    return numel * aclDataTypeSize(data_type);
+  }
+};
+
+struct StreamStats {
+  int64_t chunks;
+  size_t h2d_bytes;
+  size_t d2h_bytes;
+};
+
+// Runs an op over inputs larger than we want resident on device.
+//
+// The split inputs are processed `rows_per_chunk` dim-0 rows at a time with
+// `num_buffers` (2 = double, 3 = triple buffering) device slots. Upload,
+// execute and download run on three streams chained by events, so while
+// chunk i executes chunk i+1 is uploading and chunk i-1 is downloading.
+class StreamingExecutor {
+ public:
+  StreamingExecutor(const std::string& op_type, const aclopAttr* attr, size_t chunk_bytes, int num_buffers = 2)
+      : op_type_(op_type), attr_(attr), chunk_bytes_(chunk_bytes), num_buffers_(num_buffers) {
+    CHECK_GE(num_buffers_, 2);
+    CHECK_LE(num_buffers_, 3);
+    ACL_CALL(aclrtCreateStream(&h2d_stream_));
+    ACL_CALL(aclrtCreateStream(&exec_stream_));
+    ACL_CALL(aclrtCreateStream(&d2h_stream_));
+    for (int s = 0; s < num_buffers_; ++s) {
+      for (auto events : {&uploaded_, &executed_, &downloaded_}) {
+        aclrtEvent event;
+        ACL_CALL(aclrtCreateEvent(&event));
+        events->push_back(event);
+      }
+    }
+  }
+
+  ~StreamingExecutor() {
+    for (auto events : {&uploaded_, &executed_, &downloaded_}) {
+      for (auto event : *events) {
+        aclrtDestroyEvent(event);
+      }
+    }
+    aclopDestroyAttr(add_attr_);
+    aclrtDestroyStream(h2d_stream_);
+    aclrtDestroyStream(exec_stream_);
+    aclrtDestroyStream(d2h_stream_);
+  }
+
+  // Element-wise ops: every split input and every output share dim 0.
+  StreamStats Run(const std::vector<StreamTensor>& inputs, const std::vector<StreamTensor>& outputs) {
+    return Execute(inputs, outputs, false);
+  }
+
+  // Reduction over dim 0 (e.g. ReduceSum with axes containing 0): each chunk
+  // produces a partial result of the full output shape which is accumulated
+  // on device with Add, only the final result is downloaded.
+  StreamStats RunReduce(const std::vector<StreamTensor>& inputs, const StreamTensor& output) {
+    return Execute(inputs, {output}, true);
+  }
+
+ private:
+  struct Slot {
+    std::vector<void *> device_ptrs;   // one per split tensor, inputs then outputs
+    std::vector<aclDataBuffer *> buffers;
+  };
+
+  StreamStats Execute(const std::vector<StreamTensor>& inputs, const std::vector<StreamTensor>& outputs, bool reduce) {
+    // all split tensors, inputs first
+    std::vector<const StreamTensor *> split;
+    int64_t rows = -1;
+    size_t max_row_bytes = 0;
+    for (const auto& t : inputs) {
+      if (t.split()) {
+        split.push_back(&t);
+        rows = t.dims[0];
+        max_row_bytes = std::max(max_row_bytes, t.row_bytes());
+      }
+    }
+    CHECK_GT(rows, 0) << "at least one input must be split";
+    const size_t num_split_inputs = split.size();
+    if (!reduce) {
+      for (const auto& t : outputs) {
+        CHECK(t.split()) << "element-wise outputs must be host tensors";
+        split.push_back(&t);
+        max_row_bytes = std::max(max_row_bytes, t.row_bytes());
+      }
+    }
+    for (auto t : split) {
+      CHECK_EQ(t->dims[0], rows) << "split tensors must share dim 0";
+    }
+    const int64_t rows_per_chunk = std::max<int64_t>(1, chunk_bytes_ / max_row_bytes);
+    const int64_t num_chunks = (rows + rows_per_chunk - 1) / rows_per_chunk;
+    VLOG(1) << op_type_ << " streaming " << rows << " rows in " << num_chunks << " chunks of " << rows_per_chunk;
+
+    // device slots sized for a full chunk
+    std::vector<Slot> slots(num_buffers_);
+    for (auto& slot : slots) {
+      for (auto t : split) {
+        void* ptr = nullptr;
+        size_t bytes = rows_per_chunk * t->row_bytes();
+        ACL_CALL(aclrtMalloc(&ptr, bytes, ACL_MEM_MALLOC_HUGE_FIRST));
+        slot.device_ptrs.push_back(ptr);
+        slot.buffers.push_back(aclCreateDataBuffer(ptr, bytes));
+      }
+    }
+
+    // reduction: per-slot partial output and one accumulator
+    const StreamTensor* reduce_out = reduce ? &outputs[0] : nullptr;
+    aclTensorDesc* reduce_desc = nullptr;
+    size_t reduce_bytes = 0;
+    void* acc_ptr = nullptr;
+    aclDataBuffer* acc_buffer = nullptr;
+    std::vector<void *> partial_ptrs;
+    std::vector<aclDataBuffer *> partial_buffers;
+    if (reduce) {
+      reduce_desc = aclCreateTensorDesc(reduce_out->data_type, reduce_out->dims.size(), reduce_out->dims.data(), reduce_out->format);
+      reduce_bytes = aclGetTensorDescSize(reduce_desc);
+      ACL_CALL(aclrtMalloc(&acc_ptr, reduce_bytes, ACL_MEM_MALLOC_HUGE_FIRST));
+      acc_buffer = aclCreateDataBuffer(acc_ptr, reduce_bytes);
+      for (int s = 0; s < num_buffers_; ++s) {
+        void* ptr = nullptr;
+        ACL_CALL(aclrtMalloc(&ptr, reduce_bytes, ACL_MEM_MALLOC_HUGE_FIRST));
+        partial_ptrs.push_back(ptr);
+        partial_buffers.push_back(aclCreateDataBuffer(ptr, reduce_bytes));
+      }
+    }
+
+    StreamStats stats{num_chunks, 0, 0};
+    for (int64_t c = 0; c < num_chunks; ++c) {
+      const int s = c % num_buffers_;
+      Slot& slot = slots[s];
+      const int64_t row_begin = c * rows_per_chunk;
+      const int64_t chunk_rows = std::min(rows_per_chunk, rows - row_begin);
+
+      // upload - wait until the slot's previous chunk has left the device
+      if (c >= num_buffers_) {
+        ACL_CALL(aclrtStreamWaitEvent(h2d_stream_, downloaded_[s]));
+      }
+      for (size_t i = 0; i < num_split_inputs; ++i) {
+        const size_t bytes = chunk_rows * split[i]->row_bytes();
+        const char* src = static_cast<const char *>(split[i]->host_ptr) + row_begin * split[i]->row_bytes();
+        ACL_CALL(aclrtMemcpyAsync(slot.device_ptrs[i], bytes, src, bytes, ACL_MEMCPY_HOST_TO_DEVICE, h2d_stream_));
+        ACL_CALL(aclUpdateDataBuffer(slot.buffers[i], slot.device_ptrs[i], bytes));
+        stats.h2d_bytes += bytes;
+      }
+      ACL_CALL(aclrtRecordEvent(uploaded_[s], h2d_stream_));
+
+      // execute
+      ACL_CALL(aclrtStreamWaitEvent(exec_stream_, uploaded_[s]));
+      std::vector<aclTensorDesc *> input_descs;
+      std::vector<aclDataBuffer *> input_buffers;
+      size_t split_index = 0;
+      for (const auto& t : inputs) {
+        input_descs.push_back(t.split() ? ChunkDesc(t, chunk_rows) : t.desc);
+        input_buffers.push_back(t.split() ? slot.buffers[split_index++] : t.buffer);
+      }
+      std::vector<aclTensorDesc *> output_descs;
+      std::vector<aclDataBuffer *> output_buffers;
+      if (reduce) {
+        output_descs.push_back(reduce_desc);
+        output_buffers.push_back(c == 0 ? acc_buffer : partial_buffers[s]);
+      } else {
+        for (size_t i = num_split_inputs; i < split.size(); ++i) {
+          const size_t bytes = chunk_rows * split[i]->row_bytes();
+          ACL_CALL(aclUpdateDataBuffer(slot.buffers[i], slot.device_ptrs[i], bytes));
+          output_descs.push_back(ChunkDesc(*split[i], chunk_rows));
+          output_buffers.push_back(slot.buffers[i]);
+        }
+      }
+      ACL_CALL(aclopCompileAndExecute(op_type_.c_str(),
+                input_descs.size(), input_descs.data(), input_buffers.data(),
+                output_descs.size(), output_descs.data(), output_buffers.data(),
+                attr_, ACL_ENGINE_SYS, ACL_COMPILE_SYS, NULL, exec_stream_));
+      if (reduce && c > 0) {
+        // acc = acc + partial, element-wise so updating acc in place is safe
+        std::vector<aclTensorDesc *> add_descs{reduce_desc, reduce_desc};
+        std::vector<aclDataBuffer *> add_inputs{acc_buffer, partial_buffers[s]};
+        ACL_CALL(aclopCompileAndExecute("Add",
+                  add_descs.size(), add_descs.data(), add_inputs.data(),
+                  1, &reduce_desc, &acc_buffer,
+                  add_attr_, ACL_ENGINE_SYS, ACL_COMPILE_SYS, NULL, exec_stream_));
+      }
+      ACL_CALL(aclrtRecordEvent(executed_[s], exec_stream_));
+
+      // download
+      ACL_CALL(aclrtStreamWaitEvent(d2h_stream_, executed_[s]));
+      for (size_t i = num_split_inputs; i < split.size(); ++i) {
+        const size_t bytes = chunk_rows * split[i]->row_bytes();
+        char* dst = static_cast<char *>(split[i]->host_ptr) + row_begin * split[i]->row_bytes();
+        ACL_CALL(aclrtMemcpyAsync(dst, bytes, slot.device_ptrs[i], bytes, ACL_MEMCPY_DEVICE_TO_HOST, d2h_stream_));
+        stats.d2h_bytes += bytes;
+      }
+      ACL_CALL(aclrtRecordEvent(downloaded_[s], d2h_stream_));
+    }
+    ACL_CALL(aclrtSynchronizeStream(d2h_stream_));
+
+    if (reduce) {
+      ACL_CALL(aclrtSynchronizeStream(exec_stream_));
+      ACL_CALL(aclrtMemcpy(reduce_out->host_ptr, reduce_bytes, acc_ptr, reduce_bytes, ACL_MEMCPY_DEVICE_TO_HOST));
+      stats.d2h_bytes += reduce_bytes;
+      for (int s = 0; s < num_buffers_; ++s) {
+        ACL_CALL(aclDestroyDataBuffer(partial_buffers[s]));
+        ACL_CALL(aclrtFree(partial_ptrs[s]));
+      }
+      ACL_CALL(aclDestroyDataBuffer(acc_buffer));
+      ACL_CALL(aclrtFree(acc_ptr));
+      aclDestroyTensorDesc(reduce_desc);
+    }
+    for (auto& slot : slots) {
+      for (size_t i = 0; i < slot.buffers.size(); ++i) {
+        ACL_CALL(aclDestroyDataBuffer(slot.buffers[i]));
+        ACL_CALL(aclrtFree(slot.device_ptrs[i]));
+      }
+    }
+    for (auto& it : chunk_descs_) {
+      aclDestroyTensorDesc(it.second);
+    }
+    chunk_descs_.clear();
+    return stats;
+  }
+
+  // desc of a split tensor with dim 0 cut to `chunk_rows`, at most two
+  // distinct shapes per tensor (full chunk and tail) so compiles are cached
+  aclTensorDesc* ChunkDesc(const StreamTensor& t, int64_t chunk_rows) {
+    auto key = std::make_pair(&t, chunk_rows);
+    auto it = chunk_descs_.find(key);
+    if (it != chunk_descs_.end()) {
+      return it->second;
+    }
+    std::vector<int64_t> dims = t.dims;
+    dims[0] = chunk_rows;
+    auto desc = aclCreateTensorDesc(t.data_type, dims.size(), dims.data(), t.format);
+    chunk_descs_[key] = desc;
+    return desc;
+  }
+
+  std::string op_type_;
+  const aclopAttr* attr_;
+  const aclopAttr* add_attr_ = aclopCreateAttr();
+  size_t chunk_bytes_;
+  int num_buffers_;
+  aclrtStream h2d_stream_ = nullptr;
+  aclrtStream exec_stream_ = nullptr;
+  aclrtStream d2h_stream_ = nullptr;
+  std::vector<aclrtEvent> uploaded_;
+  std::vector<aclrtEvent> executed_;
+  std::vector<aclrtEvent> downloaded_;
+  std::map<std::pair<const StreamTensor *, int64_t>, aclTensorDesc *> chunk_descs_;
+};
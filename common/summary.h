@@ -0,0 +1,328 @@
+#pragma once
+
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "common/compare.h"
+#include "common/float16.h"
+#include "common/parallel.h"
+
+// Summary of a host buffer in one pass: min / max / mean / std over the
+// finite values, NaN and Inf counts and a 64-bit hash of the bytes.
+//
+// Chunks of 64K elements run on ParallelFor. Each chunk is read in blocks
+// converted to one compute type (float for float / float16, double
+// otherwise, so int64 values beyond 2^53 are rounded) over fixed lanes, and
+// hashed with an xxh64-style 4-lane round. Per-chunk means and squared
+// deviations are merged pairwise, and the chunk hashes are folded in order,
+// so the result does not depend on the thread count. The hash identifies
+// contents of one dtype, it is not xxh64 of the buffer.
+struct TensorSummary {
+  int64_t count = 0;
+  int64_t nan = 0;
+  int64_t inf = 0;
+  double min = 0;   // finite values only, 0 if there are none
+  double max = 0;
+  double mean = 0;
+  double std = 0;   // population std
+  uint64_t hash = 0;
+
+  void Print(std::ostream& os = std::cout) const {
+    char line[256];
+    snprintf(line, sizeof(line), "%" PRId64 " elements, min %g max %g mean %g std %g, nan %" PRId64 " inf %" PRId64
+             ", hash %016" PRIx64, count, min, max, mean, std, nan, inf, hash);
+    os << line << std::endl;
+  }
+};
+
+namespace summary {
+
+constexpr int64_t kChunk = 1 << 16;
+constexpr int64_t kBlock = 1024;
+constexpr int kLanes = 16;
+constexpr uint64_t kPrime1 = 0x9E3779B185EBCA87ULL;
+constexpr uint64_t kPrime2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr uint64_t kPrime3 = 0x165667B19E3779F9ULL;
+constexpr uint64_t kPrime4 = 0x85EBCA77C2B2AE63ULL;
+constexpr uint64_t kPrime5 = 0x27D4EB2F165667C5ULL;
+
+inline uint64_t Rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+inline uint64_t Round(uint64_t acc, uint64_t input) { return Rotl(acc + input * kPrime2, 31) * kPrime1; }
+inline uint64_t Merge(uint64_t acc, uint64_t lane) { return (acc ^ Round(0, lane)) * kPrime1 + kPrime4; }
+inline uint64_t Avalanche(uint64_t h) {
+  h ^= h >> 33;
+  h *= kPrime2;
+  h ^= h >> 29;
+  h *= kPrime3;
+  return h ^ (h >> 32);
+}
+
+inline uint64_t Hash(const unsigned char* p, size_t bytes, uint64_t seed) {
+  const unsigned char* end = p + bytes;
+  uint64_t h;
+  if (bytes >= 32) {
+    // four independent lanes keep the multipliers busy
+    uint64_t a0 = seed + kPrime1 + kPrime2;
+    uint64_t a1 = seed + kPrime2;
+    uint64_t a2 = seed;
+    uint64_t a3 = seed - kPrime1;
+    for (; p + 32 <= end; p += 32) {
+      uint64_t w[4];
+      std::memcpy(w, p, sizeof(w));
+      a0 = Round(a0, w[0]);
+      a1 = Round(a1, w[1]);
+      a2 = Round(a2, w[2]);
+      a3 = Round(a3, w[3]);
+    }
+    h = Rotl(a0, 1) + Rotl(a1, 7) + Rotl(a2, 12) + Rotl(a3, 18);
+    h = Merge(Merge(Merge(Merge(h, a0), a1), a2), a3);
+  } else {
+    h = seed + kPrime5;
+  }
+  h += bytes;
+  for (; p + 8 <= end; p += 8) {
+    uint64_t w;
+    std::memcpy(&w, p, sizeof(w));
+    h = Rotl(h ^ Round(0, w), 27) * kPrime1 + kPrime4;
+  }
+  for (; p < end; ++p) {
+    h = Rotl(h ^ (*p * kPrime5), 11) * kPrime1;
+  }
+  return Avalanche(h);
+}
+
+// statistics of one chunk, mean and squared deviations for the pairwise merge
+struct Partial {
+  int64_t finite = 0;
+  int64_t nan = 0;
+  int64_t inf = 0;
+  double min = std::numeric_limits<double>::infinity();
+  double max = -std::numeric_limits<double>::infinity();
+  double mean = 0;
+  double m2 = 0;
+  uint64_t hash = 0;
+
+  void Add(int64_t n, double block_mean, double block_m2) {
+    if (n == 0) {
+      return;
+    }
+    const int64_t total = finite + n;
+    const double delta = block_mean - mean;
+    mean += delta * n / total;
+    m2 += block_m2 + delta * delta * (static_cast<double>(finite) * n / total);
+    finite = total;
+  }
+};
+
+// mean and squared deviations of the finite values of a block, summed over
+// lanes of A
+template <typename A, typename C>
+void Moments(const C* v, int64_t finite, double* mean, double* m2) {
+  A sum[kLanes];
+  for (int l = 0; l < kLanes; ++l) {
+    sum[l] = A(0);
+  }
+  for (int64_t i = 0; i < kBlock; i += kLanes) {
+    for (int l = 0; l < kLanes; ++l) {
+      const A x = static_cast<A>(v[i + l]);
+      sum[l] += (x - x) == A(0) ? x : A(0);
+    }
+  }
+  double block_sum = 0;
+  for (int l = 0; l < kLanes; ++l) {
+    block_sum += sum[l];
+  }
+  const A m = static_cast<A>(block_sum / finite);
+  for (int l = 0; l < kLanes; ++l) {
+    sum[l] = A(0);
+  }
+  for (int64_t i = 0; i < kBlock; i += kLanes) {
+    for (int l = 0; l < kLanes; ++l) {
+      const A x = static_cast<A>(v[i + l]);
+      const A d = (x - x) == A(0) ? x - m : A(0);
+      sum[l] += d * d;
+    }
+  }
+  double block_m2 = 0;
+  for (int l = 0; l < kLanes; ++l) {
+    block_m2 += sum[l];
+  }
+  *mean = block_sum / finite;
+  *m2 = block_m2;
+}
+
+// n <= kBlock elements, the block is padded with NaN so every loop has a
+// constant trip count and vectorizes
+template <typename T>
+void Block(const T* x, int64_t n, Partial* p) {
+  typedef typename compare::Traits<T>::compute C;
+  const C inf = std::numeric_limits<C>::infinity();
+  C v[kBlock];
+  compare::Load(x, n, v);
+  std::fill(v + n, v + kBlock, std::numeric_limits<C>::quiet_NaN());
+
+  int32_t nan = 0;
+  int32_t infs = 0;
+  for (int64_t i = 0; i < kBlock; ++i) {
+    // x - x is 0 only for finite x
+    const bool finite = (v[i] - v[i]) == C(0);
+    nan += v[i] != v[i];
+    infs += !finite & (v[i] == v[i]);
+  }
+  nan -= static_cast<int32_t>(kBlock - n);
+  const int64_t finite = n - nan - infs;
+  p->nan += nan;
+  p->inf += infs;
+  if (finite == 0) {
+    return;
+  }
+
+  C lo[kLanes];
+  C hi[kLanes];
+  for (int l = 0; l < kLanes; ++l) {
+    lo[l] = inf;
+    hi[l] = -inf;
+  }
+  for (int64_t i = 0; i < kBlock; i += kLanes) {
+    for (int l = 0; l < kLanes; ++l) {
+      const C x = v[i + l];
+      const bool f = (x - x) == C(0);
+      const C xl = f ? x : inf;
+      const C xh = f ? x : -inf;
+      lo[l] = xl < lo[l] ? xl : lo[l];
+      hi[l] = xh > hi[l] ? xh : hi[l];
+    }
+  }
+  for (int l = 0; l < kLanes; ++l) {
+    p->min = std::min(p->min, static_cast<double>(lo[l]));
+    p->max = std::max(p->max, static_cast<double>(hi[l]));
+  }
+  double mean = 0;
+  double m2 = 0;
+  Moments<C>(v, finite, &mean, &m2);
+  if (!std::isfinite(mean) || !std::isfinite(m2)) {
+    // float sums overflow near FLT_MAX
+    Moments<double>(v, finite, &mean, &m2);
+  }
+  p->Add(finite, mean, m2);
+}
+
+// %g like std::ostream, integers in full
+inline int Format(char* buf, size_t len, double v) { return snprintf(buf, len, "%g", v); }
+inline int Format(char* buf, size_t len, float v) { return snprintf(buf, len, "%g", v); }
+inline int Format(char* buf, size_t len, float16 v) { return snprintf(buf, len, "%g", static_cast<float>(v)); }
+inline int Format(char* buf, size_t len, bfloat16 v) { return snprintf(buf, len, "%g", static_cast<float>(v)); }
+inline int Format(char* buf, size_t len, bool v) { return snprintf(buf, len, "%d", v ? 1 : 0); }
+inline int Format(char* buf, size_t len, char v) { return snprintf(buf, len, "%c", v); }
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value, int>::type Format(char* buf, size_t len, T v) {
+  return std::is_signed<T>::value ? snprintf(buf, len, "%lld", static_cast<long long>(v))
+                                  : snprintf(buf, len, "%llu", static_cast<unsigned long long>(v));
+}
+
+// appends "v, " for x[begin, end)
+template <typename T>
+void AppendValues(const T* x, int64_t begin, int64_t end, std::string* out) {
+  char buf[64];
+  for (int64_t i = begin; i < end; ++i) {
+    const int len = Format(buf, sizeof(buf), x[i]);
+    out->append(buf, std::min<size_t>(len, sizeof(buf) - 1));
+    out->append(", ");
+  }
+}
+
+}  // namespace summary
+
+template <typename T>
+TensorSummary Summarize(const T* x, int64_t n) {
+  const int64_t chunks = (n + summary::kChunk - 1) / summary::kChunk;
+  std::vector<summary::Partial> partials(chunks);
+  ParallelFor(chunks, [&](int64_t c) {
+    const int64_t i0 = c * summary::kChunk;
+    const int64_t i1 = std::min(n, i0 + summary::kChunk);
+    for (int64_t i = i0; i < i1; i += summary::kBlock) {
+      summary::Block(x + i, std::min(summary::kBlock, i1 - i), &partials[c]);
+    }
+    partials[c].hash = summary::Hash(reinterpret_cast<const unsigned char *>(x + i0), (i1 - i0) * sizeof(T), c);
+  });
+
+  TensorSummary s;
+  s.count = n;
+  summary::Partial total;
+  uint64_t hash = summary::kPrime5 + n * sizeof(T);
+  for (const auto& p : partials) {
+    total.nan += p.nan;
+    total.inf += p.inf;
+    total.min = std::min(total.min, p.min);
+    total.max = std::max(total.max, p.max);
+    total.Add(p.finite, p.mean, p.m2);
+    hash = summary::Merge(hash, p.hash);
+  }
+  s.nan = total.nan;
+  s.inf = total.inf;
+  if (total.finite > 0) {
+    s.min = total.min;
+    s.max = total.max;
+    s.mean = total.mean;
+    s.std = std::sqrt(total.m2 / total.finite);
+  }
+  s.hash = summary::Avalanche(hash);
+  return s;
+}
+
+// hash of raw bytes, e.g. op inputs of any dtype; chunks of 4 MB are hashed
+// on ParallelFor and folded in order like the hash of Summarize()
+inline uint64_t HashBytes(const void* p, size_t bytes) {
+  constexpr size_t kBytes = 4 << 20;
+  const unsigned char* x = static_cast<const unsigned char *>(p);
+  const int64_t chunks = (bytes + kBytes - 1) / kBytes;
+  std::vector<uint64_t> hashes(chunks);
+  ParallelFor(chunks, [&](int64_t c) {
+    hashes[c] = summary::Hash(x + c * kBytes, std::min(kBytes, bytes - c * kBytes), c);
+  });
+  uint64_t hash = summary::kPrime5 + bytes;
+  for (auto h : hashes) {
+    hash = summary::Merge(hash, h);
+  }
+  return summary::Avalanche(hash);
+}
+
+// Print mode of npuTensor::Print: tensors longer than 2 * kPreview elements
+// show kPreview elements from each end and a TensorSummary, NPU_PRINT_FULL=1
+// prints every element.
+constexpr int64_t kPreview = 8;
+
+inline bool PrintFull() {
+  static bool full = [] {
+    const char* env = std::getenv("NPU_PRINT_FULL");
+    return env != nullptr && atoi(env) != 0;
+  }();
+  return full;
+}
+
+template <typename T>
+void PrintTensor(const std::string& msg, const T* x, int64_t n, std::ostream& os = std::cout) {
+  std::string line = msg + " = [";
+  if (PrintFull() || n <= 2 * kPreview) {
+    summary::AppendValues(x, 0, n, &line);
+    line += "]";
+    os << line << std::endl;
+    return;
+  }
+  summary::AppendValues(x, 0, kPreview, &line);
+  line += "..., ";
+  summary::AppendValues(x, n - kPreview, n, &line);
+  line += "]";
+  os << line << std::endl << "  ";
+  Summarize(x, n).Print(os);
+}
@@ -0,0 +1,187 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "acl/acl.h"
+#include "common/benchmark.h"
+#include "common/dtype.h"
+#include "common/opsignature.h"
+
+// dtype x format matrix of one op case, run in one process.
+//
+// The element types and storage formats are compile-time lists:
+//
+//   typedef TypedMatrix<TypeList<float, float16, int64_t>, FormatList<ACL_FORMAT_ND, ACL_FORMAT_NCHW>> M;
+//   M::Run([&](auto tag, aclFormat format) {
+//     typedef typename decltype(tag)::type T;
+//     MatrixCell cell = NewCell<T>("Add", format);
+//     ...  // build npuTensor<T>s, TimeCell(launch, ...), verify
+//     return cell;
+//   }, &table);
+//
+// The case is instantiated once per type, so it is written once instead of
+// once per dtype. Every cell launches once to compile and then runs warm,
+// kernels stay in the op compiler's cache for the rest of the process. A
+// first launch that fails marks the cell unsupported, the table then shows
+// which dtype / format each op supports on this CANN version and which one
+// is fastest. Formats are origin = storage formats (ND, NCHW, NHWC, ...).
+template <typename... T>
+struct TypeList {};
+template <aclFormat... F>
+struct FormatList {};
+
+template <typename T>
+struct TypeTag {
+  typedef T type;
+};
+
+struct MatrixCell {
+  std::string op;
+  aclDataType dtype = ACL_FLOAT;
+  aclFormat format = ACL_FORMAT_ND;
+  aclError ret = ACL_SUCCESS;  // of the first, compiling launch
+  bool verified = false;       // output matched the CPU reference
+  double compile_ms = 0;       // first launch including compile
+  double latency_ms = 0;       // warm launch
+  int64_t elements = 0;        // output elements per launch
+  int64_t bytes = 0;           // bytes read and written per launch
+  bool reference = true;       // false: no CPU reference, `verified` is meaningless
+  std::string config;          // swept parameters of the cell, if any
+  std::string golden;          // regression store status (common/golden_store.h), if checked
+
+  bool supported() const { return ret == ACL_SUCCESS; }
+  const char* status() const {
+    return !supported() ? "unsupported" : !reference ? "ran" : verified ? "ok" : "mismatch";
+  }
+};
+
+template <typename T>
+MatrixCell NewCell(const std::string& op, aclFormat format) {
+  MatrixCell cell;
+  cell.op = op;
+  cell.dtype = sig::DType<T>::value;
+  cell.format = format;
+  return cell;
+}
+
+// `launch` returns the aclError of one launch; compiles on the first call,
+// then times `iters` synchronized warm launches. False if the cell is not
+// supported.
+template <typename Launch>
+bool TimeCell(Launch launch, int iters, aclrtStream stream, MatrixCell* cell) {
+  Timer timer;
+  cell->ret = launch();
+  if (cell->ret == ACL_SUCCESS) {
+    cell->ret = aclrtSynchronizeStream(stream);
+  }
+  cell->compile_ms = timer.ElapsedMs();
+  if (cell->ret != ACL_SUCCESS) {
+    return false;
+  }
+  aclError ret = ACL_SUCCESS;
+  timer.Start();
+  for (int i = 0; i < iters && ret == ACL_SUCCESS; ++i) {
+    ret = launch();
+    if (ret == ACL_SUCCESS) {
+      ret = aclrtSynchronizeStream(stream);
+    }
+  }
+  cell->latency_ms = timer.ElapsedMs() / std::max(iters, 1);
+  cell->ret = ret;
+  return ret == ACL_SUCCESS;
+}
+
+class MatrixTable {
+ public:
+  void Add(const MatrixCell& cell) { cells_.push_back(cell); }
+  const std::vector<MatrixCell>& cells() const { return cells_; }
+
+  void Print(std::ostream& os = std::cout) const {
+    const bool configs =
+        std::any_of(cells_.begin(), cells_.end(), [](const MatrixCell& c) { return !c.config.empty(); });
+    const bool goldens =
+        std::any_of(cells_.begin(), cells_.end(), [](const MatrixCell& c) { return !c.golden.empty(); });
+    os << std::setw(18) << "op" << std::setw(7) << "dtype" << std::setw(9) << "format" << std::setw(13) << "status"
+       << std::setw(12) << "compile_ms" << std::setw(12) << "latency_ms" << std::setw(11) << "Melem/s"
+       << std::setw(9) << "GB/s" << (goldens ? "   golden" : "") << (configs ? "  config" : "") << std::endl;
+    for (const auto& c : cells_) {
+      os << std::setw(18) << c.op << std::setw(7) << DataTypeName(c.dtype) << std::setw(9) << FormatName(c.format)
+         << std::setw(13) << c.status();
+      if (!c.supported()) {
+        os << std::setw(12) << "error " << std::setw(32) << std::left << c.ret << std::right;
+      } else {
+        // fixed precision, and a space ahead of each field so wide values cannot run together
+        const std::ios::fmtflags flags = os.flags();
+        const std::streamsize precision = os.precision();
+        os << std::fixed << std::setprecision(4) << " " << std::setw(11) << c.compile_ms << " " << std::setw(11)
+           << c.latency_ms << std::setprecision(1) << " " << std::setw(10) << c.elements / (c.latency_ms * 1e3)
+           << " " << std::setw(8) << c.bytes / (c.latency_ms * 1e6);
+        os.flags(flags);
+        os.precision(precision);
+      }
+      if (goldens) {
+        os << " " << std::setw(8) << c.golden;
+      }
+      if (configs) {
+        os << "  " << c.config;
+      }
+      os << std::endl;
+    }
+  }
+
+  // fastest verified dtype / format per op
+  void PrintBest(std::ostream& os = std::cout) const {
+    std::map<std::string, const MatrixCell *> best;
+    std::vector<std::string> order;
+    for (const auto& c : cells_) {
+      if (best.find(c.op) == best.end()) {
+        best[c.op] = nullptr;
+        order.push_back(c.op);
+      }
+      const MatrixCell*& b = best[c.op];
+      if (c.supported() && c.verified && (b == nullptr || c.latency_ms < b->latency_ms)) {
+        b = &c;
+      }
+    }
+    for (const auto& op : order) {
+      const MatrixCell* b = best[op];
+      os << op << ": ";
+      if (b == nullptr) {
+        os << "no supported and verified dtype" << std::endl;
+      } else {
+        os << DataTypeName(b->dtype) << " " << FormatName(b->format) << ", " << b->latency_ms << " ms" << std::endl;
+      }
+    }
+  }
+
+ private:
+  std::vector<MatrixCell> cells_;
+};
+
+template <typename Types, typename Formats>
+struct TypedMatrix;
+
+template <typename... T, aclFormat... F>
+struct TypedMatrix<TypeList<T...>, FormatList<F...>> {
+  // `c(TypeTag<T>(), format)` returns the MatrixCell of one dtype / format
+  template <typename Case>
+  static void Run(Case c, MatrixTable* table) {
+    const int unused[] = {0, (RunType<T>(c, table), 0)...};
+    (void)unused;
+  }
+
+ private:
+  template <typename U, typename Case>
+  static void RunType(Case& c, MatrixTable* table) {
+    const aclFormat formats[] = {F...};
+    for (aclFormat format : formats) {
+      table->Add(c(TypeTag<U>(), format));
+    }
+  }
+};
@@ -4,8 +4,11 @@
 # for example: 
 #   sh run_demo.sh Add
 #   sh run_demo.sh Sort
+#   sh run_demo.sh Bench_Inplace 1024 10 # extra args are passed to the binary
+#   sh run_demo.sh ReduceSum shape=8x64x56x56 axes=[2,3] # op parameters, see common/cmdline.h
 
 TARGET_EXE=${1:-Add}
+[ $# -gt 0 ] && shift
 
 # update TARGET_EXE for the operator
 
@@ -37,6 +40,29 @@ TARGET_EXE=${1:-Add}
 # TARGET_EXE=Tile
 # TARGET_EXE=Sort
 
+# ----------- BENCH -----------
+# TARGET_EXE=Bench_Inplace
+# TARGET_EXE=Bench_Streaming
+# TARGET_EXE=Bench_Bandwidth
+# TARGET_EXE=Bench_ZeroCopy
+# TARGET_EXE=Bench_ConstInputs
+# TARGET_EXE=Bench_DVariant
+# TARGET_EXE=Bench_RefBatchMatMul
+# TARGET_EXE=Bench_RefResize
+# TARGET_EXE=Bench_RefBN
+# TARGET_EXE=Bench_Sort
+# TARGET_EXE=Bench_ArgReduce
+# TARGET_EXE=Bench_Broadcast
+# TARGET_EXE=Bench_Scatter
+# TARGET_EXE=Bench_DeformableOffsets
+# TARGET_EXE=Bench_DeviceCompare
+# TARGET_EXE=Bench_Compare
+# TARGET_EXE=Bench_Random
+# TARGET_EXE=Bench_Launch
+# TARGET_EXE=Bench_DtypeMatrix
+# TARGET_EXE=Bench_Sweep
+# TARGET_EXE=Bench_Cases
+
 echo "----------- buiding target : ${TARGET_EXE} --------------"
 
 build_dir="$(pwd)/${TARGET_EXE}/build"
@@ -53,4 +79,4 @@ make
 # run
 echo "-------------- start running op : ${TARGET_EXE} --------------"
 export ASCEND_GLOBAL_LOG_LEVEL=0 # debug level
-./${TARGET_EXE}
+./${TARGET_EXE} "$@"